@@ -31,6 +31,7 @@ set(DOCUMENT_FILES
 set(EXPORTERS_FILES
     ${LOMSE_SRC_DIR}/exporters/lomse_ldp_exporter.cpp
     ${LOMSE_SRC_DIR}/exporters/lomse_lmd_exporter.cpp
+    ${LOMSE_SRC_DIR}/exporters/lomse_midi_exporter.cpp
     ${LOMSE_SRC_DIR}/exporters/lomse_mnx_exporter.cpp
     ${LOMSE_SRC_DIR}/exporters/lomse_mxl_exporter.cpp
 )
@@ -53,6 +54,7 @@ set(GRAPHIC_MODEL_FILES
     ${LOMSE_SRC_DIR}/graphic_model/lomse_glyphs.cpp
     ${LOMSE_SRC_DIR}/graphic_model/lomse_gm_basic.cpp
     ${LOMSE_SRC_DIR}/graphic_model/lomse_gm_measures_table.cpp
+    ${LOMSE_SRC_DIR}/graphic_model/lomse_gm_tracking_table.cpp
     ${LOMSE_SRC_DIR}/graphic_model/lomse_graphical_model.cpp
     ${LOMSE_SRC_DIR}/graphic_model/lomse_handler.cpp
     ${LOMSE_SRC_DIR}/graphic_model/lomse_measure_highlight.cpp
@@ -144,6 +146,7 @@ set(INTERNAL_MODEL_FILES
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_figured_bass.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_measures_table.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_im_note.cpp
+    ${LOMSE_SRC_DIR}/internal_model/lomse_im_snapshot.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_internal_model.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_model_builder.cpp
     ${LOMSE_SRC_DIR}/internal_model/lomse_relobj_cloner.cpp
@@ -154,6 +157,7 @@ set(INTERNAL_MODEL_FILES
 )
 
 set(MODULE_FILES
+    ${LOMSE_SRC_DIR}/module/lomse_batch_compiler.cpp
     ${LOMSE_SRC_DIR}/module/lomse_doorway.cpp
     ${LOMSE_SRC_DIR}/module/lomse_events.cpp
     ${LOMSE_SRC_DIR}/module/lomse_events_dispatcher.cpp
@@ -204,14 +208,18 @@ set(PARSER_FILES
 set(RENDER_FILES
     ${LOMSE_SRC_DIR}/render/lomse_bitmap_drawer.cpp
     ${LOMSE_SRC_DIR}/render/lomse_calligrapher.cpp
+    ${LOMSE_SRC_DIR}/render/lomse_fast_pixfmt.cpp
     ${LOMSE_SRC_DIR}/render/lomse_font_freetype.cpp
     ${LOMSE_SRC_DIR}/render/lomse_font_storage.cpp
     ${LOMSE_SRC_DIR}/render/lomse_renderer.cpp
     ${LOMSE_SRC_DIR}/render/lomse_svg_drawer.cpp
+    ${LOMSE_SRC_DIR}/render/lomse_page_cache.cpp
+    ${LOMSE_SRC_DIR}/render/lomse_tile_cache.cpp
 )
 
 set(SOUND_FILES
     ${LOMSE_SRC_DIR}/sound/lomse_midi_table.cpp
+    ${LOMSE_SRC_DIR}/sound/lomse_playback_trace.cpp
 )
 
 set(LOMSE_PACKAGES_FILES
@@ -223,6 +231,7 @@ if( LOMSE_ENABLE_THREADS )
     set(SOUND_FILES
         ${SOUND_FILES} 
         ${LOMSE_SRC_DIR}/sound/lomse_score_player.cpp
+        ${LOMSE_SRC_DIR}/sound/lomse_playback_engine.cpp
     )
     set(GUI_CONTROLS_FILES
         ${GUI_CONTROLS_FILES}
@@ -80,6 +80,31 @@ Default behaviour is to generate the most compact SVG code and, therefore, it do
     spInteractor->render_as_svg(svg, page);
 @endcode
 
+On the other hand, if you would like to reduce the size of the SVG code you can use method Interactor::svg_precision() to limit the number of decimal places for coordinates and other numbers. By default, numbers are written with six significant digits.
+
+
+@section rendering-svg-glyphs  Music glyphs as outlines
+
+By default, music symbols are generated as @a \<text\> elements using the Bravura font. Therefore, the SVG will only be properly displayed when the Bravura font is installed in the client or embedded in the web page. Alternatively, you can use method Interactor::svg_glyphs_as_symbols() for generating the outline of each distinct glyph only once, in a @a \<symbol\> element, and drawing each glyph with a @a \<use\> element. The result does not depend on the fonts available in the client and it is usually much smaller. For instance:
+
+@code
+    std::stringstream svg;
+    int page = 0;
+    pIntor->svg_glyphs_as_symbols(true);
+    spInteractor->render_as_svg(svg, page);
+@endcode
+
+The generated code would be similar to:
+
+@code
+<symbol id='glyph-E0A4-741' overflow='visible'><path d='m0 65c0 ... z'/></symbol>
+<use xlink:href='#glyph-E0A4-741' x='3574' y='1852'/>
+...
+<use xlink:href='#glyph-E0A4-741' x='4387' y='1940'/>
+@endcode
+
+The @a \<symbol\> id is the glyph code and the font size, in LUnits. When 'id' and 'class' attributes are enabled, they are added to the @a \<use\> elements.
+
 
 @section rendering-svg-attributes  SVG 'id' and 'class' attributes
 
@@ -131,6 +131,20 @@ spInteractor->set_visual_tracking_mode(k_tracking_tempo_line | k_tracking_highli
 
 Lomse will handle the event and will send an <i>update window</i> event to your application, for updating the display.
 
+Take into account that, by default, the event handling callback is invoked in the Lomse sound thread. Therefore, the sound thread will wait while the event is processed and, if the user interface thread is busy (i.e. rendering the score), sound could be delayed. To avoid this, ScorePlayer can be instructed to not post the playback events and, instead, store them in a lock-free queue in the Interactor. Then, your application will process them from the user interface thread, for instance from a timer. This is not the default mode, for preserving the behaviour of existing applications, but it is the recommended mode for new applications:
+
+@code
+    pPlayer->post_tracking_events(false);
+    ...
+
+void MyWindow::on_timer()
+{
+    spInteractor->process_playback_events();
+}
+@endcode
+
+The number of times the sound thread could not keep the schedule is available in ScorePlayer::get_num_stalls(). It is useful for debugging timing problems.
+
 Some properties of the tracking effects, such as its colour, can be customized. See method Interactor::get_tracking_effect(). For the customizable properties see the documentation of each specific visual effect. Example:
 @code
 VisualEffect* pVE = spInteractor->get_tracking_effect(k_tracking_tempo_line);
@@ -199,6 +213,75 @@ the second parameter for load_score is nullptr, meaning that no PlayerGui is use
 @endcode
 
 
+@section page-sound-generation-virtual-clock Playback without real time
+
+For some tasks, such as automated tests or rendering the score to an audio file, it is convenient to run the whole playback logic (count-off, metronome clicks, jumps, visual tracking events and end of playback event) but without waiting for real time. For this, ScorePlayer offers a <i>virtual clock</i> mode:
+
+@code
+    pPlayer->set_virtual_clock(true);
+    pPlayer->load_score(score, pGui);
+    pPlayer->play(k_do_visual_tracking, 60, spInteractor.get());
+@endcode
+
+In this mode the score is played back as fast as possible. The requests to your @c MidiServer and the visual tracking events are the same, and in the same order, than in real time playback, but the time at which they should take place is no longer the time at which they are received. Instead, before any request for a new time, lomse invokes method MidiServerBase::set_playback_time() with the time (in milliseconds since the start of playback) for the requests that follow. The time for visual tracking events is available in EventVisualTracking::get_playback_time().
+
+
+@section page-sound-generation-batched-events Simultaneous sound requests
+
+All requests that take place at the same time (e.g. the notes of a chord, or all the notes starting at the same beat in a big score) are collected by ScorePlayer and delivered in a single invocation of MidiServerBase::process_events(). The default implementation of this method just invokes the per-event methods (note_on(), note_off(), voice_change() and program_change()) so, normally, your @c MidiServer does not need to care about it. But if your synthesizer or MIDI backend can accept several messages at once, overriding this method will save calls and will reduce the time skew between the notes of a chord:
+
+@code
+void MyMidiServer::process_events(const MidiEvent* events, size_t n, uint64_t timestampUs)
+{
+    std::vector<unsigned char> buffer;
+    for (size_t i=0; i < n; ++i)
+        encode_message(events[i], buffer);      //your code
+    m_pMidiOut->write(buffer);                  //a single write for all messages
+}
+@endcode
+
+
+@section page-sound-generation-many-sessions Playing back many scores simultaneously
+
+Each ScorePlayer uses its own thread. When your application has to play back many scores at the same time (e.g. a server streaming scores to many clients) it is better to use a PlaybackEngine. It uses a single thread to drive many playback sessions, each one with its own score, @c MidiServer and tempo:
+
+@code
+    PlaybackEngine* pEngine = pLomse->create_playback_engine();
+    PlaybackSession* pSession = pEngine->create_session(score, pMidi);
+    pSession->set_end_of_playback_callback(this, wrapper_for_end_of_playback);
+    pSession->play(90);
+    ...
+    pSession->pause();      //pause/resume
+    pSession->set_tempo(120);
+    pSession->stop();
+    ...
+    delete pEngine;
+@endcode
+
+Sessions do not generate visual tracking events, metronome clicks or count-off. Several sessions can play back the same score, as the playback position and the repetitions already played are kept by each session. All requests to your @c MidiServer are invoked from the engine thread, so they must return quickly. The only exception is @c all_sounds_off(), that is invoked from the thread that stops or pauses the session. The engine lock is not held while your @c MidiServer is invoked.
+
+If the score is modified, invoke PlaybackSession::update_table() from the thread modifying the score. The changes are played from next invocation of a play method.
+
+
+@section page-sound-generation-timing-trace Analysing playback timing
+
+For investigating timing problems (e.g. notes sounding late or irregularly) you can ask ScorePlayer to record, for each group of sound requests, the time at which it was scheduled, the time at which it was really delivered and how long your MidiServerBase::process_events() method took. Posting visual tracking events is also timed. Recording does not use locks and is disabled by default:
+
+@code
+    m_pPlayer->enable_trace(true);
+    m_pPlayer->play(...);
+    ...
+    PlaybackTrace* pTrace = m_pPlayer->get_trace();
+    pTrace->collect();          //move records from the sound thread buffer
+    cout << pTrace->dump_summary();
+
+    std::ofstream file("playback.json");
+    pTrace->write_chrome_trace(file);
+@endcode
+
+The summary includes percentiles and histograms of lateness and duration. The JSON file can be opened in chrome://tracing or https://ui.perfetto.dev. As the buffer has a fixed capacity, for long scores invoke PlaybackTrace::collect() periodically.
+
+
 @section page-sound-generation-external-player Using an external player
 
 If your application would like to use an external player and to provide visual feedback by synchronizing the performance with the displayed score, Lomse can not do this automatically as it doesn't control the playback, but Lomse provides some methods that can help your application to achieve the sound/display synchronization.
@@ -0,0 +1,141 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_BATCH_COMPILER_H__        //to avoid nested includes
+#define __LOMSE_BATCH_COMPILER_H__
+
+#include "lomse_build_options.h"
+#include "lomse_import_options.h"
+
+#include <string>
+#include <vector>
+
+
+namespace lomse
+{
+
+//forward declarations
+class LibraryScope;
+class Document;
+
+
+//---------------------------------------------------------------------------------------
+/** Actions to perform on each document of a batch. Compilation is always done. The
+    other values are flags that can be combined.
+*/
+enum EBatchAction
+{
+    k_batch_compile     = 0x0000,   ///< Only compile the document
+    k_batch_layout      = 0x0001,   ///< Also layout the document (build the graphic model)
+    k_batch_export_ldp  = 0x0002,   ///< Export the document as LDP source
+    k_batch_export_lmd  = 0x0004,   ///< Export the document as LMD source
+    k_batch_export_mxl  = 0x0008,   ///< Export the document as MusicXML source
+    k_batch_export_svg  = 0x0010,   ///< Render all pages as SVG. Implies layout
+};
+
+//---------------------------------------------------------------------------------------
+/** Final status of a document processed in a batch.
+*/
+enum EBatchStatus
+{
+    k_batch_ok = 0,             ///< All actions done. No errors
+    k_batch_with_errors,        ///< All actions done, but errors found when compiling
+    k_batch_failed,             ///< Not processed or processing aborted
+};
+
+//---------------------------------------------------------------------------------------
+/** BatchJob: a document to be processed by LomseDoorway::compile_batch().
+*/
+struct BatchJob
+{
+    enum { k_detect_format = -1, };
+
+    std::string filename;   ///< Absolute path to the file containing the document
+    int format;             ///< A value from enum Document::EFileFormat, or
+                            ///< k_detect_format to determine it from file extension
+    int actions;            ///< Flags from enum EBatchAction
+
+    BatchJob(const std::string& file, int todo=k_batch_compile,
+             int fileFormat=k_detect_format)
+        : filename(file)
+        , format(fileFormat)
+        , actions(todo)
+    {
+    }
+};
+
+//---------------------------------------------------------------------------------------
+/** BatchResult: the outcome of processing one BatchJob. Times are in milliseconds.
+*/
+struct BatchResult
+{
+    int status;                 ///< A value from enum EBatchStatus
+    int numErrors;              ///< Errors reported when compiling the document
+    std::string messages;       ///< Text of all messages reported by Lomse
+
+    int numPages;               ///< Pages of the layout. 0 if not laid out
+    std::string ldp;            ///< Exported LDP source, if requested
+    std::string lmd;            ///< Exported LMD source, if requested
+    std::string mxl;            ///< Exported MusicXML source, if requested
+    std::vector<std::string> svg;   ///< One SVG image per page, if requested
+
+    double compileTime;
+    double layoutTime;
+    double exportTime;
+    double totalTime;
+
+    BatchResult()
+        : status(k_batch_failed)
+        , numErrors(0)
+        , numPages(0)
+        , compileTime(0.0)
+        , layoutTime(0.0)
+        , exportTime(0.0)
+        , totalTime(0.0)
+    {
+    }
+};
+
+//---------------------------------------------------------------------------------------
+/** BatchCompiler: processes a list of documents on a pool of worker threads. Each
+    document is owned by the thread that processes it and is deleted when finished,
+    so only the results are returned. The MusicXML import options are copied when
+    the %BatchCompiler is created, and that copy is used for all documents. See
+    LomseDoorway::compile_batch() for the thread safety rules.
+*/
+class BatchCompiler
+{
+protected:
+    LibraryScope& m_libScope;
+    MusicXmlOptions m_mxlOptions;
+
+public:
+    BatchCompiler(LibraryScope& libScope);
+    ~BatchCompiler() {}
+
+    /** Process all jobs and return their results, in the same order than the jobs.
+        @param jobs The documents to process.
+        @param numThreads Maximum number of worker threads. Value 0 means one thread
+            per hardware core. When Lomse is built without threads support, the jobs
+            are processed sequentially in the calling thread.
+    */
+    std::vector<BatchResult> compile(const std::vector<BatchJob>& jobs, int numThreads=0);
+
+    /** Process one job in the calling thread.  */
+    BatchResult compile_one(const BatchJob& job);
+
+protected:
+    void open_document(Document* pDoc, const std::string& filename, int format,
+                       BatchResult& result);
+};
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_BATCH_COMPILER_H__
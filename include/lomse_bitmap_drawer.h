@@ -50,6 +50,9 @@ private:
 //    TextMeter*      m_pTextMeter;
     Calligrapher*   m_pCalligrapher;
     int             m_numPaths;
+    int             m_firstPath;    //first path after last render()
+    int             m_batchLevel;
+    int             m_numFlushes;
     RenderingBuffer m_rbuf;
     unsigned char*  m_pBuf;         //the memory for the bitmap. Owned by user app.
     unsigned        m_bufWidth;
@@ -145,6 +148,7 @@ public:
     //SVG line with start/end markers
     void line_with_markers(UPoint start, UPoint end, LUnits width,
                            ELineCap startCap, ELineCap endCap) override;
+    void solid_rect(double x1, double y1, double x2, double y2, Color color) override;
 
 
     // Attribute setting functions.
@@ -201,6 +205,8 @@ public:
     void set_shift(LUnits x, LUnits y) override;
     void remove_shift() override;
     void render() override;
+    void begin_batch() override;
+    void end_batch() override;
     void set_affine_transformation(TransAffine& transform) override;
 
     /** Set the background color and prepare to render a new image.  */
@@ -218,6 +224,7 @@ public:
     //info
     //---------------------------------------
     bool is_ready() const override;
+    bool accepts_solid_rects() const override { return true; }
 
 
     //Viewport info
@@ -239,6 +246,34 @@ public:
     //given in device coordinates (e.g. Pixel).
     void set_view_area(unsigned width, unsigned height, unsigned xShift, unsigned yShift);
 
+    //Use the rendering buffer and the transformation of other BitmapDrawer, but
+    //restricting drawing to rows [yStart, yEnd) of the buffer. For rendering bands
+    //in parallel: the result is the same than drawing with the other drawer.
+    void share_rendering_buffer(BitmapDrawer* pDrawer, unsigned yStart, unsigned yEnd);
+
+    //Move the content of the rendering buffer by (dx, dy) pixels. Pixels not
+    //covered by the moved content are not modified.
+    void scroll_bitmap(Pixels dx, Pixels dy);
+
+    //Restrict drawing to rectangle [x1, x2) x [y1, y2) of the rendering buffer, in
+    //device coordinates (e.g. Pixel), and clear it with the given color.
+    void clear_clip_rect(Pixels x1, Pixels y1, Pixels x2, Pixels y2, Color bgcolor);
+    void set_clip_rect(Pixels x1, Pixels y1, Pixels x2, Pixels y2);
+    void reset_clip_rect();
+
+    //Pixels modified by drawing operations since last reset_drawn_area(), relative
+    //to the view area origin and limited to the view area. Empty if nothing drawn.
+    void reset_drawn_area();
+    VRect get_drawn_area() const;
+    VPoint get_view_area_origin() const;
+
+    //Copy a bitmap, with the same pixel format, onto the rendering buffer. Position
+    //in device coordinates (e.g. Pixel), relative to the view area origin.
+    void copy_bitmap(RenderingBuffer& bmap, Pixels xDest, Pixels yDest);
+
+    //Number of times that pending paths have been rendered since last reset()
+    inline int get_num_flushes() const { return m_numFlushes; }
+
     unsigned char* get_rendering_buffer() { return m_pBuf; };
     unsigned get_rendering_buffer_width() const { return m_bufWidth; };
     unsigned get_rendering_buffer_height() const { return m_bufHeight; };
@@ -249,7 +284,10 @@ protected:
     void pop_attr();
     PathAttributes& cur_attr();
     void render_existing_paths();
+    void render_paths_under(const AggRectInt& area);
+    void flush_paths();
     void delete_paths();
+    inline bool has_deferred_paths() const { return m_batchLevel > 0 && m_numPaths > 0; }
 
 };
 
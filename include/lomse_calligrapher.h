@@ -22,6 +22,7 @@
 
 #include "lomse_injectors.h"
 #include "lomse_basic.h"
+#include "lomse_agg_types.h"
 
 
 namespace lomse
@@ -30,6 +31,7 @@ namespace lomse
 //forward declarations
 class Renderer;
 class FontStorage;
+struct glyph_cache;
 
 
 // Calligrapher: A speciallized drawer that knows how to create bitmaps and
@@ -52,10 +54,21 @@ public:
     void draw_glyph(double x, double y, unsigned int ch, Color color, double scale);
     void draw_glyph_rotated(double x, double y, unsigned int ch, Color color, double scale, double rotation);
 
+    //Pixels that would be modified by drawing the glyph or the text, in device units
+    //(inclusive limits). Returns false if nothing would be drawn
+    bool get_text_bounds(double x, double y, const std::string& str, double scale,
+                         AggRectInt* pBounds);
+    bool get_text_bounds(double x, double y, const wstring& str, double scale,
+                         AggRectInt* pBounds);
+    bool get_glyph_bounds(double x, double y, unsigned int ch, double scale,
+                          double rotation, AggRectInt* pBounds);
+
 protected:
     void draw_glyph(double x, double y, unsigned int ch, Color color);
     void set_scale(double scale);
     void set_scale_and_rotation(double scale, double rotation);
+    void add_glyph_bounds(const lomse::glyph_cache* glyph, double x, double y,
+                          AggRectInt* pBounds);
 
 };
 
@@ -39,7 +39,7 @@ public:
 
 protected:
     std::string get_rootfile_path(ZipInputStream&);
-    std::vector<unsigned char> read_rootfile(ZipInputStream&);
+    void* inflate_entry(ZipInputStream&, const std::string& innerPath, size_t* pSize);
 };
 
 
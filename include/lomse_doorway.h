@@ -13,10 +13,12 @@
 #include "lomse_build_options.h"
 #include "lomse_basic.h"
 #include "lomse_pixel_formats.h"
+#include "lomse_batch_compiler.h"
 
 #include <string>
 #include <iostream>
 #include <memory>   //shared_ptr
+#include <vector>
 
 ///@cond INTERNAL
 namespace lomse
@@ -34,6 +36,7 @@ class SingleSystemView;
 class Document;
 class Presenter;
 class ScorePlayer;
+class PlaybackEngine;
 class MidiServerBase;
 class Metronome;
 class MusicXmlOptions;
@@ -395,6 +398,62 @@ public:
 
 
 
+     /** @name Batch processing  */
+    //@{
+
+	/** Compile a list of documents and, optionally, lay out and export them. The
+        documents are processed in parallel on a pool of worker threads, and each
+        document is deleted when processed. Only the results are returned.
+
+        Lomse can safely process several documents concurrently as long as your
+        application respects the following contract:
+        - Shared tables (the LDP factory, the music glyphs table and the fonts
+            selector) are created on first use and then only read. They can be used
+            from any thread.
+        - Each worker thread has its own font engine (FontStorage) as it keeps the
+            selected font and a cache of glyphs. Threads not created by Lomse share
+            the font engine of the main thread.
+        - All mutable state (the internal model, the graphic model, the ids
+            assigner) lives in each Document. A Document and all objects derived
+            from it must only be used by one thread at a time.
+        - The MusicXML import options are copied when the batch starts and each
+            document is imported with that copy. Changing them while a batch is
+            being processed only affects the next batches.
+        - Other library options (music font, fonts path, spacing parameters) must
+            not be changed while a batch is being processed.
+
+        @param jobs The documents to process and the actions to perform on each one.
+        @param numThreads Maximum number of worker threads. Value 0 means one thread per
+            hardware core. When Lomse is built without threads support the documents
+            are processed sequentially.
+
+        @return One BatchResult for each job, in the same order than the jobs, with the
+            status, the messages reported by Lomse, the exported sources and the
+            time spent in each step.
+
+        For instance, for converting a set of MusicXML files to SVG:
+
+        @code
+        std::vector<BatchJob> jobs;
+        for (const std::string& file : files)
+            jobs.push_back( BatchJob(file, k_batch_export_svg) );
+
+        std::vector<BatchResult> results = lomse.compile_batch(jobs);
+        for (size_t i=0; i < results.size(); ++i)
+        {
+            if (results[i].status == k_batch_failed)
+                cout << files[i] << ": " << results[i].messages;
+            ...
+        }
+        @endcode
+	*/
+    std::vector<BatchResult> compile_batch(const std::vector<BatchJob>& jobs,
+                                           int numThreads=0);
+
+    //@}    //Batch processing
+
+
+
      /** @name Playback related methods  */
     //@{
 
@@ -421,6 +480,14 @@ public:
         @see @subpage page-sound-generation
 	*/
     ScorePlayer* create_score_player(MidiServerBase* pSoundServer);
+
+	/** Method create_playback_engine() creates a PlaybackEngine object, for playing
+        back many scores simultaneously using a single thread. Your application owns
+        the returned object and must delete it when no longer needed.
+
+        @see @subpage page-sound-generation
+	*/
+    PlaybackEngine* create_playback_engine();
 #endif
     //@}    //Playback related methods
 
@@ -482,6 +549,21 @@ public:
 	*/
     MusicXmlOptions* get_musicxml_options();
 
+	/** Enables the cache of snapshots and sets the folder in which snapshots will be
+        saved. When enabled, each document opened from a file by method open_document()
+        is saved in the cache as a binary snapshot of its internal model. Next time
+        the same file is opened, the snapshot is loaded instead of parsing the file
+        again, what is much faster for big scores.
+
+        Snapshots are keyed by a hash of the file content and the import options, so
+        that any change in the file invalidates the cached snapshot. Files with errors
+        are never cached.
+
+        @param path   Path to an existing folder. An empty string disables the cache.
+            By default the cache is disabled.
+	*/
+    void set_snapshots_cache_path(const std::string& path);
+
 	/** Get the pointer to an object of class LibraryScope. This object gives access to
         all Lomse global functions and information.    */
     inline LibraryScope* get_library_scope() { return m_pLibraryScope; }
@@ -168,6 +168,39 @@ struct RenderOptions
         return boxes[type];
     }
 
+    bool operator==(const RenderOptions& opt) const
+    {
+        for (size_t i=0; i < sizeof(voiceColor)/sizeof(voiceColor[0]); ++i)
+        {
+            if (!is_equal(voiceColor[i], opt.voiceColor[i]))
+                return false;
+        }
+        return boxes == opt.boxes
+            && draw_anchor_objects == opt.draw_anchor_objects
+            && draw_anchor_lines == opt.draw_anchor_lines
+            && draw_shape_bounds == opt.draw_shape_bounds
+            && draw_slur_points == opt.draw_slur_points
+            && draw_vertical_profile == opt.draw_vertical_profile
+            && draw_chords_coloured == opt.draw_chords_coloured
+            && scale == opt.scale
+            && is_equal(background_color, opt.background_color)
+            && is_equal(highlighted_color, opt.highlighted_color)
+            && is_equal(dragged_color, opt.dragged_color)
+            && is_equal(selected_color, opt.selected_color)
+            && is_equal(focussed_box_color, opt.focussed_box_color)
+            && is_equal(unfocussed_box_color, opt.unfocussed_box_color)
+            && is_equal(not_highlighted_voice_color, opt.not_highlighted_voice_color)
+            && page_border_flag == opt.page_border_flag
+            && cast_shadow_flag == opt.cast_shadow_flag
+            && draw_focus_lines_on_boxes_flag == opt.draw_focus_lines_on_boxes_flag
+            && draw_shapes_highlighted == opt.draw_shapes_highlighted
+            && draw_shapes_dragged == opt.draw_shapes_dragged
+            && draw_shapes_selected == opt.draw_shapes_selected
+            && draw_voices_coloured == opt.draw_voices_coloured
+            && read_only_mode == opt.read_only_mode
+            && highlighted_voice == opt.highlighted_voice;
+    }
+
 
 };
 
@@ -180,6 +213,8 @@ struct SvgOptions
     bool add_id = false;            //include id='..' in elements
     bool add_class = false;         //include class="...." in elements
     bool add_newlines = false;      //add a new lines after each element
+    bool glyphs_as_symbols = false; //music glyphs as outlines in <symbol>, drawn by <use>
+    int precision = -1;             //max. decimal places for numbers. -1: as std::ostream
 
     SvgOptions() {}
 };
@@ -478,6 +513,14 @@ public:
     /** SVG line with start/end markers. Absolute coordinates. */
     virtual void line_with_markers(UPoint start, UPoint end, LUnits width,
                                    ELineCap startCap, ELineCap endCap) = 0;
+
+    /** Fill an axis-aligned rectangle, from corner (x1, y1) to corner (x2, y2), with
+        a solid color and no stroke. The rectangle is an independent path, so there is
+        no need to invoke begin_path() before. By default it is drawn as a closed
+        path, but drawers accepting solid rectangles (see accepts_solid_rects())
+        write it directly, which is much faster.
+    */
+    virtual void solid_rect(double x1, double y1, double x2, double y2, Color color);
     //@}    //SVG basic shapes commands
 
 
@@ -710,6 +753,18 @@ public:
     /** Do render currently defined paths. */
     virtual void render() = 0;
 
+    /** Start a batch of drawing operations. Until end_batch() is invoked, the %Drawer
+        can defer rendering the paths after render() is invoked, and render them
+        together later, provided the final image does not change. Batches can be
+        nested.
+    */
+    virtual void begin_batch() {}
+
+    /** Close a batch of drawing operations. All deferred paths are rendered
+        when the outermost batch is closed.
+    */
+    virtual void end_batch() {}
+
     /** Set the affine transformation matrix to use. */
     virtual void set_affine_transformation(TransAffine& transform) = 0;
 
@@ -800,6 +855,12 @@ public:
 
     /** Returns @TRUE if the %Drawer accepts 'id' and 'class' information */
     virtual bool accepts_id_class() const { return false; }
+
+    /** Returns @TRUE if the %Drawer has a fast method for drawing solid rectangles.
+        Shapes made of axis-aligned lines (i.e. staff lines, stems) should then
+        use solid_rect() instead of paths.
+    */
+    virtual bool accepts_solid_rects() const { return false; }
     //@}    //Other methods
 
 };
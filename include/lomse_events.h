@@ -1064,6 +1064,7 @@ protected:
     ImoId m_nID;            //ID of the target score for the event
     std::list< pair<int, ImoId> > m_items;
     TimeUnits m_timepos;    //for move tempo line sub-event
+    long m_playbackTime;    //millisecs. since start of playback
 
 public:
     /// Constructor
@@ -1071,6 +1072,7 @@ public:
         : EventPlayback(k_tracking_event, wpInteractor)
         , m_nID(nScoreID)
         , m_timepos(0.0)
+        , m_playbackTime(0L)
     {
     }
 
@@ -1080,6 +1082,7 @@ public:
         , m_nID(event.m_nID)
         , m_items(event.m_items)
         , m_timepos(event.m_timepos)
+        , m_playbackTime(event.m_playbackTime)
     {
     }
 
@@ -1106,6 +1109,10 @@ public:
 	/// Returns the time position for the tempo line sub-event
     inline TimeUnits get_timepos() { return m_timepos; }
 
+    /** Returns the playback time for this event, in milliseconds from the start of
+        playback. See MidiServerBase::set_playback_time(). */
+    inline long get_playback_time() { return m_playbackTime; }
+
 ///@cond INTERNAL
 	//construction
     void add_item(int type, ImoId id)
@@ -1117,6 +1124,7 @@ public:
         m_items.push_back( make_pair(k_move_tempo_line, -1) );
         m_timepos = timepos;
     }
+    inline void set_playback_time(long milliseconds) { m_playbackTime = milliseconds; }
 ///@endcond
 };
 
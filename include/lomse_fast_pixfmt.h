@@ -0,0 +1,180 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_FAST_PIXFMT_H__        //to avoid nested includes
+#define __LOMSE_FAST_PIXFMT_H__
+
+#include "agg_basics.h"
+#include "agg_pixfmt_rgb.h"
+#include "agg_pixfmt_rgba.h"
+#include "agg_pixfmt_gray.h"
+
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// Span kernels: fill and blend a horizontal span of pixels with a solid color. Results
+// are identical to the AGG blenders for 8 bits per component formats (blender_rgba,
+// blender_rgb and blender_gray). Pixels have 1, 3 or 4 bytes. The color is given as
+// the pixel bytes, in buffer order. For blending, the alpha byte of the color must be
+// 255, and 'alpha' is the color alpha.
+//
+// The instruction set is selected at runtime, the first time a kernel is used, as the
+// best one supported by the CPU.
+enum ESpanInstructionSet
+{
+    k_span_portable = 0,    //plain C++
+    k_span_sse2,            //x86 SSE2, 16 bytes per step
+    k_span_avx2,            //x86 AVX2, 32 bytes per step
+};
+
+extern void span_copy(agg::int8u* p, unsigned len, const agg::int8u* color,
+                      int bytesPerPixel);
+extern void span_blend(agg::int8u* p, unsigned len, const agg::int8u* color,
+                       int bytesPerPixel, agg::int8u alpha);
+extern void span_blend_covers(agg::int8u* p, unsigned len, const agg::int8u* color,
+                              int bytesPerPixel, agg::int8u alpha,
+                              const agg::int8u* covers);
+
+extern int get_span_instruction_set();
+extern bool is_span_instruction_set_supported(int iset);
+//Force an instruction set (i.e. for benchmarks). Returns false if not supported
+extern bool set_span_instruction_set(int iset);
+
+
+//---------------------------------------------------------------------------------------
+// FastPixFormatRgb: AGG rgb/rgba pixel format whose solid span methods (copy_hline,
+// blend_hline and blend_solid_hspan) use the span kernels
+template<class PixFmt>
+class FastPixFormatRgb : public PixFmt
+{
+public:
+    typedef typename PixFmt::rbuf_type rbuf_type;
+    typedef typename PixFmt::color_type color_type;
+    typedef typename PixFmt::order_type order_type;
+    typedef typename PixFmt::pixfmt_category pixfmt_category;
+    typedef typename PixFmt::value_type value_type;
+
+    FastPixFormatRgb() : PixFmt() {}
+    explicit FastPixFormatRgb(rbuf_type& rb) : PixFmt(rb) {}
+
+    //--------------------------------------------------------------------
+    void copy_hline(int x, int y, unsigned len, const color_type& c)
+    {
+        agg::int8u color[4];
+        pixel_bytes(c, c.a, color);
+        span_copy(span_ptr(x, y, len), len, color, PixFmt::pix_width);
+    }
+
+    //--------------------------------------------------------------------
+    void blend_hline(int x, int y, unsigned len, const color_type& c, agg::int8u cover)
+    {
+        if (!c.is_transparent())
+        {
+            agg::int8u color[4];
+            pixel_bytes(c, color_type::base_mask, color);
+            span_blend(span_ptr(x, y, len), len, color, PixFmt::pix_width,
+                       color_type::mult_cover(c.a, cover));
+        }
+    }
+
+    //--------------------------------------------------------------------
+    void blend_solid_hspan(int x, int y, unsigned len, const color_type& c,
+                           const agg::int8u* covers)
+    {
+        if (!c.is_transparent())
+        {
+            agg::int8u color[4];
+            pixel_bytes(c, color_type::base_mask, color);
+            span_blend_covers(span_ptr(x, y, len), len, color, PixFmt::pix_width,
+                              c.a, covers);
+        }
+    }
+
+protected:
+    //--------------------------------------------------------------------
+    inline agg::int8u* span_ptr(int x, int y, unsigned len)
+    {
+        return reinterpret_cast<agg::int8u*>( this->pix_value_ptr(x, y, len) );
+    }
+
+    //--------------------------------------------------------------------
+    static inline void pixel_bytes(const color_type& c, value_type a, agg::int8u* bytes)
+    {
+        bytes[order_type::R] = c.r;
+        bytes[order_type::G] = c.g;
+        bytes[order_type::B] = c.b;
+        alpha_byte(a, bytes, pixfmt_category());
+    }
+
+    static inline void alpha_byte(value_type a, agg::int8u* bytes, agg::pixfmt_rgba_tag)
+    {
+        bytes[order_type::A] = a;
+    }
+
+    static inline void alpha_byte(value_type, agg::int8u*, agg::pixfmt_rgb_tag) {}
+};
+
+
+//---------------------------------------------------------------------------------------
+// FastPixFormatGray: AGG gray pixel format whose solid span methods use the span kernels
+template<class PixFmt>
+class FastPixFormatGray : public PixFmt
+{
+public:
+    typedef typename PixFmt::rbuf_type rbuf_type;
+    typedef typename PixFmt::color_type color_type;
+
+    FastPixFormatGray() : PixFmt() {}
+    explicit FastPixFormatGray(rbuf_type& rb) : PixFmt(rb) {}
+
+    //--------------------------------------------------------------------
+    void copy_hline(int x, int y, unsigned len, const color_type& c)
+    {
+        span_copy(span_ptr(x, y, len), len, &c.v, 1);
+    }
+
+    //--------------------------------------------------------------------
+    void blend_hline(int x, int y, unsigned len, const color_type& c, agg::int8u cover)
+    {
+        if (!c.is_transparent())
+            span_blend(span_ptr(x, y, len), len, &c.v, 1,
+                       color_type::mult_cover(c.a, cover));
+    }
+
+    //--------------------------------------------------------------------
+    void blend_solid_hspan(int x, int y, unsigned len, const color_type& c,
+                           const agg::int8u* covers)
+    {
+        if (!c.is_transparent())
+            span_blend_covers(span_ptr(x, y, len), len, &c.v, 1, c.a, covers);
+    }
+
+protected:
+    //--------------------------------------------------------------------
+    inline agg::int8u* span_ptr(int x, int y, unsigned len)
+    {
+        return reinterpret_cast<agg::int8u*>( this->pix_value_ptr(x, y, len) );
+    }
+};
+
+
+//---------------------------------------------------------------------------------------
+typedef FastPixFormatRgb<agg::pixfmt_rgba32>    FastPixFormat_rgba32;
+typedef FastPixFormatRgb<agg::pixfmt_argb32>    FastPixFormat_argb32;
+typedef FastPixFormatRgb<agg::pixfmt_bgra32>    FastPixFormat_bgra32;
+typedef FastPixFormatRgb<agg::pixfmt_rgb24>     FastPixFormat_rgb24;
+typedef FastPixFormatRgb<agg::pixfmt_bgr24>     FastPixFormat_bgr24;
+typedef FastPixFormatGray<agg::pixfmt_gray8>    FastPixFormat_gray8;
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_FAST_PIXFMT_H__
@@ -892,6 +892,20 @@ enum EGlyphIndex
 
 };
 
+//---------------------------------------------------------------------------------------
+// Glyph metrics: an entry of the metrics table for the music font. The table is
+// generated at build time from the font outlines. All measurements in staff spaces,
+// with y axis pointing upwards, as in SMuFL metadata.
+struct GlyphMetrics
+{
+    unsigned int code;
+    float advance;          //advance width
+    float left;             //bounding box: bBoxSW.x
+    float bottom;           //bounding box: bBoxSW.y
+    float right;            //bounding box: bBoxNE.x
+    float top;              //bounding box: bBoxNE.y
+};
+
 //---------------------------------------------------------------------------------------
 // Encapsulate access to glyphs table. A singleton with library scope
 class MusicGlyphs
@@ -899,6 +913,7 @@ class MusicGlyphs
 protected:
     LibraryScope* m_pLibScope;
     const GlyphData* m_glyphs;
+    const GlyphMetrics* m_metrics;      //nullptr if no metrics for current music font
 
 public:
     MusicGlyphs(LibraryScope* pLibScope);
@@ -910,6 +925,17 @@ public:
     inline std::string glyph_name(int iGlyph) { return (*(m_glyphs+iGlyph)).GlyphName; }
     inline LUnits glyph_offset(int UNUSED(iGlyph)) { return 0.0f; }
     inline const GlyphData& get_glyph_data(int iGlyph) { return *(m_glyphs+iGlyph); }
+
+    //glyph metrics for the music font. They do not depend on the font engine, so these
+    //methods are thread safe. All methods return false when the metrics for the glyph
+    //are not available and the font must be used instead.
+    inline bool has_metrics() { return m_metrics != nullptr; }
+    const GlyphMetrics* get_metrics(unsigned int ch);
+    bool bounding_rectangle(unsigned int ch, double fontHeight, URect* pRect);
+    bool advance_x(unsigned int ch, double fontHeight, LUnits* pWidth);
+
+protected:
+    static LUnits staff_space(double fontHeight);
 };
 
 
@@ -49,6 +49,7 @@ class Control;
 class ScoreStub;
 class GraphicModel;
 class GmMeasuresTable;
+class GmTrackingTable;
 
 
 ///@cond INTERNALS
@@ -69,12 +70,13 @@ protected:
     ImoId m_scoreId;
     std::vector<GmoBoxScorePage*> m_pages;
     GmMeasuresTable* m_measures;
+    GmTrackingTable* m_tracking;
 
 public:
     ScoreStub(ImoScore* pScore);
     ~ScoreStub();
 
-    inline void add_page(GmoBoxScorePage* pPage) { m_pages.push_back(pPage); }
+    void add_page(GmoBoxScorePage* pPage);
     inline std::vector<GmoBoxScorePage*>& get_pages() { return m_pages; }
 
     /** Returns the GmoBoxScorePage containing timepos @c time. If @c time is not in
@@ -90,6 +92,12 @@ public:
     /** Returns the table of measures for this score */
     inline GmMeasuresTable* get_measures_table() { return m_measures; }
 
+    /** Returns the table with the geometry for visual tracking during playback. It is
+        created the first time it is requested, so it must not be requested before
+        the score layout is finished.
+    */
+    GmTrackingTable* get_tracking_table();
+
 };
 ///@endcond
 
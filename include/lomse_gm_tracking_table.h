@@ -0,0 +1,104 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_GM_TRACKING_TABLE_H__
+#define __LOMSE_GM_TRACKING_TABLE_H__
+
+#include "lomse_basic.h"
+
+#include <vector>
+#include <string>
+
+namespace lomse
+{
+
+//forward declarations
+class GmoBoxScorePage;
+class GmoBoxSystem;
+
+//---------------------------------------------------------------------------------------
+/** Result of a GmTrackingTable lookup: the geometry needed for placing the tempo line
+    and for scrolling the viewport at a given timepos.
+*/
+struct TrackingPosition
+{
+    GmoBoxSystem* pSystem;      //system containing the timepos
+    int iPage;                  //page number for the system (0..n-1)
+    LUnits xPos;                //x position for note/rest at timepos
+
+    TrackingPosition() : pSystem(nullptr), iPage(0), xPos(0.0f) {}
+};
+
+//---------------------------------------------------------------------------------------
+/** %GmTrackingTable object is responsible for storing, for one score, a table with the
+    relation timepos --> (system, page, x position) for all occupied times in the score.
+    It is used during playback for visual tracking, as a replacement of the slower
+    linear searches through pages, systems and TimeGridTable entries.
+
+    The table is built once, from the TimeGridTable of each system, and the lookup is
+    a binary search. Results are the same than those returned by
+    GraphicModel::get_system_for() and GmoBoxSystem::get_x_for_note_rest_at_time().
+*/
+class GmTrackingTable
+{
+protected:
+    //one entry for each distinct timepos in a system TimeGridTable
+    struct TimeEntry
+    {
+        TimeUnits timepos;      //timepos for first TimeGridTable entry with this time
+        TimeUnits lastTimepos;  //timepos for last entry with this time
+        LUnits xFirst;          //x position for first entry with this time
+        LUnits xLast;           //x position for last entry with this time
+        LUnits xNoteRest;       //x position for note/rest at this time
+    };
+
+    //one entry for each system
+    struct SystemEntry
+    {
+        GmoBoxSystem* pSystem;
+        int iPage;
+        TimeUnits startTime;
+        TimeUnits endTime;
+        int iFirst;             //index to first TimeEntry for this system
+        int iEnd;               //index to first TimeEntry for next system
+    };
+
+    std::vector<SystemEntry> m_systems;
+    std::vector<TimeEntry> m_times;
+
+public:
+    GmTrackingTable(std::vector<GmoBoxScorePage*>& pages);
+    ~GmTrackingTable() {}
+
+    /** Find the system and the x position for note/rest at the given timepos.
+        Returns @false if there is no system containing the timepos.
+    */
+    bool find(TimeUnits timepos, TrackingPosition* pPos);
+
+    /** Returns the system containing the timepos, or @nullptr if not found. */
+    GmoBoxSystem* find_system(TimeUnits timepos);
+
+    //info
+    inline int num_systems() { return int(m_systems.size()); }
+    inline int num_entries() { return int(m_times.size()); }
+
+    //debug
+    std::string dump_table();
+
+protected:
+    void add_system(GmoBoxSystem* pSystem);
+    int find_system_index(TimeUnits timepos);
+    LUnits find_x_in_system(int iSystem, TimeUnits timepos);
+
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_GM_TRACKING_TABLE_H__
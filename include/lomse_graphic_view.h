@@ -21,6 +21,7 @@
 #include <vector>
 #include <list>
 #include <mutex>
+#include <functional>
 using namespace std;
 
 
@@ -50,6 +51,9 @@ class SelectionRectangle;
 class SelectionSet;
 class SvgDrawer;
 class TempoLine;
+struct Tile;
+class TileCache;
+class PageCache;
 class TimeGrid;
 class VisualEffect;
 
@@ -152,6 +156,25 @@ protected:
     BitmapDrawer* m_pPrintDrawer;     //owned by GraphicView
     RenderOptions m_options;
     OverlaysGenerator* m_pOverlaysGenerator;
+    TileCache* m_pTileCache;            //nullptr when tiles are not used
+    BitmapDrawer* m_pTileDrawer;        //for rendering tiles. Owned by GraphicView
+    int m_numRenderThreads;             //for rasterizing bands in parallel
+
+    //last rendered frame, for reusing it when scrolling
+    struct FrameInfo
+    {
+        bool fValid = false;
+        Pixels vxOrg = 0;
+        Pixels vyOrg = 0;
+        double scale = 0.0;
+        long modelId = -1L;
+        long modelVersion = -1L;
+        RenderOptions options;
+    };
+    FrameInfo m_lastFrame;
+    bool m_fScrollBlitting;             //reuse last frame when scrolling
+    bool m_fScrollDamage;               //damaged rectangle is the exposed area
+    VRect m_scrollDamagedRect;
 
     //renderization parameters
     double m_expand;
@@ -231,6 +254,11 @@ public:
     void draw_selected_objects();
     void draw_handler(Handler* pHandler);
     void set_background(Color color) { m_backgroundColor = color; }
+    void set_tile_cache_budget(size_t maxBytes);
+    inline TileCache* get_tile_cache() { return m_pTileCache; }
+    void set_rendering_threads(int numThreads);
+    void enable_scroll_blitting(bool fEnabled);
+    inline int get_rendering_threads() const { return m_numRenderThreads; }
     ///@}    //Renderization related
 
 
@@ -463,10 +491,21 @@ protected:
 
     virtual void draw_all();
     void draw_graphic_model();
+    void draw_graphic_model_from_tiles(BitmapDrawer* pDrawer);
+    void render_tile(Tile* pTile);
+    void draw_in_bands(BitmapDrawer* pDrawer, std::function<void(Drawer*)> draw);
+    bool can_scroll_last_frame();
+    void draw_graphic_model_scrolled(BitmapDrawer* pDrawer);
+    void draw_exposed_rectangle(BitmapDrawer* pDrawer, Pixels x1, Pixels y1,
+                                Pixels x2, Pixels y2);
+    VRect get_overlays_damaged_rectangle();
+    void save_frame_info();
     void draw_time_grid();
     void generate_paths();
     virtual void collect_page_bounds() = 0;
-    void draw_visible_pages(int minPage, int maxPage);
+    void draw_visible_pages(int minPage, int maxPage, Drawer* pDrawer);
+    void draw_page_from_cache(int iPage, const URect& bounds, BitmapDrawer* pDrawer,
+                              PageCache* pPageCache);
     URect get_page_bounds(int iPage);
     int find_page_at_point(LUnits x, LUnits y);
     bool shift_right_x_to_be_on_page(double* xLeft);
@@ -49,6 +49,7 @@ class SelectionSet;
 class Control;
 class ScoreStub;
 class GmMeasuresTable;
+class GmTrackingTable;
 
 
 //---------------------------------------------------------------------------------------
@@ -165,6 +166,7 @@ protected:
     GmoBoxDocument* m_root;
     long m_modelId;
     bool m_modified;
+    long m_version;         //incremented each time the model is modified
     map<ImoId, GmoBox*> m_imoToBox;
     map<ImoId, GmoShape*> m_imoToMainShape;
     map< pair<ImoId, ShapeId>, GmoShape*> m_imoToSecondaryShape;
@@ -340,9 +342,10 @@ public:
     ///@cond INTERNALS
     //excluded from public API. Only for internal use.
 
-    inline void set_modified(bool value) { m_modified = value; }
+    inline void set_modified(bool value) { m_modified = value; if (value) ++m_version; }
     inline bool is_modified() { return m_modified; }
     inline long get_model_id() { return m_modelId; }
+    inline long get_version() { return m_version; }
 
     //drawing
     void draw_page(int iPage, UPoint& origin, Drawer* pDrawer, RenderOptions& opt);
@@ -365,6 +368,12 @@ public:
     //access to objects/information
     GmoObj* get_box_for_control(GmoRef gref);
 
+    /** Returns the table with the geometry for visual tracking during playback
+        (timepos --> system, page, x position) for the given score, or @nullptr if
+        the score is not in this model. See GmTrackingTable.
+    */
+    GmTrackingTable* get_tracking_table(ImoId scoreId);
+
     //tests
     void dump_page(int iPage, ostream& outStream);
 
@@ -30,6 +30,7 @@ class Control;
 class IdAssigner
 {
 protected:
+    friend class ImSnapshot;
     ImoId m_idCounter;
     std::unordered_map<ImoId, ImoObj*> m_idToImo;
     std::unordered_map<ImoId, Control*> m_idToControl;
@@ -51,6 +52,7 @@ public:
     void copy_ids_to(IdAssigner* assigner, ImoId idMin);
     std::string get_xml_id_for(ImoId id);
     void set_xml_id_for(ImoId id, const std::string& xmlId);
+    inline ImoId get_last_id() const { return m_idCounter; }
 
     //debug
     std::string dump() const;
@@ -59,6 +61,7 @@ public:
 
 protected:
     friend class FixModelVisitor;
+    friend class TransferIdsVisitor;
     friend class DocModel;
 
     void add_id(ImoId id, ImoObj* pImo);
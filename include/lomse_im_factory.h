@@ -36,6 +36,10 @@ public:
     static ImoObj* inject(int type, DocModel* pDocModel, ImoId id=k_no_imoid);
     static ImoObj* inject(int type, Document* pDoc, ImoId id=k_no_imoid);
 
+    //creates an empty object of the given type, without id and not attached to any
+    //model. Returns nullptr if type is not valid
+    static ImoObj* create(int type);
+
 
     //specific injectors, to simplify some code and testing
     static ImoNote* inject_note(Document* pDoc, int step, int octave,
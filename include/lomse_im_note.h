@@ -55,6 +55,7 @@ enum ENoteStem
 class ImoNoteRest : public ImoStaffObj
 {
 protected:
+    friend class ImSnapshot;
     bool        m_fUnpitched = false;           //unpitched note
     int         m_nNoteType = k_quarter;
     int         m_step = k_step_undefined;      //step and octave are for note's pitch. But
@@ -161,6 +162,7 @@ protected:
     bool m_fFullMeasureRest = false;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoRest() : ImoNoteRest(k_imo_rest) {}
 
     friend class GoBackFwdAnalyser;
@@ -217,6 +219,8 @@ protected:
     int     m_computedStem;         //value from ENoteStem
 
     friend class ImFactory;
+    friend class ImSnapshot;
+    friend class TransferIdsVisitor;
     ImoNote(int type);
     ImoNote(int step, int octave, int noteType, EAccidentals accidentals=k_no_accidentals,
             int dots=0, int staff=0, int voice=0, int stem=k_stem_default);
@@ -385,6 +389,7 @@ protected:
     TimeUnits m_alignTime;  //to simplify spacing algorithm a pseudo-timepos is assigned
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoGraceNote() : ImoNote(k_imo_note_grace), m_alignTime(0.0) {}
 
 public:
@@ -0,0 +1,116 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_IM_SNAPSHOT_H__        //to avoid nested includes
+#define __LOMSE_IM_SNAPSHOT_H__
+
+#include "lomse_basic.h"
+
+#include <string>
+#include <cstdint>
+
+
+namespace lomse
+{
+
+//forward declarations
+class DocModel;
+class Document;
+class ImoDocument;
+class ImoObj;
+class MusicXmlOptions;
+class SnapshotReader;
+class SnapshotWriter;
+
+
+//---------------------------------------------------------------------------------------
+/** ImSnapshot: encloses the algorithms to save the internal model of a document as a
+    binary image (snapshot) and to rebuild the internal model from it, without
+    parsing the source file again.
+
+    The snapshot contains the Imo tree with all nodes, attributes, relations and
+    styles, as well as the ids and xml ids registered in the IdAssigner. Derived
+    tables (ColStaffObjs, measures tables) are not saved but rebuilt when the
+    snapshot is loaded.
+
+    The format is versioned and uses fixed width little-endian fields, so that the
+    reader can work directly on a memory mapped file. A checksum of the content is
+    saved in the header to detect truncated or corrupted snapshots. Snapshots are
+    not validated in any other way: they are trusted data created by Lomse.
+
+    Documents containing objects bound to run-time resources (controls, images,
+    score players) cannot be saved as snapshot.
+*/
+class ImSnapshot
+{
+public:
+    enum { k_format_version = 1, };
+
+    /** Saves the internal model in string 'out'. Returns @FALSE if the model contains
+        objects not supported in snapshots. In this case 'out' is undefined.  */
+    static bool save(DocModel* pModel, std::string& out);
+
+    /** Rebuilds an internal model from the snapshot in buffer 'data'. The ids are
+        registered in 'pModel' IdAssigner, that must be empty. Returns the root of the
+        new tree, or @nullptr if the snapshot is not valid for this Lomse version.  */
+    static ImoDocument* load(DocModel* pModel, const char* data, size_t size);
+
+    /** Checksum used for detecting corrupted snapshots. It is the 64 bits FNV-1a
+        hash of the data, and it is also useful for keying cached snapshots.  */
+    static uint64_t hash(const char* data, size_t size, uint64_t seed=0);
+
+protected:
+    friend class SnapshotReader;
+    friend class SnapshotWriter;
+
+    static bool write_node(SnapshotWriter& a, ImoObj* pImo);
+    static ImoObj* read_node(SnapshotReader& a);
+    template<class Archive> static bool fields(Archive& a, ImoObj* pImo);
+    static void register_object(SnapshotReader& a, ImoObj* pImo);
+    static void discard_tree(SnapshotReader& a, ImoObj* pRoot);
+};
+
+
+//---------------------------------------------------------------------------------------
+/** SnapshotsCache: a side-car cache of snapshots, stored as files in a folder.
+    Each snapshot is keyed by a hash of the source file content, the file format and
+    the import options, so that any change in the source file invalidates the
+    cached snapshot.
+*/
+class SnapshotsCache
+{
+protected:
+    std::string m_path;
+    MusicXmlOptions* m_pOptions;
+
+public:
+    SnapshotsCache(const std::string& path, MusicXmlOptions* pOptions)
+        : m_path(path)
+        , m_pOptions(pOptions)
+    {
+    }
+
+    /** Add content to the uninitialized Document 'pDoc' by loading the cached snapshot
+        for file 'filename' or, when not available, by parsing the file. In this case,
+        the snapshot is saved in the cache if the file has no errors. Returns the
+        number of errors found when parsing the file.
+
+        Snapshots are saved in a temporary file that is then renamed. Thus, the
+        same cache folder can be used by several threads or processes.   */
+    int open_document(Document* pDoc, const std::string& filename, int format);
+
+protected:
+    std::string snapshot_path(const std::string& source, int format);
+    void save_snapshot(const std::string& path, const std::string& data);
+};
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_IM_SNAPSHOT_H__
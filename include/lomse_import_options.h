@@ -60,9 +60,15 @@ namespace lomse
 		<td>When %true, if an score part has pitched notes but the clef is missing,
             the importer will assume a G or an F4 clef, depending on notes pitch
             range.</td></tr>
+	<tr><td>analyse_parts_in_parallel</td>		<td>false</td>
+		<td>When %true, in partwise scores the content of each <part> element is
+            analysed in a separate thread and the results are merged in document
+            order. The resulting internal model, including ids and the numbers of
+            ties, slurs, wedges and octave shifts, is identical to the one obtained
+            in sequential analysis.</td></tr>
 	</table>
 
-	@see fix_beams(), use_default_clefs()
+	@see fix_beams(), use_default_clefs(), analyse_parts_in_parallel()
 */
 class MusicXmlOptions
 {
@@ -76,11 +82,13 @@ private:
             MusicXmlOptionsSettings()
                 : m_fFixBeams(true)
                 , m_fDefaultClef(true)
+                , m_fParallelParts(false)
             {
             }
 
             bool m_fFixBeams;
             bool m_fDefaultClef;
+            bool m_fParallelParts;
 
     };
 
@@ -100,6 +108,9 @@ public:
 	/** Returns current setting for the 'use_default_clefs' option.    */
     inline bool use_default_clefs() { return m_settings.m_fDefaultClef; }
 
+	/** Returns current setting for the 'analyse_parts_in_parallel' option.    */
+    inline bool analyse_parts_in_parallel() { return m_settings.m_fParallelParts; }
+
     //setters (only for options that can be changed without rebuilding the object)
     /** Sets the value for 'fix_beams' option. When %true, if beam information is not
         congruent with note type, the importer will fix the beam.    */
@@ -110,6 +121,12 @@ public:
         an F4 clef, depending on notes pitch range.    */
     inline void use_default_clefs(bool value) { m_settings.m_fDefaultClef = value; }
 
+    /** Sets the value for 'analyse_parts_in_parallel' option. When %true, the
+        <part> elements of partwise scores are analysed concurrently, using one
+        thread per available core. It has no effect when Lomse is built without
+        threads support.    */
+    inline void analyse_parts_in_parallel(bool value) { m_settings.m_fParallelParts = value; }
+
 };
 
 
@@ -17,7 +17,12 @@
 #include "lomse_import_options.h"
 
 
+#include <atomic>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace lomse
 {
@@ -56,6 +61,7 @@ class BitmapDrawer;
 class Task;
 class Request;
 class ScorePlayer;
+class PlaybackEngine;
 class MidiServerBase;
 class Metronome;
 class IdAssigner;
@@ -63,6 +69,7 @@ class DocCursor;
 class DocCommandExecuter;
 class CaretPositioner;
 class MusicGlyphs;
+class PageCache;
 
 //---------------------------------------------------------------------------------------
 // Trace levels for lines breaker algorithm
@@ -82,7 +89,7 @@ protected:
     LomseDoorway* m_pDoorway;
     LomseDoorway* m_pNullDoorway;
     LdpFactory* m_pLdpFactory;
-    FontStorage* m_pFontStorage;
+    std::atomic<FontStorage*> m_pFontStorage;
     FontSelector* m_pFontSelector;
     Metronome* m_pGlobalMetronome;
     EventsDispatcher* m_pDispatcher;
@@ -91,10 +98,17 @@ protected:
     std::string m_sMusicFontPath;
     std::string m_sFontsPath;
     MusicGlyphs* m_pMusicGlyphs;
+    PageCache* m_pPageCache;            //rasterized pages. nullptr when not used
+    std::recursive_mutex m_mutex;       //for lazy instantiation of shared objects
+    std::map<std::thread::id, FontStorage*> m_threadFonts;  //font engines bound to threads
+    unsigned long m_scopeId;            //unique id, for finding the font engine bound
+                                        //to current thread
+    std::vector<FontStorage*> m_freeFonts;      //font engines ready for reuse
 
     //options
     bool m_fReplaceLocalMetronome;
     MusicXmlOptions m_importOptions;
+    std::string m_sSnapshotsPath;   //folder for cached snapshots. Empty: no cache
 
     //debug options
     bool m_fJustifySystems;         //if false, prevents systems justification
@@ -128,6 +142,10 @@ public:
     EventsDispatcher* get_events_dispatcher();
     FontSelector* get_font_selector();
 
+    //threads
+    void bind_font_storage_to_this_thread();
+    void unbind_font_storage_from_this_thread();
+
     //callbacks
     void post_event(SpEventInfo pEvent);
     void post_request(Request* pRequest);
@@ -164,6 +182,13 @@ public:
     inline Metronome* get_global_metronome() { return m_pGlobalMetronome; }
     inline bool global_metronome_replaces_local() { return m_fReplaceLocalMetronome; }
     inline MusicXmlOptions* get_musicxml_options() { return &m_importOptions; }
+    inline void set_snapshots_cache_path(const std::string& path) { m_sSnapshotsPath = path; }
+    inline const std::string& get_snapshots_cache_path() { return m_sSnapshotsPath; }
+
+    //rasterized pages cache, shared by all views. Disabled (budget 0) by default.
+    //get_page_cache() returns nullptr when disabled
+    void set_page_cache_budget(size_t maxBytes);
+    PageCache* get_page_cache();
 
     //spacing and lines breaker algorithm parameters
     inline bool use_debug_values() { return m_fUseDbgValues; }
@@ -286,6 +311,7 @@ public:
 #if (LOMSE_ENABLE_THREADS == 1)
     static ScorePlayer* inject_ScorePlayer(LibraryScope& libraryScope,
                                            MidiServerBase* pSoundServer);
+    static PlaybackEngine* inject_PlaybackEngine(LibraryScope& libraryScope);
 #endif
     static DocCursor* inject_DocCursor(Document* pDoc);
     static SelectionSet* inject_SelectionSet(Document* pDoc);
@@ -18,6 +18,7 @@
 #include "lomse_document_cursor.h"
 #include "lomse_pitch.h"
 #include "lomse_drawer.h"       //for declaration of struct SvgOptions
+#include "lomse_spsc_ring.h"
 
 
 #include <iostream>
@@ -173,7 +174,10 @@ protected:
     bool        m_fViewParamsChanged;       //viewport, scale, ... have been modified
 
     //to avoid problems during playback
-    bool        m_fViewUpdatesEnabled;
+    std::atomic<bool> m_fViewUpdatesEnabled;
+
+    //playback events from the sound thread, when not posted to the application
+    SpscRing<SpEventInfo> m_playbackQueue;
 
     Handler*    m_pCurHandler;  //current handler being dragged, if any
     ImoId       m_idControlledImo;
@@ -204,12 +208,17 @@ public:
         - <b>k_timing_visual_effects_draw_time = 2</b> - elapsed time for rendering the visual effects
         - <b>k_timing_total_render_time = 3</b> - total elapsed time for renderization
         - <b>k_timing_repaint_time = 4</b> - elapsed time for repainting the view
+        - <b>k_timing_tile_cache_hits = 5</b> - when the tile cache is enabled, number of
+            tiles taken from the cache for the last renderization. It is not a time.
+        - <b>k_timing_tile_cache_misses = 6</b> - when the tile cache is enabled, number
+            of tiles that were rasterized for the last renderization. It is not a time.
         - <b>k_timing_max_value</b> - Not used as index. This value is for knowing how many items you should expect in the
             returned vector, for allocating space.
     */
     enum ETimingTarget { k_timing_gmodel_build_time=0, k_timing_gmodel_draw_time,
        k_timing_visual_effects_draw_time, k_timing_total_render_time,
-       k_timing_repaint_time, k_timing_max_value, };
+       k_timing_repaint_time, k_timing_tile_cache_hits, k_timing_tile_cache_misses,
+       k_timing_max_value, };
 
 
         //operating modes and related
@@ -344,6 +353,10 @@ public:
     /** Returns the graphic model object associated to the View of this %Interactor.   */
     GraphicModel* get_graphic_model();
 
+    /** Returns the model reference (see Document::get_model_ref()) of the Document
+        associated to this %Interactor, or -1 if the Document no longer exists.   */
+    long get_document_model_ref();
+
 
     /** Returns the View associated to this %Interactor.    */
     inline View* get_view() { return m_pView; }
@@ -549,6 +562,47 @@ public:
     */
     void set_view_background(Color color);
 
+
+    /** Enables or disables the tile cache for the View. When enabled, the view surface
+        is split into tiles of 256x256 pixels and the rasterized tiles are saved in a
+        cache. Then, redrawing the view (e.g. when scrolling) only requires to rasterize
+        the tiles not in the cache. The cached tiles are discarded when the document,
+        the scale or the rendering options change.
+
+        @param maxBytes Memory budget for the cache. When it is exceeded, the least
+            recently used tiles are discarded. Value 0 disables the cache. By default,
+            the tile cache is not used.
+
+        The number of cache hits and misses for the last renderization is available
+        by using get_elapsed_times().
+    */
+    void set_tile_cache_budget(size_t maxBytes);
+
+    /** Sets the number of threads to use for rasterizing the view and for printing.
+        When more than one, the rendering buffer is split in horizontal bands that are
+        rasterized in parallel. The result is identical to the one obtained by using
+        only one thread. It is most useful for printing at high resolutions.
+
+        @param numThreads Number of threads to use. Value 1, the default, means that
+            the calling thread does all the work. Value 0 means to use as many
+            threads as hardware cores.
+
+        This option is ignored when Lomse is built without threads support.
+    */
+    void set_rendering_threads(int numThreads);
+
+    /** Enables or disables reusing the previous frame when the view is scrolled. When
+        enabled and only the viewport origin has changed, the rendering buffer content
+        is moved by the scroll amount and only the newly exposed areas are rasterized.
+        Then, get_damaged_rectangle() will report only the exposed area. Therefore, the
+        application must also move its window content by the same amount before
+        repainting the damaged rectangle. Visual effects (caret, selection rectangle,
+        etc.) are rendered again at their new positions.
+
+        @param fEnabled Value @TRUE enables scroll blitting. By default, it is disabled.
+    */
+    void enable_scroll_blitting(bool fEnabled);
+
         //@}    //interface to GraphicView. Rendering
 
 
@@ -1042,6 +1096,19 @@ public:
         @todo Document Interactor::on_visual_tracking    */
     virtual void on_visual_tracking(SpEventVisualTracking pEvent);
 
+    /** Process all playback events (visual tracking and end of playback events)
+        queued by the ScorePlayer. It must be invoked from the user interface thread,
+        i.e. from a timer, when the player is configured for not posting these events
+        to the application (see ScorePlayer::post_tracking_events()). Returns the
+        number of events processed.
+    */
+    int process_playback_events();
+
+///@cond INTERNALS
+    //Executed in the sound thread. Returns @false if the queue is full
+    bool queue_playback_event(SpEventInfo pEvent);
+///@endcond
+
     //@}    //Visual effects during playback
 
 
@@ -1295,6 +1362,33 @@ public:
     */
     inline void svg_add_class(bool value) { m_svgOptions.add_class = value; }
 
+    /** Enable / disable drawing music glyphs as outlines instead of as text.
+
+        @param value @TRUE for writing the outline of each distinct glyph only once,
+        in a \<symbol\> element, and drawing the glyphs with \<use\> elements.
+        @FALSE for drawing each glyph as a \<text\> element.
+
+        Glyph outlines are taken from the music font. Therefore, the generated SVG
+        does not require the music font to be installed or embedded in the client,
+        and it is usually much smaller than when using \<text\> elements.
+
+        By default, glyphs are drawn as \<text\> elements.
+
+        See @subpage page-render-svg
+    */
+    inline void svg_glyphs_as_symbols(bool value) { m_svgOptions.glyphs_as_symbols = value; }
+
+    /** Set the maximum number of decimal places for numbers in the SVG code.
+
+        @param value The number of decimal places. Trailing zeros are not written.
+        A value of -1 means the default format: six significant digits.
+
+        Reducing precision produces smaller SVG code. By default, value is -1.
+
+        See @subpage page-render-svg
+    */
+    inline void svg_precision(int value) { m_svgOptions.precision = value; }
+
     //@}    //interface to GraphicView. SVG drawing
 
 
@@ -1753,6 +1847,7 @@ public:
     void timing_graphic_model_render_end();
     void timing_visual_effects_start();
     void timing_renderization_end();
+    void timing_tile_cache_counters(long numHits, long numMisses);
 
     //interface to SelectionSet
     virtual void select_object(GmoObj* pGmo, bool fClearSelection=true);
@@ -1799,6 +1894,7 @@ protected:
 
     void create_graphic_model();
     void delete_graphic_model();
+    void discard_cached_pages();
     bool graphic_model_must_be_updated();
     void request_window_update();
     VRect get_damaged_rectangle();
@@ -1815,7 +1911,7 @@ protected:
     ImoObj* find_event_originator_imo(GmoObj* pGmo);
     GmoRef find_event_originator_gref(GmoObj* pGmo);
     bool discard_visual_tracking_event_if_not_valid(ImoId scoreId);
-    bool is_valid_play_score_event(SpEventPlayCtrl pEvent);
+    bool is_valid_play_score_event(SpEventEndOfPlayback pEvent);
     void update_caret_and_view();
     void redraw_caret();
     void send_update_UI_event(EEventType type);
@@ -17,6 +17,7 @@
 #include <iomanip>
 #include <fstream>
 #include <string>
+#include <mutex>
 using namespace std;
 
 namespace lomse
@@ -66,6 +67,7 @@ private:
     int m_mode;
     uint_least32_t m_areas;
     bool m_initialized = false;
+    std::mutex m_mutex;         //messages can be logged from several threads
 
 public:
     Logger(int mode=k_normal_mode);
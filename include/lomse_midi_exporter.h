@@ -0,0 +1,137 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE__MIDI_EXPORTER_H__        //to avoid nested includes
+#define __LOMSE__MIDI_EXPORTER_H__
+
+#include "lomse_basic.h"
+#include "lomse_internal_model.h"
+
+#include <string>
+#include <vector>
+#include <map>
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//forward declarations
+class SoundEventsTable;
+
+
+//---------------------------------------------------------------------------------------
+/** %MidiExporter is responsible for generating a Standard MIDI File (SMF) for an
+    score. The file is generated directly from the score SoundEventsTable, without
+    playing it back, so the generation is fast and does not need a MIDI server or
+    threads. The generated file:
+    - is a type 1 SMF, with a first track for tempo and time signatures and one track
+      for each MIDI channel used by the score instruments.
+    - has all repetitions (repeat barlines, volta brackets, Da Capo, Dal Segno, etc.)
+      unrolled, following the same rules that ScorePlayer uses for playback.
+    - follows the tempo changes in the score (sound tempo attributes and metronome
+      marks), unless a fixed tempo is set with set_tempo().
+
+    Example:
+
+    @code
+        MidiExporter exporter;
+        exporter.set_tempo(90);
+        if (!exporter.save_smf(score, path + "score.mid"))
+            std::cout << "file error write" << endl;
+    @endcode
+
+*/
+class MidiExporter
+{
+protected:
+    long m_nMM;                 //metronome speed, in beats per minute. 0: score tempo
+    TimeUnits m_beatDuration;   //beat duration for metronome speed
+    int m_division;             //SMF ticks per quarter note
+
+    //one track per channel
+    std::vector< std::vector<unsigned char> > m_tracks;
+    std::map<int, int> m_channelTrack;      //channel -> index to m_tracks
+    std::vector<long> m_trackTime;          //time of last event in each track, in ticks
+    std::vector<int> m_runningStatus;       //last status byte in each track
+
+public:
+    /** Constructor */
+    MidiExporter();
+    /** Destructor */
+    virtual ~MidiExporter() {}
+
+    //main methods for generating the SMF
+    /** @name Main methods for generating the SMF    */
+    //@{
+
+    /** Generate the SMF for the score passed as argument and return its content.
+        It will be empty if the score is not valid.
+        @param score  The score to export.
+    */
+    std::string get_smf(AScore score);
+
+    /** Generate the SMF for the score passed as argument and save it in the given
+        file. Returns @FALSE if the file could not be written.
+        @param score  The score to export.
+        @param filename  Full path of the file to create. If it exists, it is replaced.
+    */
+    bool save_smf(AScore score, const std::string& filename);
+
+    //@}    //main methods
+
+
+    /** @name Options    */
+    //@{
+
+    /** Set a fixed tempo for the generated SMF, replacing the tempo changes in the
+        score. The meaning of parameters is the same than for the metronome in the
+        ScorePlayer play methods.
+        @param nMM  Metronome speed, in beats per minute. Default value is 0, meaning
+            that the tempo marked in the score will be used (60 quarter notes per
+            minute if the score does not specify a tempo).
+        @param beatDuration  Duration of the beat, in Lomse TimeUnits.
+            Default value is k_duration_quarter.
+    */
+    inline void set_tempo(long nMM, TimeUnits beatDuration=k_duration_quarter)
+    {
+        m_nMM = nMM;
+        m_beatDuration = beatDuration;
+    }
+
+    //@}    //options
+
+///@cond INTERNALS
+//excluded from public API. Only for internal use.
+
+    std::string get_smf(ImoScore* pScore);
+
+///@endcond
+
+protected:
+    void create_tracks(SoundEventsTable* pTable);
+    void add_events(SoundEventsTable* pTable);
+    int track_for_channel(int channel);
+    std::string build_smf();
+    long time_to_ticks(long deltaTime);
+
+    void add_channel_event(int iTrack, long ticks, int status, int data1, int data2);
+    void add_meta_event(int iTrack, long ticks, int type,
+                        const unsigned char* data, int size);
+    void add_tempo(long ticks, float qpm);
+    void add_time_signature(long ticks, int top, int beatDuration, int numPulses);
+    void add_delta_time(int iTrack, long ticks);
+    void add_variable_length(std::vector<unsigned char>& track, unsigned long value);
+
+};
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE__MIDI_EXPORTER_H__
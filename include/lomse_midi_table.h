@@ -15,6 +15,8 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <atomic>
 
 
 namespace lomse
@@ -29,8 +31,11 @@ class ImoTimeSignature;
 class ImoNote;
 class ImoTranspose;
 class StaffObjsCursor;
+class ColStaffObjsEntry;
 class SoundEvent;
 class SoundEventsTable;
+class PlaybackTimeline;
+class TempoMap;
 
 //---------------------------------------------------------------------------------------
 //JumpsEntry: An entry in the JumpsTable. It describes a jump in playback.
@@ -69,6 +74,7 @@ public:
     inline void set_times_before(int times) { m_timesBefore = times; }
     inline void increment_visited() { ++m_visited; }
     inline void set_label(const std::string& label) { m_label = label; }
+    inline void set_state(int executed, int visited) { m_executed = executed; m_visited = visited; }
 
 
     //debug
@@ -195,6 +201,17 @@ protected:
     std::vector< std::pair<int, std::string> > m_targets;          //pair measure, label
     TimeUnits m_rAnacrusisMissingTime;
     TimeUnits m_rAnacrusisExtraTime;
+    PlaybackTimeline* m_pTimeline;
+    std::vector< std::pair<TimeUnits, float> > m_tempoChanges;  //timepos, tempo (qpm)
+    TempoMap* m_pTempoMap;
+
+    //information for updating the table when the score is modified
+    bool m_fModified;
+    size_t m_globalSignature;           //instruments and anacrusis
+    std::vector<size_t> m_signatures;   //for each measure, signature of its staffobjs
+    std::vector<bool> m_structural;     //for each measure, true if it affects others
+    int m_numUpdated;                   //measures rebuilt in last update, -1 if all
+    std::atomic<int> m_numUsers;        //players and sessions using the table
 
 
 public:
@@ -203,6 +220,18 @@ public:
 
     void create_table();
 
+    //updating the table after score edition
+    inline void set_modified() { m_fModified = true; }
+    inline bool is_modified() { return m_fModified; }
+    void update_table();
+    inline int num_updated_measures() { return m_numUpdated; }
+
+    //players and sessions using the table. A table in use is never updated: when the
+    //score is modified a new table is created, and this one is kept until no longer used
+    inline void add_user() { ++m_numUsers; }
+    inline void remove_user() { --m_numUsers; }
+    inline bool is_in_use() { return m_numUsers > 0; }
+
     inline int num_events() { return int(m_events.size()); }
     std::vector<SoundEvent*>& get_events() { return m_events; }
     std::vector<int>& get_channels() { return m_channels; }
@@ -220,6 +249,15 @@ public:
     //to create systems jumps
     std::vector<MeasuresJumpsEntry*> get_measures_jumps();
 
+    //measures in playback order, with repetitions unrolled
+    PlaybackTimeline* get_timeline();
+
+    //tempo changes in the score and time for each event
+    inline std::vector< std::pair<TimeUnits, float> >& get_tempo_changes() {
+        return m_tempoChanges;
+    }
+    TempoMap* get_tempo_map();
+
     //debug
     std::string dump_midi_events();
 
@@ -232,6 +270,8 @@ protected:
     void create_events();
     void close_table();
     void sort_by_time();
+    void sort_by_time(std::vector<SoundEvent*>& events);
+    static bool is_before(SoundEvent* pEv1, SoundEvent* pEv2);
     void create_measures_table();
     void save_transposition_information(StaffObjsCursor& cursor, int iInstr, ImoTranspose* pTrp);
     void add_jumps_if_volta_bracket(StaffObjsCursor& cursor, ImoBarline* pBar,
@@ -245,10 +285,18 @@ protected:
     void delete_events_table();
     void delete_jumps_table();
     void delete_measures_jumps_table();
+    void clear_table();
+    size_t compute_signatures(std::vector<size_t>& signatures,
+                              std::vector<bool>& structural);
+    size_t compute_signature(ColStaffObjsEntry* pEntry);
+    bool is_structural(ImoStaffObj* pSO);
+    void replace_events_for_measures(const std::vector<bool>& modified);
     int compute_volume(TimeUnits timePos, ImoTimeSignature* pTS, TimeUnits timeShift);
     JumpEntry* create_jump(int inMeasure, int jumpTo, int timesValid, int timesBefore=0);
     void process_sound_change(ImoSoundChange* pSound, StaffObjsCursor& cursor,
                               int channel, int iInstr, int measure);
+    void add_tempo_change(TimeUnits rTime, float qpm);
+    void add_tempo_change_if_metronome_mark(ImoStaffObj* pSO);
 
 
     //debug
@@ -257,6 +305,123 @@ protected:
 };
 
 
+//---------------------------------------------------------------------------------------
+//PlaybackSegment: An entry in the PlaybackTimeline. It describes a pass through a
+//measure during playback
+struct PlaybackSegment
+{
+    int measure;        //number of the measure (1..n)
+    int pass;           //1 for the first time the measure is played, 2 for the second...
+    int event;          //index to the first event of the measure
+    long timepos;       //start time, in TU, as in the events table
+    long time;          //start time, in TU, from the start of playback
+    std::vector< std::pair<int, int> > jumps;   //jumps state at start: executed, visited
+
+    PlaybackSegment(int nMeasure, int nPass, int iEvent, long nTimepos, long nTime)
+        : measure(nMeasure), pass(nPass), event(iEvent), timepos(nTimepos), time(nTime)
+    {
+    }
+};
+
+//---------------------------------------------------------------------------------------
+//Class PlaybackTimeline is the list of measures in playback order, with all repetitions
+//unrolled. It is built by traversing the events table as ScorePlayer does and allows to
+//start playback at any pass through a measure, or at any time, without playing back
+//previous measures.
+class PlaybackTimeline
+{
+protected:
+    SoundEventsTable* m_pTable;
+    std::vector<PlaybackSegment> m_segments;
+    std::vector< std::vector<int> > m_passes;   //for each measure, its segments
+    long m_duration;                            //total duration, in TU
+
+public:
+    PlaybackTimeline(SoundEventsTable* pTable);
+    virtual ~PlaybackTimeline() {}
+
+    inline int num_segments() { return int(m_segments.size()); }
+    inline PlaybackSegment& get_segment(int i) { return m_segments[i]; }
+    inline long get_duration() { return m_duration; }
+
+    //searching segments. Return -1 if not found
+    int find_segment_at(long time);
+    int find_segment(int measure, int pass=1);
+    int num_passes(int measure);
+
+    //prepare the jumps table for starting playback at the given segment
+    void restore_jumps(int iSegment);
+
+    //debug
+    std::string dump_timeline();
+
+protected:
+    void create_segments();
+};
+
+
+//---------------------------------------------------------------------------------------
+//Class TempoMap gives the absolute time, in microseconds, for any timepos in the score
+//and for each event in the SoundEventsTable. It takes into account the tempo changes in
+//the score (sound tempo attribute and metronome marks) and an optional global
+//tempo that overrides them.
+//Times are measured from the start of the score, without repetitions. For unrolled
+//repetitions use get_duration() on each PlaybackTimeline segment.
+//The tempo map is a list of breakpoints, one for each tempo change in the score. When
+//the tempo is modified (set_base_tempo(), set_tempo_override()) only the breakpoints
+//are recomputed, as each event keeps the index of the breakpoint it belongs to.
+//Tempo is expressed in quarter notes per minute (qpm).
+class TempoMap
+{
+protected:
+    struct Breakpoint
+    {
+        TimeUnits timepos;      //start of this tempo segment
+        float scoreTempo;       //tempo in the score, qpm
+        double usPerTU;         //tempo in use, as microseconds per time unit
+        double us;              //time at start of this segment
+    };
+
+    SoundEventsTable* m_pTable;
+    std::vector<Breakpoint> m_breakpoints;
+    std::vector<int> m_eventBreakpoint;     //for each event, index to its breakpoint
+    float m_baseTempo;          //tempo before first tempo change, qpm
+    float m_overrideTempo;      //if not 0, tempo to use instead of score tempo, qpm
+
+public:
+    TempoMap(SoundEventsTable* pTable);
+    virtual ~TempoMap() {}
+
+    //global tempo. Each change recomputes the map in O(number of tempo changes)
+    void set_base_tempo(float qpm);
+    void set_tempo_override(float qpm);
+    inline float get_base_tempo() { return m_baseTempo; }
+    inline float get_tempo_override() { return m_overrideTempo; }
+
+    //info
+    inline int num_breakpoints() { return int(m_breakpoints.size()); }
+    inline TimeUnits get_breakpoint_timepos(int i) { return m_breakpoints[i].timepos; }
+    float get_breakpoint_tempo(int i);
+    float get_breakpoint_score_tempo(int i);
+    float get_tempo_at(TimeUnits timepos);
+    int find_breakpoint(TimeUnits timepos);
+
+    //time, in microseconds from start of score
+    uint64_t get_event_time(int iEvent);
+    uint64_t get_time_for(TimeUnits timepos);
+    uint64_t get_duration(TimeUnits fromTimepos, TimeUnits toTimepos);
+    TimeUnits get_timepos_for(uint64_t us);
+
+    //debug
+    std::string dump_tempo_map();
+
+protected:
+    void create_breakpoints();
+    void compute_times();
+    double time_at(int iBreakpoint, TimeUnits timepos);
+};
+
+
 }   //namespace lomse
 
 #endif  // __LOMSE_MIDI_TABLE_H__
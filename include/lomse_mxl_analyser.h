@@ -179,6 +179,7 @@ public:
     int get_num_items() { return static_cast<int>(m_locators.size()); }
     int add_score_part(const std::string& id, ImoInstrument* pInstrument);
     ImoInstrument* get_instrument(const std::string& id);
+    ImoInstrument* get_next_instrument(ImoInstrument* pInstr);
     bool mark_part_as_added(const std::string& id);
     void add_all_instruments(ImoScore* pScore);
     void check_if_missing_parts(ostream& reporter);
@@ -373,6 +374,15 @@ protected:
     //conversion from xml element name to int
     std::map<std::string, int> m_NameToEnum;
 
+    //partwise scores: <part> elements whose content analysis is deferred for
+    //being analysed in parallel
+    std::vector<XmlNode>        m_deferredParts;
+    std::vector<ImoInstrument*> m_deferredInstrs;
+    bool                        m_fPartAnalyser = false;    //analyser for only one <part>
+    LUnits                      m_lyricsSpaceForNextPart = 0.0f;    //to be reserved
+                                                            //in next instrument
+    bool                        m_fFirstStaffMarginReset = false;
+
 public:
     MxlAnalyser(ostream& reporter, LibraryScope& libraryScope, Document* pDoc,
                 XmlParser* parser);
@@ -399,6 +409,13 @@ public:
     }
     void check_if_missing_parts() { m_partList.check_if_missing_parts(m_reporter); }
 
+    //parallel analysis of <part> elements
+    bool analyse_parts_in_parallel();
+    inline bool is_part_analyser() { return m_fPartAnalyser; }
+    void defer_part_analysis(const XmlNode& part, ImoInstrument* pInstr);
+    void analyse_deferred_parts();
+    inline void first_staff_margin_reset() { m_fFirstStaffMarginReset = true; }
+
     //part-group
     ImoInstrGroup* start_part_group(int number);
     void terminate_part_group(int number);
@@ -519,7 +536,7 @@ public:
     void clear_pending_relations();
 
     //interface for building beams
-    inline bool fix_beams() { return m_libraryScope.get_musicxml_options()->fix_beams(); }
+    bool fix_beams();
 
     //interface for building dynamics marks
     void add_pending_dynamics_mark(ImoDynamicsMark* pObj) { m_pendingDynamicsMarks.push_back(pObj); }
@@ -589,7 +606,11 @@ public:
 
 protected:
     MxlElementAnalyser* new_analyser(const std::string& name, ImoObj* pAnchor=nullptr);
+    void create_relation_builders();
     void delete_relation_builders();
+    void prepare_as_part_analyser(MxlAnalyser* pParent, ImoInstrument* pInstr);
+    void renumber_relations(ImoInstrument* pInstr, MxlAnalyser* pPartAnalyser);
+    std::map<int, int> merge_slur_ids(MxlAnalyser* pPartAnalyser);
     void add_marging_space_for_lyrics(ImoNote* pNote, ImoLyric* pLyric);
     void add_pending_staffobjs(int voice);
 };
@@ -16,6 +16,8 @@
 
 //other
 #include <iostream>
+#include <map>
+#include <vector>
 using namespace std;
 
 
@@ -46,6 +48,8 @@ protected:
     int8u* m_pSaveBytes;                //the real buffer for the clean copy
     URect m_damagedRect;
     URect m_prevDamagedRect;
+    std::map<VisualEffect*, VRect> m_drawnAreas;    //pixels modified by each effect
+    std::vector<VRect> m_removedAreas;      //pixels modified by removed effects
     GmoObj* m_pHandlersOwner;           //object owning current defined handlers
 
 public:
@@ -57,17 +61,25 @@ public:
     void update_visual_effect(VisualEffect* pEffect, BitmapDrawer* pDrawer);
     void set_rendering_buffer(unsigned char* buf, unsigned width, unsigned height);
     void on_new_background();
+    void on_scrolled_background();
+    void restore_background();
     void add_visual_effect(VisualEffect* pEffect);
     void remove_visual_effect(VisualEffect* pEffect);
 
     //info
     URect get_damaged_rectangle();
+    inline bool is_full_rectangle_damaged() { return m_fFullRectangle; }
     inline void set_handlers_owner(GmoObj* pGmo) { m_pHandlersOwner = pGmo; }
     inline GmoObj* get_handlers_owner() { return m_pHandlersOwner; }
 
 protected:
     void save_rendering_buffer();
     void expand_damaged_rectangle();
+    void restore_area(const VRect& area);
+    void restore_drawn_areas();
+    void draw_effect(VisualEffect* pEffect, BitmapDrawer* pDrawer);
+    void refresh_area(const VRect& area, VisualEffect* pExclude, BitmapDrawer* pDrawer);
+    bool can_update_only(VisualEffect* pEffect);
 
 
 };
@@ -0,0 +1,143 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_PAGE_CACHE_H__        //to avoid nested includes
+#define __LOMSE_PAGE_CACHE_H__
+
+#include "lomse_basic.h"
+#include "lomse_agg_types.h"        //RenderingBuffer
+#include "lomse_drawer.h"           //RenderOptions
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <set>
+#include <vector>
+
+
+namespace lomse
+{
+
+//forward declarations
+class BitmapDrawer;
+
+//---------------------------------------------------------------------------------------
+// PageKey: identifies a rasterized page. Two views of the same document, with the
+// same layout constrains, produce the same pages. The page bounds (in LUnits) are
+// included as they determine the position of the page pixels.
+struct PageKey
+{
+    long docModelRef;       //DocModel::get_model_ref(), unique for each document model
+    long gmodelId;          //-1 when the graphic model was never modified, as it is
+                            //then the same layout in all views of the document model,
+                            //and pages can be shared. Otherwise, GraphicModel id
+    long gmodelVersion;
+    int layoutConstrains;
+    int iPage;
+    URect bounds;
+    double scale;
+    int pixelFormat;
+    RenderOptions options;
+
+    bool operator==(const PageKey& key) const;
+};
+
+//---------------------------------------------------------------------------------------
+// PageRaster: a rasterized page. The bitmap covers canvas pixels [x, x+width) and
+// [y, y+height), where canvas is the document rendered at the given scale, with
+// origin at the model origin. When the page is not displayed in any view the bitmap
+// is compressed. While the page is being rasterized it has no pixels.
+struct PageRaster
+{
+    PageKey key;
+    Pixels x;
+    Pixels y;
+    Pixels width;
+    Pixels height;
+    std::vector<unsigned char> pixels;      //raw or compressed pixels
+    bool fCompressed;
+    bool fRendering;                        //being rasterized, without lock
+    std::set<const void*> viewers;          //views displaying this page
+
+    PageRaster(const PageKey& k) : key(k), x(0), y(0), width(0), height(0)
+                                 , fCompressed(false), fRendering(false) {}
+};
+
+//---------------------------------------------------------------------------------------
+// PageCache: rasterized pages shared by all views. Pages are discarded when the
+// document is modified (see invalidate()) and, when the memory budget is exceeded,
+// least recently used pages are discarded. All methods are thread safe.
+class PageCache
+{
+protected:
+    int m_bytesPerPixel;
+    size_t m_maxBytes;
+    size_t m_usedBytes;
+    std::list<PageRaster*> m_pages;     //most recently used first
+    std::mutex m_mutex;
+    std::condition_variable m_rendered;     //a page being rasterized is finished
+
+    //statistics
+    long m_numHits;
+    long m_numMisses;
+
+public:
+    PageCache(int bytesPerPixel, size_t maxBytes);
+    ~PageCache();
+
+    //settings
+    void set_max_bytes(size_t maxBytes);
+    inline size_t get_max_bytes() const { return m_maxBytes; }
+
+    //Copy the page onto the drawer rendering buffer, at position (xDest, yDest) of
+    //the view area. When the page is not cached, it is rasterized by invoking
+    //'render', that must draw the page on the received rendering buffer, using
+    //canvas pixels [x, x+width) and [y, y+height) given by 'area'. The page is
+    //marked as displayed in 'viewer'. Pages are rasterized without lock, so that
+    //views and bands can rasterize different pages in parallel. Threads requesting
+    //a page being rasterized wait for it.
+    void draw_page(const PageKey& key, const VRect& area, const void* viewer,
+                   BitmapDrawer* pDrawer, Pixels xDest, Pixels yDest,
+                   std::function<void(RenderingBuffer&)> render);
+
+    //Pages displayed by a view. At frame start all pages are marked as not displayed
+    //in the view, and at frame end pages no longer displayed in any view are
+    //compressed
+    void start_frame(const void* viewer);
+    void end_frame(const void* viewer);
+
+    //Discard the pages for a document, or all pages
+    void invalidate(long docModelRef);
+    void invalidate();
+
+    //statistics
+    long get_num_hits();
+    long get_num_misses();
+    void reset_counters();
+    size_t get_used_bytes();
+    int get_num_pages();
+    int get_num_compressed_pages();
+
+protected:
+    PageRaster* find_page(const PageKey& key);
+    PageRaster* find_or_wait(const PageKey& key, std::unique_lock<std::mutex>& lock);
+    void discard_pages(PageRaster* pKeep);
+    void delete_page(std::list<PageRaster*>::iterator it);
+    void compress(PageRaster* pPage);
+    void decompress(PageRaster* pPage);
+    inline size_t raw_bytes(PageRaster* pPage) const {
+        return size_t(pPage->width) * size_t(pPage->height) * size_t(m_bytesPerPixel);
+    }
+};
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_PAGE_CACHE_H__
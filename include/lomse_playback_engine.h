@@ -0,0 +1,276 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_PLAYBACK_ENGINE_H__
+#define __LOMSE_PLAYBACK_ENGINE_H__
+
+#if (LOMSE_ENABLE_THREADS == 1)
+
+#include "lomse_basic.h"
+#include "lomse_internal_model.h"
+#include "lomse_score_player.h"
+
+#include <vector>
+#include <map>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//forward declarations
+class ImoScore;
+class LibraryScope;
+class SoundEventsTable;
+class JumpEntry;
+class PlaybackEngine;
+
+
+//---------------------------------------------------------------------------------------
+/** %PlaybackSession represents the playback of one score, driven by a PlaybackEngine.
+    It is the equivalent of a ScorePlayer without visual tracking, metronome clicks and
+    count-off, for applications that have to play back many scores simultaneously,
+    such as a server. Sessions are created by invoking
+    PlaybackEngine::create_session().
+
+    As in ScorePlayer, all sound requests are sent to the MidiServerBase object
+    associated to the session, and all requests for the same time are delivered in a
+    single invocation of MidiServerBase::process_events(). Sound requests are
+    invoked from the PlaybackEngine thread, except MidiServerBase::all_sounds_off(),
+    that is invoked from the thread stopping or pausing the playback once the engine
+    has finished delivering the requests already collected. The engine lock is never
+    held while invoking the MidiServerBase object, so it can invoke any method of the
+    session.
+
+    Several sessions can play back the same score simultaneously, as the playback state
+    (current position, repetitions already played, tempo) is kept by each session.
+    The score can be modified while sessions are playing it, as the sound events
+    table used by a session is never modified: a new table is created for the modified
+    score. Changes are taken into account after invoking update_table(), when playback
+    is started again.
+*/
+class PlaybackSession
+{
+protected:
+    PlaybackEngine* m_pEngine;
+    ImoScore* m_pScore;
+    SoundEventsTable* m_pTable;
+    SoundEventsTable* m_pNewTable;  //updated table, for next playback
+    MidiServerBase* m_pMidi;
+
+    enum EState { k_stopped=0, k_playing, k_paused, };
+    int m_state;
+    unsigned m_generation;      //to discard obsolete entries in the engine queue
+
+    //segment to play and current position
+    int m_iEvent;               //next event to process
+    int m_iEnd;                 //last event to play
+    long m_shift;               //TU to add to event times, due to executed jumps
+    std::vector< std::pair<int, int> > m_jumps;     //for each jump: executed, visited
+    std::map<JumpEntry*, int> m_jumpIndex;          //jump -> index in m_jumps
+
+    //tempo and time reference: at wall time m_anchor playback was at m_anchorTU
+    //(score time, with repetitions unrolled) and m_anchorMs (playback time)
+    long m_nMM;
+    double m_msPerTU;
+    std::chrono::steady_clock::time_point m_anchor;
+    double m_anchorTU;
+    double m_anchorMs;
+
+    std::vector<MidiEvent> m_midiEvents;    //requests for current time
+
+    //end of playback callback
+    void* m_pCallbackObj;
+    void (*m_pCallback)(void*, PlaybackSession*);
+
+    friend class PlaybackEngine;
+    PlaybackSession(PlaybackEngine* pEngine, ImoScore* pScore, SoundEventsTable* pTable,
+                    MidiServerBase* pMidi);
+
+public:
+    virtual ~PlaybackSession();
+
+    /** @name Methods to control playback
+        All these methods can be invoked from any thread. When the session is
+        playing, invoking a play method stops current playback and starts the new one.
+    */
+    //@{
+
+    /** Play all the score.
+        @param nMM Tempo speed for playback, in quarter notes per minute.
+    */
+    void play(long nMM=60);
+
+    /** Play back @c numMeasures measures, starting in measure @c startMeasure
+        (1 .. num_measures). */
+    void play_measures(int startMeasure, int numMeasures, long nMM=60);
+
+    /** Play from measure @c startMeasure (1 .. num_measures) to the end of the score. */
+    void play_from_measure(int startMeasure, long nMM=60);
+
+    /** Pause/resume current playback. The first invocation of this method pauses the
+        playback. To resume it you must invoke this method again. */
+    void pause();
+
+    /** Stop current playback. */
+    void stop();
+
+    /** Change the tempo. If the session is playing, the new tempo is applied from the
+        current position. */
+    void set_tempo(long nMM);
+
+    //@}
+
+    /** Set the function to invoke when playback reaches the end of the segment to
+        play. It is invoked from the PlaybackEngine thread, and it can invoke any
+        method of the session or of the engine, i.e. for starting a new playback. It is
+        not invoked when playback is stopped by invoking stop(). When the session is
+        deleted from other thread, PlaybackEngine::delete_session() waits until the
+        callback for this session returns.
+    */
+    void set_end_of_playback_callback(void* pThis,
+                                      void (*pt2Func)(void*, PlaybackSession*));
+
+    /** Take into account the modifications in the score. The sound events table is
+        updated from the score, so this method must be invoked from the thread
+        modifying the score. The new table is used when playback is started again.
+    */
+    void update_table();
+
+    //info
+    bool is_playing();
+    bool is_paused();
+    inline ImoScore* get_score() { return m_pScore; }
+    inline MidiServerBase* get_midi_server() { return m_pMidi; }
+    inline long get_tempo() { return m_nMM; }
+
+protected:
+    //all these methods require engine lock
+    void refresh_table();
+    void do_play_measures(int startMeasure, int numMeasures, long nMM);
+    void do_play(int iStart, int iEnd, long nMM);
+    bool do_stop();
+    void stop_and_silence(std::unique_lock<std::mutex>& lock);
+    void set_speed(long nMM);
+    void reanchor(std::chrono::steady_clock::time_point now);
+    double current_tu(std::chrono::steady_clock::time_point now);
+    std::chrono::steady_clock::time_point time_for(double tu);
+    bool process(std::chrono::steady_clock::time_point now);
+    void flush_midi_events(double tu);
+    void queue_midi_event(int type, int channel, int data1, int data2=0);
+};
+
+
+//---------------------------------------------------------------------------------------
+/** %PlaybackEngine is responsible for playing back many scores simultaneously by using
+    a single thread. Each score playback is represented by a PlaybackSession object.
+
+    Instead of using one thread per playback, that would be sleeping most of the time,
+    the engine thread keeps a priority queue with the time for the next event of each
+    playing session. It sleeps until the earliest time, processes the events due in
+    that session and schedules its next event.
+
+    The %PlaybackEngine constructor is protected. To create a %PlaybackEngine object
+    your application will have to request it to Lomse by invoking
+    LomseDoorway::create_playback_engine(). Your application owns the returned object
+    and must delete it when no longer needed:
+
+    @code
+        PlaybackEngine* pEngine = pLomse->create_playback_engine();
+        PlaybackSession* pSession = pEngine->create_session(score, pMidi);
+        pSession->play(90);
+        ...
+        delete pEngine;     //deletes also all sessions
+    @endcode
+*/
+class PlaybackEngine
+{
+protected:
+    struct ScheduledEvent
+    {
+        std::chrono::steady_clock::time_point time;
+        PlaybackSession* pSession;
+        unsigned generation;
+
+        bool operator>(const ScheduledEvent& other) const { return time > other.time; }
+    };
+
+    //sound requests collected with lock, to be delivered without it
+    struct MidiRequest
+    {
+        MidiServerBase* pMidi;
+        double ms;
+        std::vector<MidiEvent> events;
+    };
+
+    LibraryScope& m_libScope;
+    std::vector<PlaybackSession*> m_sessions;
+    std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>,
+                        std::greater<ScheduledEvent> > m_queue;
+    std::mutex m_mutex;                 //protects sessions and queue
+    std::condition_variable m_wakeUp;   //new scheduled event or end of thread
+    std::condition_variable m_delivered;    //collected requests delivered
+    std::condition_variable m_notified;     //end of playback callback returned
+    std::vector<MidiRequest> m_requests;
+    std::vector<PlaybackSession*> m_finished;   //pending end of playback callbacks
+    std::thread m_thread;
+    bool m_fStop;
+    bool m_fDelivering;
+    PlaybackSession* m_pNotifying;      //session whose callback is running
+
+    friend class Injector;
+    friend class PlaybackSession;
+    PlaybackEngine(LibraryScope& libScope);
+
+public:
+    /** Destructor. All playbacks are stopped and all sessions are deleted. */
+    virtual ~PlaybackEngine();
+
+    /** Create a new session for playing back the given score. Sound requests will be
+        sent to the given MidiServerBase object. The session is owned by the engine.
+        As PlaybackSession::update_table(), this method must be invoked from the thread
+        modifying the score.
+    */
+    PlaybackSession* create_session(AScore score, MidiServerBase* pMidi);
+
+    /** Stop playback and delete the session. */
+    void delete_session(PlaybackSession* pSession);
+
+    //info
+    int num_sessions();
+    int num_playing_sessions();
+
+///@cond INTERNALS
+//excluded from public API. Only for internal use.
+
+    PlaybackSession* create_session(ImoScore* pScore, MidiServerBase* pMidi);
+
+///@endcond
+
+protected:
+    void schedule(PlaybackSession* pSession);    //requires lock
+    void wait_for_delivery(std::unique_lock<std::mutex>& lock);
+    void wait_for_callback(PlaybackSession* pSession, std::unique_lock<std::mutex>& lock);
+    void deliver_requests(std::unique_lock<std::mutex>& lock);
+    void notify_end_of_playback(std::unique_lock<std::mutex>& lock);
+    void thread_main();
+
+};
+
+
+}   //namespace lomse
+
+#endif  //LOMSE_ENABLE_THREADS == 1
+
+#endif  //__LOMSE_PLAYBACK_ENGINE_H__
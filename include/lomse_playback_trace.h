@@ -0,0 +1,156 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_PLAYBACK_TRACE_H__
+#define __LOMSE_PLAYBACK_TRACE_H__
+
+#include "lomse_spsc_ring.h"
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+///@cond INTERNALS
+namespace lomse
+{
+///@endcond
+
+//---------------------------------------------------------------------------------------
+/** %PlaybackTraceRecord describes an action of the sound thread during playback. All
+    times are in microseconds since the start of playback. Scheduled times are
+    playback times, and actual times are measured excluding the time in which
+    playback was paused, so that both can be compared.
+*/
+struct PlaybackTraceRecord
+{
+    /** Types of actions */
+    enum ETraceRecord
+    {
+        k_midi_batch = 0,   ///< invocation of MidiServerBase::process_events()
+        k_tracking_post,    ///< posting or queueing a visual tracking event
+        k_wake_up,          ///< sound thread waking up for the next event time
+        k_pause,            ///< playback paused
+        k_resume,           ///< playback resumed. Duration is the time paused
+        k_max_record,
+    };
+
+    int type;               ///< Type of action, from ETraceRecord
+    int64_t scheduledUs;    ///< Time at which the action should take place
+    int64_t actualUs;       ///< Time at which the action started
+    int64_t durationUs;     ///< Time consumed by the action
+    int numItems;           ///< Sound requests in the batch, or items in tracking event
+    int numNoteOn;          ///< Note-on requests in the batch, for k_midi_batch
+
+    PlaybackTraceRecord()
+        : type(k_midi_batch), scheduledUs(0), actualUs(0), durationUs(0)
+        , numItems(0), numNoteOn(0)
+    {
+    }
+
+    /** Positive when the action started later than scheduled */
+    inline int64_t lateness() const { return actualUs - scheduledUs; }
+};
+
+
+//---------------------------------------------------------------------------------------
+/** %PlaybackTrace collects timing information about ScorePlayer playback: how late
+    each group of sound requests was sent relative to its scheduled time, how long
+    your MidiServerBase::process_events() implementation took, and how long posting
+    visual tracking events took. It is intended for analysing timing problems.
+
+    Records are written by the sound thread in a lock-free buffer with fixed
+    capacity, and are moved to the trace by invoking collect() from any other
+    thread. If the buffer is full records are discarded (see num_dropped()), so
+    for long playbacks collect() should be invoked periodically (i.e. from a timer).
+
+    The collected records can be exported as a summary with histograms
+    (dump_summary()) or in the Chrome trace event format (write_chrome_trace()),
+    that can be loaded in chrome://tracing or https://ui.perfetto.dev for
+    offline analysis.
+
+    See ScorePlayer::enable_trace().
+*/
+class PlaybackTrace
+{
+protected:
+    SpscRing<PlaybackTraceRecord> m_buffer;
+    std::atomic<int> m_numDropped;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::duration m_paused;   //total time paused
+    std::chrono::steady_clock::time_point m_pauseStart;
+    bool m_fPaused;
+    std::vector<PlaybackTraceRecord> m_records;     //collected records
+
+public:
+    PlaybackTrace(size_t capacity=4096);
+    virtual ~PlaybackTrace() {}
+
+    /** @name Methods for the sound thread */
+    //@{
+    /** Set the start of playback time. Times in records are relative to it.
+        ScorePlayer invokes it when playback starts. */
+    void start();
+
+    /** Current time, in microseconds since the start of playback, excluding the
+        time in which playback was paused. */
+    int64_t now_us();
+
+    /** Playback has been paused at playback time @c scheduledUs. Time is stopped
+        until resume() is invoked. */
+    void pause(int64_t scheduledUs);
+
+    /** Playback is resumed at playback time @c scheduledUs. */
+    void resume(int64_t scheduledUs);
+
+    /** Save a record. */
+    void add_record(int type, int64_t scheduledUs, int64_t actualUs, int64_t durationUs,
+                    int numItems=0, int numNoteOn=0);
+    //@}
+
+    /** @name Methods for any other thread */
+    //@{
+    /** Move the records in the buffer to the trace. Returns the number of records
+        moved. */
+    int collect();
+
+    /** Remove all collected records. */
+    void clear();
+
+    inline int num_records() { return int(m_records.size()); }
+    inline const PlaybackTraceRecord& get_record(int i) { return m_records[i]; }
+    inline int num_dropped() { return m_numDropped; }
+
+    /** Returns the number of collected records of the given type whose lateness (for
+        @c fDuration == @FALSE) or duration (for @c fDuration == @TRUE) is in the range
+        [@c fromUs, @c toUs). */
+    int count_records(int type, int64_t fromUs, int64_t toUs, bool fDuration=false);
+
+    /** Returns a text with statistics and histograms of lateness and duration for each
+        type of action, computed from the collected records. */
+    std::string dump_summary();
+
+    /** Write the collected records in the Chrome trace event format (JSON). */
+    void write_chrome_trace(std::ostream& out);
+    //@}
+
+protected:
+    void dump_histogram(std::ostream& out, int type, bool fDuration);
+    inline bool is_pause_record(int type) {
+        return type == PlaybackTraceRecord::k_pause
+               || type == PlaybackTraceRecord::k_resume;
+    }
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_PLAYBACK_TRACE_H__
@@ -47,6 +47,21 @@ typedef std::shared_ptr<Interactor>   SpInteractor;
 typedef std::weak_ptr<Interactor>     WpInteractor;
 
 
+//---------------------------------------------------------------------------------------
+///@cond INTERNALS
+//excluded from public API. Only for internal use.
+// FileFormatFinder: determines the file format from the file extension
+class FileFormatFinder
+{
+public:
+    FileFormatFinder() {}
+    ~FileFormatFinder() {}
+
+    static int determine_format(const std::string& fullpath);
+};
+///@endcond
+
+
 //---------------------------------------------------------------------------------------
 ///@cond INTERNALS
 //excluded from public API. Only for internal use.
@@ -26,6 +26,7 @@
 #include "lomse_agg_types.h"
 #include "lomse_path_attributes.h"
 #include "lomse_drawer.h"           //enums EBlendMode, EResamplingQuality
+#include "lomse_fast_pixfmt.h"
 
 #include "agg_image_accessors.h"
 #include "agg_span_image_filter_rgb.h"
@@ -34,6 +35,8 @@
 
 #include "agg_rounded_rect.h"
 
+#include <algorithm>    //min, max
+#include <vector>
 
 namespace lomse
 {
@@ -42,7 +45,7 @@ namespace lomse
 class GraphicModel;
 
 
-typedef agg::pixfmt_gray8       PixFormat_gray8;
+typedef FastPixFormat_gray8     PixFormat_gray8;
 typedef agg::pixfmt_gray16      PixFormat_gray16;
 typedef agg::pixfmt_rgb555      PixFormat_rgb555;
 typedef agg::pixfmt_rgb565      PixFormat_rgb565;
@@ -50,12 +53,12 @@ typedef agg::pixfmt_rgbAAA      PixFormat_rgbAAA;
 typedef agg::pixfmt_rgbBBA      PixFormat_rgbBBA;
 typedef agg::pixfmt_bgrAAA      PixFormat_bgrAAA;
 typedef agg::pixfmt_bgrABB      PixFormat_bgrABB;
-typedef agg::pixfmt_rgb24       PixFormat_rgb24;
-typedef agg::pixfmt_bgr24       PixFormat_bgr24;
-typedef agg::pixfmt_rgba32      PixFormat_rgba32;
-typedef agg::pixfmt_argb32      PixFormat_argb32;
+typedef FastPixFormat_rgb24     PixFormat_rgb24;
+typedef FastPixFormat_bgr24     PixFormat_bgr24;
+typedef FastPixFormat_rgba32    PixFormat_rgba32;
+typedef FastPixFormat_argb32    PixFormat_argb32;
 typedef agg::pixfmt_abgr32      PixFormat_abgr32;
-typedef agg::pixfmt_bgra32      PixFormat_bgra32;
+typedef FastPixFormat_bgra32    PixFormat_bgra32;
 typedef agg::pixfmt_rgb48       PixFormat_rgb48;
 typedef agg::pixfmt_bgr48       PixFormat_bgr48;
 typedef agg::pixfmt_rgba64      PixFormat_rgba64;
@@ -64,6 +67,17 @@ typedef agg::pixfmt_abgr64      PixFormat_abgr64;
 typedef agg::pixfmt_bgra64      PixFormat_bgra64;
 
 
+//---------------------------------------------------------------------------------------
+// PathBatch: pending paths that are rendered in a single rasterizer pass. All of them
+// have the same attributes and do not overlap, so the result is identical to rendering
+// them one by one
+struct PathBatch
+{
+    std::vector<unsigned> paths;    //indexes in the attributes storage
+    AggRectInt area;                //union of the paths bounds
+};
+
+
 //---------------------------------------------------------------------------------------
 class Renderer
 {
@@ -88,13 +102,26 @@ protected:
     AttrStorage& m_attr_storage;
     PathStorage& m_path;
 
+    AggRectInt m_drawnArea;     //pixels modified since last reset_drawn_area()
+
+    //render batches for pending paths
+    std::vector<AggRectInt> m_pathBounds;   //pixels that each path could modify
+    AggRectInt m_pendingArea;               //union of m_pathBounds
+    std::vector<PathBatch> m_batches;
+    unsigned m_numBatches;
+
 
 public:
     Renderer(double ppi, AttrStorage& attr_storage, PathStorage& path);
     virtual ~Renderer() {}
     virtual void initialize(RenderingBuffer& buf, Color bgcolor) = 0;
+    virtual void attach(RenderingBuffer& buf) = 0;
+    virtual void clip_rect(int x1, int y1, int x2, int y2) = 0;
+    virtual void clear_clip_rect(Color bgcolor) = 0;
     virtual void render() = 0;
     virtual void render(FontRasterizer& ras, FontScanline& sl, Color color) = 0;
+    virtual bool render_solid_rect(double x1, double y1, double x2, double y2,
+                                   Color color) = 0;
 //    virtual void render_gsv_text(double x, double y, const char* str) = 0;
     virtual void copy_from(RenderingBuffer& img, const AggRectInt* srcRect,
                            int xDest, int yDest) = 0;
@@ -134,10 +161,21 @@ public:
     {
         m_uxShift = x;
         m_uyShift = y;
+        set_transformation();
     }
     void remove_shift();
     inline TransAffine& get_transform() { return m_mtx; }
     void set_transform(TransAffine& transform);
+    void copy_transform(const Renderer& renderer);
+
+    //pixels modified by render operations since last reset (inclusive limits,
+    //not valid if nothing rendered)
+    inline void reset_drawn_area() { m_drawnArea = AggRectInt(1, 1, 0, 0); }
+    inline const AggRectInt& get_drawn_area() const { return m_drawnArea; }
+
+    //Returns true if any path pending to be rendered could modify pixels in the
+    //given rectangle (device units, inclusive limits)
+    bool pending_paths_overlap(const AggRectInt& rect);
 
     //information
     static int bytesPerPixel(int pixFmt);
@@ -148,6 +186,14 @@ protected:
     //void clear_all(Color c);
     void reset();
     agg::rgba to_rgba(Color c);
+    void add_drawn_area(int x1, int y1, int x2, int y2);
+
+    //render batches
+    void compute_paths_bounds();
+    AggRectInt compute_path_bounds(const PathAttributes& attr);
+    void create_batches();
+    bool can_be_batched(const PathAttributes& attr, const PathAttributes& other);
+    bool batch_overlaps(const PathBatch& batch, const AggRectInt& bounds);
 
 };
 
@@ -185,6 +231,7 @@ protected:
     RendererBase            m_renBase;      //base renderer associated to m_rbuf
     RendererSolid           m_renSolid;     //solid renderer associated to m_rbuf
     RendererBasePre         m_renBasePre;
+    AggRectInt              m_rasClipBox;   //clip box for the rasterizer
 
     CurvedConverter         m_curved;
     CurvedStroked           m_curved_stroked;
@@ -201,6 +248,7 @@ public:
         , m_renBase(m_pixFormat)    //attach the pixel accessor (and the buffer)
         , m_renSolid(m_renBase)     //attach the base renderer (and the buffer)
         , m_renBasePre(m_pixFormatPre)
+        , m_rasClipBox(0, 0, 0, 0)
 
         , m_curved(m_path)
         , m_curved_stroked(m_curved)
@@ -214,11 +262,44 @@ public:
     ~RendererTemplate() {}
 
     //-----------------------------------------------------------------------------------
-    void initialize(RenderingBuffer& buf, Color bgcolor) override
+    void attach(RenderingBuffer& buf) override
     {
         m_rbuf.attach(buf.buf(), buf.width(), buf.height(), buf.stride());
         m_renBase.reset_clipping(true);
 
+        //AWARE: rasterizer clip box is in subpixel coordinates. Right and bottom
+        //limits must include the last pixel. Otherwise it is not fully covered and
+        //tiled rendering would differ from direct rendering at tile edges
+        m_rasClipBox = AggRectInt(0, 0, int(buf.width()), int(buf.height()));
+    }
+
+    //-----------------------------------------------------------------------------------
+    void clip_rect(int x1, int y1, int x2, int y2) override
+    {
+        //Restrict drawing to rectangle [x1, x2) x [y1, y2) of the rendering buffer.
+        //AWARE: the rasterizer must not clip paths at the rectangle limits, as the
+        //rounded intersection points would alter the coverage of the pixels near the
+        //limits. A margin is added so that these pixels are outside the rectangle
+        const int margin = 2;
+        m_renBase.clip_box(x1, y1, x2 - 1, y2 - 1);
+        m_rasClipBox.x1 = std::max(0, x1 - margin);
+        m_rasClipBox.y1 = std::max(0, y1 - margin);
+        m_rasClipBox.x2 = std::min(int(m_rbuf.width()), x2 + margin);
+        m_rasClipBox.y2 = std::min(int(m_rbuf.height()), y2 + margin);
+    }
+
+    //-----------------------------------------------------------------------------------
+    void clear_clip_rect(Color bgcolor) override
+    {
+        const AggRectInt& box = m_renBase.clip_box();
+        m_renBase.copy_bar(box.x1, box.y1, box.x2, box.y2, to_rgba(bgcolor));
+    }
+
+    //-----------------------------------------------------------------------------------
+    void initialize(RenderingBuffer& buf, Color bgcolor) override
+    {
+        attach(buf);
+
         m_renBase.clear( to_rgba(bgcolor) );
 
         reset();
@@ -240,10 +321,13 @@ public:
         //set expand value for strokes
         expand(m_expand);
 
+        //group paths in batches
+        create_batches();
+
         //do renderization. Method doing renderization is a template member, so that
         //it can be created for different Renderer types.
         double alpha = 1.0;
-        render(ras, sl, m_renSolid, m_mtx, m_renBase.clip_box(), alpha);
+        render(ras, sl, m_renSolid, m_mtx, m_rasClipBox, alpha);
 
         ////////render controls
         //////ras.gamma(agg::gamma_none());
@@ -260,6 +344,70 @@ public:
     {
         m_renSolid.color( to_rgba(color) );
         agg::render_scanlines(ras, sl, m_renSolid);
+        add_drawn_area(ras);
+    }
+
+    //-----------------------------------------------------------------------------------
+    // Fill an axis-aligned rectangle (in LUnits) without using the rasterizer. The
+    // rectangle is snapped to the rasterizer subpixel grid and the coverage of the
+    // edge pixels is computed analytically, so the result is identical to rendering
+    // the rectangle as a filled path. Returns false, and nothing is drawn, when the
+    // transformation is not axis-aligned (rotation, skew) or gamma is applied.
+    bool render_solid_rect(double x1, double y1, double x2, double y2,
+                           Color color) override
+    {
+        set_transformation();
+        if (m_mtx.shx != 0.0 || m_mtx.shy != 0.0 || m_gamma != 1.0)
+            return false;
+
+        m_mtx.transform(&x1, &y1);
+        m_mtx.transform(&x2, &y2);
+
+        //subpixel coordinates, clipped as the rasterizer would do
+        const int scale = agg::poly_subpixel_scale;
+        int sx1 = std::max(agg::iround(std::min(x1, x2) * scale), m_rasClipBox.x1 * scale);
+        int sx2 = std::min(agg::iround(std::max(x1, x2) * scale), m_rasClipBox.x2 * scale);
+        int sy1 = std::max(agg::iround(std::min(y1, y2) * scale), m_rasClipBox.y1 * scale);
+        int sy2 = std::min(agg::iround(std::max(y1, y2) * scale), m_rasClipBox.y2 * scale);
+        if (sx1 >= sx2 || sy1 >= sy2)
+            return true;
+
+        //touched pixels
+        const int shift = agg::poly_subpixel_shift;
+        int px1 = sx1 >> shift;
+        int px2 = (sx2 - 1) >> shift;
+        int py1 = sy1 >> shift;
+        int py2 = (sy2 - 1) >> shift;
+
+        //covered width of each pixel in the row, in subpixels
+        const unsigned len = unsigned(px2 - px1 + 1);
+        std::vector<int> widths(len, scale);
+        widths[0] = std::min(sx2, (px1 + 1) * scale) - sx1;
+        if (len > 1)
+            widths[len - 1] = sx2 - px2 * scale;
+
+        //AWARE: the rasterizer computes the area of a cell as the sum of the
+        //trapezoids of its edges and the cover is rounded up: ceil(height * width)
+        typename PixFormat::color_type c( rgba8(to_rgba(color)) );
+        std::vector<agg::int8u> covers(len);
+        int lastHeight = -1;
+        for (int y = py1; y <= py2; ++y)
+        {
+            int height = std::min(sy2, (y + 1) * scale) - std::max(sy1, y * scale);
+            if (height != lastHeight)
+            {
+                for (unsigned i=0; i < len; ++i)
+                {
+                    int cover = (height * widths[i] + scale - 1) >> shift;
+                    covers[i] = agg::int8u(std::min(cover, 255));
+                }
+                lastHeight = height;
+            }
+            m_renBase.blend_solid_hspan(px1, y, len, c, &covers[0]);
+        }
+
+        add_drawn_area(px1, py1, px2, py2);
+        return true;
     }
 
     //-----------------------------------------------------------------------------------
@@ -313,6 +461,16 @@ public:
 
 protected:
 
+    //-----------------------------------------------------------------------------------
+    // Accumulate the pixels covered by the cells of the rasterizer, after rendering
+    template<class Rasterizer>
+    void add_drawn_area(Rasterizer& ras)
+    {
+        if (ras.min_x() <= ras.max_x() && ras.min_y() <= ras.max_y())
+            add_drawn_area(ras.min_x(), ras.min_y(), ras.max_x(), ras.max_y());
+    }
+    using Renderer::add_drawn_area;
+
     //-----------------------------------------------------------------------------------
     // Rendering. You can specify two additional parameters:
     // trans_affine and opacity. They can be used to transform the whole
@@ -326,12 +484,14 @@ protected:
                 double opacity=1.0)
     {
         unsigned i;
+        unsigned j;
 
         ras.clip_box(clipBox.x1, clipBox.y1, clipBox.x2, clipBox.y2);
 
-        for(i = 0; i < m_attr_storage.size(); i++)
+        for(i = 0; i < m_numBatches; i++)
         {
-            const PathAttributes& attr = m_attr_storage[i];
+            const std::vector<unsigned>& paths = m_batches[i].paths;
+            const PathAttributes& attr = m_attr_storage[paths[0]];
             m_transform = attr.transform;
             m_transform *= mtx;
             double scl = m_transform.scale();
@@ -345,20 +505,25 @@ protected:
             {
                 ras.reset();
                 ras.filling_rule(attr.even_odd_flag ? fill_even_odd : fill_non_zero);
-                if(fabs(m_curved_trans_contour.width()) < 0.0001)
+                for (j = 0; j < paths.size(); j++)
                 {
-                    ras.add_path(m_curved_trans, attr.path_index);
-                }
-                else
-                {
-                    m_curved_trans_contour.miter_limit(attr.miter_limit);
-                    ras.add_path(m_curved_trans_contour, attr.path_index);
+                    unsigned idx = m_attr_storage[paths[j]].path_index;
+                    if(fabs(m_curved_trans_contour.width()) < 0.0001)
+                    {
+                        ras.add_path(m_curved_trans, idx);
+                    }
+                    else
+                    {
+                        m_curved_trans_contour.miter_limit(attr.miter_limit);
+                        ras.add_path(m_curved_trans_contour, idx);
+                    }
                 }
 
                 color = to_rgba(attr.fill_color);
                 color.opacity(color.opacity() * opacity);
                 ren.color(color);
                 agg::render_scanlines(ras, sl, ren);
+                add_drawn_area(ras);
             }
 
             else if (attr.fill_mode == k_fill_gradient_linear)
@@ -408,6 +573,7 @@ protected:
 
                 //procceed to render using defined renderer
                 agg::render_scanlines(ras, sl, renderer);
+                add_drawn_area(ras);
             }
 
             if(attr.stroke_flag)
@@ -429,11 +595,16 @@ protected:
                 }
                 ras.reset();
                 ras.filling_rule(fill_non_zero);
-                ras.add_path(m_curved_stroked_trans, attr.path_index);
+                for (j = 0; j < paths.size(); j++)
+                {
+                    unsigned idx = m_attr_storage[paths[j]].path_index;
+                    ras.add_path(m_curved_stroked_trans, idx);
+                }
                 color = to_rgba(attr.stroke_color);
                 color.opacity(color.opacity() * opacity);
                 ren.color(color);
                 agg::render_scanlines(ras, sl, ren);
+                add_drawn_area(ras);
             }
         }
     }
@@ -484,6 +655,9 @@ protected:
         ras.line_to_d(dstX2, dstY2);
         ras.line_to_d(dstX1, dstY2);
 
+        add_drawn_area(int(floor(dstX1)), int(floor(dstY1)),
+                       int(ceil(dstX2)), int(ceil(dstY2)));
+
         //define the scanline class we are going to use (u8)
         agg::scanline_u8 sl;
 
@@ -14,10 +14,12 @@
 
 #include "lomse_basic.h"
 #include "lomse_internal_model.h"
-
+#include "lomse_playback_trace.h"
 
 #include <vector>
 #include <thread>
+#include <atomic>
+#include <cstdint>
 #include <condition_variable>
 
 ///@cond INTERNALS
@@ -34,6 +36,7 @@ class Interactor;
 class LibraryScope;
 class PlayerGui;
 class Metronome;
+class EventVisualTracking;
 
 //some constants for greater code legibility
 #define k_no_visual_tracking    false
@@ -48,6 +51,31 @@ typedef std::thread SoundThread;
 typedef std::condition_variable SoundFlag;
 
 
+//---------------------------------------------------------------------------------------
+/** %MidiEvent is a sound request from ScorePlayer, for passing a group of
+    simultaneous requests in a single invocation of MidiServerBase::process_events().
+*/
+struct MidiEvent
+{
+    /** Types of sound requests. Each one corresponds to a MidiServerBase method */
+    enum EMidiEventType
+    {
+        k_note_on = 0,      ///< note_on(channel, data1=pitch, data2=volume)
+        k_note_off,         ///< note_off(channel, data1=pitch, data2=volume)
+        k_voice_change,     ///< voice_change(channel, data1=instr)
+        k_program_change,   ///< program_change(channel, data1=instr)
+    };
+
+    int type;           ///< Type of request, from EMidiEventType
+    int channel;        ///< MIDI channel
+    int data1;          ///< pitch, for notes, or instrument, for program changes
+    int data2;          ///< volume, for notes. Not used for program changes
+
+    MidiEvent(int t, int ch, int d1, int d2=0)
+        : type(t), channel(ch), data1(d1), data2(d2) {}
+};
+
+
 //---------------------------------------------------------------------------------------
 /** Class %MidiServerBase is a base class defining the interface for any class
     that would like to process the requests from ScorePlayer to generate
@@ -72,6 +100,11 @@ typedef std::condition_variable SoundFlag;
     separate thread. Your application should not retain control for much time as this
     would result in freezing Lomse playback thread.
 
+    All requests for the same time are grouped and delivered in a single invocation
+    of process_events(). By default, this method just invokes the per-event methods
+    (note_on(), note_off(), etc.) for each request but your midi server can override
+    it, for instance, to send all MIDI messages for a chord in a single write.
+
 */
 class MidiServerBase
 {
@@ -116,6 +149,38 @@ public:
         methods.
     */
     virtual void all_sounds_off() {}
+
+    /** Informs about the playback time for the requests that follow. It is invoked
+        at start of playback and each time playback time advances, before any other
+        request for that time. Time is measured in milliseconds from the start of
+        playback (including count-off clicks) and it is the scheduled time, computed
+        by Lomse. Therefore, it is not affected by delays in the playback thread.
+
+        This is mainly useful when ScorePlayer is in virtual clock mode (see
+        ScorePlayer::set_virtual_clock()) as, in this mode, requests are not
+        invoked at real time.
+    */
+    virtual void set_playback_time(long UNUSED(milliseconds)) {}
+
+    /** %Request to process a group of simultaneous requests. ScorePlayer collects
+        all requests that take place at the same time and delivers them, in the
+        order in which they were generated, by invoking this method. This allows
+        your midi server to send all messages at once and to reduce the time skew
+        between the notes of a chord.
+
+        The default implementation just invokes, for each request, the respective
+        per-event method: note_on(), note_off(), voice_change() or program_change().
+        Therefore, your midi server only needs to override this method if it can take
+        advantage of receiving the requests together.
+
+        @param events Pointer to the first request.
+        @param n Number of requests.
+        @param timestampUs Time for these requests, in microseconds since the start
+            of playback. It is the scheduled time, that is, the same time informed by
+            set_playback_time(), but in microseconds.
+    */
+    virtual void process_events(const MidiEvent* events, size_t n,
+                                uint64_t timestampUs);
 };
 
 
@@ -154,13 +219,19 @@ protected:
     std::unique_ptr<SoundThread> m_pThread;      //execution thread
     std::mutex          m_startMutex;   //mutex so synchronize thread start
     MidiServerBase*     m_pMidi;        //MIDI server to receive MIDI events
-    bool                m_fPaused;      //execution is paused
-    bool                m_fRunning;     //method do_play has not finished.
-    bool                m_fShouldStop;  //request to stop playback
-    bool                m_fPlaying;     //playing (control in do_play loop)
-    bool                m_fPostEvents;  //post events to application events loop
-    bool                m_fQuit;        //the request to stop is for application quit
-    bool                m_fFinalEventSent;      //to avoid duplicating final event
+    //control flags, shared by user application and sound threads
+    std::atomic<bool>   m_fPaused;      //execution is paused
+    std::atomic<bool>   m_fRunning;     //method do_play has not finished.
+    std::atomic<bool>   m_fShouldStop;  //request to stop playback
+    std::atomic<bool>   m_fPlaying;     //playing (control in do_play loop)
+    std::atomic<bool>   m_fPostEvents;  //post events to application events loop
+    std::atomic<bool>   m_fQuit;        //the request to stop is for application quit
+    std::atomic<bool>   m_fFinalEventSent;      //to avoid duplicating final event
+    std::atomic<int>    m_numStalls;    //sound thread late or tracking queue full
+    std::unique_ptr<PlaybackTrace> m_pTrace;    //timing information, if enabled
+    bool                m_fVirtualClock;        //do not wait for real time
+    long                m_playbackTime;         //millisecs. since start of playback
+    std::vector<MidiEvent> m_midiEvents;        //pending requests for current time
     ImoScore*           m_pScore;       //score to play
     SoundEventsTable*   m_pTable;
     SoundFlag           m_canPlay;      //playback is not paused
@@ -187,6 +258,8 @@ public:
 
     /** Load the score to play and set some options. Playback does not start until you
         invoke any of the play methods: play(), play_measure(), etc.
+        The score can be modified while it is being played, as the sound events in use
+        are not modified. Changes are taken into account when playback is started again.
         @param score The score to play.
         @param pPlayerGui
         @param metronomeChannel Midi channel (0..15) to use for metronome clicks.
@@ -292,8 +365,80 @@ public:
                        long nMM = 0,
                        Interactor* pInteractor = nullptr);
 
+    /** Start the playback at the indicated pass through a measure and play until the
+        end of the score. For instance, when measure 5 is in a repeated section,
+        @c pass=2 will start playback at measure 5 when the section is played for the
+        second time.
+        Before invoking this method, an score must have been loaded in the player by
+        invoking the load_score() method.
+        @param nMeasure Number of measure to play (1..n).
+        @param pass Number of pass through the measure (1..n).
+        @param fVisualTracking Flag to signal if visual tracking effects
+            are desired. Default value is @FALSE (k_no_visual_tracking).
+        @param nMM Tempo speed for playback. Value 0 (default) means that tempo will
+            be controlled by the metronome control (in PlayerGui object) that
+            was specified in method load_score(). A non-zero value for @c nMM forces
+            to use that metronome speed. It is expressed in BPM (beats per minute).
+        @param pInteractor Pointer to the Interactor associated to the View in which the
+            score is displayed or @nullptr in case the score is not displayed.
+    */
+    void play_from_pass(int nMeasure, int pass,
+                        bool fVisualTracking = k_no_visual_tracking,
+                        long nMM = 0,
+                        Interactor* pInteractor = nullptr);
+
+    /** Start the playback at the measure being played at the given time and play
+        until the end of the score. Time is measured from the start of playback, with
+        all repetitions unrolled, and does not include count-off clicks.
+        Before invoking this method, an score must have been loaded in the player by
+        invoking the load_score() method.
+        @param milliseconds Playback time.
+        @param fVisualTracking Flag to signal if visual tracking effects
+            are desired. Default value is @FALSE (k_no_visual_tracking).
+        @param nMM Tempo speed for playback. Value 0 (default) means that tempo will
+            be controlled by the metronome control (in PlayerGui object) that
+            was specified in method load_score(). A non-zero value for @c nMM forces
+            to use that metronome speed. It is expressed in BPM (beats per minute).
+        @param pInteractor Pointer to the Interactor associated to the View in which the
+            score is displayed or @nullptr in case the score is not displayed.
+    */
+    void play_from_time(long milliseconds,
+                        bool fVisualTracking = k_no_visual_tracking,
+                        long nMM = 0,
+                        Interactor* pInteractor = nullptr);
+
     //@}    //Methods to start playback
 
+    // time <-> measure mapping
+    /** @name Time and measures mapping
+        Playback times are measured in milliseconds from the start of playback, with all
+        repetitions unrolled, and do not include count-off clicks. The meaning of
+        parameter @c nMM is the same than in play methods.
+    */
+    //@{
+
+    /** Returns the total playback time for the loaded score.    */
+    long get_playback_duration(long nMM = 0);
+
+    /** Returns the playback time at which a pass through a measure starts, or -1
+        if the measure is not played @c pass times.
+        @param nMeasure Number of measure (1..n).
+        @param pass Number of pass through the measure (1..n).
+        @param nMM Tempo speed.
+    */
+    long get_time_for_measure(int nMeasure, int pass = 1, long nMM = 0);
+
+    /** Returns the number of the measure (1..n) played back at the given time, or 0
+        if no measure is played at that time.
+        @param milliseconds Playback time.
+        @param pPass If not @nullptr, it will receive the number of pass through
+            the measure.
+        @param nMM Tempo speed.
+    */
+    int get_measure_for_time(long milliseconds, int* pPass = nullptr, long nMM = 0);
+
+    //@}    //Time and measures mapping
+
     /** Finish current playback. To start a new playback you must invoke
         any of the play methods.
     */
@@ -317,13 +462,79 @@ public:
     */
     inline bool is_playing() { return m_fPlaying; }
 
+    /** Enable or disable the virtual clock mode. By default it is disabled, and
+        playback is done at real time.
 
-///@cond INTERNALS
-//excluded from public API. Only for internal use.
+        In virtual clock mode all playback logic (count-off, metronome clicks, jumps,
+        visual tracking events and end of playback event) is executed as in normal
+        playback, but without waiting for real time, so the score is played back as
+        fast as possible. The sequence of requests to the MidiServerBase object and of
+        visual tracking events is the same than in real time playback. The playback
+        time for each request is informed by invoking
+        MidiServerBase::set_playback_time() and the time for each visual tracking
+        event can be obtained from EventVisualTracking::get_playback_time().
+
+        This mode is useful, for instance, for automated tests or for rendering the
+        score to an audio file.
+    */
+    inline void set_virtual_clock(bool value) { m_fVirtualClock = value; }
 
-    //For selecting method to send events to user application
+    /** Returns @TRUE if the virtual clock mode is enabled.
+        See set_virtual_clock().
+    */
+    inline bool is_virtual_clock() { return m_fVirtualClock; }
+
+    /** Select how visual tracking events and the end of playback event are delivered.
+
+        By default (@TRUE) they are posted to the event handling callback set up at
+        Lomse initialization. Take into account that, in this mode, the callback is
+        invoked in the sound thread. Therefore, the sound thread waits while your
+        application handles the event and, if the user interface thread is busy,
+        sound could be delayed. This mode is the default only for preserving the
+        behaviour of existing applications.
+
+        When @FALSE, the sound thread does not invoke any user application or view
+        code. Instead, tracking events and the end of playback event are stored in a
+        lock-free queue in the Interactor passed to the play methods, and your
+        application must invoke Interactor::process_playback_events() from the user
+        interface thread (i.e. from a timer) for processing them. This ensures that
+        the sound thread never waits for the user interface, and it is the
+        recommended mode for new applications. If no Interactor is passed to the play
+        methods, the end of playback event is posted to the event handling callback.
+    */
     inline void post_tracking_events(bool value) { m_fPostEvents = value; }
 
+    /** Returns the number of times, since playback started, that the sound thread
+        could not keep the schedule: either it woke up late or the tracking events
+        queue was full and an event was discarded (see post_tracking_events()). It is
+        intended for debugging timing problems. It is always zero in virtual clock
+        mode.
+    */
+    inline int get_num_stalls() { return m_numStalls; }
+
+    /** Enable or disable the collection of timing information during playback: for
+        each group of sound requests, its scheduled and actual time and the time
+        consumed by MidiServerBase::process_events(), the time consumed by posting
+        visual tracking events and the sound thread wake up times. See PlaybackTrace.
+        Tracing is disabled by default. This method must not be invoked while playing.
+
+        @param value @TRUE for enabling tracing. When @FALSE, the PlaybackTrace
+            object is deleted.
+        @param capacity Maximum number of records that can be stored until they are
+            collected by invoking PlaybackTrace::collect(). Further records are
+            discarded.
+    */
+    void enable_trace(bool value, size_t capacity=4096);
+
+    /** Returns the PlaybackTrace object, or @nullptr if tracing is not enabled.
+        See enable_trace().
+    */
+    inline PlaybackTrace* get_trace() { return m_pTrace.get(); }
+
+
+///@cond INTERNALS
+//excluded from public API. Only for internal use.
+
     //only to be used by SoundThread
     void do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                  long nMM, Interactor* pInteractor );
@@ -331,11 +542,20 @@ public:
 ///@endcond
 
 protected:
+    void refresh_table();
     virtual void play_segment(int nEvStart, int nEvEnd);
     void thread_main(int nEvStart, int nEvEnd, bool fVisualTracking, long nMM,
                      Interactor* pInteractor);
     void end_of_playback_housekeeping(bool fVisualTracking, Interactor* pInteractor);
     void set_new_beat_information(SoundEvent* pEvent);
+    void play_from_segment(int iSegment, bool fVisualTracking, long nMM,
+                           Interactor* pInteractor);
+    float milliseconds_per_time_unit(long nMM);
+    void advance_playback_time(long milliseconds, long elapsed=0L);
+    void send_tracking_event(std::shared_ptr<EventVisualTracking> pEvent,
+                             Interactor* pInteractor);
+    void queue_midi_event(int type, int channel, int data1, int data2=0);
+    void flush_midi_events();
 
     //helper, for do_play()
     //-----------------------------------------------------------------------------------
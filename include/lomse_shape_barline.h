@@ -67,6 +67,8 @@ protected:
                         Color color);
     void draw_thick_line(Drawer* pDrawer, LUnits uxLeft, LUnits uyTop, LUnits uWidth,
                          LUnits uHeight, Color color);
+    void draw_solid_rect(Drawer* pDrawer, LUnits x1, LUnits y1, LUnits x2, LUnits y2,
+                         Color color);
     void draw_two_dots(Drawer* pDrawer, LUnits uxPos, LUnits uyPos, Color color);
     void draw_repeat_dots_for_all_staves(Drawer* pDrawer, LUnits uxPos, LUnits uyPos, Color color);
     void draw_doted_line(Drawer* pDrawer, LUnits uxPos, LUnits uyPos, LUnits uyBottom, Color color);
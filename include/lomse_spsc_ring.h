@@ -0,0 +1,94 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_SPSC_RING_H__
+#define __LOMSE_SPSC_RING_H__
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+/** %SpscRing is a fixed capacity, lock-free FIFO queue for passing items from one
+    producer thread to one consumer thread. It is used for transferring information
+    from the sound thread to the user interface thread without using locks, so that
+    the sound thread is never blocked by the user interface.
+
+    Only one thread can invoke push() and only one thread can invoke pop(). Memory for
+    all items is allocated when the ring is created; push() never allocates memory.
+*/
+template <typename T>
+class SpscRing
+{
+protected:
+    std::vector<T> m_items;
+    size_t m_mask;
+    std::atomic<size_t> m_head;     //next item to pop. Written only by consumer
+    std::atomic<size_t> m_tail;     //next free slot. Written only by producer
+
+public:
+    /** Capacity is rounded up to a power of two */
+    SpscRing(size_t capacity)
+        : m_mask(0)
+        , m_head(0)
+        , m_tail(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        m_items.resize(size);
+        m_mask = size - 1;
+    }
+
+    /** Producer. Returns @false if the ring is full and the item was not added. */
+    bool push(const T& item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+            return false;
+
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer. Returns @false if the ring is empty. The slot is reset, so that
+        any resources held by the item are released in the consumer thread. */
+    bool pop(T& item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        item = m_items[head & m_mask];
+        m_items[head & m_mask] = T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //info. Values are approximate when the other thread is active
+    inline bool empty() const {
+        return m_head.load(std::memory_order_acquire)
+               == m_tail.load(std::memory_order_acquire);
+    }
+    inline size_t size() const {
+        return m_tail.load(std::memory_order_acquire)
+               - m_head.load(std::memory_order_acquire);
+    }
+    inline size_t capacity() const { return m_items.size(); }
+
+};
+
+
+}   //namespace lomse
+
+#endif      //__LOMSE_SPSC_RING_H__
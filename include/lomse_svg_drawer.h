@@ -20,14 +20,50 @@ namespace lomse
 {
 
 //---------------------------------------------------------------------------------------
-/** %SvgDrawer: a Drawer that renders as svg stream
+/** %SvgBuffer: growable char buffer for composing SVG code. Numbers are formatted
+    directly into the buffer. With default precision (-1), floating point numbers are
+    formatted as std::ostream does by default (6 significant digits). Otherwise,
+    precision is the maximum number of decimal places. Precision is referenced, not
+    copied, as SvgOptions can be changed after creating the SvgDrawer.
+*/
+class SvgBuffer
+{
+protected:
+    std::string m_data;
+    const int*  m_pPrecision;
+
+public:
+    explicit SvgBuffer(const int* pPrecision=nullptr) : m_pPrecision(pPrecision) {}
+
+    inline int get_precision() const { return m_pPrecision ? *m_pPrecision : -1; }
+    inline void clear() { m_data.clear(); }     //capacity is kept
+    inline bool empty() const { return m_data.empty(); }
+    inline size_t size() const { return m_data.size(); }
+    inline const char* data() const { return m_data.data(); }
+    inline const std::string& str() const { return m_data; }
+
+    inline SvgBuffer& operator <<(const char* s) { m_data.append(s); return *this; }
+    inline SvgBuffer& operator <<(const std::string& s) { m_data.append(s); return *this; }
+    inline SvgBuffer& operator <<(const SvgBuffer& b) { m_data.append(b.m_data); return *this; }
+    inline SvgBuffer& operator <<(char c) { m_data.push_back(c); return *this; }
+    SvgBuffer& operator <<(int value);
+    SvgBuffer& operator <<(unsigned int value);
+    SvgBuffer& operator <<(double value);
+};
+
+//---------------------------------------------------------------------------------------
+/** %SvgDrawer: a Drawer that renders as svg stream.
+    The SVG code is composed in a buffer and written to the stream in large chunks,
+    when the buffer is full, when render() or flush() are invoked and when the
+    drawer is deleted.
 */
 class LOMSE_EXPORT SvgDrawer : public Drawer
 {
 private:
-    std::ostream&       m_svg;
-    std::stringstream   m_attribs;
-    std::stringstream   m_path;
+    std::ostream&       m_stream;
+    SvgBuffer           m_svg;
+    SvgBuffer           m_attribs;
+    SvgBuffer           m_path;
     TransAffine         m_transform;
     const SvgOptions&   m_options;
     double              m_fontSize = 10;
@@ -41,10 +77,24 @@ private:
     bool                m_fPathOpen = false;    //open path pending to be closed
     std::unordered_map<std::string, int> m_ids;     //for detecting duplicated id
 
+    //for glyphs as symbols
+    std::string         m_fontFile;             //font file for current font
+    FontEngine*         m_pOutlinesEngine = nullptr;
+    std::string         m_outlinesFontFile;     //font file loaded in outlines engine
+    std::unordered_map<std::string, std::string> m_symbols;    //glyph key -> symbol id
+
 public:
     SvgDrawer(LibraryScope& libraryScope, std::ostream& svgstream, const SvgOptions& opt);
     virtual ~SvgDrawer();
 
+    /** Write the opening <svg> element for a page of the given size, with the
+        namespaces required by the options. */
+    static void write_svg_start(std::ostream& svg, const SvgOptions& opt,
+                                LUnits width, LUnits height);
+
+    /** Write the closing </svg> element. */
+    static void write_svg_end(std::ostream& svg);
+
     //===================================================================
     // Implementation of pure virtual methods in Drawer base class
     //===================================================================
@@ -224,6 +274,9 @@ public:
     // Specific methods not in Drawer base class
     //===================================================================
 
+    //write pending SVG code to the stream
+    void flush();
+
 
 protected:
     std::string to_svg(Color color);
@@ -233,6 +286,9 @@ protected:
     void add_id_and_class();
     void start_element(std::string name);
     std::string validate_id(const string& id);
+    std::string glyph_symbol(unsigned int ch);
+    bool get_glyph_outline(unsigned int ch, double size, std::string* pathData);
+    void add_glyph_fill();
 
     //helper
     inline void set_indent_level(int value) { m_indentLevel = value; }
@@ -0,0 +1,119 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#ifndef __LOMSE_TILE_CACHE_H__        //to avoid nested includes
+#define __LOMSE_TILE_CACHE_H__
+
+#include "lomse_agg_types.h"        //RenderingBuffer
+#include "lomse_drawer.h"           //RenderOptions
+
+#include <list>
+#include <map>
+#include <vector>
+
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// Tile: a rasterized square region of the view canvas. The canvas is the whole
+// document rendered at a given scale, in device units (pixels), with origin at the
+// model origin. Tile (col, row) covers canvas pixels [col*size, (col+1)*size) and
+// [row*size, (row+1)*size).
+struct Tile
+{
+    double scale;
+    int col;
+    int row;
+    std::vector<unsigned char> pixels;
+    RenderingBuffer rbuf;
+
+    Tile(double s, int c, int r) : scale(s), col(c), row(r) {}
+};
+
+//---------------------------------------------------------------------------------------
+// TileCache: the rasterized tiles for a GraphicView. Tiles are only valid for a
+// graphic model version and rendering options, and are discarded when any of them
+// changes. When the memory budget is exceeded, least recently used tiles are
+// discarded.
+class TileCache
+{
+protected:
+    int m_tileSize;             //pixels
+    int m_bytesPerPixel;
+    size_t m_maxBytes;
+    size_t m_usedBytes;
+
+    struct TileKey
+    {
+        double scale;
+        int col;
+        int row;
+
+        bool operator<(const TileKey& key) const
+        {
+            if (scale != key.scale)
+                return scale < key.scale;
+            if (row != key.row)
+                return row < key.row;
+            return col < key.col;
+        }
+    };
+    std::list<Tile*> m_tiles;     //most recently used first
+    std::map<TileKey, std::list<Tile*>::iterator> m_index;
+
+    //content for which cached tiles are valid
+    long m_modelId;
+    long m_modelVersion;
+    RenderOptions m_options;
+
+    //statistics
+    long m_numHits;
+    long m_numMisses;
+
+public:
+    enum { k_tile_size = 256, };
+
+    TileCache(int bytesPerPixel, size_t maxBytes, int tileSize=k_tile_size);
+    ~TileCache();
+
+    //settings
+    void set_max_bytes(size_t maxBytes);
+    inline size_t get_max_bytes() const { return m_maxBytes; }
+    inline int get_tile_size() const { return m_tileSize; }
+
+    //Discard all tiles if they are not valid for the given content
+    void set_content(long modelId, long modelVersion, const RenderOptions& options);
+    void invalidate();
+
+    //Returns the tile, or nullptr if not cached. Counts hits and misses
+    Tile* find_tile(double scale, int col, int row);
+
+    //Allocate a new tile, discarding other tiles if needed. Tile pixels must be
+    //rendered by the caller
+    Tile* add_tile(double scale, int col, int row);
+
+    //statistics
+    inline long get_num_hits() const { return m_numHits; }
+    inline long get_num_misses() const { return m_numMisses; }
+    inline void reset_counters() { m_numHits = 0; m_numMisses = 0; }
+    inline size_t get_used_bytes() const { return m_usedBytes; }
+    inline int get_num_tiles() const { return int(m_tiles.size()); }
+
+protected:
+    inline size_t tile_bytes() const {
+        return size_t(m_tileSize) * size_t(m_tileSize) * size_t(m_bytesPerPixel);
+    }
+    void delete_least_recently_used();
+};
+
+
+}   //namespace lomse
+
+#endif    // __LOMSE_TILE_CACHE_H__
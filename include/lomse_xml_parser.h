@@ -110,6 +110,11 @@ public:
     void parse_text(const std::string& sourceText) override;
     void parse_cstring(char* sourceText);
     void parse_buffer(const void* buffer, size_t size);
+    void parse_buffer_own(void* buffer, size_t size);
+
+    //buffers for parse_buffer_own() must be allocated with this method
+    static void* allocate_buffer(size_t size);
+    static void deallocate_buffer(void* buffer);
 
     inline const string& get_error() { return m_errorMsg; }
     inline const string& get_encoding() { return m_encoding; }
@@ -16,6 +16,7 @@
 #include <fstream>
 #include <sstream>
 #include <vector>
+#include <map>
 using namespace std;
 
 #include "unzip.h"      //minizip package
@@ -94,6 +95,8 @@ protected:
     char m_buffer[k_buffersize];
     char* m_pNextChar;
     ZipEntryInfo m_curEntry;
+    std::map<std::string, unz_file_pos> m_entries;   //central directory index
+    bool m_fEntriesIndexed;
 
 
 public:
@@ -110,6 +113,7 @@ public:
     //operations
     unsigned char* get_as_string();
     std::vector<unsigned char> get_as_vector();
+    long inflate_current_entry(unsigned char* pDestBuffer, long nBufferSize);
 
 	//positioning
 	bool move_to_first_entry();
@@ -134,6 +138,7 @@ protected:
     void close_current_entry();
     void close_zip_archive();
     bool set_up_current_entry(bool fSuccess);
+    void index_entries();
 
 };
 
@@ -140,6 +140,11 @@ public:
     void reset_id_assigner();
     void on_removed_from_model(ImoObj* pImo);
 
+    //building parts of the model in a different DocModel (i.e. in other thread)
+    void lend_subtree(ImoObj* pImo, DocModel* pBorrower);
+    void reclaim_subtree(ImoObj* pImo, DocModel* pBorrower, ImoId maxLentId);
+    ImoId get_last_assigned_id() const;
+
     //dirty flag
     inline bool is_dirty() { return (m_flags & k_dirty) != 0; }
     inline void set_dirty() { m_flags |= k_dirty; }
@@ -200,6 +205,7 @@ protected:
     DocumentScope   m_docScope;
     int             m_modified = 0;         //modified since last 'save to file' operation
     DocModel*       m_pModel = nullptr;     //the document content
+    MusicXmlOptions* m_pMxlOptions = nullptr;   //when not using library options
 
 public:
     /// Constructor
@@ -267,6 +273,25 @@ public:
     */
     int from_input(LdpReader& reader);
 
+    /** Add content to an uninitialized %Document (a %Document created by just invoking
+        the %Document constructor) by loading a binary snapshot of its internal model,
+        previously created by method to_snapshot(). Loading a snapshot is much faster
+        than parsing the source file again.
+        @param data   Pointer to the snapshot content. It can be, for instance, a
+            memory mapped file.
+        @param size   Size of the snapshot, in bytes.
+
+        Returns @TRUE if the snapshot was loaded. If the snapshot is not valid (i.e.
+        corrupted data or created by a different Lomse version) the method returns
+        @FALSE and the %Document continues uninitialized, so that any other creation
+        method can be invoked.
+
+        <b>Remarks</b>
+        - Applications using the Lomse library do not have, normally, the need to use
+            this method as all %Document creation is managed by LomseDoorway object.
+    */
+    bool from_snapshot(const char* data, size_t size);
+
     /** Initialize an uninitialized %Document (a %Document created by just invoking
         the %Document constructor) so that it will be a valid empty %Document with a
         valid empty internal model.
@@ -287,6 +312,24 @@ public:
     */
     void create_with_empty_score();
 
+    /** Saves the internal model of this %Document as a binary snapshot in string 'out'.
+        The snapshot can later be loaded by method from_snapshot().
+
+        Returns @FALSE if the document contains objects that cannot be saved in a
+        snapshot, such as controls, images or score players.
+    */
+    bool to_snapshot(std::string& out);
+
+    /** Use a copy of the given MusicXML import options for creating this %Document
+        instead of the library options (see LomseDoorway::get_musicxml_options()). It
+        must be invoked before creating the %Document content. This allows to import
+        documents with different options in different threads.  */
+    void set_musicxml_options(const MusicXmlOptions& options);
+
+    /** Returns the MusicXML import options to use for creating this %Document: the
+        options set by set_musicxml_options() or, if not set, the library options.  */
+    MusicXmlOptions* get_musicxml_options();
+
     //@}    //Document creation
 
 
@@ -1486,6 +1486,7 @@ protected:
     ImoObj(int objtype, ImoId id=k_no_imoid);
 
     friend class ImFactory;
+    friend class ImSnapshot;
     void set_owner_model(DocModel* pDocModel);
     virtual void initialize_object() {}
 
@@ -1789,6 +1790,7 @@ protected:
     ImoObj& clone(const ImoObj& a);
 
     friend class FixModelVisitor;
+    friend class TransferIdsVisitor;
     inline void anchor_to_model(DocModel* pDocModel) { m_pDocModel = pDocModel; }
 
 
@@ -1948,6 +1950,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoStyle() : ImoSimpleObj(k_imo_style), m_name(), m_idParent(k_no_imoid) {}
 
 public:
@@ -2178,6 +2181,7 @@ class ImoContentObj : public ImoObj
     , public Observable
 {
 protected:
+    friend class ImSnapshot;
     ImoId m_styleId;
     Tenths m_txUserLocation;
     Tenths m_tyUserLocation;
@@ -2185,6 +2189,7 @@ protected:
     Tenths m_tyUserRefPoint;
     bool m_fVisible;
 
+    friend class TransferIdsVisitor;
     ImoContentObj(int objtype);
     ImoContentObj(ImoId id, int objtype);
 
@@ -2296,6 +2301,7 @@ protected:
     std::list<ImoRelObj*> m_relations;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoContentObj;
     ImoRelations() : ImoSimpleObj(k_imo_relations) {}
 
@@ -2450,6 +2456,7 @@ public:
 class ImoBoxInline : public ImoInlineLevelObj
 {
 protected:
+    friend class ImSnapshot;
     USize m_size;
 
     ImoBoxInline(int objtype) : ImoInlineLevelObj(objtype), m_size(0.0f, 0.0f) {}
@@ -2522,6 +2529,7 @@ private:
     std::string m_language;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLink() : ImoBoxInline(k_imo_link) {}
 
 public:
@@ -2545,6 +2553,7 @@ public:
 class ImoScoreObj : public ImoContentObj
 {
 protected:
+    friend class ImSnapshot;
     Color m_color;
 
     ImoScoreObj(ImoId id, int objtype) : ImoContentObj(id, objtype), m_color(0,0,0) {}
@@ -2578,6 +2587,7 @@ public:
 class ImoStaffObj : public ImoScoreObj
 {
 protected:
+    friend class ImSnapshot;
     int m_staff = 0;
     int m_nVoice = 0;       //1..n. voice==0 means not defined
     TimeUnits m_time = 0.0;
@@ -2670,9 +2680,11 @@ public:
 class ImoAuxRelObj : public ImoAuxObj
 {
 protected:
+    friend class ImSnapshot;
     ImoId m_prevId;     //Id for previous ImoAuxRelObj
     ImoId m_nextId;     //Id for next ImoAuxRelObj
 
+    friend class TransferIdsVisitor;
     ImoAuxRelObj(int objtype)
         : ImoAuxObj(objtype)
         , m_prevId(k_no_imoid)
@@ -2739,6 +2751,7 @@ public:
 class ImoRelObj : public ImoScoreObj
 {
 private:
+    friend class ImSnapshot;
     //AWARE: Elements of this list can never be children of this node, as any instance
     //of ImoRelObj is linked to two or more nodes
 #if (LOMSE_RELOBJ_USES_ID == 1)
@@ -2747,6 +2760,7 @@ private:
 #else
     std::list< pair<ImoStaffObj*, ImoRelDataObj*> > m_relatedObjects;
 #endif
+    friend class TransferIdsVisitor;
 
 protected:
     ImoRelObj(int objtype) : ImoScoreObj(objtype) {}
@@ -2823,6 +2837,7 @@ protected:
     bool m_repeat[6];
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoBeamData(ImoBeamDto* pDto);
     ImoBeamData();
 
@@ -2921,6 +2936,7 @@ protected:
     TPoint m_tPoints[4];   //start, end, ctrol1, ctrol2
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoBezierInfo() : ImoSimpleObj(k_imo_bezier_info) {}
 
 public:
@@ -3000,6 +3016,7 @@ protected:
     inline void set_stem_direction(int value) { m_stemDirection = value; }
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoChord()
         : ImoRelObj(k_imo_chord)
         , m_fCrossStaff(false)
@@ -3047,6 +3064,7 @@ protected:
     ImoId m_id;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoCursorInfo() : ImoSimpleObj(k_imo_cursor_info)
         , m_instrument(0), m_staff(0), m_time(0.0), m_id(k_no_imoid) {}
 
@@ -3173,6 +3191,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     ImoMidiInfo() : ImoSimpleObj(k_imo_midi_info) {}
 
@@ -3253,6 +3272,7 @@ class ImoTextBlockInfo : public ImoSimpleObj
 {
 //<location>[<size>][<color>][<border>]
 protected:
+    friend class ImSnapshot;
     //block position and size
     TSize     m_size;
     TPoint    m_topLeftPoint;
@@ -3362,6 +3382,7 @@ protected:
 
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     ImoSoundInfo();
     void initialize_object() override;
@@ -3434,6 +3455,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoDocument;
     friend class ImoScore;
     ImoPageInfo();
@@ -3552,6 +3574,7 @@ protected:
                                         //nullptr when middle barline
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoBarline()
         : ImoStaffObj(k_imo_barline)
         , m_barlineType(k_barline_simple)
@@ -3665,6 +3688,7 @@ protected:
     //TPoint m_anchorJoinPoint;     //point on the box rectangle
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTextBox() : ImoBlock(k_imo_text_box), m_fHasAnchorLine(false) {}
     ImoTextBox(ImoTextBlockInfo& box) : ImoBlock(k_imo_text_box, box), m_fHasAnchorLine(false) {}
 
@@ -3778,6 +3802,7 @@ protected:
     int m_symbolSize = k_size_default;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoClef() : ImoStaffObj(k_imo_clef) {}
 
 public:
@@ -3885,6 +3910,8 @@ protected:
 
 
     friend class ImFactory;
+    friend class ImSnapshot;
+    friend class TransferIdsVisitor;
     ImoDirection() : ImoStaffObj(k_imo_direction) {}
 
 public:
@@ -3926,6 +3953,7 @@ protected:
     int m_symbol = ImoSymbolRepetitionMark::k_undefined;       //a value from enum ESymbolRepetitionMark
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoSymbolRepetitionMark() : ImoAuxObj(k_imo_symbol_repetition_mark) {}
 
 public:
@@ -3956,6 +3984,7 @@ protected:
     std::string m_classid;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoDynamic() : ImoContent(k_imo_dynamic), m_classid("") {}
 
 public:
@@ -4031,6 +4060,7 @@ protected:
     std::list<ImoStyle*> m_privateStyles;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoDocument(const std::string& version="");
     void initialize_object() override;
 
@@ -4094,6 +4124,7 @@ protected:
     EArpeggio m_type;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoArpeggio()
         : ImoRelObj(k_imo_arpeggio)
         , m_type(k_arpeggio_standard)
@@ -4151,6 +4182,7 @@ protected:
     int m_symbol;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoFermata()
         : ImoAuxObj(k_imo_fermata)
         , m_placement(k_placement_default)
@@ -4196,6 +4228,7 @@ public:
 class ImoArticulation : public ImoAuxObj
 {
 protected:
+    friend class ImSnapshot;
     int m_articulationType;
     int m_placement;
 
@@ -4244,6 +4277,7 @@ protected:
     int m_symbol;   //symbol to use when alternatives. For now only for breath_mark
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoArticulationSymbol()
         : ImoArticulation(k_imo_articulation_symbol)
         , m_fUp(true)
@@ -4320,6 +4354,7 @@ protected:
     Tenths m_dashSpace;     //only for dashed lines
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoArticulationLine()
         : ImoArticulation(k_imo_articulation_line)
         , m_lineShape(k_line_shape_straight)
@@ -4387,6 +4422,7 @@ protected:
 //    %enclosure;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoDynamicsMark() : ImoAuxObj(k_imo_dynamics_mark) {}
 
 public:
@@ -4423,6 +4459,7 @@ protected:
 //    %enclosure;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoOrnament()
         : ImoAuxObj(k_imo_ornament)
         , m_ornamentType(k_ornament_unknown)
@@ -4475,6 +4512,7 @@ protected:
     int m_placement;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTechnical()
         : ImoAuxObj(k_imo_technical)
         , m_technicalType(k_technical_unknown)
@@ -4515,6 +4553,7 @@ protected:
     int m_string = 1;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoFretString() : ImoTechnical(k_imo_fret_string)
     {
         m_technicalType = k_technical_fret_string;
@@ -4604,6 +4643,7 @@ protected:
     std::list<FingerData> m_fingerings;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoFingering() : ImoTechnical(k_imo_fingering)
     {
         m_technicalType = k_technical_fingering;
@@ -4636,6 +4676,7 @@ protected:
     static constexpr TimeUnits k_shift_start_end = 100000000.0;     //any too big value
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoGoBackFwd() : ImoStaffObj(k_imo_go_back_fwd), m_fFwd(true), m_rTimeShift(0.0) {}
 
 public:
@@ -4674,6 +4715,7 @@ protected:
     TimeUnits   m_makeTime;         //duration to assign
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoGraceRelObj()
         : ImoRelObj(k_imo_grace_relobj)
         , m_graceType(k_grace_steal_previous)
@@ -4725,6 +4767,7 @@ protected:
     TypeTextInfo m_text;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     friend class ImoInstrGroup;
     ImoScoreText() : ImoAuxObj(k_imo_score_text), m_text() {}
@@ -4757,6 +4800,7 @@ protected:
     int m_hAlign;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoScoreTitle() : ImoScoreText(k_imo_score_title), m_hAlign(k_halign_center) {}
 
 public:
@@ -4826,6 +4870,7 @@ protected:
     bool m_doubled;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTranspose()
         : ImoStaffObj(k_imo_transpose)
     {
@@ -4865,6 +4910,7 @@ protected:
     int m_repeatType;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTextRepetitionMark()
         : ImoScoreText(k_imo_text_repetition_mark)
         , m_repeatType(0)
@@ -4967,6 +5013,7 @@ protected:
     ImoId m_abbrevStyle = k_no_imoid;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoInstrGroup();
 
 public:
@@ -5049,6 +5096,7 @@ protected:
                                             //has no metric. Otherwise it will be nullptr.
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoInstrument();
     void initialize_object() override;
 
@@ -5330,6 +5378,7 @@ protected:
 
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoKeySignature() : ImoStaffObj(k_imo_key_signature) {}
 
 
@@ -5378,6 +5427,7 @@ protected:
     TypeLineStyle m_style;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLine() : ImoAuxObj(k_imo_line) {}
 
 public:
@@ -5414,6 +5464,7 @@ protected:
     int m_listType;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoList();
     void initialize_object() override;
 
@@ -5454,6 +5505,7 @@ protected:
     bool    m_fParenthesis;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoMetronomeMark()
         : ImoAuxObj(k_imo_metronome_mark), m_markType(k_value)
         , m_ticksPerMinute(60), m_leftNoteType(0), m_leftDots(0)
@@ -5538,6 +5590,7 @@ protected:
     std::vector<float> m_widths;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoMultiColumn();
     void initialize_object() override;
 
@@ -5595,6 +5648,7 @@ protected:
     float       m_rValue = 0.0f;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoOptionInfo() : ImoSimpleObj(k_imo_option) {}
 
 public:
@@ -5722,6 +5776,7 @@ protected:
     std::string m_value;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoParamInfo() : ImoSimpleObj(k_imo_param_info), m_name(), m_value() {}
 
 public:
@@ -5750,6 +5805,7 @@ protected:
     int m_level = 1;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoHeading() : ImoInlinesContainer(k_imo_heading) { set_edit_terminal(true); }
 
 public:
@@ -5803,6 +5859,7 @@ protected:
     TypeLineStyle m_style;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoScoreLine()
         : ImoAuxObj(k_imo_score_line)
         , m_startPoint(0.0f, 0.0f)
@@ -5940,6 +5997,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoScore;
     ImoSystemInfo() : ImoSimpleObj(k_imo_system_info) {}
 
@@ -5986,6 +6044,7 @@ protected:
     int m_accidentalsModel = k_only_notation_provided;  //how pitch//accidentals are initialized
     ColStaffObjs* m_pColStaffObjs = nullptr;
     SoundEventsTable* m_pMidiTable = nullptr;
+    std::vector<SoundEventsTable*> m_oldMidiTables;     //replaced, but still in use
     float m_scaling;                        //global scaling tenths -> LUnits
     ImoSystemInfo m_systemInfoFirst;
     ImoSystemInfo m_systemInfoOther;
@@ -6003,6 +6062,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoScore();
     void initialize_object() override;
 
@@ -6124,6 +6184,7 @@ protected:
     ImoStyle* create_default_style();
     void set_defaults_for_system_info();
     void set_defaults_for_options();
+    void delete_unused_midi_tables();
 
     friend class ScoreLdpGenerator;
     friend class ScoreMxlGenerator;
@@ -6143,6 +6204,7 @@ protected:
     int     m_orientation = k_orientation_default;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoSlur() : ImoRelObj(k_imo_slur) {}
     ImoSlur(int num) : ImoRelObj(k_imo_slur), m_slurNum(num) {}
 
@@ -6185,7 +6247,9 @@ protected:
     int     m_orientation;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoSlurData(ImoSlurDto* pDto);
+    ImoSlurData();
 
 public:
     //the five special
@@ -6203,6 +6267,7 @@ public:
 
     //building
     ImoBezierInfo* add_bezier();
+    inline void set_slur_number(int num) { m_slurNum = num; }
 };
 
 // raw info about a pending slur
@@ -6328,6 +6393,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class ImoInstrument;
     ImoStaffInfo(int numStaff=0, int lines=5, int type=k_staff_regular,
                  LUnits spacing=LOMSE_STAFF_LINE_SPACING,
@@ -6409,6 +6475,7 @@ protected:
     std::map<std::string, ImoStyle*> m_nameToStyle;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoStyles();
     void initialize_object() override;
 
@@ -6452,6 +6519,7 @@ protected:
     std::list<ImoId> m_colStyles;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTable() : ImoBlocksContainer(k_imo_table) {}
 
 public:
@@ -6486,6 +6554,7 @@ protected:
 
     friend class Document;
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTableCell();
     void initialize_object() override;
 
@@ -6603,6 +6672,7 @@ private:
 
 protected:
     friend class ImFactory;
+    friend class ImSnapshot;
     friend class TextItemAnalyser;
     friend class TextItemLmdAnalyser;
 
@@ -6642,6 +6712,7 @@ protected:
     int     m_orientation;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTieData(ImoTieDto* pDto);
     ImoTieData();
 
@@ -6671,6 +6742,7 @@ protected:
     int     m_orientation = k_orientation_default;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTie() : ImoRelObj(k_imo_tie) {}
     ImoTie(int num) : ImoRelObj(k_imo_tie), m_tieNum(num) {}
 
@@ -6833,6 +6905,7 @@ protected:
     int     m_type;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTimeSignature()
         : ImoStaffObj(k_imo_time_signature)
         , m_top(2)
@@ -7045,6 +7118,7 @@ protected:
     int m_nPlacement = k_placement_default;     //a value from enum EPlacement
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoTuplet() : ImoRelObj(k_imo_tuplet) {}
     ImoTuplet(ImoTupletDto* dto);
 
@@ -7098,6 +7172,7 @@ protected:
     // ImoLyricsTextInfo[]
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLyric()
         : ImoAuxRelObj(k_imo_lyric)
         , m_number(0)
@@ -7175,6 +7250,7 @@ protected:
 //    Color m_elisionColor;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoLyricsTextInfo() : ImoSimpleObj(k_imo_lyrics_text_info) {}
 
 
@@ -7216,6 +7292,7 @@ protected:
     int     m_octaveShiftNum;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoOctaveShift(int num=0)
         : ImoRelObj(k_imo_octave_shift)
         , m_steps(0)
@@ -7303,6 +7380,7 @@ protected:
     bool m_fAbbreviated = false;
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoPedalMark() : ImoAuxObj(k_imo_pedal_mark) {}
 
 public:
@@ -7337,6 +7415,7 @@ class ImoPedalLine : public ImoRelObj
 
 protected:
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoPedalLine() : ImoRelObj(k_imo_pedal_line) {}
 
 public:
@@ -7456,6 +7535,7 @@ protected:
     int m_numVoltas;                //number of voltas in the set
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoVoltaBracket()
         : ImoRelObj(k_imo_volta_bracket)
         , m_fStopJog(true)
@@ -7667,6 +7747,7 @@ protected:
     };
 
     friend class ImFactory;
+    friend class ImSnapshot;
     ImoWedge(int num=0) : ImoRelObj(k_imo_wedge), m_wedgeNum(num) {}
 
 public:
@@ -26,6 +26,8 @@
 #include "lomse_lmd_exporter.h"
 #include "lomse_model_builder.h"
 #include "lomse_im_factory.h"
+#include "lomse_im_snapshot.h"
+#include "lomse_im_note.h"
 #include "lomse_events.h"
 #include "lomse_ldp_elements.h"
 #include "lomse_control.h"
@@ -35,6 +37,7 @@
 #include "lomse_relobj_cloner.h"
 
 #include <sstream>
+#include <atomic>
 using namespace std;
 
 ///@cond INTERNALS
@@ -153,6 +156,107 @@ public:
 };
 
 
+//=======================================================================================
+// TransferIdsVisitor: helper visitor for moving the objects of a subtree from one
+// DocModel to another one. Only objects owned by the source model are moved. Ids
+// not greater than 'maxKeptId' are preserved and all other ids are displaced by
+// 'shift', including the ids stored in other objects for referencing them.
+//=======================================================================================
+class TransferIdsVisitor : public Visitor<ImoObj>
+{
+protected:
+    DocModel* m_pSource = nullptr;
+    DocModel* m_pTarget = nullptr;
+    IdAssigner* m_pSourceIds = nullptr;
+    IdAssigner* m_pTargetIds = nullptr;
+    ImoId m_maxKeptId = k_no_imoid;
+    ImoId m_shift = 0;
+
+public:
+    TransferIdsVisitor(DocModel* pSource, IdAssigner* pSourceIds,
+                       DocModel* pTarget, IdAssigner* pTargetIds,
+                       ImoId maxKeptId, ImoId shift)
+        : Visitor<ImoObj>()
+        , m_pSource(pSource)
+        , m_pTarget(pTarget)
+        , m_pSourceIds(pSourceIds)
+        , m_pTargetIds(pTargetIds)
+        , m_maxKeptId(maxKeptId)
+        , m_shift(shift)
+    {
+    }
+
+    void start_visit(ImoObj* pImo) override
+    {
+        //AWARE: RelObjs are visited once per participant. Only the first visit
+        //has to do the transfer
+        if (pImo->get_doc_model() != m_pSource)
+            return;
+
+        pImo->anchor_to_model(m_pTarget);
+
+        if (m_shift != 0)
+            shift_references(pImo);
+
+        ImoId id = pImo->get_id();
+        if (id == k_no_imoid)
+            return;
+
+        string xmlId = m_pSourceIds->get_xml_id_for(id);
+        m_pSourceIds->remove(pImo);     //AWARE: it also clears the id in pImo
+
+        id = shifted(id);
+        pImo->set_id(id);
+        m_pTargetIds->add_id(id, pImo);
+
+        if (!xmlId.empty())
+            m_pTargetIds->set_xml_id_for(id, xmlId);
+    }
+
+protected:
+
+    inline ImoId shifted(ImoId id)
+    {
+        return (id > m_maxKeptId ? id + m_shift : id);
+    }
+
+    void shift_references(ImoObj* pImo)
+    {
+        if (pImo->is_contentobj())
+        {
+            ImoContentObj* pCO = static_cast<ImoContentObj*>(pImo);
+            pCO->m_styleId = shifted(pCO->m_styleId);
+        }
+
+        if (pImo->is_relobj())
+        {
+            ImoRelObj* pRO = static_cast<ImoRelObj*>(pImo);
+        #if (LOMSE_RELOBJ_USES_ID == 1)
+            for (auto& item : pRO->m_relatedObjects)
+                item.first = shifted(item.first);
+        #endif
+        }
+        else if (pImo->is_auxrelobj())
+        {
+            ImoAuxRelObj* pARO = static_cast<ImoAuxRelObj*>(pImo);
+            pARO->m_prevId = shifted(pARO->m_prevId);
+            pARO->m_nextId = shifted(pARO->m_nextId);
+        }
+        else if (pImo->is_direction())
+        {
+            ImoDirection* pDir = static_cast<ImoDirection*>(pImo);
+            pDir->m_idNR = shifted(pDir->m_idNR);
+        }
+        else if (pImo->is_note())
+        {
+            ImoNote* pNote = static_cast<ImoNote*>(pImo);
+            pNote->m_idTieNext = shifted(pNote->m_idTieNext);
+            pNote->m_idTiePrev = shifted(pNote->m_idTiePrev);
+        }
+    }
+};
+
+
 //=======================================================================================
 // DocModel implementation
 //=======================================================================================
@@ -211,7 +315,7 @@ DocModel& DocModel::clone(const DocModel& a)
 //---------------------------------------------------------------------------------------
 void DocModel::add_unique_model_ref()
 {
-    static long m_refsCounter = 0L;     //global counter to create unique id numbers
+    static std::atomic<long> m_refsCounter(0L);   //global counter to create unique id numbers
 
     m_imRef = ++m_refsCounter;
 }
@@ -297,6 +401,40 @@ void DocModel::on_removed_from_model(ImoObj* pImo)
     m_pIdAssigner->remove(pImo);
 }
 
+//---------------------------------------------------------------------------------------
+ImoId DocModel::get_last_assigned_id() const
+{
+    return m_pIdAssigner->get_last_id();
+}
+
+//---------------------------------------------------------------------------------------
+void DocModel::lend_subtree(ImoObj* pImo, DocModel* pBorrower)
+{
+    //the borrower will continue numbering from current counter. Thus, ids of
+    //objects created while the subtree is lent will not collide with the lent ones
+    IdAssigner* pIds = pBorrower->m_pIdAssigner;
+    ImoId maxId = m_pIdAssigner->get_last_id();
+    pIds->set_counter( max(pIds->get_last_id(), maxId) );
+
+    TransferIdsVisitor v(this, m_pIdAssigner, pBorrower, pIds, maxId, 0);
+    pImo->accept_visitor(v);
+}
+
+//---------------------------------------------------------------------------------------
+void DocModel::reclaim_subtree(ImoObj* pImo, DocModel* pBorrower, ImoId maxLentId)
+{
+    //objects created by the borrower are renumbered, preserving their order, after
+    //the last id assigned in this model
+    IdAssigner* pIds = pBorrower->m_pIdAssigner;
+    ImoId shift = m_pIdAssigner->get_last_id() - maxLentId;
+
+    TransferIdsVisitor v(pBorrower, pIds, this, m_pIdAssigner, maxLentId, shift);
+    pImo->accept_visitor(v);
+
+    m_pIdAssigner->set_counter( max(m_pIdAssigner->get_last_id(),
+                                    pIds->get_last_id() + shift) );
+}
+
 
 
 //=======================================================================================
@@ -324,6 +462,7 @@ Document::~Document()
     delete pModel;
 
     delete_observers();
+    delete m_pMxlOptions;
 }
 
 //---------------------------------------------------------------------------------------
@@ -424,6 +563,37 @@ int Document::from_input(LdpReader& reader)
     }
 }
 
+//---------------------------------------------------------------------------------------
+bool Document::from_snapshot(const char* data, size_t size)
+{
+    initialize();
+    m_pModel->m_pImoDoc = ImSnapshot::load(m_pModel, data, size);
+    if (m_pModel->m_pImoDoc == nullptr)
+        return false;
+
+    m_pModel->add_unique_model_ref();
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool Document::to_snapshot(string& out)
+{
+    return ImSnapshot::save(m_pModel, out);
+}
+
+//---------------------------------------------------------------------------------------
+void Document::set_musicxml_options(const MusicXmlOptions& options)
+{
+    delete m_pMxlOptions;
+    m_pMxlOptions = LOMSE_NEW MusicXmlOptions(options);
+}
+
+//---------------------------------------------------------------------------------------
+MusicXmlOptions* Document::get_musicxml_options()
+{
+    return (m_pMxlOptions ? m_pMxlOptions : m_libraryScope.get_musicxml_options());
+}
+
 //---------------------------------------------------------------------------------------
 void Document::create_empty()
 {
@@ -453,7 +623,7 @@ void Document::end_of_changes()
 //---------------------------------------------------------------------------------------
 void Document::fix_malformed_musicxml()
 {
-    if (m_libraryScope.get_musicxml_options()->use_default_clefs())
+    if (get_musicxml_options()->use_default_clefs())
     {
         ImoScore* pScore = dynamic_cast<ImoScore*>( m_pModel->m_pImoDoc->get_content_item(0) );
         if (pScore)
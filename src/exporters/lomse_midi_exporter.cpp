@@ -0,0 +1,369 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_midi_exporter.h"
+
+#include "lomse_internal_model.h"
+#include "lomse_midi_table.h"
+#include "lomse_logger.h"
+
+#include <fstream>
+using namespace std;
+
+namespace lomse
+{
+
+//some SMF constants
+const int k_smf_note_off = 0x80;
+const int k_smf_note_on = 0x90;
+const int k_smf_program_change = 0xC0;
+const int k_smf_meta_tempo = 0x51;
+const int k_smf_meta_time_signature = 0x58;
+const int k_smf_meta_end_of_track = 0x2F;
+
+//To protect against endless loops in badly defined repetitions
+const int k_max_executed_jumps = 10000;
+
+
+//=======================================================================================
+// MidiExporter implementation
+//=======================================================================================
+MidiExporter::MidiExporter()
+    : m_nMM(0)
+    , m_beatDuration(k_duration_quarter)
+    , m_division(960)
+{
+}
+
+//---------------------------------------------------------------------------------------
+string MidiExporter::get_smf(AScore score)
+{
+    if (score.is_valid())
+        return get_smf(score.internal_object());
+
+    return string();
+}
+
+//---------------------------------------------------------------------------------------
+string MidiExporter::get_smf(ImoScore* pScore)
+{
+    SoundEventsTable* pTable = pScore->get_midi_table();
+    create_tracks(pTable);
+    add_events(pTable);
+    return build_smf();
+}
+
+//---------------------------------------------------------------------------------------
+bool MidiExporter::save_smf(AScore score, const std::string& filename)
+{
+    if (!score.is_valid())
+        return false;
+
+    string smf = get_smf(score);
+    ofstream file(filename, ios::out | ios::binary | ios::trunc);
+    if (file.good())
+        file.write(smf.c_str(), streamsize(smf.size()));
+
+    if (!file.good())
+    {
+        LOMSE_LOG_ERROR("Error writing SMF file '%s'", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::create_tracks(SoundEventsTable* pTable)
+{
+    m_tracks.clear();
+    m_channelTrack.clear();
+    m_trackTime.clear();
+    m_runningStatus.clear();
+
+    //track 0 for tempo and time signatures
+    m_tracks.resize(1);
+    m_trackTime.push_back(0L);
+    m_runningStatus.push_back(0);
+
+    //a track for each channel, in instruments order
+    for (int channel : pTable->get_channels())
+        track_for_channel(channel);
+}
+
+//---------------------------------------------------------------------------------------
+int MidiExporter::track_for_channel(int channel)
+{
+    map<int, int>::iterator it = m_channelTrack.find(channel);
+    if (it != m_channelTrack.end())
+        return it->second;
+
+    int iTrack = int(m_tracks.size());
+    m_channelTrack[channel] = iTrack;
+    m_tracks.push_back( vector<unsigned char>() );
+    m_trackTime.push_back(0L);
+    m_runningStatus.push_back(0);
+    return iTrack;
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_events(SoundEventsTable* pTable)
+{
+    //Traverse the events table as if it were played back (see PlaybackSession), so
+    //that all jumps are executed. Times after a jump are shifted for continuing
+    //after the time of the jump event. A tempo event is added each time the
+    //playback enters a segment of the tempo map with a different tempo.
+    //AWARE: the table is shared with the player. Jump counters are local and the
+    //tempo map is not modified
+
+    vector<SoundEvent*>& events = pTable->get_events();
+    int numEvents = int(events.size());
+    long shift = 0L;    //time to add to table times, in TU
+    long endTime = 0L;
+    int numJumps = 0;
+
+    //for each jump: times executed, times visited
+    int numJumpEntries = pTable->num_jumps();
+    vector< pair<int, int> > jumps(numJumpEntries, make_pair(0, 0));
+    map<JumpEntry*, int> jumpIndex;
+    for (int i=0; i < numJumpEntries; ++i)
+        jumpIndex[pTable->get_jump(i)] = i;
+
+    TempoMap* pTempoMap = pTable->get_tempo_map();
+    float fixedTempo = 0.0f;
+    if (m_nMM > 0)
+        fixedTempo = float(m_nMM) * float(m_beatDuration) / float(k_duration_quarter);
+    int iBreakpoint = 0;
+    float tempo = (fixedTempo > 0.0f ? fixedTempo
+                                     : pTempoMap->get_breakpoint_score_tempo(0));
+    add_tempo(0L, tempo);
+
+    int i = 0;
+    while (i < numEvents)
+    {
+        SoundEvent* pEvent = events[i];
+        long time = pEvent->DeltaTime + shift;
+        endTime = max(endTime, time);
+
+        int iNew = pTempoMap->find_breakpoint(TimeUnits(pEvent->DeltaTime));
+        if (fixedTempo == 0.0f && iNew != iBreakpoint)
+        {
+            iBreakpoint = iNew;
+            float newTempo = pTempoMap->get_breakpoint_score_tempo(iNew);
+            if (newTempo != tempo)
+            {
+                //after a jump, the breakpoint could be before the jump time. In that
+                //case the tempo event will be placed at current time
+                long bpTime = long(pTempoMap->get_breakpoint_timepos(iNew) + 0.5) + shift;
+                add_tempo(time_to_ticks(bpTime), newTempo);
+                tempo = newTempo;
+            }
+        }
+
+        if (pEvent->EventType == SoundEvent::k_jump)
+        {
+            JumpEntry* pJump = pEvent->pJump;
+            int& executed = jumps[jumpIndex[pJump]].first;
+            int& visited = jumps[jumpIndex[pJump]].second;
+            bool fExecuted = false;
+            if (visited >= pJump->get_times_before()
+                && (pJump->get_times_valid() == 0 || pJump->get_times_valid() > executed))
+            {
+                if (++numJumps > k_max_executed_jumps)
+                {
+                    LOMSE_LOG_ERROR("Endless loop in repetitions. SMF truncated.");
+                    break;
+                }
+                i = pJump->get_event();
+                shift = time - events[i]->DeltaTime;
+                if (pJump->get_times_valid() > executed)
+                    ++executed;
+                fExecuted = true;
+            }
+            ++visited;
+            if (!fExecuted)
+                ++i;
+            continue;
+        }
+
+        long ticks = time_to_ticks(time);
+        switch (pEvent->EventType)
+        {
+            case SoundEvent::k_prog_instr:
+                add_channel_event(track_for_channel(pEvent->Channel), ticks,
+                                  k_smf_program_change | pEvent->Channel,
+                                  pEvent->Instrument, -1);
+                break;
+
+            case SoundEvent::k_note_on:
+                add_channel_event(track_for_channel(pEvent->Channel), ticks,
+                                  k_smf_note_on | pEvent->Channel,
+                                  pEvent->NotePitch, pEvent->Volume);
+                break;
+
+            case SoundEvent::k_note_off:
+                add_channel_event(track_for_channel(pEvent->Channel), ticks,
+                                  k_smf_note_off | pEvent->Channel,
+                                  pEvent->NotePitch, 127);
+                break;
+
+            case SoundEvent::k_rhythm_change:
+                add_time_signature(ticks, pEvent->TopNumber, pEvent->BeatDuration,
+                                   pEvent->NumPulses);
+                break;
+
+            default:
+                //visual events are ignored
+                break;
+        }
+
+        if (pEvent->EventType == SoundEvent::k_end_of_score)
+            break;
+        ++i;
+    }
+
+    //end of track for all tracks
+    long ticks = time_to_ticks(endTime);
+    for (int iTrack=0; iTrack < int(m_tracks.size()); ++iTrack)
+        add_meta_event(iTrack, ticks, k_smf_meta_end_of_track, nullptr, 0);
+}
+
+//---------------------------------------------------------------------------------------
+long MidiExporter::time_to_ticks(long deltaTime)
+{
+    return deltaTime * long(m_division) / long(k_duration_quarter);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_tempo(long ticks, float qpm)
+{
+    //microseconds per quarter note
+    long tempo = long(60000000.0 / double(qpm) + 0.5);
+    tempo = min(tempo, 0xFFFFFFL);
+
+    unsigned char data[3];
+    data[0] = static_cast<unsigned char>((tempo >> 16) & 0xFF);
+    data[1] = static_cast<unsigned char>((tempo >> 8) & 0xFF);
+    data[2] = static_cast<unsigned char>(tempo & 0xFF);
+    add_meta_event(0, ticks, k_smf_meta_tempo, data, 3);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_time_signature(long ticks, int top, int beatDuration,
+                                      int numPulses)
+{
+    //beatDuration is the duration implied by the bottom number. Denominator is
+    //encoded as a power of 2
+    int bottom = (beatDuration > 0 ? int(k_duration_whole) / beatDuration : 4);
+    int power = 0;
+    while ((1 << power) < bottom)
+        ++power;
+
+    //MIDI clocks (24 per quarter note) per metronome click
+    int clocks = 24;
+    if (numPulses > 0)
+        clocks = (24 * top * beatDuration) / (numPulses * int(k_duration_quarter));
+
+    unsigned char data[4];
+    data[0] = static_cast<unsigned char>(top);
+    data[1] = static_cast<unsigned char>(power);
+    data[2] = static_cast<unsigned char>(clocks);
+    data[3] = 8;    //32nd notes per quarter note
+    add_meta_event(0, ticks, k_smf_meta_time_signature, data, 4);
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_channel_event(int iTrack, long ticks, int status,
+                                     int data1, int data2)
+{
+    add_delta_time(iTrack, ticks);
+    vector<unsigned char>& track = m_tracks[iTrack];
+    if (status != m_runningStatus[iTrack])
+    {
+        track.push_back(static_cast<unsigned char>(status));
+        m_runningStatus[iTrack] = status;
+    }
+    track.push_back(static_cast<unsigned char>(data1 & 0x7F));
+    if (data2 >= 0)
+        track.push_back(static_cast<unsigned char>(data2 & 0x7F));
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_meta_event(int iTrack, long ticks, int type,
+                                  const unsigned char* data, int size)
+{
+    add_delta_time(iTrack, ticks);
+    vector<unsigned char>& track = m_tracks[iTrack];
+    track.push_back(0xFF);
+    track.push_back(static_cast<unsigned char>(type));
+    add_variable_length(track, static_cast<unsigned long>(size));
+    if (size > 0)
+        track.insert(track.end(), data, data + size);
+
+    //running status is not used after meta events
+    m_runningStatus[iTrack] = 0;
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_delta_time(int iTrack, long ticks)
+{
+    long delta = max(0L, ticks - m_trackTime[iTrack]);
+    add_variable_length(m_tracks[iTrack], static_cast<unsigned long>(delta));
+    m_trackTime[iTrack] += delta;
+}
+
+//---------------------------------------------------------------------------------------
+void MidiExporter::add_variable_length(vector<unsigned char>& track, unsigned long value)
+{
+    //seven bits per byte, most significant first. All bytes but the last one have
+    //bit 7 set
+    unsigned char bytes[5];
+    int n = 0;
+    bytes[n++] = static_cast<unsigned char>(value & 0x7F);
+    while ((value >>= 7) > 0)
+        bytes[n++] = static_cast<unsigned char>((value & 0x7F) | 0x80);
+
+    while (n > 0)
+        track.push_back(bytes[--n]);
+}
+
+//---------------------------------------------------------------------------------------
+string MidiExporter::build_smf()
+{
+    size_t size = 14;
+    for (const vector<unsigned char>& track : m_tracks)
+        size += 8 + track.size();
+
+    string smf;
+    smf.reserve(size);
+
+    //header chunk: format 1, num. tracks, division
+    int numTracks = int(m_tracks.size());
+    smf.append("MThd", 4);
+    const char header[] = { 0, 0, 0, 6, 0, 1,
+                            char(numTracks >> 8), char(numTracks & 0xFF),
+                            char(m_division >> 8), char(m_division & 0xFF) };
+    smf.append(header, sizeof(header));
+
+    //track chunks
+    for (const vector<unsigned char>& track : m_tracks)
+    {
+        size_t length = track.size();
+        smf.append("MTrk", 4);
+        smf.push_back(char((length >> 24) & 0xFF));
+        smf.push_back(char((length >> 16) & 0xFF));
+        smf.push_back(char((length >> 8) & 0xFF));
+        smf.push_back(char(length & 0xFF));
+        if (length > 0)
+            smf.append(reinterpret_cast<const char*>(&track[0]), length);
+    }
+    return smf;
+}
+
+
+}  //namespace lomse
@@ -32,6 +32,7 @@ ZipInputStream::ZipInputStream(const std::string& filelocator)
     , m_fIsLastBuffer(true)
     , m_remainingBytes(0)
     , m_pNextChar(nullptr)
+    , m_fEntriesIndexed(false)
 {
     if (!open_zip_archive(filelocator))
     {
@@ -142,10 +143,47 @@ bool ZipInputStream::move_to_entry(const std::string& innerPath)
 {
     close_current_entry();
 
-    bool fSuccess = (unzLocateFile(m_uzFile, innerPath.c_str(), 2) == UNZ_OK);
+    if (!m_fEntriesIndexed)
+        index_entries();
+
+    //AWARE: the index is case sensitive. If the entry is not found, fall back to
+    //minizip search, that uses the platform rules for file names comparison.
+    bool fSuccess;
+    map<string, unz_file_pos>::iterator it = m_entries.find(innerPath);
+    if (it != m_entries.end())
+        fSuccess = (unzGoToFilePos(m_uzFile, &(it->second)) == UNZ_OK);
+    else
+        fSuccess = (unzLocateFile(m_uzFile, innerPath.c_str(), 2) == UNZ_OK);
+
     return set_up_current_entry(fSuccess);
 }
 
+//---------------------------------------------------------------------------------------
+void ZipInputStream::index_entries()
+{
+    //Walks the central directory once and saves the position of each entry, so that
+    //later look-ups by name do not require to scan the directory again.
+
+    m_fEntriesIndexed = true;
+    m_entries.clear();
+
+    char filename[256];
+    filename[255] = '\0';
+    int res = unzGoToFirstFile(m_uzFile);
+    while (res == UNZ_OK)
+    {
+        unz_file_info uzfi;
+        unz_file_pos pos;
+        if (unzGetCurrentFileInfo(m_uzFile, &uzfi, filename, 255,
+                                  nullptr, 0, nullptr, 0) == UNZ_OK
+            && unzGetFilePos(m_uzFile, &pos) == UNZ_OK)
+        {
+            m_entries.insert( make_pair(string(filename), pos) );
+        }
+        res = unzGoToNextFile(m_uzFile);
+    }
+}
+
 //---------------------------------------------------------------------------------------
 bool ZipInputStream::set_up_current_entry(bool fSuccess)
 {
@@ -409,6 +447,44 @@ std::vector<unsigned char> ZipInputStream::get_as_vector()
     return buffer;
 }
 
+//---------------------------------------------------------------------------------------
+long ZipInputStream::inflate_current_entry(unsigned char* pDestBuffer, long nBufferSize)
+{
+    //Decompresses the current entry directly into the provided buffer, without
+    //using the internal stream buffer. The entry is re-opened and, when finished,
+    //is left closed. Returns the number of bytes written into the buffer or -1 if
+    //the entry could not be inflated.
+
+    close_current_entry();
+
+    if (!m_curEntry.fIsValid || unzOpenCurrentFile(m_uzFile) != UNZ_OK)
+        return -1L;
+
+    long total = 0L;
+    while (total < nBufferSize)
+    {
+        int bytes = unzReadCurrentFile(m_uzFile, pDestBuffer + total,
+                                       unsigned(nBufferSize - total));
+        if (bytes < 0)
+        {
+            total = -1L;
+            break;
+        }
+        if (bytes == 0)
+            break;
+        total += long(bytes);
+    }
+
+    //AWARE: unzCloseCurrentFile() checks the CRC only when the entry has been fully read
+    if (unzCloseCurrentFile(m_uzFile) == UNZ_CRCERROR)
+        total = -1L;
+
+    m_remainingBytes = 0;
+    m_curEntry.fIsOpen = false;
+    m_curEntry.fEOF = true;
+    return total;
+}
+
 }  //namespace lomse
 
 #endif  // LOMSE_ENABLE_COMPRESSION
@@ -11,10 +11,15 @@
 
 #include "lomse_injectors.h"
 
+#include <algorithm>
+
 
 namespace lomse
 {
 
+//the glyph metrics table for the music font, generated at build time
+#include "lomse_glyph_metrics.h"
+
 
 //---------------------------------------------------------------------------------------
 //the glyphs table for SMuFL compliant fonts
@@ -878,6 +883,7 @@ const GlyphData m_glyphs_smufl[] =
 MusicGlyphs::MusicGlyphs(LibraryScope* pLibScope)
     : m_pLibScope(pLibScope)
     , m_glyphs(nullptr)
+    , m_metrics(nullptr)
 {
     update();
 }
@@ -887,6 +893,61 @@ void MusicGlyphs::update()
 {
     if (m_pLibScope->is_music_font_smufl_compliant())
         m_glyphs = &m_glyphs_smufl[0];
+
+    //metrics table is only valid for the font used for generating it
+    bool fValid = k_num_glyph_metrics > 0
+                  && m_pLibScope->get_music_font_name() == k_glyph_metrics_font;
+    m_metrics = (fValid ? &k_glyph_metrics[0] : nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+const GlyphMetrics* MusicGlyphs::get_metrics(unsigned int ch)
+{
+    if (!m_metrics)
+        return nullptr;
+
+    //table is ordered by code point
+    const GlyphMetrics* pEnd = m_metrics + k_num_glyph_metrics;
+    const GlyphMetrics* it = std::lower_bound(m_metrics, pEnd, ch,
+        [](const GlyphMetrics& data, unsigned int code) { return data.code < code; });
+
+    return (it != pEnd && it->code == ch ? it : nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+LUnits MusicGlyphs::staff_space(double fontHeight)
+{
+    //font height is in points and one em is four staff spaces
+    return LUnits(fontHeight * 2540.0 / 72.0 / 4.0);
+}
+
+//---------------------------------------------------------------------------------------
+bool MusicGlyphs::bounding_rectangle(unsigned int ch, double fontHeight, URect* pRect)
+{
+    //Returns the glyph bounding box, relative to the glyph origin and with y axis
+    //pointing downwards, as TextMeter::bounding_rectangle() does
+
+    const GlyphMetrics* pData = get_metrics(ch);
+    if (!pData)
+        return false;
+
+    LUnits space = staff_space(fontHeight);
+    pRect->x = pData->left * space;
+    pRect->y = -pData->top * space;
+    pRect->width = (pData->right - pData->left) * space;
+    pRect->height = (pData->top - pData->bottom) * space;
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+bool MusicGlyphs::advance_x(unsigned int ch, double fontHeight, LUnits* pWidth)
+{
+    const GlyphMetrics* pData = get_metrics(ch);
+    if (!pData)
+        return false;
+
+    *pWidth = pData->advance * staff_space(fontHeight);
+    return true;
 }
 
 }  //namespace lomse
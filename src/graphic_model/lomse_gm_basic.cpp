@@ -19,9 +19,11 @@
 #include "lomse_box_system.h"
 #include "lomse_logger.h"
 #include "lomse_gm_measures_table.h"
+#include "lomse_gm_tracking_table.h"
 
 #include <cstdlib>      //abs
 #include <iomanip>
+#include <mutex>         //call_once
 using namespace std;
 
 
@@ -35,7 +37,7 @@ namespace lomse
 
 //association object-type <-> object-name
 static std::map<int, std::string> m_typeToName;
-static bool m_fNamesLoaded = false;
+static std::once_flag m_namesLoaded;
 static string m_unknown = "unknown";
 
 //---------------------------------------------------------------------------------------
@@ -123,7 +125,7 @@ void GmoObj::dump(ostream& outStream, int level)
 //---------------------------------------------------------------------------------------
 const string& GmoObj::get_name(int objtype)
 {
-    if (!m_fNamesLoaded)
+    std::call_once(m_namesLoaded, []()
     {
         m_typeToName[k_box]                     = "box (A)";
         m_typeToName[k_box_control]             = "box-control";
@@ -194,9 +196,7 @@ const string& GmoObj::get_name(int objtype)
         m_typeToName[k_shape_volta_bracket]     = "volta-bracket";
         m_typeToName[k_shape_word]              = "word";
         m_typeToName[k_shape_wedge]             = "wedge";
-
-        m_fNamesLoaded = true;
-    }
+    });
 
 	map<int, std::string>::const_iterator it = m_typeToName.find( objtype );
 	if (it != m_typeToName.end())
@@ -1171,6 +1171,7 @@ void GmoBoxLink::notify_event(SpEventInfo pEvent)
 //=======================================================================================
 ScoreStub::ScoreStub(ImoScore* pScore)
     : m_scoreId(pScore->get_id())
+    , m_tracking(nullptr)
 {
     m_measures = LOMSE_NEW GmMeasuresTable(pScore);
 }
@@ -1179,6 +1180,25 @@ ScoreStub::ScoreStub(ImoScore* pScore)
 ScoreStub::~ScoreStub()
 {
     delete m_measures;
+    delete m_tracking;
+}
+
+//---------------------------------------------------------------------------------------
+void ScoreStub::add_page(GmoBoxScorePage* pPage)
+{
+    m_pages.push_back(pPage);
+
+    //tracking table is no longer valid
+    delete m_tracking;
+    m_tracking = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+GmTrackingTable* ScoreStub::get_tracking_table()
+{
+    if (!m_tracking)
+        m_tracking = LOMSE_NEW GmTrackingTable(m_pages);
+    return m_tracking;
 }
 
 //---------------------------------------------------------------------------------------
@@ -0,0 +1,188 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_gm_tracking_table.h"
+
+#include "lomse_gm_basic.h"
+#include "lomse_box_system.h"
+#include "lomse_timegrid_table.h"
+#include "lomse_time.h"
+
+//std
+#include <sstream>
+#include <iomanip>
+using namespace std;
+
+namespace lomse
+{
+
+//=======================================================================================
+//GmTrackingTable implementation
+//=======================================================================================
+GmTrackingTable::GmTrackingTable(vector<GmoBoxScorePage*>& pages)
+{
+    for (GmoBoxScorePage* pPage : pages)
+    {
+        //AWARE: first page could be empty. See ScoreStub::get_page_for()
+        int iFirst = pPage->get_num_first_system();
+        int iMax = iFirst + pPage->get_num_systems();
+        for (int i=iFirst; i < iMax; ++i)
+            add_system(pPage->get_system(i));
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void GmTrackingTable::add_system(GmoBoxSystem* pSystem)
+{
+    SystemEntry sys;
+    sys.pSystem = pSystem;
+    sys.iPage = pSystem->get_page_number();
+    sys.startTime = pSystem->start_time();
+    sys.endTime = pSystem->end_time();
+    sys.iFirst = int(m_times.size());
+
+    //group TimeGridTable entries with the same timepos. The x position for a
+    //note/rest is the position of the first entry when it has duration (a note or
+    //rest) or, otherwise, the position of the last entry with that timepos
+    vector<TimeGridTableEntry>& entries = pSystem->get_time_grid_table()->get_entries();
+    vector<TimeGridTableEntry>::iterator it = entries.begin();
+    while (it != entries.end())
+    {
+        TimeEntry entry;
+        entry.timepos = (*it).rTimepos;
+        entry.xFirst = (*it).uxPos;
+        bool fHasDuration = ((*it).rDuration > 0.0);
+
+        vector<TimeGridTableEntry>::iterator itLast = it;
+        for (++it; it != entries.end() && is_equal_time(entry.timepos, (*it).rTimepos); ++it)
+            itLast = it;
+
+        entry.lastTimepos = (*itLast).rTimepos;
+        entry.xLast = (*itLast).uxPos;
+        entry.xNoteRest = (fHasDuration ? entry.xFirst : entry.xLast);
+        m_times.push_back(entry);
+    }
+
+    sys.iEnd = int(m_times.size());
+    m_systems.push_back(sys);
+}
+
+//---------------------------------------------------------------------------------------
+bool GmTrackingTable::find(TimeUnits timepos, TrackingPosition* pPos)
+{
+    int iSystem = find_system_index(timepos);
+    if (iSystem == -1)
+        return false;
+
+    pPos->pSystem = m_systems[iSystem].pSystem;
+    pPos->iPage = m_systems[iSystem].iPage;
+    pPos->xPos = find_x_in_system(iSystem, timepos);
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+GmoBoxSystem* GmTrackingTable::find_system(TimeUnits timepos)
+{
+    int iSystem = find_system_index(timepos);
+    return (iSystem == -1 ? nullptr : m_systems[iSystem].pSystem);
+}
+
+//---------------------------------------------------------------------------------------
+int GmTrackingTable::find_system_index(TimeUnits timepos)
+{
+    //Find first system with end time greater or equal than timepos. When timepos
+    //is the end time of a system and next system starts at that timepos, next
+    //system is preferred (a note/rest instead of the barline ending the system).
+    //Returns -1 if not found
+
+    int iMax = int(m_systems.size());
+    int lo = 0;
+    int hi = iMax;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        TimeUnits endTime = m_systems[mid].endTime;
+        if (is_lower_time(endTime, timepos))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == iMax)
+        return -1;
+
+    if (is_equal_time(timepos, m_systems[lo].endTime) && lo + 1 < iMax
+        && is_equal_time(timepos, m_systems[lo + 1].startTime))
+    {
+        ++lo;
+    }
+    return lo;
+}
+
+//---------------------------------------------------------------------------------------
+LUnits GmTrackingTable::find_x_in_system(int iSystem, TimeUnits timepos)
+{
+    //Same results than TimeGridTable::get_x_for_note_rest_at_time()
+
+    int iFirst = m_systems[iSystem].iFirst;
+    int iEnd = m_systems[iSystem].iEnd;
+
+    //xPos = 0 if table is empty or timepos < first entry timepos
+    if (iFirst == iEnd || is_lower_time(timepos, m_times[iFirst].timepos))
+        return 0.0f;
+
+    //find first entry with timepos greater or equal than requested timepos
+    int lo = iFirst;
+    int hi = iEnd;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (is_lower_time(m_times[mid].timepos, timepos))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    //if not found return last entry xPos
+    if (lo == iEnd)
+        return m_times[iEnd - 1].xLast;
+
+    TimeEntry& entry = m_times[lo];
+    if (is_equal_time(timepos, entry.timepos))
+        return entry.xNoteRest;
+
+    //interpolate
+    TimeEntry& prev = m_times[lo - 1];
+    double dx = double(entry.xFirst - prev.xLast)
+                / double(entry.timepos - prev.lastTimepos);
+    return prev.xLast + LUnits( double(timepos - prev.lastTimepos) * dx );
+}
+
+//---------------------------------------------------------------------------------------
+string GmTrackingTable::dump_table()
+{
+    stringstream s;
+    s << "GmTrackingTable: " << m_systems.size() << " systems, "
+      << m_times.size() << " entries" << endl;
+    for (size_t i=0; i < m_systems.size(); ++i)
+    {
+        SystemEntry& sys = m_systems[i];
+        s << fixed << setprecision(2) << "system " << i << ", page " << sys.iPage
+          << ", time " << sys.startTime << " - " << sys.endTime << endl;
+        for (int j=sys.iFirst; j < sys.iEnd; ++j)
+        {
+            s << setw(11) << m_times[j].timepos
+              << setw(14) << setprecision(5) << m_times[j].xNoteRest
+              << setprecision(2) << endl;
+        }
+    }
+    return s.str();
+}
+
+
+}  //namespace lomse
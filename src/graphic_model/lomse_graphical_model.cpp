@@ -25,10 +25,12 @@
 #include "lomse_box_slice.h"
 #include "lomse_timegrid_table.h"
 #include "lomse_score_algorithms.h"
+#include "lomse_gm_tracking_table.h"
 #include "lomse_logger.h"
 
 #include <cstdlib>      //abs
 #include <iomanip>
+#include <atomic>
 
 
 namespace lomse
@@ -38,11 +40,12 @@ namespace lomse
 //=======================================================================================
 // Graphic model implementation
 //=======================================================================================
-static long m_idCounter = 0L;
+static std::atomic<long> m_idCounter(0L);
 
 //---------------------------------------------------------------------------------------
 GraphicModel::GraphicModel(ImoDocument* pCreator)
     : m_modified(true)
+    , m_version(0L)
 {
     m_root = LOMSE_NEW GmoBoxDocument(this, pCreator);
     m_modelId = ++m_idCounter;
@@ -81,8 +84,10 @@ void GraphicModel::draw_page(int iPage, UPoint& origin, Drawer* pDrawer,
     GmoBoxDocPage* pPage = get_page(iPage);
     if (pPage)
     {
+        pDrawer->begin_batch();
         pPage->on_draw(pDrawer, opt);
         pDrawer->render();
+        pDrawer->end_batch();
         pDrawer->remove_shift();
     }
     else
@@ -267,6 +272,12 @@ void GraphicModel::build_main_boxes_table()
             }
         }
     }
+
+    //tables for visual tracking during playback. They are built now, in the main
+    //thread, to avoid doing it in the sound thread when playback starts
+    map<ImoId, ScoreStub*>::iterator it;
+    for (it = m_scores.begin(); it != m_scores.end(); ++it)
+        it->second->get_tracking_table();
 }
 
 //---------------------------------------------------------------------------------------
@@ -406,6 +417,13 @@ GmMeasuresTable* GraphicModel::get_measures_table(ImoId scoreId)
 	return (pStub ? pStub->get_measures_table() : nullptr);
 }
 
+//---------------------------------------------------------------------------------------
+GmTrackingTable* GraphicModel::get_tracking_table(ImoId scoreId)
+{
+	ScoreStub* pStub = get_stub_for(scoreId);
+	return (pStub ? pStub->get_tracking_table() : nullptr);
+}
+
 //---------------------------------------------------------------------------------------
 int GraphicModel::get_page_number_containing(GmoObj* pGmo)
 {
@@ -14,6 +14,9 @@
 #include "lomse_visual_effect.h"
 #include "lomse_renderer.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace lomse
 {
 
@@ -57,13 +60,20 @@ void OverlaysGenerator::add_visual_effect(VisualEffect* pEffect)
 void OverlaysGenerator::remove_visual_effect(VisualEffect* pEffect)
 {
     m_effects.remove(pEffect);
+
+    //its pixels must be removed in next update
+    map<VisualEffect*, VRect>::iterator it = m_drawnAreas.find(pEffect);
+    if (it != m_drawnAreas.end())
+    {
+        m_removedAreas.push_back(it->second);
+        m_drawnAreas.erase(it);
+    }
 }
 
 //---------------------------------------------------------------------------------------
 void OverlaysGenerator::update_all_visual_effects(BitmapDrawer* pDrawer)
 {
-    if (m_fBackgroundDirty)
-        m_canvasBuffer.copy_from(m_savedBuffer);
+    restore_drawn_areas();
 
     m_damagedRect = URect(0.0, 0.0, 0.0, 0.0);
     int overlays = 0;
@@ -72,7 +82,7 @@ void OverlaysGenerator::update_all_visual_effects(BitmapDrawer* pDrawer)
     {
         if ((*it)->is_visible())
         {
-            (*it)->on_draw(pDrawer);
+            draw_effect(*it, pDrawer);
             ++overlays;
             m_damagedRect.Union( (*it)->get_bounds() );
         }
@@ -90,7 +100,49 @@ void OverlaysGenerator::update_all_visual_effects(BitmapDrawer* pDrawer)
 void OverlaysGenerator::update_visual_effect(VisualEffect* pEffect,
                                              BitmapDrawer* pDrawer)
 {
-    update_all_visual_effects(pDrawer);
+    if (!can_update_only(pEffect))
+        update_all_visual_effects(pDrawer);
+    else
+    {
+        //remove the pixels of the effect and of removed effects, re-drawing the
+        //other effects affected
+        map<VisualEffect*, VRect>::iterator itA = m_drawnAreas.find(pEffect);
+        if (itA != m_drawnAreas.end())
+        {
+            m_removedAreas.push_back(itA->second);
+            m_drawnAreas.erase(itA);
+        }
+        vector<VRect> areas;
+        areas.swap(m_removedAreas);
+        for (const VRect& area : areas)
+            refresh_area(area, pEffect, pDrawer);
+
+        //draw the effect. If it overlaps effects drawn after it, its area must be
+        //re-drawn to preserve the drawing order
+        if (pEffect->is_visible())
+        {
+            draw_effect(pEffect, pDrawer);
+            map<VisualEffect*, VRect>::iterator itNew = m_drawnAreas.find(pEffect);
+            if (itNew != m_drawnAreas.end())
+            {
+                list<VisualEffect*>::iterator it =
+                    find(m_effects.begin(), m_effects.end(), pEffect);
+                for (++it; it != m_effects.end(); ++it)
+                {
+                    map<VisualEffect*, VRect>::iterator itOther = m_drawnAreas.find(*it);
+                    if (itOther != m_drawnAreas.end()
+                        && !VRect(itOther->second).intersection(itNew->second).is_empty())
+                    {
+                        refresh_area(itNew->second, nullptr, pDrawer);
+                        break;
+                    }
+                }
+            }
+        }
+
+        m_fBackgroundDirty = !m_drawnAreas.empty();
+    }
+
     if (pEffect->is_visible())
     {
         m_damagedRect = pEffect->get_bounds();
@@ -100,6 +152,107 @@ void OverlaysGenerator::update_visual_effect(VisualEffect* pEffect,
         m_damagedRect = m_prevDamagedRect;
 }
 
+//---------------------------------------------------------------------------------------
+bool OverlaysGenerator::can_update_only(VisualEffect* pEffect)
+{
+    //Only the given effect can be updated when all other effects are already drawn
+    //and the pixels modified by them are known
+
+    if (!m_fBackgroundDirty || m_savedBuffer.buf() == nullptr)
+        return false;
+
+    list<VisualEffect*>::const_iterator it;
+    for (it = m_effects.begin(); it != m_effects.end(); ++it)
+    {
+        if (*it != pEffect
+            && (*it)->is_visible() != (m_drawnAreas.find(*it) != m_drawnAreas.end()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::draw_effect(VisualEffect* pEffect, BitmapDrawer* pDrawer)
+{
+    pDrawer->reset_drawn_area();
+    pEffect->on_draw(pDrawer);
+
+    VRect area = pDrawer->get_drawn_area();
+    if (!area.is_empty())
+    {
+        VPoint org = pDrawer->get_view_area_origin();
+        area.x += org.x;
+        area.y += org.y;
+        m_drawnAreas[pEffect] = area;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::refresh_area(const VRect& area, VisualEffect* pExclude,
+                                     BitmapDrawer* pDrawer)
+{
+    //restore the background in the area and re-draw, clipped to the area, the
+    //effects having pixels in it. The pixels modified by these effects do not change
+
+    restore_area(area);
+
+    VPoint org = pDrawer->get_view_area_origin();
+    pDrawer->set_clip_rect(area.left() - org.x, area.top() - org.y,
+                           area.right() - org.x, area.bottom() - org.y);
+
+    list<VisualEffect*>::const_iterator it;
+    for (it = m_effects.begin(); it != m_effects.end(); ++it)
+    {
+        map<VisualEffect*, VRect>::iterator itA = m_drawnAreas.find(*it);
+        if (*it != pExclude && itA != m_drawnAreas.end()
+            && !VRect(itA->second).intersection(area).is_empty())
+        {
+            (*it)->on_draw(pDrawer);
+        }
+    }
+
+    pDrawer->reset_clip_rect();
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::restore_area(const VRect& area)
+{
+    VRect rect(area);
+    rect.intersection( VRect(0, 0, Pixels(m_savedBuffer.width()),
+                                   Pixels(m_savedBuffer.height())) );
+    rect.intersection( VRect(0, 0, Pixels(m_canvasBuffer.width()),
+                                   Pixels(m_canvasBuffer.height())) );
+    if (rect.is_empty())
+        return;
+
+    int bytesPerPixel = Renderer::bytesPerPixel( m_libraryScope.get_pixel_format() );
+    size_t offset = size_t(rect.x) * size_t(bytesPerPixel);
+    size_t bytes = size_t(rect.width) * size_t(bytesPerPixel);
+    for (Pixels y = rect.top(); y < rect.bottom(); ++y)
+    {
+        memcpy(m_canvasBuffer.row_ptr(y) + offset,
+               m_savedBuffer.row_ptr(y) + offset, bytes);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::restore_drawn_areas()
+{
+    //remove the overlays by restoring only the pixels modified by them
+    if (m_fBackgroundDirty)
+    {
+        map<VisualEffect*, VRect>::const_iterator it;
+        for (it = m_drawnAreas.begin(); it != m_drawnAreas.end(); ++it)
+            restore_area(it->second);
+        for (const VRect& area : m_removedAreas)
+            restore_area(area);
+    }
+    m_drawnAreas.clear();
+    m_removedAreas.clear();
+}
+
 //---------------------------------------------------------------------------------------
 void OverlaysGenerator::set_rendering_buffer(unsigned char* buf, unsigned width,
                                              unsigned height)
@@ -109,6 +262,8 @@ void OverlaysGenerator::set_rendering_buffer(unsigned char* buf, unsigned width,
     m_canvasBuffer.attach(buf, width, height, stride);
     m_fBackgroundDirty = false;
     m_fFullRectangle = true;
+    m_drawnAreas.clear();
+    m_removedAreas.clear();
 }
 
 //---------------------------------------------------------------------------------------
@@ -116,6 +271,26 @@ void OverlaysGenerator::on_new_background()
 {
     save_rendering_buffer();
     m_fFullRectangle = true;
+    m_drawnAreas.clear();
+    m_removedAreas.clear();
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::on_scrolled_background()
+{
+    //only the exposed areas are new. The damaged rectangle must include the previous
+    //overlays positions, as the application window still displays them
+    save_rendering_buffer();
+    m_drawnAreas.clear();
+    m_removedAreas.clear();
+}
+
+//---------------------------------------------------------------------------------------
+void OverlaysGenerator::restore_background()
+{
+    //remove the overlays applied to the rendering buffer
+    restore_drawn_areas();
+    m_fBackgroundDirty = false;
 }
 
 //---------------------------------------------------------------------------------------
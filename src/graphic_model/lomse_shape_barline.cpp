@@ -325,6 +325,12 @@ void GmoShapeBarline::on_draw(Drawer* pDrawer, RenderOptions& opt)
 void GmoShapeBarline::draw_thin_line(Drawer* pDrawer, LUnits uxPos, LUnits uyTop,
                                      LUnits uyBottom, Color color)
 {
+    if (pDrawer->accepts_solid_rects())
+    {
+        draw_solid_rect(pDrawer, uxPos, uyTop, uxPos + m_uThinLineWidth, uyBottom, color);
+        return;
+    }
+
     pDrawer->begin_path();
     pDrawer->fill(color);
     pDrawer->stroke(color);
@@ -338,6 +344,12 @@ void GmoShapeBarline::draw_thin_line(Drawer* pDrawer, LUnits uxPos, LUnits uyTop
 void GmoShapeBarline::draw_thick_line(Drawer* pDrawer, LUnits uxPos, LUnits uyTop,
                                       LUnits uWidth, LUnits uHeight, Color color)
 {
+    if (pDrawer->accepts_solid_rects())
+    {
+        draw_solid_rect(pDrawer, uxPos, uyTop, uxPos + uWidth, uyTop + uHeight, color);
+        return;
+    }
+
     pDrawer->begin_path();
     pDrawer->fill(color);
     pDrawer->stroke(color);
@@ -347,6 +359,17 @@ void GmoShapeBarline::draw_thick_line(Drawer* pDrawer, LUnits uxPos, LUnits uyTo
     pDrawer->end_path();
 }
 
+//---------------------------------------------------------------------------------------
+void GmoShapeBarline::draw_solid_rect(Drawer* pDrawer, LUnits x1, LUnits y1,
+                                      LUnits x2, LUnits y2, Color color)
+{
+    //The line path is filled and also stroked with the default stroke width (1 LUnit).
+    //As the path is not closed, the outline, of half the stroke width, is added
+    //at left, top and bottom sides. The rectangle must cover the same area
+    const LUnits outline = 0.5f;
+    pDrawer->solid_rect(x1 - outline, y1 - outline, x2, y2 + outline, color);
+}
+
 //---------------------------------------------------------------------------------------
 void GmoShapeBarline::draw_doted_line(Drawer* pDrawer, LUnits uxPos, LUnits uyTop,
                                       LUnits uyBottom, Color color)
@@ -111,10 +111,14 @@ void GmoShapeNote::draw_leger_lines(Drawer* pDrawer)
     if (pDrawer->accepts_id_class())
         pDrawer->start_simple_notation("", "ledger-line");
 
-    pDrawer->begin_path();
-    pDrawer->fill(Color(0, 0, 0, 0));
-    pDrawer->stroke(Color(0, 0, 0));
-    pDrawer->stroke_width(m_uLineThickness);
+    bool fSolidRects = pDrawer->accepts_solid_rects();
+    if (!fSolidRects)
+    {
+        pDrawer->begin_path();
+        pDrawer->fill(Color(0, 0, 0, 0));
+        pDrawer->stroke(Color(0, 0, 0));
+        pDrawer->stroke_width(m_uLineThickness);
+    }
 
     LUnits xPos = get_notehead_left() - m_uLineOutgoing;
     LUnits lineLength = get_notehead_width() + 2.0f * m_uLineOutgoing;
@@ -128,8 +132,7 @@ void GmoShapeNote::draw_leger_lines(Drawer* pDrawer)
 
         for (int i=m_nTopPosOnStaff; i <= m_nPosOnStaff; i+=2)
         {
-            pDrawer->move_to(xPos, yPos);
-            pDrawer->hline_to(xPos + lineLength);
+            draw_leger_line(pDrawer, fSolidRects, xPos, yPos, lineLength);
             yPos -= m_lineSpacing;
         }
     }
@@ -142,13 +145,31 @@ void GmoShapeNote::draw_leger_lines(Drawer* pDrawer)
 
         for (int i=m_nBottomPosOnStaff; i >= m_nPosOnStaff; i-=2)
         {
-            pDrawer->move_to(xPos, yPos);
-            pDrawer->hline_to(xPos + lineLength);
+            draw_leger_line(pDrawer, fSolidRects, xPos, yPos, lineLength);
             yPos += m_lineSpacing;
         }
     }
 
-    pDrawer->end_path();
+    if (!fSolidRects)
+        pDrawer->end_path();
+}
+
+//---------------------------------------------------------------------------------------
+void GmoShapeNote::draw_leger_line(Drawer* pDrawer, bool fSolidRect, LUnits xPos,
+                                   LUnits yPos, LUnits lineLength)
+{
+    if (fSolidRect)
+    {
+        //the rectangle covered by the stroke
+        double halfWidth = double(m_uLineThickness) / 2.0;
+        pDrawer->solid_rect(xPos, yPos - halfWidth, xPos + lineLength, yPos + halfWidth,
+                            Color(0, 0, 0));
+    }
+    else
+    {
+        pDrawer->move_to(xPos, yPos);
+        pDrawer->hline_to(xPos + lineLength);
+    }
 }
 
 //---------------------------------------------------------------------------------------
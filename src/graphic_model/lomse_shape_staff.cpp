@@ -59,20 +59,35 @@ void GmoShapeStaff::on_draw(Drawer* pDrawer, RenderOptions& opt)
         pDrawer->start_simple_notation(get_notation_id(ss.str()), "staff-lines");
     }
 
-    pDrawer->begin_path();
-    pDrawer->stroke(color);
-    pDrawer->stroke_width(m_lineThickness);
     int iMax = max(m_pStaff->get_num_lines(), 5);
-    for (int iL=0; iL < iMax; iL++ )
-	{
-	    if (m_pStaff->is_line_visible(iL))
-	    {
-            pDrawer->move_to(xStart, yPos);
-            pDrawer->line_to(xEnd, yPos);
-	    }
-        yPos += spacing;
+    if (pDrawer->accepts_solid_rects())
+    {
+        //each line is the rectangle covered by the stroke
+        double halfWidth = double(m_lineThickness) / 2.0;
+        for (int iL=0; iL < iMax; iL++ )
+        {
+            if (m_pStaff->is_line_visible(iL))
+                pDrawer->solid_rect(xStart, yPos - halfWidth, xEnd, yPos + halfWidth,
+                                    color);
+            yPos += spacing;
+        }
+    }
+    else
+    {
+        pDrawer->begin_path();
+        pDrawer->stroke(color);
+        pDrawer->stroke_width(m_lineThickness);
+        for (int iL=0; iL < iMax; iL++ )
+        {
+            if (m_pStaff->is_line_visible(iL))
+            {
+                pDrawer->move_to(xStart, yPos);
+                pDrawer->line_to(xEnd, yPos);
+            }
+            yPos += spacing;
+        }
+        pDrawer->end_path();
     }
-    pDrawer->end_path();
 
     GmoSimpleShape::on_draw(pDrawer, opt);
 }
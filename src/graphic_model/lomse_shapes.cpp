@@ -54,12 +54,17 @@ void GmoShapeGlyph::compute_size_origin(double fontHeight, UPoint pos)
 {
     m_fontHeight = fontHeight;
 
-    TextMeter meter(m_libraryScope);
-    meter.select_font("any",
-                      m_libraryScope.get_music_font_file(),
-                      m_libraryScope.get_music_font_name(),
-                      m_fontHeight);
-    URect bbox = meter.bounding_rectangle(m_glyph);
+    URect bbox;
+    MusicGlyphs* pGlyphs = m_libraryScope.get_glyphs_table();
+    if (!pGlyphs->bounding_rectangle(m_glyph, m_fontHeight, &bbox))
+    {
+        TextMeter meter(m_libraryScope);
+        meter.select_font("any",
+                          m_libraryScope.get_music_font_file(),
+                          m_libraryScope.get_music_font_name(),
+                          m_fontHeight);
+        bbox = meter.bounding_rectangle(m_glyph);
+    }
 
     m_origin.x = pos.x + bbox.x;
     m_origin.y = pos.y + bbox.y;
@@ -184,14 +189,24 @@ void GmoShapeSimpleLine::on_draw(Drawer* pDrawer, RenderOptions& opt)
         pDrawer->start_simple_notation("", get_name());
 
     Color color = determine_color_to_use(opt);
-    pDrawer->begin_path();
-    pDrawer->fill(color);
-    pDrawer->stroke(color);
-    pDrawer->stroke_width(m_uWidth);
-    pDrawer->move_to(m_origin.x + m_uWidth / 2.0f, m_origin.y);
-    pDrawer->line_to(m_origin.x + m_uWidth / 2.0f, m_origin.y + m_size.height);
-    pDrawer->end_path();
-    pDrawer->render();
+    double xCenter = m_origin.x + m_uWidth / 2.0f;
+    if (pDrawer->accepts_solid_rects())
+    {
+        double halfWidth = double(m_uWidth) / 2.0;
+        pDrawer->solid_rect(xCenter - halfWidth, m_origin.y,
+                            xCenter + halfWidth, m_origin.y + m_size.height, color);
+    }
+    else
+    {
+        pDrawer->begin_path();
+        pDrawer->fill(color);
+        pDrawer->stroke(color);
+        pDrawer->stroke_width(m_uWidth);
+        pDrawer->move_to(xCenter, m_origin.y);
+        pDrawer->line_to(xCenter, m_origin.y + m_size.height);
+        pDrawer->end_path();
+        pDrawer->render();
+    }
 
     GmoSimpleShape::on_draw(pDrawer, opt);
 }
@@ -533,16 +548,27 @@ void GmoShapeArpeggio::increase_length_up(LUnits increment)
 //---------------------------------------------------------------------------------------
 void GmoShapeArpeggio::compute_shape_geometry(LUnits xRight, LUnits yTop, LUnits yBottom)
 {
-    TextMeter meter(m_libraryScope);
-    meter.select_font("any",
-                      m_libraryScope.get_music_font_file(),
-                      m_libraryScope.get_music_font_name(),
-                      m_fontHeight);
+    URect segmentGlyphBox;
+    URect arrowGlyphBox;
+    MusicGlyphs* pGlyphs = m_libraryScope.get_glyphs_table();
+    if (!pGlyphs->bounding_rectangle(m_segmentGlyph, m_fontHeight, &segmentGlyphBox)
+        || !pGlyphs->advance_x(m_segmentGlyph, m_fontHeight, &m_segmentAdvance)
+        || (m_arrowGlyph
+            && !pGlyphs->bounding_rectangle(m_arrowGlyph, m_fontHeight, &arrowGlyphBox)))
+    {
+        TextMeter meter(m_libraryScope);
+        meter.select_font("any",
+                          m_libraryScope.get_music_font_file(),
+                          m_libraryScope.get_music_font_name(),
+                          m_fontHeight);
+        segmentGlyphBox = meter.bounding_rectangle(m_segmentGlyph);
+        m_segmentAdvance = meter.get_advance_x(m_segmentGlyph);
+        if (m_arrowGlyph)
+            arrowGlyphBox = meter.bounding_rectangle(m_arrowGlyph);
+    }
 
-    const URect segmentGlyphBox = meter.bounding_rectangle(m_segmentGlyph);
     m_xInitialAdvance = 0;
     m_yInitialAdvance = -segmentGlyphBox.x;
-    m_segmentAdvance = meter.get_advance_x(m_segmentGlyph);
 
     LUnits maxGlyphHeight = segmentGlyphBox.height;
 
@@ -550,7 +576,6 @@ void GmoShapeArpeggio::compute_shape_geometry(LUnits xRight, LUnits yTop, LUnits
 
     if (m_arrowGlyph)
     {
-        const URect arrowGlyphBox = meter.bounding_rectangle(m_arrowGlyph);
         remainingHeight -= arrowGlyphBox.right();
 
         if (arrowGlyphBox.height > maxGlyphHeight)
@@ -0,0 +1,1647 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_im_snapshot.h"
+
+#include "lomse_internal_model.h"
+#include "lomse_im_note.h"
+#include "lomse_im_factory.h"
+#include "lomse_id_assigner.h"
+#include "lomse_document.h"
+#include "lomse_model_builder.h"
+#include "lomse_import_options.h"
+#include "lomse_logger.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// Snapshot layout:
+//
+//  header:     magic "LOMSESNP", u32 format version, u32 k_imo_last,
+//              u64 payload size, u64 payload checksum
+//  payload:    i32 last assigned id, u32 num xml ids, (i32 id, string xml id)*,
+//              root node
+//  node:       i32 type, i32 id, u32 flags, u32 num attribs, attrib*, fields,
+//              u32 num children, node*
+//  attrib:     i32 index, u8 value type, value
+//
+// All numbers are little-endian. Strings are saved as u32 length followed by the
+// characters. Fields are defined in ImSnapshot::fields(), that is shared by reader
+// and writer. ImoRelObj objects are saved only once, the first time they are found
+// in an ImoRelations node. Next times only its index is saved.
+//---------------------------------------------------------------------------------------
+
+static const char k_snapshot_magic[8] = { 'L','O','M','S','E','S','N','P' };
+static const size_t k_header_size = 8 + 4 + 4 + 8 + 8;
+
+//attribute value types
+enum { k_attr_int=0, k_attr_float, k_attr_double, k_attr_bool, k_attr_string,
+       k_attr_color, };
+
+
+//=======================================================================================
+// SnapshotWriter: archive for saving a snapshot
+//=======================================================================================
+class SnapshotWriter
+{
+protected:
+    string& m_out;
+    bool m_fError = false;
+    unordered_map<ImoRelObj*, uint32_t> m_relobjs;
+
+public:
+    SnapshotWriter(string& out) : m_out(out) {}
+
+    inline bool failed() const { return m_fError; }
+    inline void fail() { m_fError = true; }
+
+    //basic types
+    void u8(uint8_t value) { m_out.push_back(char(value)); }
+    void u32(uint32_t value)
+    {
+        char buf[4] = { char(value), char(value >> 8), char(value >> 16), char(value >> 24) };
+        m_out.append(buf, 4);
+    }
+    void u64(uint64_t value)
+    {
+        u32(uint32_t(value));
+        u32(uint32_t(value >> 32));
+    }
+
+    void io(bool& value) { u8(value ? 1 : 0); }
+    void io(int& value) { u32(uint32_t(value)); }
+    void io(unsigned int& value) { u32(value); }
+    void io(long& value) { u64(uint64_t(int64_t(value))); }
+    void io(float& value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        u32(bits);
+    }
+    void io(double& value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        u64(bits);
+    }
+    void io(string& value)
+    {
+        u32(uint32_t(value.size()));
+        m_out.append(value);
+    }
+    void io(Color& value)
+    {
+        u8(value.r);
+        u8(value.g);
+        u8(value.b);
+        u8(value.a);
+    }
+    template<class T> void io(Point<T>& value) { io(value.x); io(value.y); }
+    template<class T> void io(Size<T>& value) { io(value.width); io(value.height); }
+    template<class E> void io_enum(E& value)
+    {
+        int i = int(value);
+        io(i);
+    }
+
+    //composite types
+    void io(TypeTextInfo& value)
+    {
+        io(value.text);
+        io(value.language);
+    }
+    void io(TypeLineStyle& value)
+    {
+        io_enum(value.lineStyle);
+        io_enum(value.startEdge);
+        io_enum(value.endEdge);
+        io_enum(value.startStyle);
+        io_enum(value.endStyle);
+        io(value.color);
+        io(value.width);
+        io(value.startPoint);
+        io(value.endPoint);
+    }
+    void measure_info(TypeMeasureInfo*& pInfo)
+    {
+        u8(pInfo ? 1 : 0);
+        if (pInfo)
+        {
+            io(pInfo->index);
+            io(pInfo->count);
+            io(pInfo->number);
+            io(pInfo->fHideNumber);
+        }
+    }
+
+    //containers
+    template<class C> void items(C& container)
+    {
+        u32(uint32_t(container.size()));
+        for (typename C::iterator it = container.begin(); it != container.end(); ++it)
+        {
+            typename C::value_type value = *it;
+            io(value);
+        }
+    }
+    template<class V> void io(map<int, V>& values)
+    {
+        u32(uint32_t(values.size()));
+        for (typename map<int, V>::iterator it = values.begin(); it != values.end(); ++it)
+        {
+            int key = it->first;
+            io(key);
+            io(it->second);
+        }
+    }
+    void fingerings(list<FingerData>& values)
+    {
+        u32(uint32_t(values.size()));
+        for (list<FingerData>::iterator it = values.begin(); it != values.end(); ++it)
+        {
+            if ((*it).attribs)
+                fail();     //attributes in fingerings are not yet supported
+            io((*it).value);
+            io((*it).flags);
+        }
+    }
+
+    //nodes
+    template<class T> void nodes(list<T*>& values, int UNUSED(type))
+    {
+        u32(uint32_t(values.size()));
+        for (typename list<T*>::iterator it = values.begin(); it != values.end(); ++it)
+            node(*it);
+    }
+    void styles(map<string, ImoStyle*>& values)
+    {
+        u32(uint32_t(values.size()));
+        for (map<string, ImoStyle*>::iterator it = values.begin(); it != values.end(); ++it)
+        {
+            string name = it->first;
+            io(name);
+            node(it->second);
+        }
+    }
+    void relations(list<ImoRelObj*>& values)
+    {
+        u32(uint32_t(values.size()));
+        for (list<ImoRelObj*>::iterator it = values.begin(); it != values.end(); ++it)
+        {
+            unordered_map<ImoRelObj*, uint32_t>::iterator itRO = m_relobjs.find(*it);
+            if (itRO != m_relobjs.end())
+            {
+                u8(1);
+                u32(itRO->second);
+            }
+            else
+            {
+                u8(0);
+                uint32_t index = uint32_t(m_relobjs.size());
+                m_relobjs[*it] = index;
+                node(*it);
+            }
+        }
+    }
+    void related(list< pair<ImoId, ImoRelDataObj*> >& values)
+    {
+        u32(uint32_t(values.size()));
+        for (list< pair<ImoId, ImoRelDataObj*> >::iterator it = values.begin();
+             it != values.end(); ++it)
+        {
+            io((*it).first);
+            u8((*it).second ? 1 : 0);
+            if ((*it).second)
+                node((*it).second);
+        }
+    }
+
+protected:
+    template<class T> void node(T* pImo)
+    {
+        if (!ImSnapshot::write_node(*this, pImo))
+            fail();
+    }
+};
+
+
+//=======================================================================================
+// SnapshotReader: archive for loading a snapshot
+//=======================================================================================
+class SnapshotReader
+{
+protected:
+    const unsigned char* m_pos;
+    const unsigned char* m_end;
+    bool m_fError = false;
+
+    friend class ImSnapshot;
+    DocModel* m_pModel;
+    IdAssigner* m_pIdAssigner;
+    vector<ImoRelObj*> m_relobjs;       //saved relobjs, by index
+    vector<ImoObj*> m_created;          //all created objects, for discarding the tree
+    vector<ImoObj*> m_orphans;          //rejected objects, not included in the tree
+
+public:
+    SnapshotReader(const char* data, size_t size, DocModel* pModel)
+        : m_pos(reinterpret_cast<const unsigned char*>(data))
+        , m_end(reinterpret_cast<const unsigned char*>(data) + size)
+        , m_pModel(pModel)
+        , m_pIdAssigner(pModel->get_id_assigner())
+    {
+    }
+
+    inline bool failed() const { return m_fError; }
+    inline void fail() { m_fError = true; }
+    inline bool at_end() const { return m_pos == m_end; }
+
+    //basic types
+    uint8_t u8()
+    {
+        if (m_fError || m_pos + 1 > m_end)
+            return fail_and_zero();
+        return *m_pos++;
+    }
+    uint32_t u32()
+    {
+        if (m_fError || m_pos + 4 > m_end)
+            return fail_and_zero();
+        uint32_t value = uint32_t(m_pos[0]) | (uint32_t(m_pos[1]) << 8)
+                         | (uint32_t(m_pos[2]) << 16) | (uint32_t(m_pos[3]) << 24);
+        m_pos += 4;
+        return value;
+    }
+    uint64_t u64()
+    {
+        uint64_t low = u32();
+        uint64_t high = u32();
+        return low | (high << 32);
+    }
+    uint32_t count()
+    {
+        //a count can not be greater than the remaining bytes. This prevents huge
+        //allocations when data is not valid
+        uint32_t num = u32();
+        if (num > uint32_t(m_end - m_pos))
+            return fail_and_zero();
+        return num;
+    }
+
+    void io(bool& value) { value = (u8() != 0); }
+    void io(int& value) { value = int(u32()); }
+    void io(unsigned int& value) { value = u32(); }
+    void io(long& value) { value = long(int64_t(u64())); }
+    void io(float& value)
+    {
+        uint32_t bits = u32();
+        memcpy(&value, &bits, sizeof(bits));
+    }
+    void io(double& value)
+    {
+        uint64_t bits = u64();
+        memcpy(&value, &bits, sizeof(bits));
+    }
+    void io(string& value)
+    {
+        uint32_t size = count();
+        value.assign(reinterpret_cast<const char*>(m_pos), size);
+        m_pos += size;
+    }
+    void io(Color& value)
+    {
+        value.r = u8();
+        value.g = u8();
+        value.b = u8();
+        value.a = u8();
+    }
+    template<class T> void io(Point<T>& value) { io(value.x); io(value.y); }
+    template<class T> void io(Size<T>& value) { io(value.width); io(value.height); }
+    template<class E> void io_enum(E& value)
+    {
+        int i;
+        io(i);
+        value = static_cast<E>(i);
+    }
+
+    //composite types
+    void io(TypeTextInfo& value)
+    {
+        io(value.text);
+        io(value.language);
+    }
+    void io(TypeLineStyle& value)
+    {
+        io_enum(value.lineStyle);
+        io_enum(value.startEdge);
+        io_enum(value.endEdge);
+        io_enum(value.startStyle);
+        io_enum(value.endStyle);
+        io(value.color);
+        io(value.width);
+        io(value.startPoint);
+        io(value.endPoint);
+    }
+    void measure_info(TypeMeasureInfo*& pInfo)
+    {
+        delete pInfo;
+        pInfo = nullptr;
+        if (u8() != 0)
+        {
+            pInfo = LOMSE_NEW TypeMeasureInfo();
+            io(pInfo->index);
+            io(pInfo->count);
+            io(pInfo->number);
+            io(pInfo->fHideNumber);
+        }
+    }
+
+    //containers
+    template<class C> void items(C& container)
+    {
+        container.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num; ++i)
+        {
+            typename C::value_type value;
+            io(value);
+            container.push_back(value);
+        }
+    }
+    template<class V> void io(map<int, V>& values)
+    {
+        values.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num; ++i)
+        {
+            int key;
+            io(key);
+            io(values[key]);
+        }
+    }
+    void fingerings(list<FingerData>& values)
+    {
+        values.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num; ++i)
+        {
+            string value;
+            io(value);
+            values.emplace_back(value);
+            io(values.back().flags);
+        }
+    }
+
+    //nodes
+    template<class T> void nodes(list<T*>& values, int type)
+    {
+        values.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num; ++i)
+        {
+            ImoObj* pImo = node(type);
+            if (pImo)
+                values.push_back( static_cast<T*>(pImo) );
+        }
+    }
+    void styles(map<string, ImoStyle*>& values)
+    {
+        values.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num; ++i)
+        {
+            string name;
+            io(name);
+            ImoObj* pImo = node(k_imo_style);
+            if (pImo)
+                values[name] = static_cast<ImoStyle*>(pImo);
+        }
+    }
+    void relations(list<ImoRelObj*>& values)
+    {
+        values.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num && !m_fError; ++i)
+        {
+            if (u8() != 0)
+            {
+                uint32_t index = u32();
+                if (index < m_relobjs.size())
+                    values.push_back(m_relobjs[index]);
+                else
+                    fail();
+            }
+            else
+            {
+                ImoObj* pImo = ImSnapshot::read_node(*this);
+                if (pImo && pImo->is_relobj())
+                {
+                    m_relobjs.push_back( static_cast<ImoRelObj*>(pImo) );
+                    values.push_back( static_cast<ImoRelObj*>(pImo) );
+                }
+                else
+                    reject(pImo);
+            }
+        }
+    }
+    void related(list< pair<ImoId, ImoRelDataObj*> >& values)
+    {
+        values.clear();
+        uint32_t num = count();
+        for (uint32_t i=0; i < num && !m_fError; ++i)
+        {
+            ImoId id;
+            io(id);
+            ImoRelDataObj* pData = nullptr;
+            if (u8() != 0)
+            {
+                ImoObj* pImo = ImSnapshot::read_node(*this);
+                if (pImo && pImo->is_reldataobj())
+                    pData = static_cast<ImoRelDataObj*>(pImo);
+                else
+                    reject(pImo);
+            }
+            values.emplace_back(id, pData);
+        }
+    }
+
+protected:
+    uint8_t fail_and_zero()
+    {
+        m_fError = true;
+        return 0;
+    }
+
+    ImoObj* node(int type)
+    {
+        ImoObj* pImo = ImSnapshot::read_node(*this);
+        if (pImo && pImo->get_obj_type() == type)
+            return pImo;
+
+        reject(pImo);
+        return nullptr;
+    }
+
+    void reject(ImoObj* pImo)
+    {
+        fail();
+        if (pImo)
+            m_orphans.push_back(pImo);
+    }
+};
+
+
+//=======================================================================================
+// ImSnapshot implementation
+//=======================================================================================
+uint64_t ImSnapshot::hash(const char* data, size_t size, uint64_t seed)
+{
+    uint64_t value = 14695981039346656037ULL ^ seed;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    for (size_t i=0; i < size; ++i)
+    {
+        value ^= uint64_t(p[i]);
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+//---------------------------------------------------------------------------------------
+bool ImSnapshot::save(DocModel* pModel, string& out)
+{
+    out.clear();
+    ImoDocument* pImoDoc = pModel->get_im_root();
+    if (!pImoDoc)
+        return false;
+
+    //reserve space for the header. It will be filled when the payload is saved
+    out.assign(k_header_size, '\0');
+
+    SnapshotWriter a(out);
+    IdAssigner* pIdAssigner = pModel->get_id_assigner();
+    ImoId lastId = pIdAssigner->get_last_id();
+    a.io(lastId);
+
+    //xml ids, sorted to obtain always the same snapshot for the same model
+    map<ImoId, string> xmlIds(pIdAssigner->m_idToXmlId.begin(),
+                              pIdAssigner->m_idToXmlId.end());
+    a.u32(uint32_t(xmlIds.size()));
+    for (map<ImoId, string>::iterator it = xmlIds.begin(); it != xmlIds.end(); ++it)
+    {
+        ImoId id = it->first;
+        a.io(id);
+        a.io(it->second);
+    }
+
+    if (!write_node(a, pImoDoc) || a.failed())
+    {
+        out.clear();
+        return false;
+    }
+
+    //header
+    uint64_t payloadSize = uint64_t(out.size() - k_header_size);
+    uint64_t checksum = hash(out.data() + k_header_size, out.size() - k_header_size);
+    string header;
+    SnapshotWriter h(header);
+    header.append(k_snapshot_magic, 8);
+    h.u32(k_format_version);
+    h.u32(k_imo_last);
+    h.u64(payloadSize);
+    h.u64(checksum);
+    out.replace(0, k_header_size, header);
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+ImoDocument* ImSnapshot::load(DocModel* pModel, const char* data, size_t size)
+{
+    if (size < k_header_size || memcmp(data, k_snapshot_magic, 8) != 0)
+        return nullptr;
+
+    SnapshotReader h(data + 8, k_header_size - 8, pModel);
+    uint32_t version = h.u32();
+    uint32_t numTypes = h.u32();
+    uint64_t payloadSize = h.u64();
+    uint64_t checksum = h.u64();
+    if (version != k_format_version || numTypes != uint32_t(k_imo_last))
+    {
+        LOMSE_LOG_INFO("Snapshot discarded: different version.");
+        return nullptr;
+    }
+    if (payloadSize != uint64_t(size - k_header_size))
+    {
+        LOMSE_LOG_INFO("Snapshot discarded: truncated data.");
+        return nullptr;
+    }
+    if (checksum != hash(data + k_header_size, size - k_header_size))
+    {
+        LOMSE_LOG_INFO("Snapshot discarded: corrupted data.");
+        return nullptr;
+    }
+
+    SnapshotReader a(data + k_header_size, size - k_header_size, pModel);
+    IdAssigner* pIdAssigner = a.m_pIdAssigner;
+    ImoId lastId;
+    a.io(lastId);
+
+    uint32_t numXmlIds = a.count();
+    for (uint32_t i=0; i < numXmlIds && !a.failed(); ++i)
+    {
+        ImoId id;
+        string xmlId;
+        a.io(id);
+        a.io(xmlId);
+        pIdAssigner->set_xml_id_for(id, xmlId);
+    }
+
+    //AWARE: the payload must be fully consumed. Otherwise, the snapshot was not
+    //saved by this code, even if all fields were read without errors
+    ImoObj* pRoot = read_node(a);
+    if (a.failed() || !a.at_end() || !pRoot || !pRoot->is_document())
+    {
+        LOMSE_LOG_ERROR("Invalid snapshot. Model discarded.");
+        discard_tree(a, pRoot);
+        pIdAssigner->reset();
+        return nullptr;
+    }
+    pIdAssigner->set_counter(lastId);
+
+    ImoDocument* pImoDoc = static_cast<ImoDocument*>(pRoot);
+    ModelBuilder builder;
+    builder.fix_cloned_model(pImoDoc);
+
+    return pImoDoc;
+}
+
+//---------------------------------------------------------------------------------------
+bool ImSnapshot::write_node(SnapshotWriter& a, ImoObj* pImo)
+{
+    int type = pImo->get_obj_type();
+    a.io(type);
+    a.io(pImo->m_id);
+    a.io(pImo->m_flags);
+
+    //attributes
+    a.u32(uint32_t(pImo->m_attribs.size()));
+    for (AttrObj* pAttr = pImo->m_attribs.front(); pAttr; pAttr = pAttr->get_next_attrib())
+    {
+        int idx = pAttr->get_attrib_idx();
+        a.io(idx);
+        if (AttrInt* p = dynamic_cast<AttrInt*>(pAttr))
+        {
+            a.u8(k_attr_int);
+            int value = p->get_value();
+            a.io(value);
+        }
+        else if (AttrFloat* p = dynamic_cast<AttrFloat*>(pAttr))
+        {
+            a.u8(k_attr_float);
+            float value = p->get_value();
+            a.io(value);
+        }
+        else if (AttrDouble* p = dynamic_cast<AttrDouble*>(pAttr))
+        {
+            a.u8(k_attr_double);
+            double value = p->get_value();
+            a.io(value);
+        }
+        else if (AttrBool* p = dynamic_cast<AttrBool*>(pAttr))
+        {
+            a.u8(k_attr_bool);
+            bool value = p->get_value();
+            a.io(value);
+        }
+        else if (AttrString* p = dynamic_cast<AttrString*>(pAttr))
+        {
+            a.u8(k_attr_string);
+            string value = p->get_value();
+            a.io(value);
+        }
+        else if (AttrColor* p = dynamic_cast<AttrColor*>(pAttr))
+        {
+            a.u8(k_attr_color);
+            Color value = p->get_value();
+            a.io(value);
+        }
+        else
+            return false;
+    }
+
+    if (!fields(a, pImo))
+        return false;
+
+    //children
+    a.u32(uint32_t(pImo->get_num_children()));
+    for (ImoObj* pChild = pImo->get_first_child(); pChild; pChild = pChild->get_next_sibling())
+    {
+        if (!write_node(a, pChild))
+            return false;
+    }
+
+    return !a.failed();
+}
+
+//---------------------------------------------------------------------------------------
+ImoObj* ImSnapshot::read_node(SnapshotReader& a)
+{
+    int type;
+    a.io(type);
+    ImoObj* pImo = (a.failed() ? nullptr : ImFactory::create(type));
+    if (!pImo)
+    {
+        a.fail();
+        return nullptr;
+    }
+    a.m_created.push_back(pImo);
+
+    a.io(pImo->m_id);
+    a.io(pImo->m_flags);
+
+    //attributes
+    uint32_t numAttribs = a.count();
+    for (uint32_t i=0; i < numAttribs && !a.failed(); ++i)
+    {
+        int idx;
+        a.io(idx);
+        switch (a.u8())
+        {
+            case k_attr_int:
+            {
+                int value;
+                a.io(value);
+                pImo->add_attribute( LOMSE_NEW AttrInt(idx, value) );
+                break;
+            }
+            case k_attr_float:
+            {
+                float value;
+                a.io(value);
+                pImo->add_attribute( LOMSE_NEW AttrFloat(idx, value) );
+                break;
+            }
+            case k_attr_double:
+            {
+                double value;
+                a.io(value);
+                pImo->add_attribute( LOMSE_NEW AttrDouble(idx, value) );
+                break;
+            }
+            case k_attr_bool:
+            {
+                bool value;
+                a.io(value);
+                pImo->add_attribute( LOMSE_NEW AttrBool(idx, value) );
+                break;
+            }
+            case k_attr_string:
+            {
+                string value;
+                a.io(value);
+                pImo->add_attribute( LOMSE_NEW AttrString(idx, value) );
+                break;
+            }
+            case k_attr_color:
+            {
+                Color value;
+                a.io(value);
+                pImo->add_attribute( LOMSE_NEW AttrColor(idx, value) );
+                break;
+            }
+            default:
+                a.fail();
+        }
+    }
+
+    if (!fields(a, pImo))
+        a.fail();
+    register_object(a, pImo);
+
+    //children
+    uint32_t numChildren = a.count();
+    for (uint32_t i=0; i < numChildren && !a.failed(); ++i)
+    {
+        ImoObj* pChild = read_node(a);
+        if (pChild)
+            pImo->append_child(pChild);
+    }
+
+    return pImo;
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::register_object(SnapshotReader& a, ImoObj* pImo)
+{
+    pImo->anchor_to_model(a.m_pModel);
+    if (pImo->m_id != k_no_imoid)
+        a.m_pIdAssigner->add_id(pImo->m_id, pImo);
+}
+
+//---------------------------------------------------------------------------------------
+void ImSnapshot::discard_tree(SnapshotReader& a, ImoObj* pRoot)
+{
+    //AWARE: Relations, ties and chains of ImoAuxRelObj could be incomplete.
+    //Therefore, before deleting the tree, all links between objects are removed, and
+    //relobjs and their data are deleted here, as they are not nodes in the tree
+    vector<ImoObj*>::iterator it;
+    for (it = a.m_created.begin(); it != a.m_created.end(); ++it)
+    {
+        ImoObj* pImo = *it;
+        if (pImo->is_relations())
+            static_cast<ImoRelations*>(pImo)->m_relations.clear();
+        else if (pImo->is_relobj())
+            static_cast<ImoRelObj*>(pImo)->m_relatedObjects.clear();
+        else if (pImo->is_note())
+        {
+            static_cast<ImoNote*>(pImo)->m_idTieNext = k_no_imoid;
+            static_cast<ImoNote*>(pImo)->m_idTiePrev = k_no_imoid;
+        }
+        else if (pImo->is_auxrelobj())
+        {
+            static_cast<ImoAuxRelObj*>(pImo)->m_prevId = k_no_imoid;
+            static_cast<ImoAuxRelObj*>(pImo)->m_nextId = k_no_imoid;
+        }
+    }
+
+    for (it = a.m_orphans.begin(); it != a.m_orphans.end(); ++it)
+    {
+        if (!(*it)->is_relobj() && !(*it)->is_reldataobj())
+            delete *it;
+    }
+
+    if (pRoot && !pRoot->is_relobj() && !pRoot->is_reldataobj())
+        delete pRoot;
+
+    for (it = a.m_created.begin(); it != a.m_created.end(); ++it)
+    {
+        if ((*it)->is_relobj() || (*it)->is_reldataobj())
+            delete *it;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+template<class Archive>
+bool ImSnapshot::fields(Archive& a, ImoObj* pImo)
+{
+    //data in abstract classes
+    if (pImo->is_contentobj())
+    {
+        ImoContentObj* p = static_cast<ImoContentObj*>(pImo);
+        a.io(p->m_styleId);
+        a.io(p->m_txUserLocation);
+        a.io(p->m_tyUserLocation);
+        a.io(p->m_txUserRefPoint);
+        a.io(p->m_tyUserRefPoint);
+        a.io(p->m_fVisible);
+    }
+    if (pImo->is_scoreobj())
+        a.io( static_cast<ImoScoreObj*>(pImo)->m_color );
+
+    if (pImo->is_staffobj())
+    {
+        ImoStaffObj* p = static_cast<ImoStaffObj*>(pImo);
+        a.io(p->m_staff);
+        a.io(p->m_nVoice);
+        a.io(p->m_time);
+    }
+    if (pImo->is_auxrelobj())
+    {
+        ImoAuxRelObj* p = static_cast<ImoAuxRelObj*>(pImo);
+        a.io(p->m_prevId);
+        a.io(p->m_nextId);
+    }
+    if (pImo->is_relobj())
+        a.related( static_cast<ImoRelObj*>(pImo)->m_relatedObjects );
+
+    if (pImo->is_box_inline())
+        a.io( static_cast<ImoBoxInline*>(pImo)->m_size );
+
+    if (pImo->is_note_rest())
+    {
+        ImoNoteRest* p = static_cast<ImoNoteRest*>(pImo);
+        a.io(p->m_fUnpitched);
+        a.io(p->m_nNoteType);
+        a.io(p->m_step);
+        a.io(p->m_octave);
+        a.io(p->m_nDots);
+        a.io(p->m_timeModifierTop);
+        a.io(p->m_timeModifierBottom);
+        a.io(p->m_duration);
+        a.io(p->m_playDuration);
+        a.io(p->m_eventDuration);
+        a.io(p->m_playTime);
+    }
+    if (pImo->is_note())
+    {
+        ImoNote* p = static_cast<ImoNote*>(pImo);
+        a.io(p->m_actual_acc);
+        a.io_enum(p->m_notated_acc);
+        a.io(p->m_options);
+        a.io(p->m_stemDirection);
+        a.io(p->m_idTieNext);
+        a.io(p->m_idTiePrev);
+        a.io(p->m_computedStem);
+        a.io(p->m_fMute);
+    }
+    if (pImo->is_articulation())
+    {
+        ImoArticulation* p = static_cast<ImoArticulation*>(pImo);
+        a.io(p->m_articulationType);
+        a.io(p->m_placement);
+    }
+
+    //data in concrete classes
+    switch (pImo->get_obj_type())
+    {
+        //objects without additional data
+        case k_imo_anonymous_block:
+        case k_imo_attachments:
+        case k_imo_content:
+        case k_imo_inline_wrapper:
+        case k_imo_instruments:
+        case k_imo_instrument_groups:
+        case k_imo_listitem:
+        case k_imo_music_data:
+        case k_imo_options:
+        case k_imo_para:
+        case k_imo_parameters:
+        case k_imo_score_titles:
+        case k_imo_sound_change:
+        case k_imo_sounds:
+        case k_imo_system_break:
+        case k_imo_table_body:
+        case k_imo_table_head:
+        case k_imo_table_row:
+            break;
+
+        case k_imo_arpeggio:
+            a.io_enum( static_cast<ImoArpeggio*>(pImo)->m_type );
+            break;
+
+        case k_imo_articulation_symbol:
+        {
+            ImoArticulationSymbol* p = static_cast<ImoArticulationSymbol*>(pImo);
+            a.io(p->m_fUp);
+            a.io(p->m_symbol);
+            break;
+        }
+
+        case k_imo_articulation_line:
+        {
+            ImoArticulationLine* p = static_cast<ImoArticulationLine*>(pImo);
+            a.io(p->m_lineShape);
+            a.io(p->m_lineType);
+            a.io(p->m_dashLength);
+            a.io(p->m_dashSpace);
+            break;
+        }
+
+        case k_imo_barline:
+        {
+            ImoBarline* p = static_cast<ImoBarline*>(pImo);
+            a.io(p->m_barlineType);
+            a.io(p->m_fMiddle);
+            a.io(p->m_fTKChange);
+            a.io(p->m_times);
+            a.io(p->m_winged);
+            a.measure_info(p->m_pMeasureInfo);
+            break;
+        }
+
+        case k_imo_beam:
+            break;      //stems direction is computed by engravers
+
+        case k_imo_beam_data:
+        {
+            ImoBeamData* p = static_cast<ImoBeamData*>(pImo);
+            for (int i=0; i < 6; ++i)
+            {
+                a.io(p->m_beamType[i]);
+                a.io(p->m_repeat[i]);
+            }
+            break;
+        }
+
+        case k_imo_bezier_info:
+        {
+            ImoBezierInfo* p = static_cast<ImoBezierInfo*>(pImo);
+            for (int i=0; i < 4; ++i)
+                a.io(p->m_tPoints[i]);
+            break;
+        }
+
+        case k_imo_chord:
+        {
+            ImoChord* p = static_cast<ImoChord*>(pImo);
+            a.io(p->m_fCrossStaff);
+            a.io(p->m_stemDirection);
+            break;
+        }
+
+        case k_imo_clef:
+        {
+            ImoClef* p = static_cast<ImoClef*>(pImo);
+            a.io(p->m_sign);
+            a.io(p->m_line);
+            a.io(p->m_octaveChange);
+            a.io(p->m_symbolSize);
+            break;
+        }
+
+        case k_imo_cursor_info:
+        {
+            ImoCursorInfo* p = static_cast<ImoCursorInfo*>(pImo);
+            a.io(p->m_instrument);
+            a.io(p->m_staff);
+            a.io(p->m_time);
+            a.io(p->m_id);
+            break;
+        }
+
+        case k_imo_direction:
+        {
+            ImoDirection* p = static_cast<ImoDirection*>(pImo);
+            a.io(p->m_space);
+            a.io_enum(p->m_placement);
+            a.io(p->m_displayRepeat);
+            a.io(p->m_soundRepeat);
+            a.io(p->m_idNR);
+            break;
+        }
+
+        case k_imo_document:
+        {
+            ImoDocument* p = static_cast<ImoDocument*>(pImo);
+            a.io(p->m_scale);
+            a.io(p->m_version);
+            a.io(p->m_language);
+            a.nodes(p->m_privateStyles, k_imo_style);
+            break;
+        }
+
+        case k_imo_dynamic:
+            a.io( static_cast<ImoDynamic*>(pImo)->m_classid );
+            break;
+
+        case k_imo_dynamics_mark:
+        {
+            ImoDynamicsMark* p = static_cast<ImoDynamicsMark*>(pImo);
+            a.io(p->m_markType);
+            a.io(p->m_placement);
+            a.io(p->m_moved);
+            break;
+        }
+
+        case k_imo_fermata:
+        {
+            ImoFermata* p = static_cast<ImoFermata*>(pImo);
+            a.io(p->m_placement);
+            a.io(p->m_symbol);
+            break;
+        }
+
+        case k_imo_fingering:
+        case k_imo_fret_string:
+        case k_imo_technical:
+        {
+            ImoTechnical* p = static_cast<ImoTechnical*>(pImo);
+            a.io(p->m_technicalType);
+            a.io(p->m_placement);
+            if (pImo->is_fret_string())
+            {
+                a.io( static_cast<ImoFretString*>(pImo)->m_fret );
+                a.io( static_cast<ImoFretString*>(pImo)->m_string );
+            }
+            else if (pImo->is_fingering())
+                a.fingerings( static_cast<ImoFingering*>(pImo)->m_fingerings );
+            break;
+        }
+
+        case k_imo_go_back_fwd:
+        {
+            ImoGoBackFwd* p = static_cast<ImoGoBackFwd*>(pImo);
+            a.io(p->m_fFwd);
+            a.io(p->m_rTimeShift);
+            break;
+        }
+
+        case k_imo_grace_relobj:
+        {
+            ImoGraceRelObj* p = static_cast<ImoGraceRelObj*>(pImo);
+            a.io(p->m_graceType);
+            a.io(p->m_fSlash);
+            a.io(p->m_percentage);
+            a.io(p->m_makeTime);
+            break;
+        }
+
+        case k_imo_heading:
+            a.io( static_cast<ImoHeading*>(pImo)->m_level );
+            break;
+
+        case k_imo_instr_group:
+        {
+            ImoInstrGroup* p = static_cast<ImoInstrGroup*>(pImo);
+            a.io(p->m_joinBarlines);
+            a.io(p->m_symbol);
+            a.io(p->m_name);
+            a.io(p->m_abbrev);
+            a.io(p->m_numInstrs);
+            a.io(p->m_iFirstInstr);
+            a.io(p->m_nameStyle);
+            a.io(p->m_abbrevStyle);
+            break;
+        }
+
+        case k_imo_instrument:
+        {
+            ImoInstrument* p = static_cast<ImoInstrument*>(pImo);
+            a.io(p->m_name);
+            a.io(p->m_abbrev);
+            a.io(p->m_nameStyle);
+            a.io(p->m_abbrevStyle);
+            a.io(p->m_partId);
+            a.nodes(p->m_staves, k_imo_staff_info);
+            a.io(p->m_barlineLayout);
+            a.io(p->m_measuresNumbering);
+            a.measure_info(p->m_pLastMeasureInfo);
+            break;
+        }
+
+        case k_imo_key_signature:
+        {
+            ImoKeySignature* p = static_cast<ImoKeySignature*>(pImo);
+            a.io(p->m_fStandard);
+            a.io(p->m_fForAllStaves);
+            a.io(p->m_fifths);
+            a.io(p->m_keyMode);
+            a.io(p->m_fCancel);
+            for (int i=0; i < 7; ++i)
+            {
+                a.io(p->m_accidentals[i].step);
+                a.io(p->m_accidentals[i].alter);
+                a.io(p->m_accidentals[i].accidental);
+                a.io(p->m_octave[i]);
+            }
+            break;
+        }
+
+        case k_imo_line:
+            a.io( static_cast<ImoLine*>(pImo)->m_style );
+            break;
+
+        case k_imo_link:
+        {
+            ImoLink* p = static_cast<ImoLink*>(pImo);
+            a.io(p->m_url);
+            a.io(p->m_language);
+            break;
+        }
+
+        case k_imo_list:
+            a.io( static_cast<ImoList*>(pImo)->m_listType );
+            break;
+
+        case k_imo_lyric:
+        {
+            ImoLyric* p = static_cast<ImoLyric*>(pImo);
+            a.io(p->m_number);
+            a.io(p->m_placement);
+            a.io(p->m_numTextItems);
+            a.io(p->m_fLaughing);
+            a.io(p->m_fHumming);
+            a.io(p->m_fEndLine);
+            a.io(p->m_fEndParagraph);
+            a.io(p->m_fMelisma);
+            a.io(p->m_fHyphenation);
+            break;
+        }
+
+        case k_imo_lyrics_text_info:
+        {
+            ImoLyricsTextInfo* p = static_cast<ImoLyricsTextInfo*>(pImo);
+            a.io(p->m_syllableType);
+            a.io(p->m_text);
+            a.io(p->m_styleId);
+            a.io(p->m_elision);
+            break;
+        }
+
+        case k_imo_metronome_mark:
+        {
+            ImoMetronomeMark* p = static_cast<ImoMetronomeMark*>(pImo);
+            a.io(p->m_markType);
+            a.io(p->m_ticksPerMinute);
+            a.io(p->m_leftNoteType);
+            a.io(p->m_leftDots);
+            a.io(p->m_rightNoteType);
+            a.io(p->m_rightDots);
+            a.io(p->m_fParenthesis);
+            break;
+        }
+
+        case k_imo_midi_info:
+        {
+            ImoMidiInfo* p = static_cast<ImoMidiInfo*>(pImo);
+            a.io(p->m_soundId);
+            a.io(p->m_port);
+            a.io(p->m_midiDeviceName);
+            a.io(p->m_midiName);
+            a.io(p->m_bank);
+            a.io(p->m_channel);
+            a.io(p->m_program);
+            a.io(p->m_unpitched);
+            a.io(p->m_volume);
+            a.io(p->m_pan);
+            a.io(p->m_elevation);
+            a.io(p->m_modified);
+            break;
+        }
+
+        case k_imo_multicolumn:
+            a.items( static_cast<ImoMultiColumn*>(pImo)->m_widths );
+            break;
+
+        case k_imo_note_grace:
+            a.io( static_cast<ImoGraceNote*>(pImo)->m_alignTime );
+            break;
+
+        case k_imo_note_cue:
+        case k_imo_note_regular:
+            break;
+
+        case k_imo_octave_shift:
+        {
+            ImoOctaveShift* p = static_cast<ImoOctaveShift*>(pImo);
+            a.io(p->m_steps);
+            a.io(p->m_octaveShiftNum);
+            break;
+        }
+
+        case k_imo_option:
+        {
+            ImoOptionInfo* p = static_cast<ImoOptionInfo*>(pImo);
+            a.io(p->m_type);
+            a.io(p->m_name);
+            a.io(p->m_sValue);
+            a.io(p->m_fValue);
+            a.io(p->m_nValue);
+            a.io(p->m_rValue);
+            break;
+        }
+
+        case k_imo_ornament:
+        {
+            ImoOrnament* p = static_cast<ImoOrnament*>(pImo);
+            a.io(p->m_ornamentType);
+            a.io(p->m_placement);
+            break;
+        }
+
+        case k_imo_page_info:
+        {
+            ImoPageInfo* p = static_cast<ImoPageInfo*>(pImo);
+            a.io(p->m_uLeftMarginOdd);
+            a.io(p->m_uRightMarginOdd);
+            a.io(p->m_uTopMarginOdd);
+            a.io(p->m_uBottomMarginOdd);
+            a.io(p->m_uLeftMarginEven);
+            a.io(p->m_uRightMarginEven);
+            a.io(p->m_uTopMarginEven);
+            a.io(p->m_uBottomMarginEven);
+            a.io(p->m_uPageSize);
+            a.io(p->m_fPortrait);
+            a.io(p->m_modified);
+            break;
+        }
+
+        case k_imo_param_info:
+        {
+            ImoParamInfo* p = static_cast<ImoParamInfo*>(pImo);
+            a.io(p->m_name);
+            a.io(p->m_value);
+            break;
+        }
+
+        case k_imo_pedal_mark:
+        {
+            ImoPedalMark* p = static_cast<ImoPedalMark*>(pImo);
+            a.io_enum(p->m_type);
+            a.io(p->m_fAbbreviated);
+            break;
+        }
+
+        case k_imo_pedal_line:
+        {
+            ImoPedalLine* p = static_cast<ImoPedalLine*>(pImo);
+            a.io(p->m_fDrawStartCorner);
+            a.io(p->m_fDrawEndCorner);
+            a.io(p->m_fDrawContinuationText);
+            a.io(p->m_fSostenuto);
+            break;
+        }
+
+        case k_imo_relations:
+            a.relations( static_cast<ImoRelations*>(pImo)->m_relations );
+            break;
+
+        case k_imo_rest:
+        {
+            ImoRest* p = static_cast<ImoRest*>(pImo);
+            a.io(p->m_fGoFwd);
+            a.io(p->m_fFullMeasureRest);
+            break;
+        }
+
+        case k_imo_score:
+        {
+            ImoScore* p = static_cast<ImoScore*>(pImo);
+            a.io(p->m_version);
+            a.io(p->m_sourceFormat);
+            a.io(p->m_accidentalsModel);
+            a.io(p->m_scaling);
+            a.io(p->m_systemInfoFirst.m_id);
+            fields(a, &p->m_systemInfoFirst);
+            a.io(p->m_systemInfoOther.m_id);
+            fields(a, &p->m_systemInfoOther);
+            a.styles(p->m_nameToStyle);
+            a.io(p->m_numLyricFonts);
+            a.io(p->m_lyricLanguages);
+            a.io(p->m_staffDistance);
+            a.io(p->m_modified);
+            break;
+        }
+
+        case k_imo_score_line:
+        {
+            ImoScoreLine* p = static_cast<ImoScoreLine*>(pImo);
+            a.io(p->m_startPoint);
+            a.io(p->m_endPoint);
+            a.io(p->m_style);
+            break;
+        }
+
+        case k_imo_score_text:
+        case k_imo_score_title:
+        case k_imo_text_repetition_mark:
+        {
+            a.io( static_cast<ImoScoreText*>(pImo)->m_text );
+            if (pImo->is_score_title())
+                a.io( static_cast<ImoScoreTitle*>(pImo)->m_hAlign );
+            else if (pImo->is_text_repetition_mark())
+                a.io( static_cast<ImoTextRepetitionMark*>(pImo)->m_repeatType );
+            break;
+        }
+
+        case k_imo_slur:
+        {
+            ImoSlur* p = static_cast<ImoSlur*>(pImo);
+            a.io(p->m_slurNum);
+            a.io(p->m_orientation);
+            break;
+        }
+
+        case k_imo_slur_data:
+        {
+            ImoSlurData* p = static_cast<ImoSlurData*>(pImo);
+            a.io(p->m_fStart);
+            a.io(p->m_slurNum);
+            a.io(p->m_orientation);
+            break;
+        }
+
+        case k_imo_sound_info:
+        {
+            ImoSoundInfo* p = static_cast<ImoSoundInfo*>(pImo);
+            a.io(p->m_soundId);
+            a.io(p->m_instrName);
+            a.io(p->m_instrAbbrev);
+            a.io(p->m_instrSound);
+            a.io(p->m_fSolo);
+            a.io(p->m_fEnsemble);
+            a.io(p->m_ensembleSize);
+            a.io(p->m_virtualLibrary);
+            a.io(p->m_virtualName);
+            a.io(p->m_playTechnique);
+            break;
+        }
+
+        case k_imo_staff_info:
+        {
+            ImoStaffInfo* p = static_cast<ImoStaffInfo*>(pImo);
+            a.io(p->m_numStaff);
+            a.io(p->m_nNumLines);
+            a.io(p->m_staffType);
+            a.io(p->m_uSpacing);
+            a.io(p->m_uLineThickness);
+            a.io(p->m_uMarging);
+            a.io(p->m_fTablature);
+            a.io(p->m_notationScaling);
+            a.io(p->m_modified);
+            break;
+        }
+
+        case k_imo_style:
+        {
+            ImoStyle* p = static_cast<ImoStyle*>(pImo);
+            a.io(p->m_name);
+            a.io(p->m_idParent);
+            a.io(p->m_lunitsProps);
+            a.io(p->m_floatProps);
+            a.io(p->m_stringProps);
+            a.io(p->m_intProps);
+            a.io(p->m_colorProps);
+            a.io(p->m_modified);
+            break;
+        }
+
+        case k_imo_styles:
+            a.styles( static_cast<ImoStyles*>(pImo)->m_nameToStyle );
+            break;
+
+        case k_imo_symbol_repetition_mark:
+            a.io( static_cast<ImoSymbolRepetitionMark*>(pImo)->m_symbol );
+            break;
+
+        case k_imo_system_info:
+        {
+            ImoSystemInfo* p = static_cast<ImoSystemInfo*>(pImo);
+            a.io(p->m_fFirst);
+            a.io(p->m_leftMargin);
+            a.io(p->m_rightMargin);
+            a.io(p->m_systemDistance);
+            a.io(p->m_topSystemDistance);
+            a.io(p->m_modified);
+            break;
+        }
+
+        case k_imo_table:
+            a.items( static_cast<ImoTable*>(pImo)->m_colStyles );
+            break;
+
+        case k_imo_table_cell:
+        {
+            ImoTableCell* p = static_cast<ImoTableCell*>(pImo);
+            a.io(p->m_rowspan);
+            a.io(p->m_colspan);
+            break;
+        }
+
+        case k_imo_textblock_info:
+        {
+            ImoTextBlockInfo* p = static_cast<ImoTextBlockInfo*>(pImo);
+            a.io(p->m_size);
+            a.io(p->m_topLeftPoint);
+            a.io(p->m_bgColor);
+            a.io(p->m_borderColor);
+            a.io(p->m_borderWidth);
+            a.io_enum(p->m_borderStyle);
+            break;
+        }
+
+        case k_imo_text_box:
+        {
+            ImoTextBox* p = static_cast<ImoTextBox*>(pImo);
+            a.io(p->m_box.m_id);
+            fields(a, &p->m_box);
+            a.io(p->m_text);
+            a.io(p->m_line);
+            a.io(p->m_fHasAnchorLine);
+            break;
+        }
+
+        case k_imo_text_item:
+        {
+            ImoTextItem* p = static_cast<ImoTextItem*>(pImo);
+            a.io(p->m_text);
+            a.io(p->m_language);
+            break;
+        }
+
+        case k_imo_tie:
+        {
+            ImoTie* p = static_cast<ImoTie*>(pImo);
+            a.io(p->m_tieNum);
+            a.io(p->m_orientation);
+            break;
+        }
+
+        case k_imo_tie_data:
+        {
+            ImoTieData* p = static_cast<ImoTieData*>(pImo);
+            a.io(p->m_fStart);
+            a.io(p->m_tieNum);
+            a.io(p->m_orientation);
+            break;
+        }
+
+        case k_imo_time_signature:
+        {
+            ImoTimeSignature* p = static_cast<ImoTimeSignature*>(pImo);
+            a.io(p->m_top);
+            a.io(p->m_bottom);
+            a.io(p->m_type);
+            break;
+        }
+
+        case k_imo_transpose:
+        {
+            ImoTranspose* p = static_cast<ImoTranspose*>(pImo);
+            a.io(p->m_numStaff);
+            a.io(p->m_diatonic);
+            a.io(p->m_chromatic);
+            a.io(p->m_octaveChange);
+            a.io(p->m_doubled);
+            break;
+        }
+
+        case k_imo_tuplet:
+        {
+            ImoTuplet* p = static_cast<ImoTuplet*>(pImo);
+            a.io(p->m_nActualNum);
+            a.io(p->m_nNormalNum);
+            a.io(p->m_nShowBracket);
+            a.io(p->m_nShowNumber);
+            a.io(p->m_nPlacement);
+            break;
+        }
+
+        case k_imo_volta_bracket:
+        {
+            ImoVoltaBracket* p = static_cast<ImoVoltaBracket*>(pImo);
+            a.io(p->m_fStopJog);
+            a.io(p->m_voltaNum);
+            a.io(p->m_voltaText);
+            a.items(p->m_repetitions);
+            a.io(p->m_numVoltas);
+            break;
+        }
+
+        case k_imo_wedge:
+        {
+            ImoWedge* p = static_cast<ImoWedge*>(pImo);
+            a.io(p->m_startSpread);
+            a.io(p->m_endSpread);
+            a.io(p->m_fNiente);
+            a.io(p->m_fCrescendo);
+            a.io(p->m_wedgeNum);
+            a.io(p->m_modified);
+            break;
+        }
+
+        //DTOs are never part of a finished model. Controls, images and players
+        //hold run-time objects that can not be saved
+        default:
+            return false;
+    }
+
+    return !a.failed();
+}
+
+
+//=======================================================================================
+// SnapshotsCache implementation
+//=======================================================================================
+int SnapshotsCache::open_document(Document* pDoc, const string& filename, int format)
+{
+    //load source file. It is needed to validate the cached snapshot
+    ifstream source(filename, ios::in | ios::binary);
+    stringstream content;
+    content << source.rdbuf();
+    string path = snapshot_path(content.str(), format);
+
+    if (source.good())
+    {
+        ifstream cached(path, ios::in | ios::binary);
+        if (cached.good())
+        {
+            stringstream snapshot;
+            snapshot << cached.rdbuf();
+            const string& data = snapshot.str();
+            if (pDoc->from_snapshot(data.data(), data.size()))
+                return 0;
+        }
+    }
+
+    int numErrors = pDoc->from_file(filename, format);
+
+    //AWARE: documents with errors are not cached. Otherwise, errors would not be
+    //reported when the document is loaded from the cache
+    string data;
+    if (numErrors == 0 && source.good() && pDoc->to_snapshot(data))
+        save_snapshot(path, data);
+
+    return numErrors;
+}
+
+//---------------------------------------------------------------------------------------
+void SnapshotsCache::save_snapshot(const string& path, const string& data)
+{
+    //AWARE: other threads or processes could be reading or saving the same snapshot.
+    //It is written in a temporary file, with an unique name, and then renamed, so
+    //that a partially written snapshot is never visible
+    static std::atomic<unsigned> counter(0);
+    std::random_device random;
+    stringstream tmp;
+    tmp << path << "." << std::hex << random() << "-" << ++counter << ".tmp";
+    string tmpPath = tmp.str();
+
+    ofstream cached(tmpPath, ios::out | ios::binary | ios::trunc);
+    cached.write(data.data(), streamsize(data.size()));
+    cached.close();
+    if (!cached)
+    {
+        LOMSE_LOG_ERROR("Error writing snapshot file '%s'", tmpPath.c_str());
+        std::remove(tmpPath.c_str());
+        return;
+    }
+
+    //AWARE: rename() can fail in some platforms when the target exists, because other
+    //process saved it. The snapshot is the same, so just remove the temporary file
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        std::remove(tmpPath.c_str());
+}
+
+//---------------------------------------------------------------------------------------
+string SnapshotsCache::snapshot_path(const string& source, int format)
+{
+    //key: content, format and import options
+    uint64_t options = uint64_t(format) << 8;
+    if (m_pOptions)
+    {
+        options |= (m_pOptions->fix_beams() ? 1 : 0);
+        options |= (m_pOptions->use_default_clefs() ? 2 : 0);
+    }
+    uint64_t key = ImSnapshot::hash(source.data(), source.size(), options);
+
+    stringstream path;
+    path << m_path;
+    if (!m_path.empty() && m_path.back() != '/' && m_path.back() != '\\')
+        path << '/';
+    path << std::hex << std::setw(16) << std::setfill('0') << key << ".lsnp";
+    return path.str();
+}
+
+
+}  //namespace lomse
@@ -13,6 +13,7 @@
 
 #include <algorithm>
 #include <math.h>                   //pow
+#include <mutex>                    //call_once
 #include "lomse_staffobjs_table.h"
 #include "lomse_im_note.h"
 #include "lomse_midi_table.h"
@@ -48,7 +49,7 @@ LUnits pt_to_LUnits(float pt)
 //---------------------------------------------------------------------------------------
 // static variables to convert from ImoObj type to name
 static map<int, string> m_TypeToName;
-static bool m_fNamesRegistered;
+static std::once_flag m_namesRegistered;
 static string m_unknown = "unknown";
 
 //---------------------------------------------------------------------------------------
@@ -667,7 +668,7 @@ void ImoObj::set_xml_id(const std::string& value)
 const string& ImoObj::get_name(int type)
 {
     //Register all IM objects
-    if (!m_fNamesRegistered)
+    std::call_once(m_namesRegistered, []()
     {
         // ImoStaffObj (A)
         m_TypeToName[k_imo_barline] = "barline";
@@ -843,9 +844,7 @@ const string& ImoObj::get_name(int type)
         m_TypeToName[k_imo_articulation] = "non-valid";
         m_TypeToName[k_imo_articulation_last] = "non-valid";
         m_TypeToName[k_imo_last] = "non-valid";
-
-        m_fNamesRegistered = true;
-    }
+    });
 
 	map<int, std::string>::const_iterator it = m_TypeToName.find( type );
 	if (it != m_TypeToName.end())
@@ -4204,6 +4203,8 @@ ImoScore::~ImoScore()
     delete m_pColStaffObjs;
     delete_text_styles();
     delete m_pMidiTable;
+    for (SoundEventsTable* pTable : m_oldMidiTables)
+        delete pTable;
 }
 
 //---------------------------------------------------------------------------------------
@@ -4374,6 +4375,10 @@ void ImoScore::set_staffobjs_table(ColStaffObjs* pColStaffObjs)
 {
     delete m_pColStaffObjs;
     m_pColStaffObjs = pColStaffObjs;
+
+    //the score has been modified. Sound events will be updated when requested
+    if (m_pMidiTable)
+        m_pMidiTable->set_modified();
 }
 
 //---------------------------------------------------------------------------------------
@@ -4863,14 +4868,46 @@ string ImoScore::get_lyric_language(int number)
 //---------------------------------------------------------------------------------------
 SoundEventsTable* ImoScore::get_midi_table()
 {
+    //This method must be invoked from the thread modifying the score. Tables being
+    //used for playback are never modified, as the player thread is reading them. In
+    //that case a new table is created and the old one is deleted when unused.
+
+    delete_unused_midi_tables();
+
+    if (m_pMidiTable && m_pMidiTable->is_modified() && m_pMidiTable->is_in_use())
+    {
+        m_oldMidiTables.push_back(m_pMidiTable);
+        m_pMidiTable = nullptr;
+    }
+
     if (!m_pMidiTable)
     {
         m_pMidiTable = LOMSE_NEW SoundEventsTable(this);
         m_pMidiTable->create_table();
     }
+    else if (m_pMidiTable->is_modified())
+    {
+        m_pMidiTable->update_table();
+    }
     return m_pMidiTable;
 }
 
+//---------------------------------------------------------------------------------------
+void ImoScore::delete_unused_midi_tables()
+{
+    vector<SoundEventsTable*>::iterator it = m_oldMidiTables.begin();
+    while (it != m_oldMidiTables.end())
+    {
+        if ((*it)->is_in_use())
+            ++it;
+        else
+        {
+            delete *it;
+            it = m_oldMidiTables.erase(it);
+        }
+    }
+}
+
 //---------------------------------------------------------------------------------------
 // Score API
 //---------------------------------------------------------------------------------------
@@ -6463,6 +6500,15 @@ ImoSlurData::ImoSlurData(ImoSlurDto* pDto)
 
 }
 
+//---------------------------------------------------------------------------------------
+ImoSlurData::ImoSlurData()
+    : ImoRelDataObj(k_imo_slur_data)
+    , m_fStart(false)
+    , m_slurNum(0)
+    , m_orientation(k_orientation_default)
+{
+}
+
 //---------------------------------------------------------------------------------------
 ImoBezierInfo* ImoSlurData::add_bezier()
 {
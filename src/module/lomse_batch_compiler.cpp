@@ -0,0 +1,208 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_batch_compiler.h"
+
+#include "lomse_injectors.h"
+#include "private/lomse_document_p.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"        //ptime
+#include "lomse_document_layouter.h"
+#include "lomse_graphical_model.h"
+#include "lomse_gm_basic.h"
+#include "lomse_svg_drawer.h"
+#include "lomse_ldp_exporter.h"
+#include "lomse_lmd_exporter.h"
+#include "lomse_mxl_exporter.h"
+#include "lomse_im_snapshot.h"
+#include "lomse_logger.h"
+
+#include <sstream>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#if (LOMSE_ENABLE_THREADS == 1)
+    #include <atomic>
+    #include <thread>
+#endif
+using namespace std;
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+static double elapsed_time_since(ptime startTime)
+{
+    //millisecods
+    ptime now(true);
+    return double(now - startTime);
+}
+
+
+//=======================================================================================
+// BatchCompiler implementation
+//=======================================================================================
+BatchCompiler::BatchCompiler(LibraryScope& libScope)
+    : m_libScope(libScope)
+    , m_mxlOptions( *libScope.get_musicxml_options() )
+{
+}
+
+//---------------------------------------------------------------------------------------
+vector<BatchResult> BatchCompiler::compile(const vector<BatchJob>& jobs, int numThreads)
+{
+    vector<BatchResult> results(jobs.size());
+
+#if (LOMSE_ENABLE_THREADS == 1)
+    //The calling thread also works. Each worker uses its own font engine, bound to
+    //the thread while processing the jobs
+
+    size_t maxThreads = (numThreads > 0 ? size_t(numThreads)
+                                        : size_t(std::thread::hardware_concurrency()));
+    maxThreads = max(size_t(1), min(jobs.size(), maxThreads));
+
+    std::atomic<size_t> nextJob(0);
+    auto worker = [&](bool fBindFonts)
+    {
+        if (fBindFonts)
+            m_libScope.bind_font_storage_to_this_thread();
+
+        size_t i;
+        while ((i = nextJob++) < jobs.size())
+            results[i] = compile_one(jobs[i]);
+
+        if (fBindFonts)
+            m_libScope.unbind_font_storage_from_this_thread();
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i=1; i < maxThreads; ++i)
+        threads.push_back( std::thread(worker, true) );
+    worker(false);
+    for (std::thread& t : threads)
+        t.join();
+
+#else
+    (void)numThreads;
+    for (size_t i=0; i < jobs.size(); ++i)
+        results[i] = compile_one(jobs[i]);
+#endif
+
+    return results;
+}
+
+//---------------------------------------------------------------------------------------
+BatchResult BatchCompiler::compile_one(const BatchJob& job)
+{
+    BatchResult result;
+    ptime startTime(true);
+    stringstream reporter;
+
+    try
+    {
+        Document doc(m_libScope, reporter);
+        doc.set_musicxml_options(m_mxlOptions);
+
+        ptime start(true);
+        int format = (job.format == BatchJob::k_detect_format
+                      ? FileFormatFinder::determine_format(job.filename)
+                      : job.format);
+        if (format < 0 || format >= Document::k_format_unknown)
+            throw runtime_error("[BatchCompiler::compile_one] File format not supported.");
+        open_document(&doc, job.filename, format, result);
+        result.compileTime = elapsed_time_since(start);
+
+        std::unique_ptr<GraphicModel> pGModel;
+        if (job.actions & (k_batch_layout | k_batch_export_svg))
+        {
+            start.init_now();
+            DocLayouter layouter(&doc, m_libScope, k_use_paper_width | k_use_paper_height);
+            layouter.layout_document();
+            pGModel.reset( layouter.get_graphic_model() );
+            pGModel->build_main_boxes_table();
+            result.numPages = pGModel->get_num_pages();
+            result.layoutTime = elapsed_time_since(start);
+        }
+
+        start.init_now();
+        ImoDocument* pImoDoc = doc.get_im_root();
+        if (job.actions & k_batch_export_ldp)
+        {
+            LdpExporter exporter;
+            result.ldp = exporter.get_source(pImoDoc);
+        }
+        if (job.actions & k_batch_export_lmd)
+        {
+            LmdExporter exporter(m_libScope);
+            result.lmd = exporter.get_source(pImoDoc);
+        }
+        if (job.actions & k_batch_export_mxl)
+        {
+            MxlExporter exporter(m_libScope);
+            result.mxl = exporter.get_source(pImoDoc);
+        }
+        if (pGModel && (job.actions & k_batch_export_svg))
+        {
+            SvgOptions svgOptions;
+            RenderOptions renderOptions;
+            for (int i=0; i < result.numPages; ++i)
+            {
+                stringstream svg;
+                URect rect = pGModel->get_page(i)->get_bounds();
+                SvgDrawer::write_svg_start(svg, svgOptions, rect.width, rect.height);
+
+                SvgDrawer drawer(m_libScope, svg, svgOptions);
+                drawer.reset(Color(255, 255, 255));
+                UPoint origin(0.0f, 0.0f);
+                pGModel->draw_page(i, origin, &drawer, renderOptions);
+                drawer.render();
+
+                SvgDrawer::write_svg_end(svg);
+                result.svg.push_back( svg.str() );
+            }
+        }
+        result.exportTime = elapsed_time_since(start);
+
+        result.status = (result.numErrors == 0 ? k_batch_ok : k_batch_with_errors);
+    }
+    catch (std::exception& e)
+    {
+        LOMSE_LOG_ERROR(e.what());
+        reporter << e.what() << " File: " << job.filename << endl;
+        result.status = k_batch_failed;
+    }
+    catch (...)
+    {
+        //jobs are compiled in worker threads: no exception can escape
+        LOMSE_LOG_ERROR("Default exception caught");
+        reporter << "Unknown exception. File: " << job.filename << endl;
+        result.status = k_batch_failed;
+    }
+
+    result.messages = reporter.str();
+    result.totalTime = elapsed_time_since(startTime);
+    return result;
+}
+
+//---------------------------------------------------------------------------------------
+void BatchCompiler::open_document(Document* pDoc, const string& filename, int format,
+                                  BatchResult& result)
+{
+    const string& cachePath = m_libScope.get_snapshots_cache_path();
+    if (cachePath.empty())
+        result.numErrors = pDoc->from_file(filename, format);
+    else
+    {
+        SnapshotsCache cache(cachePath, pDoc->get_musicxml_options());
+        result.numErrors = cache.open_document(pDoc, filename, format);
+    }
+}
+
+
+}  //namespace lomse
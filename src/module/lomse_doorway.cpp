@@ -118,6 +118,14 @@ Presenter* LomseDoorway::open_document(int viewType, LdpReader& reader,
     return builder.open_document(viewType, reader, screenDrawer, printDrawer, reporter);
 }
 
+//---------------------------------------------------------------------------------------
+std::vector<BatchResult> LomseDoorway::compile_batch(const std::vector<BatchJob>& jobs,
+                                                     int numThreads)
+{
+    BatchCompiler compiler(*m_pLibraryScope);
+    return compiler.compile(jobs, numThreads);
+}
+
 //---------------------------------------------------------------------------------------
 void LomseDoorway::init_library(int pixel_format, int ppi, bool reverse_y_axis,
                                ostream& reporter)
@@ -220,6 +228,12 @@ ScorePlayer* LomseDoorway::create_score_player(MidiServerBase* pSoundServer)
 {
     return Injector::inject_ScorePlayer(*m_pLibraryScope, pSoundServer);
 }
+
+//---------------------------------------------------------------------------------------
+PlaybackEngine* LomseDoorway::create_playback_engine()
+{
+    return Injector::inject_PlaybackEngine(*m_pLibraryScope);
+}
 #endif
 
 //---------------------------------------------------------------------------------------
@@ -234,6 +248,12 @@ MusicXmlOptions* LomseDoorway::get_musicxml_options()
     return m_pLibraryScope->get_musicxml_options();
 }
 
+//---------------------------------------------------------------------------------------
+void LomseDoorway::set_snapshots_cache_path(const std::string& path)
+{
+    m_pLibraryScope->set_snapshots_cache_path(path);
+}
+
 //---------------------------------------------------------------------------------------
 void LomseDoorway::post_event(SpEventInfo pEvent)
 {
@@ -40,9 +40,12 @@
 #include "lomse_caret_positioner.h"
 #include "lomse_glyphs.h"
 #include "lomse_engraving_options.h"
+#include "lomse_page_cache.h"
+#include "lomse_renderer.h"
 
 #if (LOMSE_ENABLE_THREADS == 1)
     #include "lomse_score_player.h"
+    #include "lomse_playback_engine.h"
 #endif
 
 #include <sstream>
@@ -55,6 +58,20 @@ namespace lomse
 //=======================================================================================
 // LibraryScope implementation
 //=======================================================================================
+
+//Font engine bound to current thread by bind_font_storage_to_this_thread(). As there
+//can be many LibraryScope objects, it is only valid for the LibraryScope with that id.
+//AWARE: ids are never reused, so a dangling binding of a deleted LibraryScope can not
+//be taken by other LibraryScope created at the same address
+struct ThreadFontStorage
+{
+    unsigned long scopeId = 0;
+    FontStorage* pFonts = nullptr;
+};
+static thread_local ThreadFontStorage m_threadFontStorage;
+static std::atomic<unsigned long> m_lastScopeId(0);
+
+//---------------------------------------------------------------------------------------
 LibraryScope::LibraryScope(ostream& reporter, LomseDoorway* pDoorway)
     : m_reporter(reporter)
     , m_pDoorway(pDoorway)
@@ -69,6 +86,7 @@ LibraryScope::LibraryScope(ostream& reporter, LomseDoorway* pDoorway)
     , m_sMusicFontPath(LOMSE_FONTS_PATH)
     , m_sFontsPath(LOMSE_FONTS_PATH)
     , m_pMusicGlyphs(nullptr)      //lazzy instantiation. Singleton scope.
+    , m_pPageCache(nullptr)
     , m_fReplaceLocalMetronome(false)
     , m_importOptions()
     , m_fJustifySystems(true)
@@ -87,6 +105,8 @@ LibraryScope::LibraryScope(ostream& reporter, LomseDoorway* pDoorway)
     , m_spacingSmin(LOMSE_MIN_SPACE)
     , m_renderSpacingOpts(k_render_opt_breaker_optimal)
 {
+    m_scopeId = ++m_lastScopeId;
+
     if (!m_pDoorway)
     {
         m_pNullDoorway = LOMSE_NEW LomseDoorway();
@@ -99,10 +119,17 @@ LibraryScope::LibraryScope(ostream& reporter, LomseDoorway* pDoorway)
 LibraryScope::~LibraryScope()
 {
     delete m_pLdpFactory;
-    delete m_pFontStorage;
+    delete m_pFontStorage.load();
     delete m_pFontSelector;
     delete m_pNullDoorway;
     delete m_pMusicGlyphs;
+    delete m_pPageCache;
+
+    for (auto it : m_threadFonts)
+        delete it.second;
+    for (FontStorage* pFonts : m_freeFonts)
+        delete pFonts;
+
     if (m_pDispatcher)
     {
         m_pDispatcher->stop_events_loop();
@@ -113,6 +140,7 @@ LibraryScope::~LibraryScope()
 //---------------------------------------------------------------------------------------
 LdpFactory* LibraryScope::ldp_factory()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     if (!m_pLdpFactory)
         m_pLdpFactory = LOMSE_NEW LdpFactory();
     return m_pLdpFactory;
@@ -121,14 +149,74 @@ LdpFactory* LibraryScope::ldp_factory()
 //---------------------------------------------------------------------------------------
 FontStorage* LibraryScope::font_storage()
 {
-    if (!m_pFontStorage)
-        m_pFontStorage = LOMSE_NEW FontStorage(this);
-    return m_pFontStorage;
+    //FontStorage is not thread safe: it keeps the selected font and the glyphs cache.
+    //Threads other than the main one must use their own instance.
+    //AWARE: This method is invoked very often during layout. The lock is only taken
+    //for creating the shared instance
+
+    if (m_threadFontStorage.scopeId == m_scopeId)
+        return m_threadFontStorage.pFonts;
+
+    FontStorage* pFonts = m_pFontStorage.load(std::memory_order_acquire);
+    if (pFonts)
+        return pFonts;
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    pFonts = m_pFontStorage.load(std::memory_order_relaxed);
+    if (!pFonts)
+    {
+        pFonts = LOMSE_NEW FontStorage(this);
+        m_pFontStorage.store(pFonts, std::memory_order_release);
+    }
+    return pFonts;
+}
+
+//---------------------------------------------------------------------------------------
+void LibraryScope::bind_font_storage_to_this_thread()
+{
+    //From now on, font_storage() will return a FontStorage instance for the exclusive
+    //use of the calling thread. Instances are not deleted when unbound but kept
+    //for reuse, as graphic objects created by the thread keep pointers to them.
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::thread::id id = std::this_thread::get_id();
+    if (m_threadFonts.find(id) != m_threadFonts.end())
+        return;
+
+    FontStorage* pFonts;
+    if (m_freeFonts.empty())
+        pFonts = LOMSE_NEW FontStorage(this);
+    else
+    {
+        pFonts = m_freeFonts.back();
+        m_freeFonts.pop_back();
+    }
+    m_threadFonts[id] = pFonts;
+    m_threadFontStorage.scopeId = m_scopeId;
+    m_threadFontStorage.pFonts = pFonts;
+}
+
+//---------------------------------------------------------------------------------------
+void LibraryScope::unbind_font_storage_from_this_thread()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto it = m_threadFonts.find(std::this_thread::get_id());
+    if (it != m_threadFonts.end())
+    {
+        m_freeFonts.push_back(it->second);
+        m_threadFonts.erase(it);
+    }
+    if (m_threadFontStorage.scopeId == m_scopeId)
+    {
+        m_threadFontStorage.scopeId = 0;
+        m_threadFontStorage.pFonts = nullptr;
+    }
 }
 
 //---------------------------------------------------------------------------------------
 FontSelector* LibraryScope::get_font_selector()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     if (!m_pFontSelector)
         m_pFontSelector = LOMSE_NEW FontSelector(this);
     return m_pFontSelector;
@@ -137,11 +225,39 @@ FontSelector* LibraryScope::get_font_selector()
 //---------------------------------------------------------------------------------------
 MusicGlyphs* LibraryScope::get_glyphs_table()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     if (!m_pMusicGlyphs)
         m_pMusicGlyphs = LOMSE_NEW MusicGlyphs(this);
     return m_pMusicGlyphs;
 }
 
+//---------------------------------------------------------------------------------------
+void LibraryScope::set_page_cache_budget(size_t maxBytes)
+{
+    //AWARE: views must not be rendering when the cache is disabled
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if (maxBytes == 0)
+    {
+        delete m_pPageCache;
+        m_pPageCache = nullptr;
+    }
+    else if (m_pPageCache)
+        m_pPageCache->set_max_bytes(maxBytes);
+    else
+    {
+        int bytesPerPixel = Renderer::bytesPerPixel( get_pixel_format() );
+        m_pPageCache = LOMSE_NEW PageCache(bytesPerPixel, maxBytes);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+PageCache* LibraryScope::get_page_cache()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return m_pPageCache;
+}
+
 //---------------------------------------------------------------------------------------
 void LibraryScope::set_music_font(const string& fontFile, const string& fontName,
                                   const string& path)
@@ -172,6 +288,7 @@ bool LibraryScope::is_music_font_smufl_compliant()
 //---------------------------------------------------------------------------------------
 EventsDispatcher* LibraryScope::get_events_dispatcher()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     if (!m_pDispatcher)
     {
         m_pDispatcher = LOMSE_NEW EventsDispatcher();
@@ -431,6 +548,12 @@ ScorePlayer* Injector::inject_ScorePlayer(LibraryScope& libraryScope,
 {
     return LOMSE_NEW ScorePlayer(libraryScope, pSoundServer);
 }
+
+//---------------------------------------------------------------------------------------
+PlaybackEngine* Injector::inject_PlaybackEngine(LibraryScope& libraryScope)
+{
+    return LOMSE_NEW PlaybackEngine(libraryScope);
+}
 #endif
 
 //---------------------------------------------------------------------------------------
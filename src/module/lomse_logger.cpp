@@ -129,6 +129,7 @@ void Logger::log_message(const string& file, int line, const string& prettyFunct
     size_t fileStartWindows = file.rfind("\\") + 1;
     size_t fileStart = max(fileStartLinux, fileStartWindows);
 
+    std::lock_guard<std::mutex> lock(m_mutex);
     (*m_logStream) << file.substr(fileStart) << ", line " << line << ". " << prefix << "["
             << prettyFunction.substr(begin,end) << "] " << msg << endl;
 }
@@ -33,7 +33,15 @@
 #include "lomse_measure_highlight.h"
 #include "lomse_score_algorithms.h"
 #include "lomse_gm_measures_table.h"
-
+#include "lomse_gm_tracking_table.h"
+#include "lomse_tile_cache.h"
+#include "lomse_page_cache.h"
+
+#include <cmath>        //floor
+#if (LOMSE_ENABLE_THREADS == 1)
+    #include <atomic>
+    #include <thread>
+#endif
 using namespace std;
 
 namespace lomse
@@ -123,6 +131,11 @@ GraphicView::GraphicView(LibraryScope& libraryScope, Drawer* pDrawer,
     , m_pPrintDrawer(pPrintDrawer)
     , m_options()
     , m_pOverlaysGenerator(nullptr)
+    , m_pTileCache(nullptr)
+    , m_pTileDrawer(nullptr)
+    , m_numRenderThreads(1)
+    , m_fScrollBlitting(false)
+    , m_fScrollDamage(false)
     , m_expand(0.0)
     , m_gamma(1.0)
     , m_rotation(0.0)   //degrees: -180.0 to 180.0
@@ -180,6 +193,16 @@ GraphicView::~GraphicView()
     delete m_pDrawer;
     delete m_pPrintDrawer;
     delete m_pOverlaysGenerator;
+    delete m_pTileCache;
+    delete m_pTileDrawer;
+
+    //cached pages are no longer displayed in this view
+    PageCache* pPageCache = m_libraryScope.get_page_cache();
+    if (pPageCache)
+    {
+        pPageCache->start_frame(this);
+        pPageCache->end_frame(this);
+    }
 
     //AWARE: ownership of all VisualEffects (m_pCaret, m_pDragImg, m_pHighlighted,
     //       m_pTimeGrid & m_pTempoLine) is transferred to OverlaysGenerator.
@@ -368,15 +391,16 @@ bool GraphicView::determine_page_system_and_position_for(ImoId scoreId, TimeUnit
     if (!pGModel)
         return false;    //error
 
-    m_pScrollSystem = pGModel->get_system_for(scoreId, timepos);
-    //LOMSE_LOG_DEBUG(Logger::k_events,
-    //                "scoreId=%d, timepos=%f, system=%s",
-    //                scoreId, timepos, (m_pScrollSystem != nullptr ? "found" : "not found"));
-    if (!m_pScrollSystem)
+    //AWARE: This code is executed in the sound thread. The tracking table was built
+    //when the graphic model was created, so this is just a binary search
+    GmTrackingTable* pTable = pGModel->get_tracking_table(scoreId);
+    TrackingPosition pos;
+    if (!pTable || !pTable->find(timepos, &pos))
         return false;    //error
 
-    m_iScrollPage = m_pScrollSystem->get_page_number();
-    m_xScrollLeft = m_pScrollSystem->get_x_for_note_rest_at_time(timepos);
+    m_pScrollSystem = pos.pSystem;
+    m_iScrollPage = pos.iPage;
+    m_xScrollLeft = pos.xPos;
     m_xScrollRight = m_xScrollLeft + 1000;   //1 cm
 
     //LOMSE_LOG_DEBUG(Logger::k_events, "new scroll pos = %f, %f", m_xScrollLeft, m_xScrollRight);
@@ -402,9 +426,10 @@ void GraphicView::change_viewport_if_necessary(ImoId id)
 {
     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player, string(""));
 
-    //AWARE: This code is executed in the sound thread
-
-    std::lock_guard<std::mutex> lock(m_viewportMutex);
+    //AWARE: This code could be executed in the sound thread. The graphic model is not
+    //modified during playback, so only the view variables need the lock. But the
+    //sound thread must never wait for the user interface: if the viewport is being
+    //changed, this request is ignored. Next tracking event will check again
 
     GraphicModel* pGModel = get_graphic_model();
     if (!pGModel)
@@ -416,9 +441,15 @@ void GraphicView::change_viewport_if_necessary(ImoId id)
 
     GmoBoxSliceInstr* pBSI = static_cast<GmoBoxSliceInstr*>( pShape->get_owner_box() );
     GmoBoxSlice* pBS = static_cast<GmoBoxSlice*>( pBSI->get_parent_box() );
-    m_pScrollSystem = static_cast<GmoBoxSystem*>( pBS->get_parent_box() );
-    GmoBoxDocPage* pBoxPage = m_pScrollSystem->get_parent_doc_page();
-    m_iScrollPage = pBoxPage->get_number() - 1;
+    GmoBoxSystem* pSystem = static_cast<GmoBoxSystem*>( pBS->get_parent_box() );
+    int iPage = pSystem->get_parent_doc_page()->get_number() - 1;
+
+    std::unique_lock<std::mutex> lock(m_viewportMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+
+    m_pScrollSystem = pSystem;
+    m_iScrollPage = iPage;
     m_xScrollLeft = pBS->get_left();
     m_xScrollRight = pBS->get_right();
 
@@ -692,7 +723,10 @@ void GraphicView::draw_all()
 
         //render handlers and visual effects
         m_pInteractor->timing_visual_effects_start();
-        m_pOverlaysGenerator->on_new_background();
+        if (m_fScrollDamage)
+            m_pOverlaysGenerator->on_scrolled_background();
+        else
+            m_pOverlaysGenerator->on_new_background();
         draw_all_visual_effects();
         m_pInteractor->timing_renderization_end();
     }
@@ -832,8 +866,11 @@ void GraphicView::print_page(int page, VPoint viewport)
 
         UPoint origin(0.0f, 0.0f);
         GraphicModel* pGModel = get_graphic_model();
-        pGModel->draw_page(page, origin, m_pPrintDrawer, m_options);
-        m_pPrintDrawer->render();
+        draw_in_bands(m_pPrintDrawer, [&](Drawer* pDrawer)
+        {
+            pGModel->draw_page(page, origin, pDrawer, m_options);
+            pDrawer->render();
+        });
     }
 }
 
@@ -873,12 +910,330 @@ void GraphicView::draw_graphic_model()
     m_options.read_only_mode =
         m_pInteractor->get_operating_mode() != Interactor::k_mode_edition;
 
+    m_fScrollDamage = false;
+    BitmapDrawer* pDrawer = dynamic_cast<BitmapDrawer*>(m_pDrawer);
+    if (m_pTileCache && pDrawer && is_valid_viewport())
+    {
+        //frame info is not saved, so it can not be reused if tiles are disabled
+        m_lastFrame.fValid = false;
+        draw_graphic_model_from_tiles(pDrawer);
+        return;
+    }
+
+    if (pDrawer && can_scroll_last_frame())
+    {
+        draw_graphic_model_scrolled(pDrawer);
+        save_frame_info();
+        return;
+    }
+    save_frame_info();
+
+    //pages no longer displayed will be compressed in the page cache
+    PageCache* pPageCache = m_libraryScope.get_page_cache();
+    if (pPageCache)
+        pPageCache->start_frame(this);
+
     m_pDrawer->reset(m_options.background_color);
     m_pDrawer->new_viewport_origin(double(m_vxOrg), double(m_vyOrg));
     m_pDrawer->set_affine_transformation(m_transform);
 
-    generate_paths();
-    m_pDrawer->render();
+    if (m_numRenderThreads != 1 && pDrawer)
+    {
+        collect_page_bounds();
+        if (is_valid_viewport())
+        {
+            int minPage, maxPage;
+            determine_visible_pages(&minPage, &maxPage);
+            draw_in_bands(pDrawer, [&](Drawer* pBandDrawer)
+            {
+                draw_visible_pages(minPage, maxPage, pBandDrawer);
+                pBandDrawer->render();
+            });
+        }
+    }
+    else
+    {
+        generate_paths();
+        m_pDrawer->render();
+    }
+
+    if (pPageCache)
+        pPageCache->end_frame(this);
+}
+
+//---------------------------------------------------------------------------------------
+bool GraphicView::can_scroll_last_frame()
+{
+    //The last frame can be reused if it was rendered on the same buffer, only the
+    //viewport origin has changed and part of the frame is still visible
+
+    if (!m_fScrollBlitting || !m_lastFrame.fValid || !is_valid_viewport())
+        return false;
+
+    Pixels dx = m_lastFrame.vxOrg - m_vxOrg;
+    Pixels dy = m_lastFrame.vyOrg - m_vyOrg;
+    if ((dx == 0 && dy == 0)
+        || abs(dx) >= m_viewportSize.width || abs(dy) >= m_viewportSize.height)
+    {
+        return false;
+    }
+
+    GraphicModel* pGModel = get_graphic_model();
+    return m_lastFrame.scale == m_transform.scale()
+        && m_lastFrame.modelId == pGModel->get_model_id()
+        && m_lastFrame.modelVersion == pGModel->get_version()
+        && m_lastFrame.options == m_options;
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::draw_graphic_model_scrolled(BitmapDrawer* pDrawer)
+{
+    //The last frame is moved by the scroll amount and only the newly exposed areas,
+    //a vertical and/or an horizontal strip, are rasterized
+
+    Pixels dx = m_lastFrame.vxOrg - m_vxOrg;
+    Pixels dy = m_lastFrame.vyOrg - m_vyOrg;
+    Pixels width = m_viewportSize.width;
+    Pixels height = m_viewportSize.height;
+
+    //remove overlays, as they will be rendered again at their new positions
+    m_pOverlaysGenerator->restore_background();
+    pDrawer->scroll_bitmap(dx, dy);
+
+    pDrawer->new_viewport_origin(double(m_vxOrg), double(m_vyOrg));
+    pDrawer->set_affine_transformation(m_transform);
+    collect_page_bounds();
+
+    m_scrollDamagedRect = VRect(0, 0, 0, 0);
+    if (dx > 0)
+        draw_exposed_rectangle(pDrawer, 0, 0, dx, height);
+    else if (dx < 0)
+        draw_exposed_rectangle(pDrawer, width + dx, 0, width, height);
+
+    if (dy > 0)
+        draw_exposed_rectangle(pDrawer, 0, 0, width, dy);
+    else if (dy < 0)
+        draw_exposed_rectangle(pDrawer, 0, height + dy, width, height);
+
+    pDrawer->reset_clip_rect();
+    m_fScrollDamage = true;
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::draw_exposed_rectangle(BitmapDrawer* pDrawer, Pixels x1, Pixels y1,
+                                         Pixels x2, Pixels y2)
+{
+    pDrawer->clear_clip_rect(x1, y1, x2, y2, m_options.background_color);
+
+    int minPage, maxPage;
+    determine_visible_pages(&minPage, &maxPage);
+    draw_visible_pages(minPage, maxPage, pDrawer);
+    pDrawer->render();
+
+    m_scrollDamagedRect.Union( VRect(VPoint(x1, y1), VPoint(x2, y2)) );
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::save_frame_info()
+{
+    GraphicModel* pGModel = get_graphic_model();
+    m_lastFrame.fValid = (pGModel != nullptr);
+    m_lastFrame.vxOrg = m_vxOrg;
+    m_lastFrame.vyOrg = m_vyOrg;
+    m_lastFrame.scale = m_transform.scale();
+    m_lastFrame.modelId = (pGModel ? pGModel->get_model_id() : -1L);
+    m_lastFrame.modelVersion = (pGModel ? pGModel->get_version() : -1L);
+    m_lastFrame.options = m_options;
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::enable_scroll_blitting(bool fEnabled)
+{
+    m_fScrollBlitting = fEnabled;
+    m_lastFrame.fValid = false;
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::draw_in_bands(BitmapDrawer* pDrawer, std::function<void(Drawer*)> draw)
+{
+    //The rendering buffer is split in horizontal bands that are rasterized in
+    //parallel. Each worker thread uses its own BitmapDrawer (renderer, paths and
+    //font engine) but all them draw directly on the rendering buffer of pDrawer.
+    //The graphic model is only read. Result is identical to the one obtained by
+    //using only pDrawer.
+
+#if (LOMSE_ENABLE_THREADS == 1)
+    int numThreads = (m_numRenderThreads > 0 ? m_numRenderThreads
+                                             : int(std::thread::hardware_concurrency()));
+    int height = int(pDrawer->get_rendering_buffer_height());
+    if (numThreads > 1 && height > 1)
+    {
+        //more bands than threads, to balance the load when content is not uniform
+        int numBands = min(height, 2 * numThreads);
+        int bandHeight = (height + numBands - 1) / numBands;
+        numBands = (height + bandHeight - 1) / bandHeight;
+        numThreads = min(numThreads, numBands);
+
+        std::atomic<int> nextBand(0);
+        std::vector<std::exception_ptr> errors(numThreads);
+        auto worker = [&](int iThread)
+        {
+            //AWARE: the drawer must be created after binding the font engine
+            if (iThread > 0)
+                m_libraryScope.bind_font_storage_to_this_thread();
+            try
+            {
+                BitmapDrawer drawer(m_libraryScope);
+                int iBand;
+                while ((iBand = nextBand++) < numBands)
+                {
+                    int yStart = iBand * bandHeight;
+                    int yEnd = min(height, yStart + bandHeight);
+                    drawer.share_rendering_buffer(pDrawer, unsigned(yStart),
+                                                  unsigned(yEnd));
+                    draw(&drawer);
+                }
+            }
+            catch (...)
+            {
+                errors[iThread] = std::current_exception();
+            }
+            if (iThread > 0)
+                m_libraryScope.unbind_font_storage_from_this_thread();
+        };
+
+        std::vector<std::thread> threads;
+        for (int i=1; i < numThreads; ++i)
+            threads.push_back( std::thread(worker, i) );
+        worker(0);
+        for (std::thread& t : threads)
+            t.join();
+
+        for (std::exception_ptr& error : errors)
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+        return;
+    }
+#endif
+
+    draw(pDrawer);
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::set_rendering_threads(int numThreads)
+{
+    m_numRenderThreads = max(0, numThreads);
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::draw_graphic_model_from_tiles(BitmapDrawer* pDrawer)
+{
+    //The viewport is composed from the cached tiles that intersect it. Only missing
+    //tiles are rasterized. The canvas (tiles space) is the viewport space, without
+    //the viewport origin translation
+
+    pDrawer->new_viewport_origin(double(m_vxOrg), double(m_vyOrg));
+    pDrawer->set_affine_transformation(m_transform);
+    collect_page_bounds();
+
+    GraphicModel* pGModel = get_graphic_model();
+    m_pTileCache->set_content(pGModel->get_model_id(), pGModel->get_version(), m_options);
+    m_pTileCache->reset_counters();
+
+    int size = m_pTileCache->get_tile_size();
+    double scale = m_transform.scale();
+    Pixels xLeft = m_vxOrg;
+    Pixels yTop = m_vyOrg;
+    Pixels xRight = m_vxOrg + m_viewportSize.width - 1;
+    Pixels yBottom = m_vyOrg + m_viewportSize.height - 1;
+
+    //AWARE: viewport origin can be negative. Round towards minus infinity
+    int colMin = int( floor(double(xLeft) / double(size)) );
+    int colMax = int( floor(double(xRight) / double(size)) );
+    int rowMin = int( floor(double(yTop) / double(size)) );
+    int rowMax = int( floor(double(yBottom) / double(size)) );
+
+    for (int row = rowMin; row <= rowMax; ++row)
+    {
+        for (int col = colMin; col <= colMax; ++col)
+        {
+            Tile* pTile = m_pTileCache->find_tile(scale, col, row);
+            if (!pTile)
+            {
+                pTile = m_pTileCache->add_tile(scale, col, row);
+                render_tile(pTile);
+            }
+            pDrawer->copy_bitmap(pTile->rbuf, col * size - m_vxOrg, row * size - m_vyOrg);
+        }
+    }
+
+    m_pInteractor->timing_tile_cache_counters(m_pTileCache->get_num_hits(),
+                                              m_pTileCache->get_num_misses());
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::render_tile(Tile* pTile)
+{
+    if (!m_pTileDrawer)
+        m_pTileDrawer = LOMSE_NEW BitmapDrawer(m_libraryScope);
+
+    //the tile is rendered as a viewport whose origin is the tile origin
+    int size = m_pTileCache->get_tile_size();
+    Pixels xOrg = pTile->col * size;
+    Pixels yOrg = pTile->row * size;
+    m_pTileDrawer->set_rendering_buffer(pTile->rbuf.buf(), unsigned(size), unsigned(size),
+                                        m_options.background_color);
+    m_pTileDrawer->new_viewport_size(double(size), double(size));
+    m_pTileDrawer->new_viewport_origin(double(xOrg), double(yOrg));
+    TransAffine transform = m_transform;
+    transform.tx = double(-xOrg);
+    transform.ty = double(-yOrg);
+    m_pTileDrawer->set_affine_transformation(transform);
+
+    //draw the pages intersecting the tile. A margin is added for antialiasing pixels
+    double xLeft = -2.0;
+    double yTop = -2.0;
+    double xRight = double(size + 2);
+    double yBottom = double(size + 2);
+    m_pTileDrawer->device_point_to_model(&xLeft, &yTop);
+    m_pTileDrawer->device_point_to_model(&xRight, &yBottom);
+
+    GraphicModel* pGModel = get_graphic_model();
+    int iPage = 0;
+    for (list<URect>::iterator it = m_pageBounds.begin(); it != m_pageBounds.end();
+         ++it, ++iPage)
+    {
+        if ((*it).right() >= xLeft && (*it).left() <= xRight
+            && (*it).bottom() >= yTop && (*it).top() <= yBottom)
+        {
+            UPoint origin = (*it).get_top_left();
+            pGModel->draw_page(iPage, origin, m_pTileDrawer, m_options);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void GraphicView::set_tile_cache_budget(size_t maxBytes)
+{
+    if (maxBytes == 0)
+    {
+        if (m_pTileCache)
+            m_lastFrame.fValid = false;
+        delete m_pTileCache;
+        m_pTileCache = nullptr;
+        delete m_pTileDrawer;
+        m_pTileDrawer = nullptr;
+    }
+    else if (m_pTileCache)
+        m_pTileCache->set_max_bytes(maxBytes);
+    else
+    {
+        int bytesPerPixel = Renderer::bytesPerPixel(m_libraryScope.get_pixel_format());
+        m_pTileCache = LOMSE_NEW TileCache(bytesPerPixel, maxBytes);
+        m_lastFrame.fValid = false;
+    }
 }
 
 //---------------------------------------------------------------------------------------
@@ -972,6 +1327,24 @@ void GraphicView::draw_selected_objects()
 
 //---------------------------------------------------------------------------------------
 VRect GraphicView::get_damaged_rectangle()
+{
+    //after scrolling, only the exposed area was rendered. But overlays, at their
+    //previous and new positions, can be outside the exposed area
+    bool fScrolled = m_fScrollDamage
+                     && !m_pOverlaysGenerator->is_full_rectangle_damaged();
+    m_fScrollDamage = false;
+
+    VRect overlaysRect = get_overlays_damaged_rectangle();
+    if (fScrolled)
+    {
+        VRect rect = m_scrollDamagedRect;
+        return rect.Union(overlaysRect);
+    }
+    return overlaysRect;
+}
+
+//---------------------------------------------------------------------------------------
+VRect GraphicView::get_overlays_damaged_rectangle()
 {
     URect uRect = m_pOverlaysGenerator->get_damaged_rectangle();
     if (uRect == URect(0.0, 0.0, 0.0, 0.0))
@@ -989,6 +1362,8 @@ VRect GraphicView::get_damaged_rectangle()
     Pixels y1 = max(0, Pixels(top));
     Pixels x2 = min(Pixels(right), m_viewportSize.width);
     Pixels y2 = min(Pixels(bottom), m_viewportSize.height);
+    if (x2 <= x1 || y2 <= y1)
+        return VRect(0, 0, 0, 0);
 
     return VRect(VPoint(x1, y1), VPoint(x2, y2));
 }
@@ -1622,7 +1997,7 @@ void GraphicView::generate_paths()
         int minPage, maxPage;
 
         determine_visible_pages(&minPage, &maxPage);
-        draw_visible_pages(minPage, maxPage);
+        draw_visible_pages(minPage, maxPage, m_pDrawer);
     }
 }
 
@@ -1656,7 +2031,7 @@ void GraphicView::delete_rectangles(list<PageRectangle*>& rectangles)
 }
 
 //---------------------------------------------------------------------------------------
-void GraphicView::draw_visible_pages(int minPage, int maxPage)
+void GraphicView::draw_visible_pages(int minPage, int maxPage, Drawer* pDrawer)
 {
     GraphicModel* pGModel = get_graphic_model();
 
@@ -1664,13 +2039,76 @@ void GraphicView::draw_visible_pages(int minPage, int maxPage)
     for (int i=0; i < minPage; i++)
         ++it;
 
+    PageCache* pPageCache = m_libraryScope.get_page_cache();
+    BitmapDrawer* pBmpDrawer = dynamic_cast<BitmapDrawer*>(pDrawer);
     for (int i=minPage; i <= maxPage; i++, ++it)
     {
-        UPoint origin = (*it).get_top_left();
-        pGModel->draw_page(i, origin, m_pDrawer, m_options);
+        if (pPageCache && pBmpDrawer)
+            draw_page_from_cache(i, *it, pBmpDrawer, pPageCache);
+        else
+        {
+            UPoint origin = (*it).get_top_left();
+            pGModel->draw_page(i, origin, pDrawer, m_options);
+        }
     }
 }
 
+//---------------------------------------------------------------------------------------
+void GraphicView::draw_page_from_cache(int iPage, const URect& bounds,
+                                       BitmapDrawer* pDrawer, PageCache* pPageCache)
+{
+    //The page is rasterized in canvas space, as tiles are (see render_tile()), so
+    //that the cached bitmap is identical to direct rendering for any viewport
+    //origin. A margin is added for antialiasing pixels
+
+    GraphicModel* pGModel = get_graphic_model();
+    PageKey key;
+    key.docModelRef = m_pInteractor->get_document_model_ref();
+    //A graphic model never modified (version 0) is the layout of the document model,
+    //identical in all views of this document with the same layout constrains, so its
+    //pages are shared. Once modified (e.g. selection highlight) the pages are specific
+    //to that graphic model and its id is used
+    key.gmodelId = (pGModel->get_version() == 0L ? -1L : pGModel->get_model_id());
+    key.gmodelVersion = pGModel->get_version();
+    key.layoutConstrains = get_layout_constrains();
+    key.iPage = iPage;
+    key.bounds = bounds;
+    key.scale = m_transform.scale();
+    key.pixelFormat = m_libraryScope.get_pixel_format();
+    key.options = m_options;
+
+    double xLeft = bounds.left();
+    double yTop = bounds.top();
+    double xRight = bounds.right();
+    double yBottom = bounds.bottom();
+    pDrawer->model_point_to_device(&xLeft, &yTop);
+    pDrawer->model_point_to_device(&xRight, &yBottom);
+    const Pixels margin = 2;
+    Pixels x1 = Pixels( floor(xLeft) ) + m_vxOrg - margin;
+    Pixels y1 = Pixels( floor(yTop) ) + m_vyOrg - margin;
+    Pixels x2 = Pixels( ceil(xRight) ) + m_vxOrg + margin;
+    Pixels y2 = Pixels( ceil(yBottom) ) + m_vyOrg + margin;
+    VRect area(VPoint(x1, y1), VPoint(x2, y2));
+
+    pPageCache->draw_page(key, area, this, pDrawer, x1 - m_vxOrg, y1 - m_vyOrg,
+                          [&](RenderingBuffer& rbuf)
+    {
+        //AWARE: the drawer must be created in the current thread (fonts)
+        BitmapDrawer drawer(m_libraryScope);
+        drawer.set_rendering_buffer(rbuf.buf(), rbuf.width(), rbuf.height(),
+                                    m_options.background_color);
+        drawer.new_viewport_size(double(rbuf.width()), double(rbuf.height()));
+        drawer.new_viewport_origin(double(x1), double(y1));
+        TransAffine transform = m_transform;
+        transform.tx = double(-x1);
+        transform.ty = double(-y1);
+        drawer.set_affine_transformation(transform);
+
+        UPoint origin = bounds.get_top_left();
+        pGModel->draw_page(iPage, origin, &drawer, m_options);
+    });
+}
+
 //---------------------------------------------------------------------------------------
 UPoint GraphicView::get_page_origin_for(GmoObj* pGmo)
 {
@@ -1695,6 +2133,7 @@ void GraphicView::set_rendering_buffer(unsigned char* buf, unsigned width, unsig
         m_fUpdateGModel = true;
 
 
+    m_lastFrame.fValid = false;
     if (buf && width > 0 && height > 0)
     {
         BitmapDrawer* pScreenDrawer = dynamic_cast<BitmapDrawer*>(m_pDrawer);
@@ -1725,6 +2164,7 @@ void GraphicView::set_rendering_buffer(RenderingBuffer* rbuf)
     if (m_viewportSize.width != int(rbuf->width()))
         m_fUpdateGModel = true;
 
+    m_lastFrame.fValid = false;
     BitmapDrawer* pScreenDrawer = dynamic_cast<BitmapDrawer*>(m_pDrawer);
     if (pScreenDrawer)
     {
@@ -1768,6 +2208,7 @@ void GraphicView::set_print_buffer(RenderingBuffer* rbuf)
 void GraphicView::set_view_area(unsigned width, unsigned height, unsigned xShift,
                                 unsigned yShift)
 {
+    m_lastFrame.fValid = false;
     BitmapDrawer* pScreenDrawer = dynamic_cast<BitmapDrawer*>(m_pDrawer);
     if (pScreenDrawer)
         pScreenDrawer->set_view_area(width, height, xShift, yShift);
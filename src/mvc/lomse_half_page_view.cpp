@@ -108,6 +108,9 @@ void HalfPageView::do_draw_all()
             draw_separation_line();
             draw_bottom_window();
         }
+
+        //the frame is the last window drawn, not the whole buffer
+        m_lastFrame.fValid = false;
     }
 }
 
@@ -125,6 +128,7 @@ void HalfPageView::draw_bottom_window()
     //trim view area to avoid drawing part of next system
     m_pBmpDrawer->set_view_area(m_bufWidth, m_usedHeight[1], 0, m_yShiftBottom);
     GraphicView::do_change_viewport(m_vxOrgPlay[1], m_vyOrgPlay[1]);
+    m_lastFrame.fValid = false;     //last frame is the other window
     GraphicView::draw_all();
 }
 
@@ -149,6 +153,7 @@ void HalfPageView::draw_top_window()
     //trim view area to avoid drawing part of next system
     m_pBmpDrawer->set_view_area(m_bufWidth, m_usedHeight[0], 0, 0);
     GraphicView::do_change_viewport(m_vxOrgPlay[0], m_vyOrgPlay[0]);
+    m_lastFrame.fValid = false;     //last frame is the other window
     GraphicView::draw_all();
 }
 
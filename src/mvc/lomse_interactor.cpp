@@ -34,6 +34,7 @@
 #include "lomse_score_algorithms.h"
 #include "lomse_renderer.h"
 #include "lomse_svg_drawer.h"
+#include "lomse_page_cache.h"
 
 #include <sstream>
 #include <chrono>
@@ -71,6 +72,7 @@ Interactor::Interactor(LibraryScope& libraryScope, WpDocument wpDoc, View* pView
     , m_fEditionEnabled(false)
     , m_fViewParamsChanged(false)
     , m_fViewUpdatesEnabled(true)
+    , m_playbackQueue(256)
     , m_idControlledImo(k_no_imoid)
 {
     switch_task(TaskFactory::k_task_only_clicks);
@@ -123,6 +125,14 @@ GraphicModel* Interactor::get_graphic_model()
     return m_pGraphicModel;
 }
 
+//---------------------------------------------------------------------------------------
+long Interactor::get_document_model_ref()
+{
+    if (SpDocument spDoc = m_wpDoc.lock())
+        return spDoc->get_model_ref();
+    return -1L;
+}
+
 //---------------------------------------------------------------------------------------
 void Interactor::create_graphic_model()
 {
@@ -181,6 +191,7 @@ bool Interactor::graphic_model_must_be_updated()
 void Interactor::on_document_updated()
 {
     LOMSE_LOG_DEBUG(Logger::k_mvc, "[Interactor::on_document_updated]");
+    discard_cached_pages();
     delete_graphic_model();
     create_graphic_model();
     //TODO: Interactor::on_document_updated. Update cursor
@@ -188,12 +199,21 @@ void Interactor::on_document_updated()
     //m_cursor = cursor;
 }
 
+//---------------------------------------------------------------------------------------
+void Interactor::discard_cached_pages()
+{
+    PageCache* pPageCache = m_libScope.get_page_cache();
+    if (pPageCache)
+        pPageCache->invalidate( get_document_model_ref() );
+}
+
 //---------------------------------------------------------------------------------------
 void Interactor::handle_event(SpEventInfo pEvent)
 {
     switch(pEvent->get_event_type())
     {
         case k_doc_modified_event:
+            discard_cached_pages();
             delete_graphic_model();
             restore_selection();
             force_redraw();
@@ -215,7 +235,7 @@ void Interactor::handle_event(SpEventInfo pEvent)
             //AWARE: It could never arrive here as on_end_of_play_event() could
             //be invoked directly by user application
             LOMSE_LOG_DEBUG(Logger::k_events, "Interactor::handle_even] End of playback event received");
-            SpEventPlayCtrl pEv( static_pointer_cast<EventPlayCtrl>(pEvent) );
+            SpEventEndOfPlayback pEv( static_pointer_cast<EventEndOfPlayback>(pEvent) );
             if (is_valid_play_score_event(pEv))
                 on_end_of_play_event(pEv->get_score(), pEv->get_player());
             break;
@@ -1496,6 +1516,30 @@ void Interactor::set_view_background(Color color)
         pGView->set_background(color);
 }
 
+//---------------------------------------------------------------------------------------
+void Interactor::set_tile_cache_budget(size_t maxBytes)
+{
+    GraphicView* pGView = dynamic_cast<GraphicView*>(m_pView);
+    if (pGView)
+        pGView->set_tile_cache_budget(maxBytes);
+}
+
+//---------------------------------------------------------------------------------------
+void Interactor::set_rendering_threads(int numThreads)
+{
+    GraphicView* pGView = dynamic_cast<GraphicView*>(m_pView);
+    if (pGView)
+        pGView->set_rendering_threads(numThreads);
+}
+
+//---------------------------------------------------------------------------------------
+void Interactor::enable_scroll_blitting(bool fEnabled)
+{
+    GraphicView* pGView = dynamic_cast<GraphicView*>(m_pView);
+    if (pGView)
+        pGView->enable_scroll_blitting(fEnabled);
+}
+
 //---------------------------------------------------------------------------------------
 void Interactor::set_box_to_draw(int boxType)
 {
@@ -1602,17 +1646,14 @@ void Interactor::render_as_svg(std::ostream& svg, int page)
         USize size = get_page_size(page);
 
         //add <svg> element with the viewport
-        svg << "<svg xmlns='http://www.w3.org/2000/svg' version='1.1' viewBox='0 0 "
-                << size.width << " " << size.height << "'>";
-        if (m_svgOptions.add_newlines)
-            svg << endl;
+        SvgDrawer::write_svg_start(svg, m_svgOptions, size.width, size.height);
 
         //render the page
         SvgDrawer drawer(m_libScope, svg, m_svgOptions);
         pGView->render_as_svg(drawer, page);
 
         //terminate svg element
-        svg << "</svg>";
+        SvgDrawer::write_svg_end(svg);
     }
 }
 
@@ -1656,7 +1697,7 @@ bool Interactor::discard_visual_tracking_event_if_not_valid(ImoId scoreId)
 }
 
 //---------------------------------------------------------------------------------------
-bool Interactor::is_valid_play_score_event(SpEventPlayCtrl UNUSED(pEvent))
+bool Interactor::is_valid_play_score_event(SpEventEndOfPlayback UNUSED(pEvent))
 {
     LOMSE_LOG_ERROR("TODO: Method not implemented");
     //TODO
@@ -1723,6 +1764,26 @@ void Interactor::on_visual_tracking(SpEventVisualTracking pEvent)
     }
 }
 
+//---------------------------------------------------------------------------------------
+bool Interactor::queue_playback_event(SpEventInfo pEvent)
+{
+    //AWARE: This code is executed in the sound thread. No locks, no view access
+    return m_playbackQueue.push(pEvent);
+}
+
+//---------------------------------------------------------------------------------------
+int Interactor::process_playback_events()
+{
+    int numEvents = 0;
+    SpEventInfo pEvent;
+    while (m_playbackQueue.pop(pEvent))
+    {
+        handle_event(pEvent);
+        ++numEvents;
+    }
+    return numEvents;
+}
+
 //---------------------------------------------------------------------------------------
 void Interactor::on_end_of_play_event(ImoScore* pScore, PlayerGui* pPlayCtrl)
 {
@@ -1980,6 +2041,13 @@ void Interactor::timing_renderization_end()
     m_repaintStartTime = now;
 }
 
+//---------------------------------------------------------------------------------------
+void Interactor::timing_tile_cache_counters(long numHits, long numMisses)
+{
+    m_elapsedTimes[k_timing_tile_cache_hits] = double(numHits);
+    m_elapsedTimes[k_timing_tile_cache_misses] = double(numMisses);
+}
+
 //---------------------------------------------------------------------------------------
 void Interactor::timing_repaint_done()
 {
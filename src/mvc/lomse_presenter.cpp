@@ -16,6 +16,7 @@
 #include "lomse_view.h"
 #include "lomse_interactor.h"
 #include "lomse_logger.h"
+#include "lomse_im_snapshot.h"
 
 #include <sstream>
 using namespace std;
@@ -24,40 +25,32 @@ namespace lomse
 {
 
 //=======================================================================================
-// Helper class to determine file format
+// FileFormatFinder implementation
 //=======================================================================================
-class FileFormatFinder
-{
-public:
-    FileFormatFinder() {}
-    ~FileFormatFinder() {}
-
-    static int determine_format(const string& fullpath)
-    {
-        size_t length = fullpath.size();
-        if (length < 5)
-            return Document::k_format_unknown;
-
-        size_t i = fullpath.rfind('.', length);
-        if (i == string::npos)
-            return Document::k_format_unknown;
-
-        string ext = fullpath.substr(i+1, length - i);
-        if (ext == "lms")
-            return Document::k_format_ldp;
-        else if (ext == "lmd")
-            return Document::k_format_lmd;
-        else if (ext == "xml" || ext == "musicxml")
-            return Document::k_format_mxl;
-        else if (ext == "mxl")
-            return Document::k_format_mxl_compressed;
-        else if (ext == "mnx")
-            return Document::k_format_mnx;
-        else
-            return Document::k_format_unknown;
-    }
-
-};
+int FileFormatFinder::determine_format(const string& fullpath)
+{
+    size_t length = fullpath.size();
+    if (length < 5)
+        return Document::k_format_unknown;
+
+    size_t i = fullpath.rfind('.', length);
+    if (i == string::npos)
+        return Document::k_format_unknown;
+
+    string ext = fullpath.substr(i+1, length - i);
+    if (ext == "lms")
+        return Document::k_format_ldp;
+    else if (ext == "lmd")
+        return Document::k_format_lmd;
+    else if (ext == "xml" || ext == "musicxml")
+        return Document::k_format_mxl;
+    else if (ext == "mxl")
+        return Document::k_format_mxl_compressed;
+    else if (ext == "mnx")
+        return Document::k_format_mnx;
+    else
+        return Document::k_format_unknown;
+}
 
 
 //=======================================================================================
@@ -108,7 +101,14 @@ Presenter* PresenterBuilder::open_document(int viewType, const std::string& file
 {
     Document* pDoc = Injector::inject_Document(m_libScope, reporter);
     int format = FileFormatFinder::determine_format(filename);
-    pDoc->from_file(filename, format);
+    const std::string& cachePath = m_libScope.get_snapshots_cache_path();
+    if (cachePath.empty())
+        pDoc->from_file(filename, format);
+    else
+    {
+        SnapshotsCache cache(cachePath, pDoc->get_musicxml_options());
+        cache.open_document(pDoc, filename, format);
+    }
 
     return Injector::inject_Presenter(m_libScope, viewType, pDoc, screenDrawer,
                                       printDrawer);
@@ -193,6 +193,43 @@ void XmlParser::parse_buffer(const void* buffer, size_t size)
     find_root();
 }
 
+//---------------------------------------------------------------------------------------
+void XmlParser::parse_buffer_own(void* buffer, size_t size)
+{
+    //The parser takes ownership of the buffer, that must have been allocated by
+    //allocate_buffer(), and builds the tree in place, without copying it. The
+    //buffer will be freed when the parser is deleted or a new source is parsed.
+
+    m_fOffsetDataReady = false;
+    m_filename.clear();
+    pugi::xml_parse_result result = m_doc.load_buffer_inplace_own(buffer, size,
+                                                      (pugi::parse_default |
+                                                       //pugi::parse_trim_pcdata |
+                                                       //pugi::parse_wnorm_attribute |
+                                                       pugi::parse_declaration)
+                                                     );
+
+    if (!result)
+    {
+        m_errorMsg = string(result.description());
+        m_errorOffset = int(result.offset);
+        m_reporter << "Pos: " << m_errorOffset << ". Error: " << m_errorMsg << endl;
+    }
+    find_root();
+}
+
+//---------------------------------------------------------------------------------------
+void* XmlParser::allocate_buffer(size_t size)
+{
+    return (*pugi::get_memory_allocation_function())(size);
+}
+
+//---------------------------------------------------------------------------------------
+void XmlParser::deallocate_buffer(void* buffer)
+{
+    (*pugi::get_memory_deallocation_function())(buffer);
+}
+
 //---------------------------------------------------------------------------------------
 void XmlParser::find_root()
 {
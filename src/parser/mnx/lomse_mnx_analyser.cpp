@@ -35,6 +35,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <atomic>
 //BUG: In my Ubuntu box next line causes problems since approx. 20/march/2011
 #if (LOMSE_PLATFORM_WIN32 == 1)
     #include <locale>
@@ -3571,7 +3572,7 @@ public:
         //attrib: staff
         //TODO
 
-        static int num = 0;
+        static std::atomic<int> num(0);
 
         set_mandatory_data(orient, ++num, type);
 
@@ -3729,10 +3730,9 @@ protected:
 
     string generate_new_id()
     {
-        static int num=1;
+        static std::atomic<int> num(1);
         stringstream s;
-        s << "P" << num;
-        ++num;
+        s << "P" << num++;
         return s.str();
     }
 };
@@ -4230,7 +4230,7 @@ protected:
     ImoTie* create_tie(ImoNote* pStartNote, ImoNote* pEndNote)
     {
         //TODO: Finish this
-        static int tieNumber = 0;
+        static std::atomic<int> tieNumber(0);
 
         Document* pDoc = m_pAnalyser->get_document_being_analysed();
 
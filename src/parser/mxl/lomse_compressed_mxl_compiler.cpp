@@ -42,15 +42,21 @@ ImoDocument* CompressedMxlCompiler::compile_file(const std::string& filename)
 #if (LOMSE_ENABLE_COMPRESSION == 1)
     ZipInputStream zip(filename);
 
-    const std::vector<unsigned char> mxmlBuffer = read_rootfile(zip);
+    //the rootfile is inflated directly into a buffer owned by the XML parser, that
+    //parses it in place. Thus, there is only one copy of the decompressed score.
+    size_t size = 0;
+    void* buffer = nullptr;
+    const std::string rootFilePath = get_rootfile_path(zip);
+    if (!rootFilePath.empty())
+        buffer = inflate_entry(zip, rootFilePath, &size);
 
-    if (mxmlBuffer.empty())
+    if (!buffer)
     {
         LOMSE_LOG_ERROR("[CompressedMxlCompiler::compile_file] Couldn't read rootfile");
         return nullptr;
     }
 
-    return m_pMxlCompiler->compile_buffer(static_cast<const void*>(mxmlBuffer.data()), mxmlBuffer.size());
+    return m_pMxlCompiler->compile_buffer_own(buffer, size);
 #else
     throw runtime_error("Could not open compressed file: Lomse was compiled without compression support");
 #endif
@@ -67,15 +73,13 @@ ImoDocument* CompressedMxlCompiler::compile_string(const std::string& UNUSED(sou
 std::string CompressedMxlCompiler::get_rootfile_path(ZipInputStream& zip)
 {
 #if (LOMSE_ENABLE_COMPRESSION == 1)
-    zip.move_to_entry("META-INF/container.xml");
-
-    if (!zip.open_current_entry())
+    size_t size = 0;
+    void* buffer = inflate_entry(zip, "META-INF/container.xml", &size);
+    if (!buffer)
         return std::string();
 
-    std::vector<unsigned char> metaInfBuffer = zip.get_as_vector();
-
     XmlParser xml;
-    xml.parse_buffer(static_cast<const void*>(metaInfBuffer.data()), metaInfBuffer.size());
+    xml.parse_buffer_own(buffer, size);
 
     XmlNode* root = xml.get_tree_root();
 
@@ -93,22 +97,37 @@ std::string CompressedMxlCompiler::get_rootfile_path(ZipInputStream& zip)
 }
 
 //---------------------------------------------------------------------------------------
-std::vector<unsigned char> CompressedMxlCompiler::read_rootfile(ZipInputStream& zip)
+void* CompressedMxlCompiler::inflate_entry(ZipInputStream& zip,
+                                           const std::string& innerPath,
+                                           size_t* pSize)
 {
+    //Returns a buffer, allocated with XmlParser::allocate_buffer(), containing the
+    //decompressed entry, or nullptr if the entry does not exist or could not be
+    //inflated. The entry size is returned in pSize.
+
 #if (LOMSE_ENABLE_COMPRESSION == 1)
-    const std::string rootFilePath = get_rootfile_path(zip);
+    if (!zip.move_to_entry(innerPath))
+        return nullptr;
 
-    if (rootFilePath.empty())
-        return {};
+    ZipEntryInfo info;
+    if (!zip.get_current_entry_info(info) || info.dwUncompressedSize == 0)
+        return nullptr;
 
-    zip.move_to_entry(rootFilePath);
+    long size = long(info.dwUncompressedSize);
+    void* buffer = XmlParser::allocate_buffer(size_t(size));
+    if (!buffer)
+        return nullptr;
 
-    if (!zip.open_current_entry())
-        return {};
+    if (zip.inflate_current_entry(static_cast<unsigned char*>(buffer), size) != size)
+    {
+        XmlParser::deallocate_buffer(buffer);
+        return nullptr;
+    }
 
-    return zip.get_as_vector();
+    *pSize = size_t(size);
+    return buffer;
 #else
-    return {};
+    return nullptr;
 #endif
 }
 
@@ -41,6 +41,11 @@
 #include <vector>
 #include <algorithm>   // for find
 #include <regex>
+#if (LOMSE_ENABLE_THREADS == 1)
+    #include <thread>
+    #include <atomic>
+    #include <exception>
+#endif
 using namespace std;
 
 #define LOMSE_TRACE_GOBACK  0
@@ -107,6 +112,17 @@ ImoInstrument* PartList::get_instrument(const string& id)
 	return (i != -1 ? m_instruments[i] : nullptr);
 }
 
+//---------------------------------------------------------------------------------------
+ImoInstrument* PartList::get_next_instrument(ImoInstrument* pInstr)
+{
+    for (int i=0; i < m_numInstrs - 1; ++i)
+    {
+        if (m_instruments[i] == pInstr)
+            return m_instruments[i+1];
+    }
+    return nullptr;
+}
+
 //---------------------------------------------------------------------------------------
 int PartList::find_index_for(const string& id)
 {
@@ -2386,6 +2402,7 @@ public:
                 if (m_pAnalyser->staff_distance_is_imported(iStaff))
                     pInstr->mark_staff_margin_as_imported(iStaff);
             }
+            m_pAnalyser->first_staff_margin_reset();
         }
 
         // part-symbol?
@@ -2495,6 +2512,8 @@ protected:
             ImoStaffInfo* pOldInfo = pInstr->get_staff(iStaff);
             pInfo->set_tablature( pOldInfo->is_for_tablature() );
             pInstr->replace_staff_info(pInfo);
+            if (iStaff == 0)
+                m_pAnalyser->first_staff_margin_reset();
         }
     }
 };
@@ -5579,21 +5598,37 @@ public:
     {
         //attrb: id
         string id = get_optional_string_attribute("id", "");
-        if (id.empty())
-        {
-            error_msg("<part>: missing mandatory 'id' attribute. <part> content will be ignored");
-            return nullptr;
-        }
-        ImoInstrument* pInstr = m_pAnalyser->get_instrument(id);
-        if (pInstr==nullptr)
+        ImoInstrument* pInstr = nullptr;
+        if (m_pAnalyser->is_part_analyser())
         {
-            error_msg("No <score-part> found for part id='" + id + "'. <part> content will be ignored.");
-            return nullptr;
+            //<part> already validated. Only its content has to be analysed
+            pInstr = m_pAnalyser->get_current_instrument();
         }
-        if (m_pAnalyser->mark_part_as_added(id))
+        else
         {
-            error_msg("Duplicated <part> for part id='" + id + "'. <part> content will be ignored.");
-            return nullptr;
+            if (id.empty())
+            {
+                error_msg("<part>: missing mandatory 'id' attribute. <part> content will be ignored");
+                return nullptr;
+            }
+            pInstr = m_pAnalyser->get_instrument(id);
+            if (pInstr==nullptr)
+            {
+                error_msg("No <score-part> found for part id='" + id + "'. <part> content will be ignored.");
+                return nullptr;
+            }
+            if (m_pAnalyser->mark_part_as_added(id))
+            {
+                error_msg("Duplicated <part> for part id='" + id + "'. <part> content will be ignored.");
+                return nullptr;
+            }
+
+            if (m_pAnalyser->analyse_parts_in_parallel())
+            {
+                //content will be analysed later, when all <part> elements are collected
+                m_pAnalyser->defer_part_analysis(m_analysedNode, pInstr);
+                return pInstr->get_musicdata();
+            }
         }
 
         m_pAnalyser->save_current_part_id(id);
@@ -7004,7 +7039,13 @@ public:
             remove_score(pImoDoc, pScore);
             return pImoDoc;
         }
-        add_all_instruments(pScore);
+
+        //AWARE: When parts are analysed in parallel, instruments are added to the
+        //score after analysing their content, so that the score is not modified
+        //while parts are being analysed
+        bool fParallel = m_pAnalyser->analyse_parts_in_parallel();
+        if (!fParallel)
+            add_all_instruments(pScore);
 
         // <part>*
         while (more_children_to_analyse())
@@ -7014,6 +7055,12 @@ public:
         }
         error_if_more_elements();
 
+        if (fParallel)
+        {
+            m_pAnalyser->analyse_deferred_parts();
+            add_all_instruments(pScore);
+        }
+
         check_if_missing_parts();
 
         //m_pAnalyser->score_analysis_end();
@@ -9300,7 +9347,7 @@ void MxlAnalyser::delete_relation_builders()
 }
 
 //---------------------------------------------------------------------------------------
-ImoObj* MxlAnalyser::analyse_tree_and_get_object(XmlNode* root)
+void MxlAnalyser::create_relation_builders()
 {
     delete_relation_builders();
     m_pTiesBuilder = LOMSE_NEW MxlTiesBuilder(m_reporter, this);
@@ -9311,6 +9358,12 @@ ImoObj* MxlAnalyser::analyse_tree_and_get_object(XmlNode* root)
     m_pWedgesBuilder = LOMSE_NEW MxlWedgesBuilder(m_reporter, this);
     m_pOctaveShiftBuilder = LOMSE_NEW MxlOctaveShiftBuilder(m_reporter, this);
     m_pPedalBuilder = LOMSE_NEW MxlPedalBuilder(m_reporter, this);
+}
+
+//---------------------------------------------------------------------------------------
+ImoObj* MxlAnalyser::analyse_tree_and_get_object(XmlNode* root)
+{
+    create_relation_builders();
 
     m_pTree = root;
 //    m_curStaff = 0;
@@ -9895,7 +9948,7 @@ void MxlAnalyser::add_marging_space_for_lyrics(ImoNote* pNote, ImoLyric* pLyric)
     int iStaff = pNote->get_staff();
     bool fAbove = pLyric->get_placement() == k_placement_above;
     LUnits space = 400.0f;  //4mm per lyrics line
-    ImoInstrument* pInstr = get_instrument(m_curPartId);
+    ImoInstrument* pInstr = m_pCurInstrument;
 
     if (fAbove)
     {
@@ -9909,6 +9962,14 @@ void MxlAnalyser::add_marging_space_for_lyrics(ImoNote* pNote, ImoLyric* pLyric)
         if (++iStaff == staves)
         {
             //add space to top margin of first staff in next instrument
+            if (m_fPartAnalyser)
+            {
+                //next instrument could be being analysed in other thread. The
+                //space will be reserved when all parts are analysed
+                m_lyricsSpaceForNextPart += space;
+                return;
+            }
+
             //AWARE: All instruments are already created
             int iInstr = m_pCurScore->get_instr_number_for(pInstr) + 1;
             if (iInstr < m_pCurScore->get_num_instruments())
@@ -9929,6 +9990,248 @@ void MxlAnalyser::add_marging_space_for_lyrics(ImoNote* pNote, ImoLyric* pLyric)
     }
 }
 
+//---------------------------------------------------------------------------------------
+bool MxlAnalyser::fix_beams()
+{
+    return m_pDoc->get_musicxml_options()->fix_beams();
+}
+
+//---------------------------------------------------------------------------------------
+bool MxlAnalyser::analyse_parts_in_parallel()
+{
+#if (LOMSE_ENABLE_THREADS == 1)
+    return !m_fPartAnalyser
+           && m_pDoc->get_musicxml_options()->analyse_parts_in_parallel();
+#else
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------------------
+void MxlAnalyser::defer_part_analysis(const XmlNode& part, ImoInstrument* pInstr)
+{
+    m_deferredParts.push_back(part);
+    m_deferredInstrs.push_back(pInstr);
+}
+
+//---------------------------------------------------------------------------------------
+void MxlAnalyser::analyse_deferred_parts()
+{
+#if (LOMSE_ENABLE_THREADS == 1)
+    size_t numParts = m_deferredParts.size();
+    if (numParts == 0)
+        return;
+
+    //AWARE: line numbers data is built the first time it is requested. Force it
+    //now, before starting the threads
+    get_line_number(&m_deferredParts[0]);
+
+    //each part is analysed by a dedicated analyser. The instrument is lent to an
+    //scratch Document while its content is analysed, so that ids assignment and
+    //object creation does not interfere with the analysis of other parts
+    DocModel* pModel = m_pDoc->get_doc_model();
+    ImoId maxLentId = pModel->get_last_assigned_id();
+
+    std::vector<stringstream*> reporters(numParts);
+    std::vector<Document*> docs(numParts);
+    std::vector<MxlAnalyser*> analysers(numParts);
+    std::vector<std::exception_ptr> errors(numParts);
+    for (size_t i=0; i < numParts; ++i)
+    {
+        reporters[i] = LOMSE_NEW stringstream();
+        docs[i] = LOMSE_NEW Document(m_libraryScope, *reporters[i]);
+        docs[i]->set_musicxml_options(*m_pDoc->get_musicxml_options());
+        analysers[i] = LOMSE_NEW MxlAnalyser(*reporters[i], m_libraryScope, docs[i],
+                                             m_pParser);
+        pModel->lend_subtree(m_deferredInstrs[i], docs[i]->get_doc_model());
+        analysers[i]->prepare_as_part_analyser(this, m_deferredInstrs[i]);
+    }
+
+    std::atomic<size_t> nextPart(0);
+    auto worker = [&]()
+    {
+        size_t i;
+        while ((i = nextPart++) < numParts)
+        {
+            try
+            {
+                analysers[i]->analyse_node(&m_deferredParts[i], m_pCurScore);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+
+    size_t numThreads = min(numParts, size_t(std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t i=1; i < numThreads; ++i)
+        threads.push_back( std::thread(worker) );
+    worker();
+    for (std::thread& t : threads)
+        t.join();
+
+    //merge results in <part> order, so that ids and messages are deterministic
+    std::exception_ptr firstError;
+    for (size_t i=0; i < numParts; ++i)
+    {
+        pModel->reclaim_subtree(m_deferredInstrs[i], docs[i]->get_doc_model(), maxLentId);
+        renumber_relations(m_deferredInstrs[i], analysers[i]);
+        m_reporter << reporters[i]->str();
+        m_measuresCounter = analysers[i]->get_measures_counter();
+        if (!firstError && errors[i])
+            firstError = errors[i];
+    }
+    for (size_t i=0; i < numParts; ++i)
+    {
+        //space for lyrics in next instrument. When analysing sequentially, space is
+        //reserved before analysing next <part>, and it is lost if that analysis
+        //resets the margin of first staff
+        LUnits space = analysers[i]->m_lyricsSpaceForNextPart;
+        ImoInstrument* pNext = m_partList.get_next_instrument(m_deferredInstrs[i]);
+        if (space != 0.0f && pNext)
+        {
+            bool fReset = false;
+            for (size_t j=i+1; j < numParts; ++j)
+            {
+                if (m_deferredInstrs[j] == pNext)
+                    fReset = analysers[j]->m_fFirstStaffMarginReset;
+            }
+            if (!fReset)
+                pNext->reserve_space_for_lyrics(0, space);
+        }
+    }
+
+    for (size_t i=0; i < numParts; ++i)
+    {
+        delete analysers[i];
+        delete docs[i];
+        delete reporters[i];
+    }
+
+    m_deferredParts.clear();
+    m_deferredInstrs.clear();
+
+    if (firstError)
+        std::rethrow_exception(firstError);
+#endif
+}
+
+//---------------------------------------------------------------------------------------
+void MxlAnalyser::renumber_relations(ImoInstrument* pInstr, MxlAnalyser* pPartAnalyser)
+{
+    //relations are numbered sequentially in the whole document but each part analyser
+    //starts numbering from zero. Displace numbers by those used in previous parts.
+    //Slurs are different: the number assigned to a slur depends on the slur numbers
+    //found in previous parts, as the MusicXML number to slur number map is never
+    //cleared. Replay the assignment, in order of first appearance in this part
+    std::map<int, int> slurNums = merge_slur_ids(pPartAnalyser);
+
+    ImoMusicData* pMD = pInstr->get_musicdata();
+    ImoObj::children_iterator it;
+    for (it = pMD->begin(); it != pMD->end(); ++it)
+    {
+        if (!(*it)->is_staffobj())
+            continue;
+
+        ImoStaffObj* pSO = static_cast<ImoStaffObj*>(*it);
+        ImoRelations* pRels = pSO->get_relations();
+        if (pRels == nullptr)
+            continue;
+
+        for (int i=0; i < pRels->get_num_items(); ++i)
+        {
+            ImoRelObj* pRO = pRels->get_item(i);
+            if (pRO->get_start_object() != pSO)
+                continue;
+
+            if (pRO->is_tie())
+            {
+                ImoTie* pTie = static_cast<ImoTie*>(pRO);
+                pTie->set_tie_number(pTie->get_tie_number() + m_tieNum);
+            }
+            else if (pRO->is_slur())
+            {
+                ImoSlur* pSlur = static_cast<ImoSlur*>(pRO);
+                int num = slurNums[pSlur->get_slur_number()];
+                pSlur->set_slur_number(num);
+                for (auto& item : pSlur->get_related_objects())
+                    static_cast<ImoSlurData*>(item.second)->set_slur_number(num);
+            }
+            else if (pRO->is_wedge())
+            {
+                ImoWedge* pWedge = static_cast<ImoWedge*>(pRO);
+                pWedge->set_wedge_number(pWedge->get_wedge_number() + m_wedgeNum);
+            }
+            else if (pRO->is_octave_shift())
+            {
+                ImoOctaveShift* pOctave = static_cast<ImoOctaveShift*>(pRO);
+                pOctave->set_octave_shift_number(pOctave->get_octave_shift_number()
+                                                 + m_octaveShiftNum);
+            }
+        }
+    }
+
+    m_tieNum += pPartAnalyser->m_tieNum;
+    m_voltaNum += pPartAnalyser->m_voltaNum;
+    m_wedgeNum += pPartAnalyser->m_wedgeNum;
+    m_octaveShiftNum += pPartAnalyser->m_octaveShiftNum;
+    m_pedalNum += pPartAnalyser->m_pedalNum;
+}
+
+//---------------------------------------------------------------------------------------
+std::map<int, int> MxlAnalyser::merge_slur_ids(MxlAnalyser* pPartAnalyser)
+{
+    //returns the map from slur numbers in the part analyser to slur numbers in
+    //this analyser, updating the slur ids map as if the part were analysed here
+
+    //AWARE: each MusicXML number gets a single slur number, and slur numbers are
+    //assigned in order of first appearance
+    std::map<int, int> xmlNums;     //part slur number -> MusicXML number
+    for (auto& item : pPartAnalyser->m_slurIds)
+    {
+        if (item.second != 0)
+            xmlNums[int(item.second)] = item.first;
+    }
+
+    std::map<int, int> slurNums;
+    for (auto& item : xmlNums)
+    {
+        ImoId& slurId = m_slurIds[item.second];
+        if (slurId == 0)
+            slurId = ++m_slurNum;
+        slurNums[item.first] = int(slurId);
+    }
+    return slurNums;
+}
+
+//---------------------------------------------------------------------------------------
+void MxlAnalyser::prepare_as_part_analyser(MxlAnalyser* pParent, ImoInstrument* pInstr)
+{
+    m_fPartAnalyser = true;
+    m_fileLocator = pParent->m_fileLocator;
+    m_musicxmlVersion = pParent->m_musicxmlVersion;
+    m_pCurScore = pParent->m_pCurScore;
+    m_pImoDoc = pParent->m_pImoDoc;
+
+    //global info from <defaults> and <part-list>
+    if (pParent->m_pMusicFont)
+        set_music_font( LOMSE_NEW ImoFontStyleDto(*(pParent->m_pMusicFont)) );
+    if (pParent->m_pWordFont)
+        set_word_font( LOMSE_NEW ImoFontStyleDto(*(pParent->m_pWordFont)) );
+    m_lyricStyle = pParent->m_lyricStyle;
+    m_lyricLang = pParent->m_lyricLang;
+    m_defaultStaffDistance = pParent->m_defaultStaffDistance;
+    m_fDefaultStaffDistanceForAllStaves = pParent->m_fDefaultStaffDistanceForAllStaves;
+    m_soundIdToIdx = pParent->m_soundIdToIdx;
+    m_latestMidiInfo = pParent->m_latestMidiInfo;
+
+    create_relation_builders();
+    m_curVoice = 0;
+    save_current_instrument(pInstr);
+}
+
 //---------------------------------------------------------------------------------------
 ImoInstrGroup* MxlAnalyser::start_part_group(int number)
 {
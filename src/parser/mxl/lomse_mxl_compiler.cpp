@@ -105,6 +105,17 @@ ImoDocument* MxlCompiler::compile_buffer(const void* buffer, size_t size)
     return compile_parsed_tree( m_pXmlParser->get_tree_root() );
 }
 
+//---------------------------------------------------------------------------------------
+ImoDocument* MxlCompiler::compile_buffer_own(void* buffer, size_t size)
+{
+    //buffer must have been allocated with XmlParser::allocate_buffer(). The parser
+    //takes ownership of it.
+
+    m_fileLocator = "string:";
+    m_pXmlParser->parse_buffer_own(buffer, size);
+    return compile_parsed_tree( m_pXmlParser->get_tree_root() );
+}
+
 //---------------------------------------------------------------------------------------
 ImoDocument* MxlCompiler::compile_parsed_tree(XmlNode* root)
 {
@@ -44,6 +44,8 @@ std::string FontSelector::find_font(const std::string& language,
                                     const std::string& name,
                                     bool fBold, bool fItalic)
 {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
     //search in cache
     string key=language + name + (fBold ? "1" : "0") + (fItalic ? "1" : "0");
     map<string, string>::iterator it = m_cache.find(key);
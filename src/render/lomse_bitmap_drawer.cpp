@@ -34,6 +34,9 @@ using namespace std;
 namespace lomse
 {
 
+//max number of paths deferred in a batch. More paths are rendered
+const int k_max_deferred_paths = 256;
+
 //---------------------------------------------------------------------------------------
 MarkerVertexSource::MarkerVertexSource()
     : VertexSource()
@@ -246,6 +249,20 @@ void Drawer::set_text_color(Color color)
     m_textColor = color;
 }
 
+//---------------------------------------------------------------------------------------
+void Drawer::solid_rect(double x1, double y1, double x2, double y2, Color color)
+{
+    begin_path();
+    fill(color);
+    stroke_none();
+    move_to(x1, y1);
+    hline_to(x2);
+    vline_to(y2);
+    hline_to(x1);
+    close_path();
+    end_path();
+}
+
 //---------------------------------------------------------------------------------------
 void Drawer::new_viewport_origin(double x, double y)
 {
@@ -273,6 +290,9 @@ BitmapDrawer::BitmapDrawer(LibraryScope& libraryScope)
 //    , m_pTextMeter(nullptr)
     , m_pCalligrapher( LOMSE_NEW Calligrapher(m_pFonts, m_pRenderer) )
     , m_numPaths(0)
+    , m_firstPath(0)
+    , m_batchLevel(0)
+    , m_numFlushes(0)
     , m_rbuf(nullptr, 0, 0, 0)
     , m_pBuf(nullptr)
 {
@@ -303,13 +323,15 @@ void BitmapDrawer::delete_paths()
 
     m_attr_storage.clear();
     m_numPaths = 0;
+    m_firstPath = 0;
 }
 
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::begin_path()
 {
     unsigned idx = m_path.start_new_path();
-    m_attr_storage.add( m_numPaths==0 ? PathAttributes(idx) : PathAttributes(cur_attr(), idx) );
+    m_attr_storage.add( m_numPaths==m_firstPath ? PathAttributes(idx)
+                                                : PathAttributes(cur_attr(), idx) );
     m_numPaths++;
 }
 
@@ -556,21 +578,39 @@ bool BitmapDrawer::select_font(const std::string& language,
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::draw_glyph(double x, double y, unsigned int ch)
 {
-    render_existing_paths();
-
     TransAffine& mtx = m_pRenderer->get_transform();
     mtx.transform(&x, &y);
-    m_pCalligrapher->draw_glyph(x, y, ch, m_textColor, m_pRenderer->get_scale());
+    double scale = m_pRenderer->get_scale();
+
+    AggRectInt area;
+    if (has_deferred_paths()
+        && m_pCalligrapher->get_glyph_bounds(x, y, ch, scale, 0.0, &area))
+    {
+        render_paths_under(area);
+    }
+    else
+        render_existing_paths();
+
+    m_pCalligrapher->draw_glyph(x, y, ch, m_textColor, scale);
 }
 
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::draw_glyph_rotated(double x, double y, unsigned int ch, double rotation)
 {
-    render_existing_paths();
-
     TransAffine& mtx = m_pRenderer->get_transform();
     mtx.transform(&x, &y);
-    m_pCalligrapher->draw_glyph_rotated(x, y, ch, m_textColor, m_pRenderer->get_scale(), rotation);
+    double scale = m_pRenderer->get_scale();
+
+    AggRectInt area;
+    if (has_deferred_paths()
+        && m_pCalligrapher->get_glyph_bounds(x, y, ch, scale, rotation, &area))
+    {
+        render_paths_under(area);
+    }
+    else
+        render_existing_paths();
+
+    m_pCalligrapher->draw_glyph_rotated(x, y, ch, m_textColor, scale, rotation);
 }
 
 //---------------------------------------------------------------------------------------
@@ -578,11 +618,17 @@ int BitmapDrawer::draw_text(double x, double y, const std::string& str)
 {
     //returns the number of chars drawn
 
-    render_existing_paths();
-
     TransAffine& mtx = m_pRenderer->get_transform();
     mtx.transform(&x, &y);
-    return m_pCalligrapher->draw_text(x, y, str, m_textColor, m_pRenderer->get_scale());
+    double scale = m_pRenderer->get_scale();
+
+    AggRectInt area;
+    if (has_deferred_paths() && m_pCalligrapher->get_text_bounds(x, y, str, scale, &area))
+        render_paths_under(area);
+    else
+        render_existing_paths();
+
+    return m_pCalligrapher->draw_text(x, y, str, m_textColor, scale);
 }
 
 //---------------------------------------------------------------------------------------
@@ -590,11 +636,17 @@ int BitmapDrawer::draw_text(double x, double y, const wstring& str)
 {
     //returns the number of chars drawn
 
-    render_existing_paths();
-
     TransAffine& mtx = m_pRenderer->get_transform();
     mtx.transform(&x, &y);
-    return m_pCalligrapher->draw_text(x, y, str, m_textColor, m_pRenderer->get_scale());
+    double scale = m_pRenderer->get_scale();
+
+    AggRectInt area;
+    if (has_deferred_paths() && m_pCalligrapher->get_text_bounds(x, y, str, scale, &area))
+        render_paths_under(area);
+    else
+        render_existing_paths();
+
+    return m_pCalligrapher->draw_text(x, y, str, m_textColor, scale);
 }
 
 //---------------------------------------------------------------------------------------
@@ -634,6 +686,7 @@ void BitmapDrawer::reset(Color bgcolor)
 {
     m_pRenderer->initialize(m_rbuf, bgcolor);
     delete_paths();
+    m_numFlushes = 0;
 }
 
 //---------------------------------------------------------------------------------------
@@ -676,12 +729,109 @@ void BitmapDrawer::set_view_area(unsigned width, unsigned height, unsigned xShif
     unsigned char* start = m_pBuf + shift * bytesPerPixel;
     int stride = m_rbuf.stride();
     m_rbuf.attach(start, width, height, stride);
+    m_pRenderer->attach(m_rbuf);
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::share_rendering_buffer(BitmapDrawer* pDrawer, unsigned yStart,
+                                          unsigned yEnd)
+{
+    //AWARE: the buffer is not cleared, as other bands could be being rendered
+
+    RenderingBuffer& rbuf = pDrawer->m_rbuf;
+    m_rbuf.attach(rbuf.buf(), rbuf.width(), rbuf.height(), rbuf.stride());
+    m_pBuf = pDrawer->m_pBuf;
+    m_bufWidth = pDrawer->m_bufWidth;
+    m_bufHeight = pDrawer->m_bufHeight;
+    m_viewportOrg = pDrawer->m_viewportOrg;
+    m_viewportSize = pDrawer->m_viewportSize;
+    delete_paths();
+
+    m_pRenderer->attach(m_rbuf);
+    m_pRenderer->copy_transform(*(pDrawer->m_pRenderer));
+    m_pRenderer->clip_rect(0, int(yStart), int(m_rbuf.width()), int(yEnd));
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::scroll_bitmap(Pixels dx, Pixels dy)
+{
+    //AWARE: source and destination overlap. Rows are copied in the right order
+    if (has_deferred_paths())
+        render_existing_paths();
+    m_pRenderer->copy_from(m_rbuf, nullptr, int(dx), int(dy));
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::clear_clip_rect(Pixels x1, Pixels y1, Pixels x2, Pixels y2,
+                                   Color bgcolor)
+{
+    if (has_deferred_paths())
+        render_existing_paths();
+    m_pRenderer->clip_rect(int(x1), int(y1), int(x2), int(y2));
+    m_pRenderer->clear_clip_rect(bgcolor);
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::set_clip_rect(Pixels x1, Pixels y1, Pixels x2, Pixels y2)
+{
+    if (has_deferred_paths())
+        render_existing_paths();
+    m_pRenderer->clip_rect(int(x1), int(y1), int(x2), int(y2));
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::reset_clip_rect()
+{
+    if (has_deferred_paths())
+        render_existing_paths();
+    m_pRenderer->attach(m_rbuf);
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::reset_drawn_area()
+{
+    m_pRenderer->reset_drawn_area();
+}
+
+//---------------------------------------------------------------------------------------
+VRect BitmapDrawer::get_drawn_area() const
+{
+    const AggRectInt& area = m_pRenderer->get_drawn_area();
+    if (!area.is_valid())
+        return VRect(0, 0, 0, 0);
+
+    VRect rect(VPoint(area.x1, area.y1), VPoint(area.x2 + 1, area.y2 + 1));
+    return rect.intersection( VRect(0, 0, Pixels(m_rbuf.width()),
+                                    Pixels(m_rbuf.height())) );
+}
+
+//---------------------------------------------------------------------------------------
+VPoint BitmapDrawer::get_view_area_origin() const
+{
+    if (m_pBuf == nullptr || m_bufWidth == 0)
+        return VPoint(0, 0);
+
+    int bytesPerPixel = Renderer::bytesPerPixel( m_libraryScope.get_pixel_format() );
+    Pixels shift = Pixels((m_rbuf.buf() - m_pBuf) / bytesPerPixel);
+    return VPoint(shift % Pixels(m_bufWidth), shift / Pixels(m_bufWidth));
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::copy_bitmap(RenderingBuffer& bmap, Pixels xDest, Pixels yDest)
+{
+    //bitmap must have the same pixel format. It is clipped to the rendering buffer
+    if (has_deferred_paths())
+        render_existing_paths();
+    m_pRenderer->copy_from(bmap, nullptr, int(xDest), int(yDest));
 }
 
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::new_viewport_origin(double x, double y)
 {
     //coordinates in device units (e.g. Pixel)
+    if (has_deferred_paths())
+        render_existing_paths();
+
     Drawer::new_viewport_origin(x, y);
     m_pRenderer->set_viewport(x, y);
 }
@@ -696,6 +846,9 @@ void BitmapDrawer::new_viewport_size(double x, double y)
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::set_affine_transformation(TransAffine& transform)
 {
+    if (has_deferred_paths())
+        render_existing_paths();
+
     m_pRenderer->set_transform(transform);
     //m_pRenderer->set_scale(transform.scale());
 }
@@ -703,6 +856,35 @@ void BitmapDrawer::set_affine_transformation(TransAffine& transform)
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::render()
 {
+    //In a batch, rendering is deferred. But next path must not inherit attributes
+    //from previous paths, as they are considered rendered
+    if (m_batchLevel > 0 && m_numPaths < k_max_deferred_paths)
+    {
+        m_firstPath = m_numPaths;
+        return;
+    }
+    flush_paths();
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::begin_batch()
+{
+    ++m_batchLevel;
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::end_batch()
+{
+    if (m_batchLevel > 0 && --m_batchLevel == 0)
+        render_existing_paths();
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::flush_paths()
+{
+    if (m_numPaths > 0)
+        ++m_numFlushes;
+
     m_pRenderer->render();
     delete_paths();
 }
@@ -710,12 +892,19 @@ void BitmapDrawer::render()
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::set_shift(LUnits x, LUnits y)
 {
+    //deferred paths are rendered with the transformation used for creating them
+    if (has_deferred_paths())
+        render_existing_paths();
+
     m_pRenderer->set_shift(x, y);
 }
 
 //---------------------------------------------------------------------------------------
 void BitmapDrawer::remove_shift()
 {
+    if (has_deferred_paths())
+        render_existing_paths();
+
     m_pRenderer->remove_shift();
 }
 
@@ -808,11 +997,49 @@ void BitmapDrawer::rect(UPoint pos, USize size, LUnits radius)
     m_path.concat_path<agg::rounded_rect>(rr);
 }
 
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::solid_rect(double x1, double y1, double x2, double y2, Color color)
+{
+    //AWARE: pending paths must be rendered first, to preserve the drawing order
+    if (has_deferred_paths())
+    {
+        double dx1 = x1, dy1 = y1, dx2 = x2, dy2 = y2;
+        TransAffine& mtx = m_pRenderer->get_transform();
+        mtx.transform(&dx1, &dy1);
+        mtx.transform(&dx2, &dy2);
+        render_paths_under( AggRectInt(int(floor(min(dx1, dx2))) - 1,
+                                       int(floor(min(dy1, dy2))) - 1,
+                                       int(floor(max(dx1, dx2))) + 1,
+                                       int(floor(max(dy1, dy2))) + 1) );
+    }
+    else
+        render_existing_paths();
+
+    if (!m_pRenderer->render_solid_rect(x1, y1, x2, y2, color))
+    {
+        //not axis-aligned in device space. Render it as a path
+        Drawer::solid_rect(x1, y1, x2, y2, color);
+        render();
+    }
+}
+
 //------------------------------------------------------------------------
 void BitmapDrawer::render_existing_paths()
 {
     if (m_path.total_vertices() > 0)
-        render();
+        flush_paths();
+}
+
+//---------------------------------------------------------------------------------------
+void BitmapDrawer::render_paths_under(const AggRectInt& area)
+{
+    //Deferred paths are rendered before drawing on the given area (device units)
+    //only if they overlap it. Otherwise painter's order does not matter.
+
+    if (m_pRenderer->pending_paths_overlap(area))
+        flush_paths();
+    else
+        m_firstPath = m_numPaths;
 }
 
 #if (0)
@@ -130,6 +130,92 @@ void Calligrapher::draw_glyph(double x, double y, unsigned int ch, Color color)
     }
 }
 
+//---------------------------------------------------------------------------------------
+bool Calligrapher::get_text_bounds(double x, double y, const std::string& str,
+                                   double scale, AggRectInt* pBounds)
+{
+    //convert to utf-32
+    const char* utf8str = str.c_str();
+    wstring utf32result;
+    utf8::utf8to32(utf8str, utf8str + strlen(utf8str), std::back_inserter(utf32result));
+
+    return get_text_bounds(x, y, utf32result, scale, pBounds);
+}
+
+//---------------------------------------------------------------------------------------
+bool Calligrapher::get_text_bounds(double x, double y, const wstring& str,
+                                   double scale, AggRectInt* pBounds)
+{
+    //AWARE: Glyphs are positioned as in draw_text(). Kerning depends on the previous
+    //glyph, but setting the scale resets it, so measuring does not alter the text
+    //drawn later
+
+    *pBounds = AggRectInt(1, 1, 0, 0);
+    if (!m_pFonts->is_font_valid())
+        return false;
+
+    set_scale(scale);
+    wstring::const_iterator it;
+    for (it = str.begin(); it != str.end(); ++it)
+    {
+        const lomse::glyph_cache* glyph = m_pFonts->get_glyph_cache(*it);
+        if(glyph)
+        {
+            m_pFonts->add_kerning(&x, &y);
+            add_glyph_bounds(glyph, x, y, pBounds);
+            x += glyph->advance_x;
+        }
+    }
+    return pBounds->is_valid();
+}
+
+//---------------------------------------------------------------------------------------
+bool Calligrapher::get_glyph_bounds(double x, double y, unsigned int ch, double scale,
+                                    double rotation, AggRectInt* pBounds)
+{
+    *pBounds = AggRectInt(1, 1, 0, 0);
+    if (!m_pFonts->is_font_valid())
+        return false;
+
+    if (rotation == 0.0)
+        set_scale(scale);
+    else
+        set_scale_and_rotation(scale, rotation);
+
+    const lomse::glyph_cache* glyph = m_pFonts->get_glyph_cache(ch);
+    if(glyph)
+    {
+        m_pFonts->add_kerning(&x, &y);
+        add_glyph_bounds(glyph, x, y, pBounds);
+    }
+    return pBounds->is_valid();
+}
+
+//---------------------------------------------------------------------------------------
+void Calligrapher::add_glyph_bounds(const lomse::glyph_cache* glyph, double x, double y,
+                                    AggRectInt* pBounds)
+{
+    if (!glyph->bounds.is_valid())
+        return;
+
+    //glyph bounds are relative to the rounded pen position. One pixel is added, just
+    //in case
+    int dx = agg::iround(x);
+    int dy = agg::iround(y);
+    AggRectInt bounds(glyph->bounds.x1 + dx - 1, glyph->bounds.y1 + dy - 1,
+                      glyph->bounds.x2 + dx + 1, glyph->bounds.y2 + dy + 1);
+
+    if (pBounds->is_valid())
+    {
+        pBounds->x1 = std::min(pBounds->x1, bounds.x1);
+        pBounds->y1 = std::min(pBounds->y1, bounds.y1);
+        pBounds->x2 = std::max(pBounds->x2, bounds.x2);
+        pBounds->y2 = std::max(pBounds->y2, bounds.y2);
+    }
+    else
+        *pBounds = bounds;
+}
+
 //---------------------------------------------------------------------------------------
 void Calligrapher::set_scale(double scale)
 {
@@ -0,0 +1,569 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_fast_pixfmt.h"
+
+#include <atomic>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define LOMSE_SPAN_X86      1
+    #include <immintrin.h>
+    #define LOMSE_TARGET(iset)  __attribute__((target(iset)))
+#else
+    #define LOMSE_SPAN_X86      0
+#endif
+
+using namespace agg;
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+// Blending formulas. For 8 bits components the AGG blenders compute
+//      p' = lerp(p, c, alpha)                  for color components
+//      p' = prelerp(p, alpha, alpha)           for the alpha component
+// The second one is identical to lerp(p, 255, alpha). Therefore, using 255 as the alpha
+// byte of the color, all bytes of a pixel are blended with the same formula. And
+// lerp(p, c, alpha) is identical to
+//      p + multiply(c - p, alpha)      when p <= c
+//      p - multiply(p - c, alpha)      when p > c
+// which only uses unsigned values that fit in 16 bits, and so can be computed with
+// SIMD instructions.
+
+//---------------------------------------------------------------------------------------
+struct SpanKernels
+{
+    void (*copy4)(int8u* p, unsigned len, const int8u* color);
+    void (*blend4)(int8u* p, unsigned len, const int8u* color, int8u alpha);
+    void (*blend_covers4)(int8u* p, unsigned len, const int8u* color, int8u alpha,
+                          const int8u* covers);
+    void (*blend1)(int8u* p, unsigned len, const int8u* color, int8u alpha);
+    void (*blend_covers1)(int8u* p, unsigned len, const int8u* color, int8u alpha,
+                          const int8u* covers);
+};
+
+
+//=======================================================================================
+// Portable kernels
+//=======================================================================================
+static inline void blend_pixel(int8u* p, const int8u* color, int8u alpha,
+                               int bytesPerPixel)
+{
+    for (int i=0; i < bytesPerPixel; ++i)
+        p[i] = rgba8::lerp(p[i], color[i], alpha);
+}
+
+//---------------------------------------------------------------------------------------
+template<int Bpp>
+static void copy_portable(int8u* p, unsigned len, const int8u* color)
+{
+    if (Bpp == 1)
+    {
+        memset(p, *color, len);
+        return;
+    }
+
+    for (; len; --len, p += Bpp)
+        memcpy(p, color, Bpp);
+}
+
+//---------------------------------------------------------------------------------------
+template<int Bpp>
+static void blend_portable(int8u* p, unsigned len, const int8u* color, int8u alpha)
+{
+    if (alpha == 0)
+        return;
+
+    if (alpha == rgba8::base_mask)
+    {
+        copy_portable<Bpp>(p, len, color);
+        return;
+    }
+
+    for (; len; --len, p += Bpp)
+        blend_pixel(p, color, alpha, Bpp);
+}
+
+//---------------------------------------------------------------------------------------
+template<int Bpp>
+static void blend_covers_portable(int8u* p, unsigned len, const int8u* color,
+                                  int8u alpha, const int8u* covers)
+{
+    for (; len; --len, p += Bpp, ++covers)
+    {
+        //most covers are either 0 (background) or 255 (solid shapes)
+        if (*covers == 0)
+            continue;
+
+        int8u a = rgba8::mult_cover(alpha, *covers);
+        if (a == rgba8::base_mask)
+            memcpy(p, color, Bpp);
+        else
+            blend_pixel(p, color, a, Bpp);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+static const SpanKernels k_portable_kernels = {
+    copy_portable<4>,
+    blend_portable<4>,
+    blend_covers_portable<4>,
+    blend_portable<1>,
+    blend_covers_portable<1>,
+};
+
+
+#if (LOMSE_SPAN_X86 == 1)
+
+//=======================================================================================
+// SSE2 kernels
+//=======================================================================================
+LOMSE_TARGET("sse2")
+static inline __m128i multiply_sse2(__m128i a, __m128i b)
+{
+    //a, b: 16 bits values <= 255
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("sse2")
+static inline __m128i lerp_sse2(__m128i p, __m128i q, __m128i alphaLo, __m128i alphaHi)
+{
+    //alphaLo, alphaHi: 16 bits alpha for bytes 0-7 and 8-15
+    const __m128i zero = _mm_setzero_si128();
+    __m128i pq = _mm_subs_epu8(p, q);
+    __m128i d = _mm_or_si128(pq, _mm_subs_epu8(q, p));
+    __m128i mLo = multiply_sse2(_mm_unpacklo_epi8(d, zero), alphaLo);
+    __m128i mHi = multiply_sse2(_mm_unpackhi_epi8(d, zero), alphaHi);
+    __m128i m = _mm_packus_epi16(mLo, mHi);
+    __m128i up = _mm_cmpeq_epi8(pq, zero);     //p <= q
+    return _mm_or_si128(_mm_and_si128(up, _mm_add_epi8(p, m)),
+                        _mm_andnot_si128(up, _mm_sub_epi8(p, m)));
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("sse2")
+static void copy4_sse2(int8u* p, unsigned len, const int8u* color)
+{
+    int32u c;
+    memcpy(&c, color, 4);
+    __m128i q = _mm_set1_epi32(int(c));
+    for (; len >= 4; len -= 4, p += 16)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), q);
+    copy_portable<4>(p, len, color);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("sse2")
+static void blend4_sse2(int8u* p, unsigned len, const int8u* color, int8u alpha)
+{
+    if (alpha == 0)
+        return;
+    if (alpha == rgba8::base_mask)
+    {
+        copy4_sse2(p, len, color);
+        return;
+    }
+
+    int32u c;
+    memcpy(&c, color, 4);
+    __m128i q = _mm_set1_epi32(int(c));
+    __m128i a = _mm_set1_epi16(alpha);
+    for (; len >= 4; len -= 4, p += 16)
+    {
+        __m128i* ptr = reinterpret_cast<__m128i*>(p);
+        _mm_storeu_si128(ptr, lerp_sse2(_mm_loadu_si128(ptr), q, a, a));
+    }
+    blend_portable<4>(p, len, color, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("sse2")
+static void blend_covers4_sse2(int8u* p, unsigned len, const int8u* color, int8u alpha,
+                               const int8u* covers)
+{
+    int32u c;
+    memcpy(&c, color, 4);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i q = _mm_set1_epi32(int(c));
+    __m128i a = _mm_set1_epi16(alpha);
+    for (; len >= 4; len -= 4, p += 16, covers += 4)
+    {
+        int32u cv;
+        memcpy(&cv, covers, 4);
+        if (cv == 0)
+            continue;
+
+        __m128i* ptr = reinterpret_cast<__m128i*>(p);
+        if (cv == 0xFFFFFFFFu && alpha == rgba8::base_mask)
+        {
+            _mm_storeu_si128(ptr, q);
+            continue;
+        }
+
+        //alpha for each pixel, expanded to its four bytes
+        __m128i pa = multiply_sse2(_mm_unpacklo_epi8(_mm_cvtsi32_si128(int(cv)), zero), a);
+        pa = _mm_unpacklo_epi16(pa, pa);
+        _mm_storeu_si128(ptr, lerp_sse2(_mm_loadu_si128(ptr), q,
+                                        _mm_unpacklo_epi32(pa, pa),
+                                        _mm_unpackhi_epi32(pa, pa)));
+    }
+    blend_covers_portable<4>(p, len, color, alpha, covers);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("sse2")
+static void blend1_sse2(int8u* p, unsigned len, const int8u* color, int8u alpha)
+{
+    if (alpha == 0)
+        return;
+    if (alpha == rgba8::base_mask)
+    {
+        memset(p, *color, len);
+        return;
+    }
+
+    __m128i q = _mm_set1_epi8(char(*color));
+    __m128i a = _mm_set1_epi16(alpha);
+    for (; len >= 16; len -= 16, p += 16)
+    {
+        __m128i* ptr = reinterpret_cast<__m128i*>(p);
+        _mm_storeu_si128(ptr, lerp_sse2(_mm_loadu_si128(ptr), q, a, a));
+    }
+    blend_portable<1>(p, len, color, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("sse2")
+static void blend_covers1_sse2(int8u* p, unsigned len, const int8u* color, int8u alpha,
+                               const int8u* covers)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi8(char(0xFF));
+    __m128i q = _mm_set1_epi8(char(*color));
+    __m128i a = _mm_set1_epi16(alpha);
+    for (; len >= 16; len -= 16, p += 16, covers += 16)
+    {
+        __m128i cv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(covers));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(cv, zero)) == 0xFFFF)
+            continue;
+
+        __m128i* ptr = reinterpret_cast<__m128i*>(p);
+        if (alpha == rgba8::base_mask
+            && _mm_movemask_epi8(_mm_cmpeq_epi8(cv, full)) == 0xFFFF)
+        {
+            _mm_storeu_si128(ptr, q);
+            continue;
+        }
+
+        _mm_storeu_si128(ptr, lerp_sse2(_mm_loadu_si128(ptr), q,
+                                 multiply_sse2(_mm_unpacklo_epi8(cv, zero), a),
+                                 multiply_sse2(_mm_unpackhi_epi8(cv, zero), a)));
+    }
+    blend_covers_portable<1>(p, len, color, alpha, covers);
+}
+
+//---------------------------------------------------------------------------------------
+static const SpanKernels k_sse2_kernels = {
+    copy4_sse2,
+    blend4_sse2,
+    blend_covers4_sse2,
+    blend1_sse2,
+    blend_covers1_sse2,
+};
+
+
+//=======================================================================================
+// AVX2 kernels. The remaining pixels are processed by the SSE2 kernels. Before calling
+// them, the upper halves of the AVX registers are cleared, as otherwise SSE
+// instructions are penalized.
+//=======================================================================================
+LOMSE_TARGET("avx2")
+static inline __m256i multiply_avx2(__m256i a, __m256i b)
+{
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(a, b), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("avx2")
+static inline __m256i lerp_avx2(__m256i p, __m256i q, __m256i alphaLo, __m256i alphaHi)
+{
+    //AWARE: unpack and pack operate on each 128 bits lane. alphaLo is for bytes 0-7
+    //and 16-23, and alphaHi for bytes 8-15 and 24-31
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i pq = _mm256_subs_epu8(p, q);
+    __m256i d = _mm256_or_si256(pq, _mm256_subs_epu8(q, p));
+    __m256i mLo = multiply_avx2(_mm256_unpacklo_epi8(d, zero), alphaLo);
+    __m256i mHi = multiply_avx2(_mm256_unpackhi_epi8(d, zero), alphaHi);
+    __m256i m = _mm256_packus_epi16(mLo, mHi);
+    __m256i up = _mm256_cmpeq_epi8(pq, zero);
+    return _mm256_blendv_epi8(_mm256_sub_epi8(p, m), _mm256_add_epi8(p, m), up);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("avx2")
+static void copy4_avx2(int8u* p, unsigned len, const int8u* color)
+{
+    int32u c;
+    memcpy(&c, color, 4);
+    __m256i q = _mm256_set1_epi32(int(c));
+    for (; len >= 8; len -= 8, p += 32)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), q);
+    _mm256_zeroupper();
+    copy4_sse2(p, len, color);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("avx2")
+static void blend4_avx2(int8u* p, unsigned len, const int8u* color, int8u alpha)
+{
+    if (alpha == 0)
+        return;
+    if (alpha == rgba8::base_mask)
+    {
+        copy4_avx2(p, len, color);
+        return;
+    }
+
+    int32u c;
+    memcpy(&c, color, 4);
+    __m256i q = _mm256_set1_epi32(int(c));
+    __m256i a = _mm256_set1_epi16(alpha);
+    for (; len >= 8; len -= 8, p += 32)
+    {
+        __m256i* ptr = reinterpret_cast<__m256i*>(p);
+        _mm256_storeu_si256(ptr, lerp_avx2(_mm256_loadu_si256(ptr), q, a, a));
+    }
+    _mm256_zeroupper();
+    blend4_sse2(p, len, color, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("avx2")
+static void blend_covers4_avx2(int8u* p, unsigned len, const int8u* color, int8u alpha,
+                               const int8u* covers)
+{
+    int32u c;
+    memcpy(&c, color, 4);
+    __m256i q = _mm256_set1_epi32(int(c));
+    __m256i a = _mm256_set1_epi32(alpha);
+    const __m256i idxLo = _mm256_setr_epi32(0, 0, 1, 1, 4, 4, 5, 5);
+    const __m256i idxHi = _mm256_setr_epi32(2, 2, 3, 3, 6, 6, 7, 7);
+    for (; len >= 8; len -= 8, p += 32, covers += 8)
+    {
+        int64u cv;
+        memcpy(&cv, covers, 8);
+        if (cv == 0)
+            continue;
+
+        __m256i* ptr = reinterpret_cast<__m256i*>(p);
+        if (cv == 0xFFFFFFFFFFFFFFFFull && alpha == rgba8::base_mask)
+        {
+            _mm256_storeu_si256(ptr, q);
+            continue;
+        }
+
+        //alpha for each pixel, in both halves of a 32 bits item. Then each pixel
+        //alpha is expanded to its four bytes
+        __m128i cv8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(covers));
+        __m256i pa = multiply_avx2(_mm256_cvtepu8_epi32(cv8), a);
+        pa = _mm256_or_si256(pa, _mm256_slli_epi32(pa, 16));
+        _mm256_storeu_si256(ptr, lerp_avx2(_mm256_loadu_si256(ptr), q,
+                                           _mm256_permutevar8x32_epi32(pa, idxLo),
+                                           _mm256_permutevar8x32_epi32(pa, idxHi)));
+    }
+    _mm256_zeroupper();
+    blend_covers4_sse2(p, len, color, alpha, covers);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("avx2")
+static void blend1_avx2(int8u* p, unsigned len, const int8u* color, int8u alpha)
+{
+    if (alpha == 0)
+        return;
+    if (alpha == rgba8::base_mask)
+    {
+        memset(p, *color, len);
+        return;
+    }
+
+    __m256i q = _mm256_set1_epi8(char(*color));
+    __m256i a = _mm256_set1_epi16(alpha);
+    for (; len >= 32; len -= 32, p += 32)
+    {
+        __m256i* ptr = reinterpret_cast<__m256i*>(p);
+        _mm256_storeu_si256(ptr, lerp_avx2(_mm256_loadu_si256(ptr), q, a, a));
+    }
+    _mm256_zeroupper();
+    blend1_sse2(p, len, color, alpha);
+}
+
+//---------------------------------------------------------------------------------------
+LOMSE_TARGET("avx2")
+static void blend_covers1_avx2(int8u* p, unsigned len, const int8u* color, int8u alpha,
+                               const int8u* covers)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i full = _mm256_set1_epi8(char(0xFF));
+    __m256i q = _mm256_set1_epi8(char(*color));
+    __m256i a = _mm256_set1_epi16(alpha);
+    for (; len >= 32; len -= 32, p += 32, covers += 32)
+    {
+        __m256i cv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(covers));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(cv, zero)) == -1)
+            continue;
+
+        __m256i* ptr = reinterpret_cast<__m256i*>(p);
+        if (alpha == rgba8::base_mask
+            && _mm256_movemask_epi8(_mm256_cmpeq_epi8(cv, full)) == -1)
+        {
+            _mm256_storeu_si256(ptr, q);
+            continue;
+        }
+
+        _mm256_storeu_si256(ptr, lerp_avx2(_mm256_loadu_si256(ptr), q,
+                                 multiply_avx2(_mm256_unpacklo_epi8(cv, zero), a),
+                                 multiply_avx2(_mm256_unpackhi_epi8(cv, zero), a)));
+    }
+    _mm256_zeroupper();
+    blend_covers1_sse2(p, len, color, alpha, covers);
+}
+
+//---------------------------------------------------------------------------------------
+static const SpanKernels k_avx2_kernels = {
+    copy4_avx2,
+    blend4_avx2,
+    blend_covers4_avx2,
+    blend1_avx2,
+    blend_covers1_avx2,
+};
+
+#endif  //LOMSE_SPAN_X86
+
+
+//=======================================================================================
+// Kernels selection
+//=======================================================================================
+static const SpanKernels* kernels_for(int iset)
+{
+#if (LOMSE_SPAN_X86 == 1)
+    switch (iset)
+    {
+        case k_span_sse2:   return &k_sse2_kernels;
+        case k_span_avx2:   return &k_avx2_kernels;
+        default:            return &k_portable_kernels;
+    }
+#else
+    return &k_portable_kernels;
+#endif
+}
+
+//---------------------------------------------------------------------------------------
+static int best_instruction_set()
+{
+#if (LOMSE_SPAN_X86 == 1)
+    __builtin_cpu_init();
+#endif
+    if (is_span_instruction_set_supported(k_span_avx2))
+        return k_span_avx2;
+    if (is_span_instruction_set_supported(k_span_sse2))
+        return k_span_sse2;
+    return k_span_portable;
+}
+
+//---------------------------------------------------------------------------------------
+static std::atomic<int>& current_instruction_set()
+{
+    static std::atomic<int> iset(best_instruction_set());
+    return iset;
+}
+
+//---------------------------------------------------------------------------------------
+static inline const SpanKernels* kernels()
+{
+    return kernels_for( current_instruction_set().load(std::memory_order_relaxed) );
+}
+
+//---------------------------------------------------------------------------------------
+bool is_span_instruction_set_supported(int iset)
+{
+    switch (iset)
+    {
+        case k_span_portable:
+            return true;
+#if (LOMSE_SPAN_X86 == 1)
+        case k_span_sse2:
+            return __builtin_cpu_supports("sse2");
+        case k_span_avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+int get_span_instruction_set()
+{
+    return current_instruction_set().load();
+}
+
+//---------------------------------------------------------------------------------------
+bool set_span_instruction_set(int iset)
+{
+    if (!is_span_instruction_set_supported(iset))
+        return false;
+    current_instruction_set().store(iset);
+    return true;
+}
+
+
+//=======================================================================================
+// Span operations
+//=======================================================================================
+void span_copy(int8u* p, unsigned len, const int8u* color, int bytesPerPixel)
+{
+    switch (bytesPerPixel)
+    {
+        case 4:     kernels()->copy4(p, len, color);        break;
+        case 3:     copy_portable<3>(p, len, color);        break;
+        default:    copy_portable<1>(p, len, color);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void span_blend(int8u* p, unsigned len, const int8u* color, int bytesPerPixel,
+                int8u alpha)
+{
+    switch (bytesPerPixel)
+    {
+        case 4:     kernels()->blend4(p, len, color, alpha);        break;
+        case 3:     blend_portable<3>(p, len, color, alpha);        break;
+        default:    kernels()->blend1(p, len, color, alpha);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void span_blend_covers(int8u* p, unsigned len, const int8u* color, int bytesPerPixel,
+                       int8u alpha, const int8u* covers)
+{
+    switch (bytesPerPixel)
+    {
+        case 4:     kernels()->blend_covers4(p, len, color, alpha, covers);     break;
+        case 3:     blend_covers_portable<3>(p, len, color, alpha, covers);     break;
+        default:    kernels()->blend_covers1(p, len, color, alpha, covers);
+    }
+}
+
+
+}  //namespace lomse
@@ -0,0 +1,372 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_page_cache.h"
+
+#include "lomse_bitmap_drawer.h"
+#include "lomse_logger.h"
+
+#if (LOMSE_ENABLE_COMPRESSION == 1)
+    #include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace lomse
+{
+
+//=======================================================================================
+// PageKey implementation
+//=======================================================================================
+bool PageKey::operator==(const PageKey& key) const
+{
+    return docModelRef == key.docModelRef
+        && gmodelId == key.gmodelId
+        && gmodelVersion == key.gmodelVersion
+        && layoutConstrains == key.layoutConstrains
+        && iPage == key.iPage
+        && bounds == key.bounds
+        && scale == key.scale
+        && pixelFormat == key.pixelFormat
+        && options == key.options;
+}
+
+
+//=======================================================================================
+// PageCache implementation
+//=======================================================================================
+PageCache::PageCache(int bytesPerPixel, size_t maxBytes)
+    : m_bytesPerPixel(bytesPerPixel)
+    , m_maxBytes(maxBytes)
+    , m_usedBytes(0)
+    , m_numHits(0)
+    , m_numMisses(0)
+{
+}
+
+//---------------------------------------------------------------------------------------
+PageCache::~PageCache()
+{
+    invalidate();
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::set_max_bytes(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxBytes = maxBytes;
+    discard_pages(nullptr);
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::draw_page(const PageKey& key, const VRect& area, const void* viewer,
+                          BitmapDrawer* pDrawer, Pixels xDest, Pixels yDest,
+                          std::function<void(RenderingBuffer&)> render)
+{
+    if (area.is_empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    PageRaster* pPage = find_or_wait(key, lock);
+    if (pPage)
+    {
+        ++m_numHits;
+        if (pPage->fCompressed)
+            decompress(pPage);
+    }
+    else
+    {
+        //the page is inserted while rasterized, for other threads to wait for it
+        ++m_numMisses;
+        pPage = LOMSE_NEW PageRaster(key);
+        pPage->x = area.x;
+        pPage->y = area.y;
+        pPage->width = area.width;
+        pPage->height = area.height;
+        pPage->fRendering = true;
+        m_pages.push_front(pPage);
+
+        vector<unsigned char> pixels(raw_bytes(pPage));
+        lock.unlock();
+        try
+        {
+            RenderingBuffer rbuf(&pixels[0], unsigned(area.width),
+                                 unsigned(area.height), area.width * m_bytesPerPixel);
+            render(rbuf);
+        }
+        catch (...)
+        {
+            lock.lock();
+            m_pages.remove(pPage);
+            delete pPage;
+            m_rendered.notify_all();
+            throw;
+        }
+        lock.lock();
+
+        pPage->pixels.swap(pixels);
+        pPage->fRendering = false;
+        m_rendered.notify_all();
+
+        //if the page was invalidated while rasterized, it is not saved
+        if (find(m_pages.begin(), m_pages.end(), pPage) == m_pages.end())
+        {
+            RenderingBuffer rbuf(&pPage->pixels[0], unsigned(pPage->width),
+                                 unsigned(pPage->height), pPage->width * m_bytesPerPixel);
+            pDrawer->copy_bitmap(rbuf, xDest, yDest);
+            delete pPage;
+            return;
+        }
+        m_usedBytes += raw_bytes(pPage);
+    }
+    discard_pages(pPage);
+    pPage->viewers.insert(viewer);
+
+    RenderingBuffer rbuf(&pPage->pixels[0], unsigned(pPage->width),
+                         unsigned(pPage->height), pPage->width * m_bytesPerPixel);
+    pDrawer->copy_bitmap(rbuf, xDest, yDest);
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::start_frame(const void* viewer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (PageRaster* pPage : m_pages)
+        pPage->viewers.erase(viewer);
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::end_frame(const void* UNUSED(viewer))
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (PageRaster* pPage : m_pages)
+    {
+        if (pPage->viewers.empty() && !pPage->fCompressed && !pPage->fRendering)
+            compress(pPage);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::invalidate(long docModelRef)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    list<PageRaster*>::iterator it = m_pages.begin();
+    while (it != m_pages.end())
+    {
+        list<PageRaster*>::iterator itNext = it;
+        ++itNext;
+        if ((*it)->key.docModelRef == docModelRef)
+            delete_page(it);
+        it = itNext;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (!m_pages.empty())
+        delete_page(m_pages.begin());
+}
+
+//---------------------------------------------------------------------------------------
+PageRaster* PageCache::find_page(const PageKey& key)
+{
+    for (list<PageRaster*>::iterator it = m_pages.begin(); it != m_pages.end(); ++it)
+    {
+        if ((*it)->key == key)
+        {
+            //move to front, as most recently used
+            m_pages.splice(m_pages.begin(), m_pages, it);
+            return m_pages.front();
+        }
+    }
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+PageRaster* PageCache::find_or_wait(const PageKey& key, std::unique_lock<std::mutex>& lock)
+{
+    //Returns the page, or nullptr if not cached. When the page is being rasterized
+    //by other thread, waits until it is finished or discarded
+
+    PageRaster* pPage = find_page(key);
+    while (pPage && pPage->fRendering)
+    {
+        m_rendered.wait(lock);
+        pPage = find_page(key);
+    }
+    return pPage;
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::discard_pages(PageRaster* pKeep)
+{
+    //AWARE: the page being drawn is always kept, even when the budget is smaller.
+    //Pages being rasterized are owned by the rasterizing thread
+
+    list<PageRaster*>::iterator it = m_pages.end();
+    while (m_usedBytes > m_maxBytes && it != m_pages.begin())
+    {
+        --it;
+        if (*it != pKeep && !(*it)->fRendering)
+        {
+            list<PageRaster*>::iterator itDel = it;
+            ++it;
+            delete_page(itDel);
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::delete_page(list<PageRaster*>::iterator it)
+{
+    //a page being rasterized is only removed from the list. It will be deleted by
+    //the rasterizing thread
+
+    PageRaster* pPage = *it;
+    m_usedBytes -= pPage->pixels.size();
+    m_pages.erase(it);
+    if (pPage->fRendering)
+        m_rendered.notify_all();
+    else
+        delete pPage;
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::compress(PageRaster* pPage)
+{
+    vector<unsigned char> data;
+
+#if (LOMSE_ENABLE_COMPRESSION == 1)
+    uLongf size = compressBound(uLong(pPage->pixels.size()));
+    data.resize(size);
+    if (compress2(&data[0], &size, &pPage->pixels[0], uLong(pPage->pixels.size()),
+                  Z_BEST_SPEED) != Z_OK)
+    {
+        LOMSE_LOG_ERROR("Page compression failed. Page kept uncompressed.");
+        return;
+    }
+    data.resize(size);
+
+#else
+    //Run-length encoding: sequence of [count][pixel], count 1..255
+    const unsigned char* pixel = &pPage->pixels[0];
+    const unsigned char* end = pixel + pPage->pixels.size();
+    while (pixel < end)
+    {
+        const unsigned char* next = pixel + m_bytesPerPixel;
+        int count = 1;
+        while (next < end && count < 255
+               && memcmp(pixel, next, size_t(m_bytesPerPixel)) == 0)
+        {
+            next += m_bytesPerPixel;
+            ++count;
+        }
+        data.push_back(static_cast<unsigned char>(count));
+        data.insert(data.end(), pixel, pixel + m_bytesPerPixel);
+        pixel = next;
+    }
+#endif
+
+    m_usedBytes -= pPage->pixels.size();
+    m_usedBytes += data.size();
+    pPage->pixels.swap(data);
+    pPage->fCompressed = true;
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::decompress(PageRaster* pPage)
+{
+    vector<unsigned char> data(raw_bytes(pPage));
+
+#if (LOMSE_ENABLE_COMPRESSION == 1)
+    uLongf size = uLongf(data.size());
+    if (uncompress(&data[0], &size, &pPage->pixels[0], uLong(pPage->pixels.size()))
+        != Z_OK || size != uLongf(data.size()))
+    {
+        LOMSE_LOG_ERROR("Page decompression failed.");
+        throw runtime_error("[PageCache::decompress] Page decompression failed.");
+    }
+
+#else
+    unsigned char* pixel = &data[0];
+    const unsigned char* src = &pPage->pixels[0];
+    const unsigned char* end = src + pPage->pixels.size();
+    while (src < end)
+    {
+        int count = *src++;
+        for (int i=0; i < count; ++i, pixel += m_bytesPerPixel)
+            memcpy(pixel, src, size_t(m_bytesPerPixel));
+        src += m_bytesPerPixel;
+    }
+#endif
+
+    m_usedBytes -= pPage->pixels.size();
+    m_usedBytes += data.size();
+    pPage->pixels.swap(data);
+    pPage->fCompressed = false;
+}
+
+//---------------------------------------------------------------------------------------
+long PageCache::get_num_hits()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numHits;
+}
+
+//---------------------------------------------------------------------------------------
+long PageCache::get_num_misses()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_numMisses;
+}
+
+//---------------------------------------------------------------------------------------
+void PageCache::reset_counters()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_numHits = 0;
+    m_numMisses = 0;
+}
+
+//---------------------------------------------------------------------------------------
+size_t PageCache::get_used_bytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_usedBytes;
+}
+
+//---------------------------------------------------------------------------------------
+int PageCache::get_num_pages()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return int(m_pages.size());
+}
+
+//---------------------------------------------------------------------------------------
+int PageCache::get_num_compressed_pages()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for (PageRaster* pPage : m_pages)
+    {
+        if (pPage->fCompressed)
+            ++count;
+    }
+    return count;
+}
+
+
+}  //namespace lomse
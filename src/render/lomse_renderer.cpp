@@ -22,6 +22,7 @@
 #include "lomse_renderer.h"
 #include "lomse_logger.h"
 
+#include <cmath>
 #include <sstream>
 using namespace std;
 
@@ -82,13 +83,13 @@ Renderer* RendererFactory::create_renderer(LibraryScope& libraryScope,
         //                    (libraryScope.get_screen_ppi(), attr_storage, path);
 
         case k_pix_format_rgba32:
-            return LOMSE_NEW RendererTemplate<agg::pixfmt_rgba32,
-                                        agg::pixfmt_rgba32::color_type>
+            return LOMSE_NEW RendererTemplate<PixFormat_rgba32,
+                                        PixFormat_rgba32::color_type>
                             (libraryScope.get_screen_ppi(), attr_storage, path);
 
         case k_pix_format_argb32:
-            return LOMSE_NEW RendererTemplate<agg::pixfmt_argb32,
-                                        agg::pixfmt_argb32::color_type>
+            return LOMSE_NEW RendererTemplate<PixFormat_argb32,
+                                        PixFormat_argb32::color_type>
                             (libraryScope.get_screen_ppi(), attr_storage, path);
 
         //case k_pix_format_abgr32:
@@ -147,6 +148,9 @@ Renderer::Renderer(double ppi, AttrStorage& attr_storage, PathStorage& path)
 
     , m_attr_storage(attr_storage)
     , m_path(path)
+    , m_drawnArea(1, 1, 0, 0)
+    , m_pendingArea(1, 1, 0, 0)
+    , m_numBatches(0)
 {
     // device units are pixels. Therefore we must convert from LUnits to pixels:
     //      ppi px/inch = ppi/25.4 px/mm = ppi/2540 px/LU
@@ -172,6 +176,38 @@ void Renderer::set_transform(TransAffine& transform)
     set_transformation();
 }
 
+//---------------------------------------------------------------------------------------
+void Renderer::copy_transform(const Renderer& renderer)
+{
+    //AWARE: all parameters are copied, instead of the resulting matrix, so that
+    //the computed transformation is exactly the same in both renderers
+
+    m_lunitsToPixels = renderer.m_lunitsToPixels;
+    m_expand = renderer.m_expand;
+    m_gamma = renderer.m_gamma;
+    m_userScale = renderer.m_userScale;
+    m_rotation = renderer.m_rotation;
+    m_uxShift = renderer.m_uxShift;
+    m_uyShift = renderer.m_uyShift;
+    m_vxOrg = renderer.m_vxOrg;
+    m_vyOrg = renderer.m_vyOrg;
+    set_transformation();
+}
+
+//---------------------------------------------------------------------------------------
+void Renderer::add_drawn_area(int x1, int y1, int x2, int y2)
+{
+    if (m_drawnArea.is_valid())
+    {
+        m_drawnArea.x1 = std::min(m_drawnArea.x1, x1);
+        m_drawnArea.y1 = std::min(m_drawnArea.y1, y1);
+        m_drawnArea.x2 = std::max(m_drawnArea.x2, x2);
+        m_drawnArea.y2 = std::max(m_drawnArea.y2, y2);
+    }
+    else
+        m_drawnArea = AggRectInt(x1, y1, x2, y2);
+}
+
 //---------------------------------------------------------------------------------------
 TransAffine& Renderer::set_transformation()
 {
@@ -204,6 +240,216 @@ void Renderer::reset()
 {
     m_path.remove_all();
     m_attr_storage.remove_all();
+    m_pathBounds.clear();
+    m_pendingArea = AggRectInt(1, 1, 0, 0);
+    m_numBatches = 0;
+}
+
+//---------------------------------------------------------------------------------------
+bool Renderer::pending_paths_overlap(const AggRectInt& rect)
+{
+    compute_paths_bounds();
+    if (!m_pendingArea.is_valid() || !m_pendingArea.overlaps(rect))
+        return false;
+
+    for (const AggRectInt& bounds : m_pathBounds)
+    {
+        if (bounds.is_valid() && bounds.overlaps(rect))
+            return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------
+void Renderer::compute_paths_bounds()
+{
+    //AWARE: the last path could still be growing. Its bounds are always recomputed
+
+    unsigned numPaths = m_attr_storage.size();
+    if (!m_pathBounds.empty() && m_pathBounds.size() == numPaths)
+        m_pathBounds.pop_back();
+
+    for (unsigned i = unsigned(m_pathBounds.size()); i < numPaths; ++i)
+    {
+        AggRectInt bounds = compute_path_bounds(m_attr_storage[i]);
+        m_pathBounds.push_back(bounds);
+        if (!bounds.is_valid())
+            continue;
+
+        if (m_pendingArea.is_valid())
+        {
+            m_pendingArea.x1 = std::min(m_pendingArea.x1, bounds.x1);
+            m_pendingArea.y1 = std::min(m_pendingArea.y1, bounds.y1);
+            m_pendingArea.x2 = std::max(m_pendingArea.x2, bounds.x2);
+            m_pendingArea.y2 = std::max(m_pendingArea.y2, bounds.y2);
+        }
+        else
+            m_pendingArea = bounds;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+AggRectInt Renderer::compute_path_bounds(const PathAttributes& attr)
+{
+    //Pixels that the rasterizer could touch when rendering the path: its vertices
+    //(curves are inside the polygon of their control points), expanded by the
+    //stroke and by one pixel, to include the cells of the edges
+
+    TransAffine mtx = attr.transform;
+    mtx *= m_mtx;
+
+    double x1 = 0.0, y1 = 0.0, x2 = 0.0, y2 = 0.0;
+    bool fFirst = true;
+    double x, y;
+    unsigned cmd;
+    m_path.rewind(attr.path_index);
+    while (!agg::is_stop(cmd = m_path.vertex(&x, &y)))
+    {
+        if (agg::is_vertex(cmd))
+        {
+            mtx.transform(&x, &y);
+            if (fFirst)
+            {
+                x1 = x2 = x;
+                y1 = y2 = y;
+                fFirst = false;
+            }
+            else
+            {
+                x1 = std::min(x1, x);
+                y1 = std::min(y1, y);
+                x2 = std::max(x2, x);
+                y2 = std::max(y2, y);
+            }
+        }
+    }
+    if (fFirst)
+        return AggRectInt(1, 1, 0, 0);
+
+    //stroke width, in pixels, including joins and caps
+    double margin = 1.0 + fabs(m_expand) * std::max(attr.miter_limit, 1.5);
+    if (attr.stroke_flag)
+    {
+        double scale = std::max(fabs(mtx.sx) + fabs(mtx.shx),
+                                fabs(mtx.shy) + fabs(mtx.sy));
+        margin += attr.stroke_width / 2.0 * scale * std::max(attr.miter_limit, 1.5);
+    }
+
+    return AggRectInt(int(floor(x1 - margin)), int(floor(y1 - margin)),
+                      int(floor(x2 + margin)), int(floor(y2 + margin)));
+}
+
+//---------------------------------------------------------------------------------------
+void Renderer::create_batches()
+{
+    //Paths are rendered in painter's order only when they overlap. Each path is
+    //added to the earliest batch with the same attributes that is not followed by
+    //any batch overlapping the path. Otherwise, a new batch is created at the end
+
+    m_numBatches = 0;
+    unsigned numPaths = m_attr_storage.size();
+    if (numPaths > 1)
+        compute_paths_bounds();
+
+    for (unsigned i = 0; i < numPaths; ++i)
+    {
+        int target = -1;
+        if (numPaths > 1)
+        {
+            const AggRectInt& bounds = m_pathBounds[i];
+            const PathAttributes& attr = m_attr_storage[i];
+            for (int j = int(m_numBatches) - 1; j >= 0; --j)
+            {
+                PathBatch& batch = m_batches[j];
+                if (batch_overlaps(batch, bounds))
+                    break;
+                if (can_be_batched(attr, m_attr_storage[batch.paths[0]]))
+                    target = j;
+            }
+        }
+
+        if (target < 0)
+        {
+            if (m_batches.size() == m_numBatches)
+                m_batches.push_back(PathBatch());
+            target = int(m_numBatches++);
+            m_batches[target].paths.clear();
+            m_batches[target].area = AggRectInt(1, 1, 0, 0);
+        }
+
+        PathBatch& batch = m_batches[target];
+        batch.paths.push_back(i);
+        if (numPaths > 1 && m_pathBounds[i].is_valid())
+        {
+            const AggRectInt& bounds = m_pathBounds[i];
+            if (batch.area.is_valid())
+            {
+                batch.area.x1 = std::min(batch.area.x1, bounds.x1);
+                batch.area.y1 = std::min(batch.area.y1, bounds.y1);
+                batch.area.x2 = std::max(batch.area.x2, bounds.x2);
+                batch.area.y2 = std::max(batch.area.y2, bounds.y2);
+            }
+            else
+                batch.area = bounds;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+bool Renderer::batch_overlaps(const PathBatch& batch, const AggRectInt& bounds)
+{
+    if (!bounds.is_valid() || !batch.area.is_valid() || !batch.area.overlaps(bounds))
+        return false;
+
+    for (unsigned i : batch.paths)
+    {
+        if (m_pathBounds[i].is_valid() && m_pathBounds[i].overlaps(bounds))
+            return true;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------------------
+static inline bool is_same_color(Color c1, Color c2)
+{
+    return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a;
+}
+
+//---------------------------------------------------------------------------------------
+bool Renderer::can_be_batched(const PathAttributes& attr, const PathAttributes& other)
+{
+    //gradients are never batched
+    if (attr.fill_mode != other.fill_mode
+        || attr.fill_mode == k_fill_gradient_linear
+        || attr.fill_mode == k_fill_gradient_radial)
+    {
+        return false;
+    }
+
+    if (attr.fill_mode == k_fill_solid
+        && (!is_same_color(attr.fill_color, other.fill_color)
+            || attr.even_odd_flag != other.even_odd_flag))
+    {
+        return false;
+    }
+
+    if (attr.stroke_flag != other.stroke_flag)
+        return false;
+
+    if (attr.stroke_flag
+        && (!is_same_color(attr.stroke_color, other.stroke_color)
+            || attr.stroke_width != other.stroke_width
+            || attr.line_join != other.line_join
+            || attr.line_cap != other.line_cap
+            || attr.miter_limit != other.miter_limit))
+    {
+        return false;
+    }
+
+    const TransAffine& t1 = attr.transform;
+    const TransAffine& t2 = other.transform;
+    return t1.sx == t2.sx && t1.shy == t2.shy && t1.shx == t2.shx
+           && t1.sy == t2.sy && t1.tx == t2.tx && t1.ty == t2.ty;
 }
 
 //---------------------------------------------------------------------------------------
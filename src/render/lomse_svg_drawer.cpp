@@ -16,19 +16,116 @@
 //std
 #include <locale>
 #include <codecvt>
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include <cstdio>
+#include <clocale>
 using namespace std;
 
 
 namespace lomse
 {
 
+//SVG code is written to the stream when the buffer reaches this size
+const size_t k_svg_chunk_size = 64 * 1024;
+
+//=======================================================================================
+// SvgBuffer implementation
+//=======================================================================================
+SvgBuffer& SvgBuffer::operator <<(int value)
+{
+    char buf[16];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    unsigned int v = (value < 0 ? 0U - unsigned(value) : unsigned(value));
+    do
+    {
+        *--p = char('0' + v % 10);
+        v /= 10;
+    }
+    while (v > 0);
+    if (value < 0)
+        *--p = '-';
+    m_data.append(p, size_t(end - p));
+    return *this;
+}
+
+//---------------------------------------------------------------------------------------
+SvgBuffer& SvgBuffer::operator <<(unsigned int value)
+{
+    char buf[16];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    do
+    {
+        *--p = char('0' + value % 10);
+        value /= 10;
+    }
+    while (value > 0);
+    m_data.append(p, size_t(end - p));
+    return *this;
+}
+
+//---------------------------------------------------------------------------------------
+SvgBuffer& SvgBuffer::operator <<(double value)
+{
+    //AWARE: std::ostream default formatting for doubles is printf "%g" with precision
+    //6. With fixed precision, trailing zeros are removed.
+
+    char buf[64];
+    int precision = get_precision();
+    int len;
+    if (precision < 0)
+        len = snprintf(buf, sizeof(buf), "%.6g", value);
+    else
+    {
+        len = snprintf(buf, sizeof(buf), "%.*f", precision, value);
+        if (len > 0 && len < int(sizeof(buf)) && precision > 0)
+        {
+            while (buf[len-1] == '0')
+                --len;
+            if (buf[len-1] == '.' || buf[len-1] == ',')
+                --len;
+        }
+        if (len == 2 && buf[0] == '-' && buf[1] == '0')
+        {
+            buf[0] = '0';
+            len = 1;
+        }
+    }
+    if (len < 0 || len >= int(sizeof(buf)))
+    {
+        LOMSE_LOG_ERROR("Number formatting failed");
+        return *this;
+    }
+
+    //SVG requires '.' as decimal separator, whatever the C locale is
+    char point = *localeconv()->decimal_point;
+    if (point != '.')
+    {
+        for (int i=0; i < len; ++i)
+        {
+            if (buf[i] == point)
+                buf[i] = '.';
+        }
+    }
+
+    m_data.append(buf, size_t(len));
+    return *this;
+}
+
+
 //=======================================================================================
 // SvgDrawer implementation
 //=======================================================================================
 SvgDrawer::SvgDrawer(LibraryScope& libraryScope, ostream& svgstream,
                      const SvgOptions& opt)
     : Drawer(libraryScope)
-    , m_svg(svgstream)
+    , m_stream(svgstream)
+    , m_svg(&opt.precision)
+    , m_attribs(&opt.precision)
+    , m_path(&opt.precision)
     , m_options(opt)
 {
 }
@@ -36,14 +133,42 @@ SvgDrawer::SvgDrawer(LibraryScope& libraryScope, ostream& svgstream,
 //---------------------------------------------------------------------------------------
 SvgDrawer::~SvgDrawer()
 {
+    flush();
+    delete m_pOutlinesEngine;
+}
+
+//---------------------------------------------------------------------------------------
+void SvgDrawer::write_svg_start(ostream& svg, const SvgOptions& opt,
+                                LUnits width, LUnits height)
+{
+    svg << "<svg xmlns='http://www.w3.org/2000/svg' ";
+    if (opt.glyphs_as_symbols)
+        svg << "xmlns:xlink='http://www.w3.org/1999/xlink' ";
+    svg << "version='1.1' viewBox='0 0 " << width << " " << height << "'>";
+    if (opt.add_newlines)
+        svg << endl;
+}
+
+//---------------------------------------------------------------------------------------
+void SvgDrawer::write_svg_end(ostream& svg)
+{
+    svg << "</svg>";
+}
+
+//---------------------------------------------------------------------------------------
+void SvgDrawer::flush()
+{
+    if (!m_svg.empty())
+    {
+        m_stream.write(m_svg.data(), streamsize(m_svg.size()));
+        m_svg.clear();
+    }
 }
 
 //---------------------------------------------------------------------------------------
 void SvgDrawer::reset(Color UNUSED(bgcolor))
 {
-    m_path.str("");
     m_path.clear();
-    m_attribs.str("");
     m_attribs.clear();
 }
 
@@ -53,7 +178,6 @@ void SvgDrawer::begin_path()
     if (m_fPathOpen)
     {
         LOMSE_LOG_ERROR("Path already open: [" + m_path.str() + "]");
-        m_path.str("");
         m_path.clear();
     }
     m_fPathOpen = true;
@@ -68,18 +192,16 @@ void SvgDrawer::end_path()
     }
     else
     {
-        if (!m_path.str().empty())
+        if (!m_path.empty())
         {
             start_element("path");
-            m_svg << " d='" << m_path.str() << "'" << m_attribs.str() << "/>";
+            m_svg << " d='" << m_path << "'" << m_attribs << "/>";
             new_line();
         }
     }
     m_fPathOpen = false;
 
-    m_path.str("");
     m_path.clear();
-    m_attribs.str("");
     m_attribs.clear();
 }
 
@@ -289,6 +411,7 @@ bool SvgDrawer::select_font(const std::string& language,
 
     //AWARE: this is needed so that shapes can do measurements at drawing time
     m_pFonts->select_font(language, fontFile, fontName, height, fBold, fItalic);
+    m_fontFile = m_pFonts->get_font_file();
 
     return true;
 }
@@ -296,6 +419,20 @@ bool SvgDrawer::select_font(const std::string& language,
 //---------------------------------------------------------------------------------------
 void SvgDrawer::draw_glyph(double x, double y, unsigned int ch)
 {
+    if (m_options.glyphs_as_symbols)
+    {
+        string id = glyph_symbol(ch);
+        if (!id.empty())
+        {
+            start_element("use");
+            m_svg << " xlink:href='#" << id << "' x='" << x << "' y='" << y << "'";
+            add_glyph_fill();
+            m_svg << "/>";
+            new_line();
+            return;
+        }
+    }
+
     const double factor = 35.2778;   //to convert font-size (pt) to LUnits  (25.4*100/72)
     start_element("text");
     m_svg << " x='" << x << "' y='" << y << "' fill='" << to_svg(m_textColor)
@@ -316,6 +453,23 @@ void SvgDrawer::draw_glyph_rotated(double x, double y, unsigned int ch, double r
 {
     const double factor = 35.2778;   //to convert font-size (pt) to LUnits  (25.4*100/72)
     const double degrees = 180.0 / 3.141592654;   //to convert radians to degrees
+
+    if (m_options.glyphs_as_symbols)
+    {
+        string id = glyph_symbol(ch);
+        if (!id.empty())
+        {
+            start_element("use");
+            m_svg << " xlink:href='#" << id << "' x='" << x << "' y='" << y
+                  << "' transform='rotate(" << rotation * degrees << "," << x << ","
+                  << y << ")'";
+            add_glyph_fill();
+            m_svg << "/>";
+            new_line();
+            return;
+        }
+    }
+
     start_element("text");
     m_svg << " x='" << x << "' y='" << y << "' fill='" << to_svg(m_textColor)
          << "' transform='rotate(" << rotation * degrees << "," << x << "," << y << ")"
@@ -331,6 +485,183 @@ void SvgDrawer::draw_glyph_rotated(double x, double y, unsigned int ch, double r
     new_line();
  }
 
+//---------------------------------------------------------------------------------------
+string SvgDrawer::glyph_symbol(unsigned int ch)
+{
+    //Returns the id of the <symbol> element with the outline of the glyph for the
+    //current font and size. The <symbol> is written the first time the glyph is used.
+    //Returns an empty string if the outline is not available.
+
+    const double factor = 35.2778;   //to convert font-size (pt) to LUnits  (25.4*100/72)
+    double size = m_fontSize * factor;
+
+    if (m_fontFile.empty())
+    {
+        m_fontFile = m_libraryScope.get_music_font_path();
+        m_fontFile += m_libraryScope.get_music_font_file();
+    }
+
+    stringstream key;
+    key << m_fontFile << "|" << size << "|" << ch;
+    auto it = m_symbols.find(key.str());
+    if (it != m_symbols.end())
+        return it->second;
+
+    string path;
+    if (!get_glyph_outline(ch, size, &path))
+    {
+        m_symbols.emplace(key.str(), "");
+        return "";
+    }
+
+    //id from glyph code and size. A suffix is added if another font was used
+    stringstream ss;
+    ss << "glyph-" << std::hex << std::uppercase << ch << std::dec << "-"
+       << int(std::round(size));
+    string id = ss.str();
+    int suffix = 1;
+    while (m_ids.find(id) != m_ids.end())
+    {
+        stringstream ssid;
+        ssid << ss.str() << "-" << suffix++;
+        id = ssid.str();
+    }
+    m_ids.emplace(id, 0);
+    m_symbols.emplace(key.str(), id);
+
+    indent_spaces();
+    m_svg << "<symbol id='" << id << "' overflow='visible'><path d='" << path
+          << "'/></symbol>";
+    new_line();
+
+    return id;
+}
+
+//---------------------------------------------------------------------------------------
+void SvgDrawer::add_glyph_fill()
+{
+    //black is the default fill color
+    if (!is_equal(m_textColor, Color(0,0,0)))
+        m_svg << " fill='" << to_svg(m_textColor) << "'";
+}
+
+//---------------------------------------------------------------------------------------
+bool SvgDrawer::get_glyph_outline(unsigned int ch, double size, string* pathData)
+{
+    //Outline of glyph, in LUnits relative to glyph origin, as svg path data. The glyph
+    //is loaded in a private font engine, in vector mode, so that the shared
+    //FontStorage used for measurements is not affected.
+
+    if (!m_pOutlinesEngine)
+    {
+        m_pOutlinesEngine = LOMSE_NEW FontEngine();
+        m_pOutlinesEngine->resolution(72);     //font size in points is in LUnits
+        m_pOutlinesEngine->hinting(false);
+        m_pOutlinesEngine->flip_y(true);
+    }
+
+    if (m_outlinesFontFile != m_fontFile)
+    {
+        m_outlinesFontFile = m_fontFile;
+        if (!m_pOutlinesEngine->select_font(m_fontFile, 0, glyph_ren_outline))
+        {
+            LOMSE_LOG_ERROR("Font not found: " + m_fontFile);
+            m_outlinesFontFile = "";
+            return false;
+        }
+    }
+    m_pOutlinesEngine->height(size);
+    m_pOutlinesEngine->width(size);
+
+    if (!m_pOutlinesEngine->prepare_glyph(ch)
+        || m_pOutlinesEngine->data_type() != glyph_data_outline)
+    {
+        return false;
+    }
+
+    vector<int8u> data(m_pOutlinesEngine->data_size() + 1);
+    m_pOutlinesEngine->write_glyph_to(&data[0]);
+    FontEngine::path_adaptor_type outline;
+    outline.init(&data[0], m_pOutlinesEngine->data_size(), 0.0, 0.0);
+
+    //For compactness, coordinates are rounded to LUnits and written relative to
+    //current point, using implicit separators
+    stringstream ss;
+    int xCur = 0, yCur = 0;
+    auto add_point = [&ss, &xCur, &yCur](double x, double y, bool fFirst)
+    {
+        int dx = int(std::round(x)) - xCur;
+        int dy = int(std::round(y)) - yCur;
+        if (!fFirst && dx >= 0)
+            ss << " ";
+        ss << dx;
+        if (dy >= 0)
+            ss << " ";
+        ss << dy;
+    };
+    auto move_current = [&xCur, &yCur](double x, double y)
+    {
+        xCur = int(std::round(x));
+        yCur = int(std::round(y));
+    };
+
+    double x, y;
+    double xStart = 0.0, yStart = 0.0;
+    unsigned cmd;
+    bool fOpen = false;
+    while (!is_stop(cmd = outline.vertex(&x, &y)))
+    {
+        switch (cmd)
+        {
+            case agg::path_cmd_move_to:
+                ss << "m";
+                add_point(x, y, true);
+                move_current(x, y);
+                xStart = x;
+                yStart = y;
+                fOpen = true;
+                break;
+
+            case agg::path_cmd_line_to:
+                ss << "l";
+                add_point(x, y, true);
+                move_current(x, y);
+                break;
+
+            case agg::path_cmd_curve3:
+                ss << "q";
+                add_point(x, y, true);
+                outline.vertex(&x, &y);
+                add_point(x, y, false);
+                move_current(x, y);
+                break;
+
+            case agg::path_cmd_curve4:
+                ss << "c";
+                add_point(x, y, true);
+                for (int i=0; i < 2; ++i)
+                {
+                    outline.vertex(&x, &y);
+                    add_point(x, y, false);
+                }
+                move_current(x, y);
+                break;
+
+            default:
+                if (agg::is_end_poly(cmd) && fOpen)
+                {
+                    //after closing, current point is the start of the subpath
+                    ss << "z";
+                    move_current(xStart, yStart);
+                    fOpen = false;
+                }
+        }
+    }
+
+    *pathData = ss.str();
+    return true;
+}
+
 //---------------------------------------------------------------------------------------
 int SvgDrawer::draw_text(double x, double y, const std::string& str)
 {
@@ -423,6 +754,7 @@ void SvgDrawer::set_affine_transformation(TransAffine& transform)
 //---------------------------------------------------------------------------------------
 void SvgDrawer::render()
 {
+    flush();
 }
 
 //---------------------------------------------------------------------------------------
@@ -451,7 +783,7 @@ void SvgDrawer::circle(LUnits xCenter, LUnits yCenter, LUnits radius)
 {
     start_element("circle");
     m_svg << " cx='" << xCenter << "' cy='" << yCenter
-          << "' r='" << radius << "'" << m_attribs.str() << "/>";
+          << "' r='" << radius << "'" << m_attribs << "/>";
     new_line();
 }
 
@@ -643,17 +975,10 @@ string SvgDrawer::to_svg(Color color)
     else if (is_equal(color, Color(255,255,255)) )
         return "#fff";
 
-    stringstream ss;
-    ss << "#";
-    int r = color.r;
-    int g = color.g;
-    int b = color.b;
-    int a = color.a;
-    ss << std::hex << setfill('0') << setw(2) << r;
-    ss << std::hex << setfill('0') << setw(2) << g;
-    ss << std::hex << setfill('0') << setw(2) << b;
-    ss << std::hex << setfill('0') << setw(2) << a;
-    return ss.str();
+    char buf[16];
+    snprintf(buf, sizeof(buf), "#%02x%02x%02x%02x", unsigned(color.r),
+             unsigned(color.g), unsigned(color.b), unsigned(color.a));
+    return string(buf);
 }
 
 //---------------------------------------------------------------------------------------
@@ -674,7 +999,10 @@ void SvgDrawer::indent_spaces()
 void SvgDrawer::new_line()
 {
     if (m_options.add_newlines)
-        m_svg << endl;
+        m_svg << '\n';
+
+    if (m_svg.size() >= k_svg_chunk_size)
+        flush();
 }
 
 //---------------------------------------------------------------------------------------
@@ -746,7 +1074,7 @@ void SvgDrawer::end_composite_notation()
 //---------------------------------------------------------------------------------------
 string SvgDrawer::validate_id(const string& id)
 {
-    static int counter = 0;
+    static std::atomic<int> counter(0);
 
     if (id.empty())
         return id;
@@ -0,0 +1,116 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_tile_cache.h"
+
+using namespace std;
+
+namespace lomse
+{
+
+//=======================================================================================
+// TileCache implementation
+//=======================================================================================
+TileCache::TileCache(int bytesPerPixel, size_t maxBytes, int tileSize)
+    : m_tileSize(tileSize)
+    , m_bytesPerPixel(bytesPerPixel)
+    , m_maxBytes(maxBytes)
+    , m_usedBytes(0)
+    , m_modelId(-1)
+    , m_modelVersion(-1)
+    , m_numHits(0)
+    , m_numMisses(0)
+{
+}
+
+//---------------------------------------------------------------------------------------
+TileCache::~TileCache()
+{
+    invalidate();
+}
+
+//---------------------------------------------------------------------------------------
+void TileCache::set_max_bytes(size_t maxBytes)
+{
+    m_maxBytes = maxBytes;
+    while (m_usedBytes > m_maxBytes && !m_tiles.empty())
+        delete_least_recently_used();
+}
+
+//---------------------------------------------------------------------------------------
+void TileCache::set_content(long modelId, long modelVersion, const RenderOptions& options)
+{
+    if (modelId != m_modelId || modelVersion != m_modelVersion || !(options == m_options))
+    {
+        invalidate();
+        m_modelId = modelId;
+        m_modelVersion = modelVersion;
+        m_options = options;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void TileCache::invalidate()
+{
+    for (Tile* pTile : m_tiles)
+        delete pTile;
+    m_tiles.clear();
+    m_index.clear();
+    m_usedBytes = 0;
+}
+
+//---------------------------------------------------------------------------------------
+Tile* TileCache::find_tile(double scale, int col, int row)
+{
+    TileKey key = {scale, col, row};
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+    {
+        ++m_numMisses;
+        return nullptr;
+    }
+
+    //move to front, as most recently used
+    ++m_numHits;
+    m_tiles.splice(m_tiles.begin(), m_tiles, it->second);
+    return *(it->second);
+}
+
+//---------------------------------------------------------------------------------------
+Tile* TileCache::add_tile(double scale, int col, int row)
+{
+    //AWARE: at least one tile is always kept, even when the budget is smaller
+    while (!m_tiles.empty() && m_usedBytes + tile_bytes() > m_maxBytes)
+        delete_least_recently_used();
+
+    Tile* pTile = LOMSE_NEW Tile(scale, col, row);
+    pTile->pixels.resize(tile_bytes());
+    pTile->rbuf.attach(&pTile->pixels[0], unsigned(m_tileSize), unsigned(m_tileSize),
+                       m_tileSize * m_bytesPerPixel);
+
+    m_tiles.push_front(pTile);
+    TileKey key = {scale, col, row};
+    m_index[key] = m_tiles.begin();
+    m_usedBytes += tile_bytes();
+    return pTile;
+}
+
+//---------------------------------------------------------------------------------------
+void TileCache::delete_least_recently_used()
+{
+    Tile* pTile = m_tiles.back();
+    TileKey key = {pTile->scale, pTile->col, pTile->row};
+    m_index.erase(key);
+    m_tiles.pop_back();
+    m_usedBytes -= tile_bytes();
+    delete pTile;
+}
+
+
+}  //namespace lomse
@@ -19,11 +19,21 @@
 #include "lomse_score_utilities.h"
 #include "lomse_im_attributes.h"
 
+#include <functional>   //std::hash
+#include <iterator>     //back_inserter
+
 using namespace std;
 
 namespace lomse
 {
 
+//---------------------------------------------------------------------------------------
+//helper, to accumulate values in a signature
+static inline void add_to_signature(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 //=======================================================================================
 // SoundEventsTable: Manager for the events table
 //
@@ -45,12 +55,23 @@ namespace lomse
 //    marked as belonging to measure 0.
 //
 //    The two tables must be synchronized.
+//
+//    When the score is modified the table is not re-created. Instead, it is marked
+//    as modified and it is updated when requested again to the score. For this, a
+//    signature of the staffobjs in each measure is saved, and only the events for the
+//    measures whose signature has changed are re-created.
 //=======================================================================================
 SoundEventsTable::SoundEventsTable(ImoScore* pScore)
     : m_pScore(pScore)
     , m_numMeasures(0)
     , m_rAnacrusisMissingTime(0.0)
     , m_rAnacrusisExtraTime(0.0)
+    , m_pTimeline(nullptr)
+    , m_pTempoMap(nullptr)
+    , m_fModified(false)
+    , m_globalSignature(0)
+    , m_numUpdated(-1)
+    , m_numUsers(0)
 {
 }
 
@@ -60,6 +81,8 @@ SoundEventsTable::~SoundEventsTable()
     delete_events_table();
     delete_jumps_table();
     delete_measures_jumps_table();
+    delete m_pTimeline;
+    delete m_pTempoMap;
 }
 
 //---------------------------------------------------------------------------------------
@@ -96,6 +119,248 @@ void SoundEventsTable::create_table()
     create_measures_table();
     replace_label_in_jumps();
     add_events_to_jumps();
+
+    m_globalSignature = compute_signatures(m_signatures, m_structural);
+    m_fModified = false;
+    m_numUpdated = -1;
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::clear_table()
+{
+    delete_events_table();
+    delete_jumps_table();
+    delete_measures_jumps_table();
+    delete m_pTimeline;
+    m_pTimeline = nullptr;
+    delete m_pTempoMap;
+    m_pTempoMap = nullptr;
+
+    m_numMeasures = 0;
+    m_measures.clear();
+    m_channels.clear();
+    m_semitones.clear();
+    m_targets.clear();
+    m_tempoChanges.clear();
+    m_rAnacrusisMissingTime = 0.0;
+    m_rAnacrusisExtraTime = 0.0;
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::update_table()
+{
+    //Only the events for modified measures are re-created. But when the modified
+    //measures contain objects that affect other measures (repetitions, time signatures,
+    //tempo and sound changes, transpositions), or when the instruments or the number
+    //of measures change, the whole table is re-created.
+
+    m_fModified = false;
+
+    vector<size_t> signatures;
+    vector<bool> structural;
+    size_t globalSignature = compute_signatures(signatures, structural);
+
+    bool fRebuild = (globalSignature != m_globalSignature
+                     || signatures.size() != m_signatures.size());
+
+    vector<bool> modified(signatures.size(), false);
+    int numModified = 0;
+    for (size_t i=0; i < signatures.size() && !fRebuild; ++i)
+    {
+        if (signatures[i] != m_signatures[i])
+        {
+            fRebuild = structural[i] || m_structural[i];
+            modified[i] = true;
+            ++numModified;
+        }
+    }
+
+    if (fRebuild)
+    {
+        clear_table();
+        create_table();
+        return;
+    }
+
+    if (numModified > 0)
+        replace_events_for_measures(modified);
+
+    m_signatures.swap(signatures);
+    m_structural.swap(structural);
+    m_numUpdated = numModified;
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::replace_events_for_measures(const vector<bool>& modified)
+{
+    //remove the events for the modified measures and the end of table event
+    vector<SoundEvent*> events;
+    events.reserve(m_events.size());
+    for (SoundEvent* pEvent : m_events)
+    {
+        if (pEvent->EventType == SoundEvent::k_end_of_score || modified[pEvent->Measure])
+            delete pEvent;
+        else
+            events.push_back(pEvent);
+    }
+    m_events.clear();
+
+    //create the new events. Modified measures only contain note/rest events, but all
+    //the score must be traversed as the cursor provides the context for them
+    StaffObjsCursor cursor(m_pScore);
+    m_semitones.assign(cursor.get_num_staves(), 0);
+    while(!cursor.is_end())
+    {
+        int measure = cursor.measure() + 1;
+        ImoStaffObj* pSO = cursor.get_staffobj();
+        if (pSO->is_note_rest())
+        {
+            if (modified[measure] && !pSO->is_cue_note())
+                add_noterest_events(cursor, measure);
+        }
+        else if (pSO->is_transpose())
+        {
+            ImoTranspose* pTrp = static_cast<ImoTranspose*>(pSO);
+            save_transposition_information(cursor, cursor.num_instrument(), pTrp);
+        }
+        cursor.move_next();
+    }
+    sort_by_time(m_events);
+
+    //merge the new events with the remaining ones
+    vector<SoundEvent*> newEvents;
+    newEvents.swap(m_events);
+    m_events.reserve(events.size() + newEvents.size() + 1);
+    std::merge(events.begin(), events.end(), newEvents.begin(), newEvents.end(),
+               back_inserter(m_events), is_before);
+
+    //rebuild the tables that depend on events position
+    close_table();
+    m_measures.clear();
+    create_measures_table();
+    add_events_to_jumps();
+    delete_measures_jumps_table();
+    delete m_pTimeline;
+    m_pTimeline = nullptr;
+    delete m_pTempoMap;
+    m_pTempoMap = nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+size_t SoundEventsTable::compute_signatures(vector<size_t>& signatures,
+                                            vector<bool>& structural)
+{
+    //Computes the signature of each measure (1..n) and returns the signature for
+    //the information not related to measures
+
+    signatures.assign(2, 0);
+    structural.assign(2, false);
+
+    size_t globalSignature = 0;
+    int numInstruments = m_pScore->get_num_instruments();
+    add_to_signature(globalSignature, size_t(numInstruments));
+    for (int iInstr = 0; iInstr < numInstruments; iInstr++)
+    {
+        ImoInstrument* pInstr = m_pScore->get_instrument(iInstr);
+        add_to_signature(globalSignature, size_t(pInstr->get_num_staves()));
+        if (pInstr->get_num_sounds() > 0)
+        {
+            ImoMidiInfo* pMidi = pInstr->get_sound_info(0)->get_midi_info();
+            add_to_signature(globalSignature, size_t(pMidi->get_midi_channel()));
+            add_to_signature(globalSignature, size_t(pMidi->get_midi_program()));
+        }
+    }
+
+    ColStaffObjs* pColStaffObjs = m_pScore->get_staffobjs_table();
+    if (!pColStaffObjs)
+        return globalSignature;
+
+    add_to_signature(globalSignature,
+                     std::hash<double>()(pColStaffObjs->anacrusis_missing_time()));
+    add_to_signature(globalSignature,
+                     std::hash<double>()(pColStaffObjs->anacrusis_extra_time()));
+
+    for (ColStaffObjsEntry* pEntry = pColStaffObjs->front(); pEntry;
+         pEntry = pEntry->get_next())
+    {
+        size_t measure = size_t(pEntry->measure() + 1);
+        if (measure + 1 >= signatures.size())
+        {
+            signatures.resize(measure + 2, 0);
+            structural.resize(measure + 2, false);
+        }
+        add_to_signature(signatures[measure], compute_signature(pEntry));
+        if (is_structural(pEntry->imo_object()))
+            structural[measure] = true;
+    }
+
+    return globalSignature;
+}
+
+//---------------------------------------------------------------------------------------
+size_t SoundEventsTable::compute_signature(ColStaffObjsEntry* pEntry)
+{
+    //all information used for creating the events for a note/rest
+
+    ImoStaffObj* pSO = pEntry->imo_object();
+    size_t seed = 0;
+    add_to_signature(seed, std::hash<void*>()(pSO));
+    add_to_signature(seed, size_t(pSO->get_id()));
+    add_to_signature(seed, size_t(pSO->get_obj_type()));
+    add_to_signature(seed, size_t(pEntry->num_instrument()));
+    add_to_signature(seed, size_t(pEntry->staff()));
+    add_to_signature(seed, std::hash<double>()(pSO->get_time()));
+
+    if (pSO->is_note_rest())
+    {
+        ImoNoteRest* pNR = static_cast<ImoNoteRest*>(pSO);
+        add_to_signature(seed, std::hash<double>()(pNR->get_playback_time()));
+        add_to_signature(seed, std::hash<double>()(pNR->get_playback_duration()));
+        add_to_signature(seed, size_t(pNR->is_visible()));
+        add_to_signature(seed, size_t(pNR->is_cue_note()));
+        if (pNR->is_note())
+        {
+            ImoNote* pNote = static_cast<ImoNote*>(pNR);
+            add_to_signature(seed, size_t(int(pNote->get_midi_pitch())));
+            add_to_signature(seed, size_t(pNote->is_tied_prev()));
+            add_to_signature(seed, size_t(pNote->is_tied_next()));
+            add_to_signature(seed, size_t(pNote->is_muted()));
+        }
+    }
+    else if (pSO->is_barline())
+    {
+        ImoBarline* pBar = static_cast<ImoBarline*>(pSO);
+        add_to_signature(seed, size_t(pBar->get_type()));
+        add_to_signature(seed, size_t(pBar->get_num_repeats()));
+        add_to_signature(seed, size_t(pBar->get_num_relations()));
+    }
+    return seed;
+}
+
+//---------------------------------------------------------------------------------------
+bool SoundEventsTable::is_structural(ImoStaffObj* pSO)
+{
+    //objects whose events affect other measures or that require to process
+    //previous measures
+
+    if (pSO->is_barline())
+    {
+        ImoBarline* pBar = static_cast<ImoBarline*>(pSO);
+        int type = pBar->get_type();
+        return type == k_barline_start_repetition
+               || type == k_barline_end_repetition
+               || type == k_barline_double_repetition
+               || type == k_barline_double_repetition_alt
+               || pBar->get_num_relations() > 0;
+    }
+
+    if (pSO->is_direction())
+    {
+        return pSO->get_child_of_type(k_imo_sound_change) != nullptr
+               || pSO->find_attachment(k_imo_metronome_mark) != nullptr;
+    }
+
+    return pSO->is_time_signature() || pSO->is_sound_change() || pSO->is_transpose();
 }
 
 //---------------------------------------------------------------------------------------
@@ -180,6 +445,8 @@ void SoundEventsTable::create_events()
         }
         else if (pSO->is_direction())
         {
+            add_tempo_change_if_metronome_mark(pSO);
+
             ImoSoundChange* pSound = static_cast<ImoSoundChange*>(
                                           pSO->get_child_of_type(k_imo_sound_change));
             if (pSound)
@@ -257,6 +524,8 @@ void SoundEventsTable::process_sound_change(ImoSoundChange* pSound,
             case k_attr_time_only:
                 break;
             case k_attr_tempo:
+                add_tempo_change(cursor.get_staffobj()->get_time(),
+                                 pSound->get_float_attribute(k_attr_tempo));
                 break;
             default:
                 break;
@@ -265,6 +534,35 @@ void SoundEventsTable::process_sound_change(ImoSoundChange* pSound,
     }
 }
 
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::add_tempo_change_if_metronome_mark(ImoStaffObj* pSO)
+{
+    //Only marks of type 'note = value' define a tempo. If there is also a sound
+    //tempo attribute it will replace this one, as it is processed later.
+
+    ImoMetronomeMark* pMark =
+        static_cast<ImoMetronomeMark*>( pSO->find_attachment(k_imo_metronome_mark) );
+    if (!pMark || pMark->get_mark_type() != ImoMetronomeMark::k_note_value)
+        return;
+
+    TimeUnits beat = to_duration(pMark->get_left_note_type(), pMark->get_left_dots());
+    float qpm = float(pMark->get_ticks_per_minute()) * float(beat / k_duration_quarter);
+    add_tempo_change(pSO->get_time(), qpm);
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::add_tempo_change(TimeUnits rTime, float qpm)
+{
+    if (qpm <= 0.0f)
+        return;
+
+    //same change in several instruments: keep last one
+    if (!m_tempoChanges.empty() && is_equal_time(m_tempoChanges.back().first, rTime))
+        m_tempoChanges.back().second = qpm;
+    else
+        m_tempoChanges.push_back( make_pair(rTime, qpm) );
+}
+
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::add_jumps_if_volta_bracket(StaffObjsCursor& cursor,
                                                   ImoBarline* pBar, int measure)
@@ -479,12 +777,27 @@ void SoundEventsTable::create_measures_table()
 
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::sort_by_time()
+{
+    sort_by_time(m_events);
+}
+
+//---------------------------------------------------------------------------------------
+bool SoundEventsTable::is_before(SoundEvent* pEv1, SoundEvent* pEv2)
+{
+    return (pEv1->DeltaTime < pEv2->DeltaTime) ||
+           ((pEv1->DeltaTime == pEv2->DeltaTime) &&
+            ((pEv1->Measure < pEv2->Measure) ||
+             (pEv1->EventType < pEv2->EventType)));
+}
+
+//---------------------------------------------------------------------------------------
+void SoundEventsTable::sort_by_time(vector<SoundEvent*>& events)
 {
     // Sort events by time, measure and event type. Uses the bubble sort algorithm
 
     int j, k;
     bool fChanges;
-    int nNumElements = int(m_events.size());
+    int nNumElements = int(events.size());
     SoundEvent* pEvAux;
 
     for (int i = 0; i < nNumElements; i++)
@@ -495,15 +808,12 @@ void SoundEventsTable::sort_by_time()
         while ( j != i )
         {
             k = j - 1;
-            if ((m_events[j]->DeltaTime < m_events[k]->DeltaTime) ||
-                ((m_events[j]->DeltaTime == m_events[k]->DeltaTime) &&
-                 ((m_events[j]->Measure < m_events[k]->Measure) ||
-                  (m_events[j]->EventType < m_events[k]->EventType))))
+            if (is_before(events[j], events[k]))
             {
                 //interchange elements
-                pEvAux = m_events[j];
-                m_events[j] = m_events[k];
-                m_events[k] = pEvAux;
+                pEvAux = events[j];
+                events[j] = events[k];
+                events[k] = pEvAux;
                 fChanges = true;
             }
             j = k;
@@ -809,6 +1119,22 @@ vector<MeasuresJumpsEntry*> SoundEventsTable::get_measures_jumps()
     return m_measuresJumps;
 }
 
+//---------------------------------------------------------------------------------------
+PlaybackTimeline* SoundEventsTable::get_timeline()
+{
+    if (!m_pTimeline)
+        m_pTimeline = LOMSE_NEW PlaybackTimeline(this);
+    return m_pTimeline;
+}
+
+//---------------------------------------------------------------------------------------
+TempoMap* SoundEventsTable::get_tempo_map()
+{
+    if (!m_pTempoMap)
+        m_pTempoMap = LOMSE_NEW TempoMap(this);
+    return m_pTempoMap;
+}
+
 //---------------------------------------------------------------------------------------
 void SoundEventsTable::save_transposition_information(StaffObjsCursor& cursor,
                                                       int iInstr, ImoTranspose* pTrp)
@@ -898,6 +1224,360 @@ string MeasuresJumpsEntry::dump_entry()
 }
 
 
+//=======================================================================================
+// PlaybackTimeline implementation
+//=======================================================================================
+PlaybackTimeline::PlaybackTimeline(SoundEventsTable* pTable)
+    : m_pTable(pTable)
+    , m_duration(0L)
+{
+    create_segments();
+}
 
-}   //namespace lomse
+//---------------------------------------------------------------------------------------
+void PlaybackTimeline::create_segments()
+{
+    //traverse the events table as if it were played back (see ScorePlayer::do_play)
+    //and create a segment each time a new measure starts or a jump is executed.
+
+    vector<SoundEvent*>& events = m_pTable->get_events();
+    int numEvents = int(events.size());
+    int numMeasures = m_pTable->get_num_measures();
+    int numJumps = m_pTable->num_jumps();
+    m_passes.assign(numMeasures + 1, vector<int>());
+
+    //To protect against endless loops in badly defined repetitions
+    const int maxSegments = 100 * (numMeasures + 1);
+
+    m_pTable->reset_jumps();
+    long shift = 0L;        //to convert table times to playback times
+    int curMeasure = -1;
+    int i = 0;
+    while (i < numEvents && int(m_segments.size()) < maxSegments)
+    {
+        SoundEvent* pEvent = events[i];
+        long time = pEvent->DeltaTime + shift;
+        m_duration = max(m_duration, time);
 
+        if (pEvent->EventType == SoundEvent::k_end_of_score)
+            break;
+
+        if (pEvent->EventType == SoundEvent::k_jump)
+        {
+            bool fExecuted = false;
+            JumpEntry* pJump = pEvent->pJump;
+            if (pJump->get_visited() >= pJump->get_times_before())
+            {
+                if (pJump->get_times_valid() == 0
+                    || pJump->get_times_valid() > pJump->get_executed())
+                {
+                    i = pJump->get_event();
+                    shift = time - events[i]->DeltaTime;
+                    if (pJump->get_times_valid() > pJump->get_executed())
+                        pJump->increment_applied();
+                    fExecuted = true;
+                    curMeasure = -1;    //force a new segment
+                }
+            }
+
+            pJump->increment_visited();
+
+            if (!fExecuted)
+                ++i;
+
+            continue;
+        }
+
+        int measure = pEvent->Measure;
+        if (measure != curMeasure && measure > 0 && measure <= numMeasures)
+        {
+            int pass = int(m_passes[measure].size()) + 1;
+            m_passes[measure].push_back(int(m_segments.size()));
+            m_segments.push_back( PlaybackSegment(measure, pass, i, pEvent->DeltaTime,
+                                                  time) );
+            PlaybackSegment& segment = m_segments.back();
+            segment.jumps.reserve(numJumps);
+            for (int j=0; j < numJumps; ++j)
+            {
+                JumpEntry* pJump = m_pTable->get_jump(j);
+                segment.jumps.push_back( make_pair(pJump->get_executed(),
+                                                   pJump->get_visited()) );
+            }
+            curMeasure = measure;
+        }
+        ++i;
+    }
+    m_pTable->reset_jumps();
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackTimeline::find_segment_at(long time)
+{
+    //returns the segment being played at the given time, or -1 if time is before
+    //start of first segment
+
+    if (m_segments.empty() || time < m_segments.front().time)
+        return -1;
+
+    //binary search for the last segment starting at or before time
+    int first = 0;
+    int last = int(m_segments.size()) - 1;
+    while (first < last)
+    {
+        int mid = (first + last + 1) / 2;
+        if (m_segments[mid].time <= time)
+            first = mid;
+        else
+            last = mid - 1;
+    }
+    return first;
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackTimeline::find_segment(int measure, int pass)
+{
+    if (measure < 1 || measure >= int(m_passes.size())
+        || pass < 1 || pass > int(m_passes[measure].size()))
+    {
+        return -1;
+    }
+    return m_passes[measure][pass - 1];
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackTimeline::num_passes(int measure)
+{
+    if (measure < 1 || measure >= int(m_passes.size()))
+        return 0;
+    return int(m_passes[measure].size());
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTimeline::restore_jumps(int iSegment)
+{
+    if (iSegment < 0 || iSegment >= int(m_segments.size()))
+    {
+        m_pTable->reset_jumps();
+        return;
+    }
+
+    vector< pair<int, int> >& jumps = m_segments[iSegment].jumps;
+    for (int j=0; j < int(jumps.size()); ++j)
+        m_pTable->get_jump(j)->set_state(jumps[j].first, jumps[j].second);
+}
+
+//---------------------------------------------------------------------------------------
+string PlaybackTimeline::dump_timeline()
+{
+    stringstream msg;
+    msg << "Playback timeline (" << m_segments.size() << " segments, duration="
+        << m_duration << ")\n";
+    msg << "Num.\tMeas.\tPass\tEvent\tTimepos\tTime\n";
+    for (int i=0; i < int(m_segments.size()); ++i)
+    {
+        PlaybackSegment& segment = m_segments[i];
+        msg << i << ":\t" << segment.measure << "\t" << segment.pass << "\t"
+            << segment.event << "\t" << segment.timepos << "\t" << segment.time << "\n";
+    }
+    return msg.str();
+}
+
+
+//=======================================================================================
+// TempoMap implementation
+//=======================================================================================
+TempoMap::TempoMap(SoundEventsTable* pTable)
+    : m_pTable(pTable)
+    , m_baseTempo(60.0f)
+    , m_overrideTempo(0.0f)
+{
+    create_breakpoints();
+    compute_times();
+}
+
+//---------------------------------------------------------------------------------------
+void TempoMap::create_breakpoints()
+{
+    //first breakpoint at start of score, with base tempo. Then one breakpoint for
+    //each tempo change. A tempo change at start of score replaces the base tempo
+
+    vector< pair<TimeUnits, float> > changes = m_pTable->get_tempo_changes();
+    stable_sort(changes.begin(), changes.end(),
+                [](const pair<TimeUnits, float>& a, const pair<TimeUnits, float>& b)
+                { return a.first < b.first; });
+
+    m_breakpoints.clear();
+    m_breakpoints.push_back({0.0, 0.0f, 0.0, 0.0});     //0.0f: use base tempo
+    for (auto& change : changes)
+    {
+        Breakpoint& last = m_breakpoints.back();
+        if (is_equal_time(change.first, last.timepos) || change.first < 0.0)
+            last.scoreTempo = change.second;
+        else
+            m_breakpoints.push_back({change.first, change.second, 0.0, 0.0});
+    }
+
+    //assign breakpoint to each event. Events are ordered by time
+    vector<SoundEvent*>& events = m_pTable->get_events();
+    m_eventBreakpoint.resize(events.size());
+    int iBreakpoint = 0;
+    int maxBreakpoint = int(m_breakpoints.size()) - 1;
+    for (size_t i=0; i < events.size(); ++i)
+    {
+        TimeUnits timepos = TimeUnits(events[i]->DeltaTime);
+        while (iBreakpoint < maxBreakpoint
+               && !is_lower_time(timepos, m_breakpoints[iBreakpoint + 1].timepos))
+        {
+            ++iBreakpoint;
+        }
+        m_eventBreakpoint[i] = iBreakpoint;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void TempoMap::compute_times()
+{
+    //tempo and start time for each breakpoint. O(number of breakpoints)
+
+    double us = 0.0;
+    float tempo = m_baseTempo;
+    for (size_t i=0; i < m_breakpoints.size(); ++i)
+    {
+        Breakpoint& bp = m_breakpoints[i];
+        if (i > 0)
+        {
+            Breakpoint& prev = m_breakpoints[i - 1];
+            us += (bp.timepos - prev.timepos) * prev.usPerTU;
+        }
+        if (bp.scoreTempo > 0.0f)
+            tempo = bp.scoreTempo;
+
+        float qpm = (m_overrideTempo > 0.0f ? m_overrideTempo : tempo);
+        bp.usPerTU = 60000000.0 / (double(qpm) * double(k_duration_quarter));
+        bp.us = us;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void TempoMap::set_base_tempo(float qpm)
+{
+    if (qpm <= 0.0f)
+        return;
+
+    m_baseTempo = qpm;
+    compute_times();
+}
+
+//---------------------------------------------------------------------------------------
+void TempoMap::set_tempo_override(float qpm)
+{
+    m_overrideTempo = max(0.0f, qpm);
+    compute_times();
+}
+
+//---------------------------------------------------------------------------------------
+int TempoMap::find_breakpoint(TimeUnits timepos)
+{
+    //last breakpoint with timepos lower or equal than given timepos
+
+    int lo = 0;
+    int hi = int(m_breakpoints.size()) - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (is_lower_time(timepos, m_breakpoints[mid].timepos))
+            hi = mid - 1;
+        else
+            lo = mid;
+    }
+    return lo;
+}
+
+//---------------------------------------------------------------------------------------
+double TempoMap::time_at(int iBreakpoint, TimeUnits timepos)
+{
+    Breakpoint& bp = m_breakpoints[iBreakpoint];
+    return max(0.0, bp.us + (timepos - bp.timepos) * bp.usPerTU);
+}
+
+//---------------------------------------------------------------------------------------
+float TempoMap::get_breakpoint_tempo(int i)
+{
+    return float(60000000.0 / (m_breakpoints[i].usPerTU * double(k_duration_quarter)));
+}
+
+//---------------------------------------------------------------------------------------
+float TempoMap::get_breakpoint_score_tempo(int i)
+{
+    //tempo marked in the score, ignoring the tempo override
+    for (; i >= 0; --i)
+    {
+        if (m_breakpoints[i].scoreTempo > 0.0f)
+            return m_breakpoints[i].scoreTempo;
+    }
+    return m_baseTempo;
+}
+
+//---------------------------------------------------------------------------------------
+float TempoMap::get_tempo_at(TimeUnits timepos)
+{
+    return get_breakpoint_tempo( find_breakpoint(timepos) );
+}
+
+//---------------------------------------------------------------------------------------
+uint64_t TempoMap::get_event_time(int iEvent)
+{
+    TimeUnits timepos = TimeUnits(m_pTable->get_events()[iEvent]->DeltaTime);
+    return uint64_t( time_at(m_eventBreakpoint[iEvent], timepos) + 0.5 );
+}
+
+//---------------------------------------------------------------------------------------
+uint64_t TempoMap::get_time_for(TimeUnits timepos)
+{
+    return uint64_t( time_at(find_breakpoint(timepos), timepos) + 0.5 );
+}
+
+//---------------------------------------------------------------------------------------
+uint64_t TempoMap::get_duration(TimeUnits fromTimepos, TimeUnits toTimepos)
+{
+    uint64_t from = get_time_for(fromTimepos);
+    uint64_t to = get_time_for(toTimepos);
+    return (to > from ? to - from : 0);
+}
+
+//---------------------------------------------------------------------------------------
+TimeUnits TempoMap::get_timepos_for(uint64_t us)
+{
+    //last breakpoint starting before the given time
+    int lo = 0;
+    int hi = int(m_breakpoints.size()) - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (double(us) < m_breakpoints[mid].us)
+            hi = mid - 1;
+        else
+            lo = mid;
+    }
+    Breakpoint& bp = m_breakpoints[lo];
+    return bp.timepos + TimeUnits( (double(us) - bp.us) / bp.usPerTU );
+}
+
+//---------------------------------------------------------------------------------------
+string TempoMap::dump_tempo_map()
+{
+    stringstream ss;
+    ss << "Tempo map (" << m_breakpoints.size() << " breakpoints, base tempo="
+       << m_baseTempo << ", override=" << m_overrideTempo << ")" << endl
+       << "Num.\tTimepos\tTempo\tTime(us)" << endl;
+    for (size_t i=0; i < m_breakpoints.size(); ++i)
+    {
+        Breakpoint& bp = m_breakpoints[i];
+        ss << i << ":\t" << bp.timepos << "\t" << get_breakpoint_tempo(int(i))
+           << "\t" << uint64_t(bp.us + 0.5) << endl;
+    }
+    return ss.str();
+}
+
+
+}   //namespace lomse
@@ -0,0 +1,687 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_config.h"
+#if (LOMSE_ENABLE_THREADS == 1)
+
+#include "lomse_playback_engine.h"
+
+#include "lomse_midi_table.h"
+#include "lomse_internal_model.h"
+#include "lomse_logger.h"
+
+#include <algorithm>    //max(), min()
+
+using namespace std;
+using namespace std::chrono;
+
+namespace lomse
+{
+
+//=======================================================================================
+// PlaybackSession implementation
+//=======================================================================================
+PlaybackSession::PlaybackSession(PlaybackEngine* pEngine, ImoScore* pScore,
+                                 SoundEventsTable* pTable, MidiServerBase* pMidi)
+    : m_pEngine(pEngine)
+    , m_pScore(pScore)
+    , m_pTable(nullptr)
+    , m_pNewTable(pTable)
+    , m_pMidi(pMidi)
+    , m_state(k_stopped)
+    , m_generation(0)
+    , m_iEvent(0)
+    , m_iEnd(-1)
+    , m_shift(0L)
+    , m_nMM(60L)
+    , m_msPerTU(0.0)
+    , m_anchorTU(0.0)
+    , m_anchorMs(0.0)
+    , m_pCallbackObj(nullptr)
+    , m_pCallback(nullptr)
+{
+    refresh_table();
+    set_speed(m_nMM);
+}
+
+//---------------------------------------------------------------------------------------
+PlaybackSession::~PlaybackSession()
+{
+    m_pTable->remove_user();
+    if (m_pNewTable)
+        m_pNewTable->remove_user();
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::update_table()
+{
+    //The table is obtained in the caller thread, as it could be created or updated
+    //from the score. The session is a user of the table since then, so the score
+    //will not modify it
+
+    SoundEventsTable* pTable = m_pScore->get_midi_table();
+    pTable->add_user();
+
+    lock_guard<mutex> lock(m_pEngine->m_mutex);
+    if (m_pNewTable)
+        m_pNewTable->remove_user();
+    m_pNewTable = pTable;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::refresh_table()
+{
+    //use the updated table, if any. Invoked only when stopped, so the previous table
+    //is no longer used by this session
+
+    if (!m_pNewTable)
+        return;
+
+    if (m_pTable)
+        m_pTable->remove_user();
+    m_pTable = m_pNewTable;
+    m_pNewTable = nullptr;
+
+    //jumps state is kept in the session, as the table could be shared with
+    //other sessions
+    int numJumps = m_pTable->num_jumps();
+    m_jumps.resize(numJumps);
+    m_jumpIndex.clear();
+    for (int i=0; i < numJumps; ++i)
+        m_jumpIndex[m_pTable->get_jump(i)] = i;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::play(long nMM)
+{
+    unique_lock<mutex> lock(m_pEngine->m_mutex);
+
+    stop_and_silence(lock);
+    refresh_table();
+
+    int iStart = m_pTable->get_first_event_for_measure(1);
+    do_play(iStart, m_pTable->get_last_event(), nMM);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::play_measures(int startMeasure, int numMeasures, long nMM)
+{
+    unique_lock<mutex> lock(m_pEngine->m_mutex);
+
+    stop_and_silence(lock);
+    refresh_table();
+    do_play_measures(startMeasure, numMeasures, nMM);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::play_from_measure(int startMeasure, long nMM)
+{
+    unique_lock<mutex> lock(m_pEngine->m_mutex);
+
+    stop_and_silence(lock);
+    refresh_table();
+    do_play_measures(startMeasure, m_pTable->get_num_measures(), nMM);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::do_play_measures(int startMeasure, int numMeasures, long nMM)
+{
+    //same rules than ScorePlayer::play_measures()
+    int iStart = m_pTable->get_first_event_for_measure(startMeasure);
+    int maxMeasure = m_pTable->get_num_measures();
+    while (iStart == -1 && startMeasure < maxMeasure)
+        iStart = m_pTable->get_first_event_for_measure(++startMeasure);
+
+    if (iStart == -1)
+        return;     //all measures are empty after selected one!
+
+    int lastMeasure = min(startMeasure + numMeasures, maxMeasure+1);
+    int iEnd;
+    if (lastMeasure > maxMeasure)
+        iEnd = m_pTable->get_last_event();
+    else
+        iEnd = m_pTable->get_first_event_for_measure(lastMeasure) - 1;
+
+    do_play(iStart, iEnd, nMM);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::pause()
+{
+    unique_lock<mutex> lock(m_pEngine->m_mutex);
+
+    steady_clock::time_point now = steady_clock::now();
+    if (m_state == k_playing)
+    {
+        reanchor(now);
+        m_state = k_paused;
+        ++m_generation;
+        m_pEngine->wait_for_delivery(lock);
+        lock.unlock();
+        m_pMidi->all_sounds_off();
+    }
+    else if (m_state == k_paused)
+    {
+        m_anchor = now;
+        m_state = k_playing;
+        m_pEngine->schedule(this);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::stop()
+{
+    unique_lock<mutex> lock(m_pEngine->m_mutex);
+    stop_and_silence(lock);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::set_tempo(long nMM)
+{
+    lock_guard<mutex> lock(m_pEngine->m_mutex);
+
+    if (m_state != k_stopped)
+        reanchor(steady_clock::now());
+
+    set_speed(nMM);
+
+    if (m_state == k_playing)
+        m_pEngine->schedule(this);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::set_end_of_playback_callback(void* pThis,
+                                              void (*pt2Func)(void*, PlaybackSession*))
+{
+    lock_guard<mutex> lock(m_pEngine->m_mutex);
+    m_pCallbackObj = pThis;
+    m_pCallback = pt2Func;
+}
+
+//---------------------------------------------------------------------------------------
+bool PlaybackSession::is_playing()
+{
+    lock_guard<mutex> lock(m_pEngine->m_mutex);
+    return m_state == k_playing;
+}
+
+//---------------------------------------------------------------------------------------
+bool PlaybackSession::is_paused()
+{
+    lock_guard<mutex> lock(m_pEngine->m_mutex);
+    return m_state == k_paused;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::do_play(int iStart, int iEnd, long nMM)
+{
+    if (m_state != k_stopped)
+        do_stop();
+
+    if (iStart < 0 || iEnd < iStart)
+        return;
+
+    m_iEvent = iStart;
+    m_iEnd = iEnd;
+    m_shift = 0L;
+    std::fill(m_jumps.begin(), m_jumps.end(), make_pair(0, 0));
+    m_midiEvents.clear();
+
+    set_speed(nMM);
+    m_anchor = steady_clock::now();
+    m_anchorTU = double(m_pTable->get_events()[iStart]->DeltaTime);
+    m_anchorMs = 0.0;
+    m_state = k_playing;
+
+    m_pEngine->schedule(this);
+}
+
+//---------------------------------------------------------------------------------------
+bool PlaybackSession::do_stop()
+{
+    //Returns true if playback was stopped. In this case the caller must invoke
+    //all_sounds_off() after releasing the engine lock
+
+    if (m_state == k_stopped)
+        return false;
+
+    m_state = k_stopped;
+    ++m_generation;
+    m_midiEvents.clear();
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::stop_and_silence(unique_lock<mutex>& lock)
+{
+    //Stop playback and silence the MIDI server. The server is invoked without lock,
+    //once the engine has delivered the requests already collected for this session
+
+    if (!do_stop())
+        return;
+
+    m_pEngine->wait_for_delivery(lock);
+    lock.unlock();
+    m_pMidi->all_sounds_off();
+    lock.lock();
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::set_speed(long nMM)
+{
+    //Same conversion than in ScorePlayer, with a quarter note beat
+    m_nMM = max(1L, nMM);
+    long interval = 60000L / m_nMM;
+    m_msPerTU = double(interval) / double(k_duration_quarter);
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::reanchor(steady_clock::time_point now)
+{
+    //Move the time reference to current time. When paused the reference
+    //is not moved, as time is stopped
+
+    if (m_state != k_playing)
+        return;
+
+    double tu = current_tu(now);
+    m_anchorMs += (tu - m_anchorTU) * m_msPerTU;
+    m_anchorTU = tu;
+    m_anchor = now;
+}
+
+//---------------------------------------------------------------------------------------
+double PlaybackSession::current_tu(steady_clock::time_point now)
+{
+    //score time for given wall time. It never goes beyond next event, as this
+    //event is not yet processed
+
+    double elapsedMs = duration<double, milli>(now - m_anchor).count();
+    double tu = m_anchorTU + elapsedMs / m_msPerTU;
+    if (m_iEvent <= m_iEnd)
+    {
+        double nextTU = double(m_pTable->get_events()[m_iEvent]->DeltaTime + m_shift);
+        tu = min(tu, nextTU);
+    }
+    return max(tu, m_anchorTU);
+}
+
+//---------------------------------------------------------------------------------------
+steady_clock::time_point PlaybackSession::time_for(double tu)
+{
+    double ms = (tu - m_anchorTU) * m_msPerTU;
+    return m_anchor + duration_cast<steady_clock::duration>(duration<double, milli>(ms));
+}
+
+//---------------------------------------------------------------------------------------
+bool PlaybackSession::process(steady_clock::time_point now)
+{
+    //Process all events due at given time. Returns false when the end of the
+    //segment to play is reached.
+    //The rules for jumps are the same than in ScorePlayer::do_play()
+
+    vector<SoundEvent*>& events = m_pTable->get_events();
+    double batchTU = -1.0;
+    while (m_iEvent <= m_iEnd)
+    {
+        SoundEvent* pEvent = events[m_iEvent];
+        long time = pEvent->DeltaTime + m_shift;
+        if (time_for(double(time)) > now)
+            break;
+
+        if (double(time) != batchTU)
+        {
+            flush_midi_events(batchTU);
+            batchTU = double(time);
+        }
+
+        if (pEvent->EventType == SoundEvent::k_jump)
+        {
+            int iJump = m_jumpIndex[pEvent->pJump];
+            int& executed = m_jumps[iJump].first;
+            int& visited = m_jumps[iJump].second;
+            JumpEntry* pJump = pEvent->pJump;
+            bool fExecuted = false;
+            if (visited >= pJump->get_times_before()
+                && (pJump->get_times_valid() == 0 || pJump->get_times_valid() > executed))
+            {
+                m_iEvent = pJump->get_event();
+                m_shift = time - events[m_iEvent]->DeltaTime;
+                if (pJump->get_times_valid() > executed)
+                    ++executed;
+                fExecuted = true;
+            }
+            ++visited;
+            if (!fExecuted)
+                ++m_iEvent;
+            continue;
+        }
+
+        switch (pEvent->EventType)
+        {
+            case SoundEvent::k_prog_instr:
+                queue_midi_event(MidiEvent::k_voice_change, pEvent->Channel,
+                                 pEvent->Instrument);
+                break;
+
+            case SoundEvent::k_note_on:
+                queue_midi_event(MidiEvent::k_note_on, pEvent->Channel,
+                                 pEvent->NotePitch, pEvent->Volume);
+                break;
+
+            case SoundEvent::k_note_off:
+                queue_midi_event(MidiEvent::k_note_off, pEvent->Channel,
+                                 pEvent->NotePitch, 127);
+                break;
+
+            default:
+                //visual and rhythm change events are ignored
+                break;
+        }
+
+        if (pEvent->EventType == SoundEvent::k_end_of_score)
+            m_iEvent = m_iEnd;
+        ++m_iEvent;
+    }
+    flush_midi_events(batchTU);
+
+    if (m_iEvent > m_iEnd)
+    {
+        m_state = k_stopped;
+        ++m_generation;
+        return false;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::queue_midi_event(int type, int channel, int data1, int data2)
+{
+    m_midiEvents.push_back( MidiEvent(type, channel, data1, data2) );
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackSession::flush_midi_events(double tu)
+{
+    //requests are delivered by the engine thread after releasing the lock
+
+    if (m_midiEvents.empty())
+        return;
+
+    double ms = m_anchorMs + (tu - m_anchorTU) * m_msPerTU;
+    m_pEngine->m_requests.push_back({m_pMidi, ms, std::move(m_midiEvents)});
+    m_midiEvents.clear();
+}
+
+
+//=======================================================================================
+// PlaybackEngine implementation
+//=======================================================================================
+PlaybackEngine::PlaybackEngine(LibraryScope& libScope)
+    : m_libScope(libScope)
+    , m_fStop(false)
+    , m_fDelivering(false)
+    , m_pNotifying(nullptr)
+{
+    m_thread = std::thread(&PlaybackEngine::thread_main, this);
+}
+
+//---------------------------------------------------------------------------------------
+PlaybackEngine::~PlaybackEngine()
+{
+    vector<PlaybackSession*> stopped;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_fStop = true;
+        for (PlaybackSession* pSession : m_sessions)
+        {
+            if (pSession->do_stop())
+                stopped.push_back(pSession);
+        }
+    }
+    m_wakeUp.notify_all();
+    if (m_thread.joinable())
+        m_thread.join();
+
+    for (PlaybackSession* pSession : stopped)
+        pSession->m_pMidi->all_sounds_off();
+
+    for (PlaybackSession* pSession : m_sessions)
+        delete pSession;
+}
+
+//---------------------------------------------------------------------------------------
+PlaybackSession* PlaybackEngine::create_session(AScore score, MidiServerBase* pMidi)
+{
+    if (score.is_valid())
+        return create_session(score.internal_object(), pMidi);
+    return nullptr;
+}
+
+//---------------------------------------------------------------------------------------
+PlaybackSession* PlaybackEngine::create_session(ImoScore* pScore, MidiServerBase* pMidi)
+{
+    if (!pScore || !pMidi)
+        return nullptr;
+
+    //the events table is obtained in the caller thread, see
+    //PlaybackSession::update_table()
+    SoundEventsTable* pTable = pScore->get_midi_table();
+    pTable->add_user();
+
+    lock_guard<mutex> lock(m_mutex);
+    PlaybackSession* pSession = LOMSE_NEW PlaybackSession(this, pScore, pTable, pMidi);
+    m_sessions.push_back(pSession);
+    return pSession;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackEngine::delete_session(PlaybackSession* pSession)
+{
+    unique_lock<mutex> lock(m_mutex);
+
+    vector<PlaybackSession*>::iterator it = find(m_sessions.begin(), m_sessions.end(),
+                                                 pSession);
+    if (it == m_sessions.end())
+        return;
+
+    bool fStopped = pSession->do_stop();
+    m_sessions.erase(it);
+
+    //remove all queue entries for this session
+    vector<ScheduledEvent> entries;
+    while (!m_queue.empty())
+    {
+        if (m_queue.top().pSession != pSession)
+            entries.push_back(m_queue.top());
+        m_queue.pop();
+    }
+    for (const ScheduledEvent& entry : entries)
+        m_queue.push(entry);
+
+    //the session must not be notified after deleting it
+    m_finished.erase( remove(m_finished.begin(), m_finished.end(), pSession),
+                      m_finished.end() );
+    wait_for_callback(pSession, lock);
+
+    //the MIDI server could be deleted after returning. Ensure that the engine
+    //is not using it
+    wait_for_delivery(lock);
+    lock.unlock();
+    if (fStopped)
+        pSession->m_pMidi->all_sounds_off();
+
+    delete pSession;
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackEngine::num_sessions()
+{
+    lock_guard<mutex> lock(m_mutex);
+    return int(m_sessions.size());
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackEngine::num_playing_sessions()
+{
+    lock_guard<mutex> lock(m_mutex);
+    int count = 0;
+    for (PlaybackSession* pSession : m_sessions)
+    {
+        if (pSession->m_state == PlaybackSession::k_playing)
+            ++count;
+    }
+    return count;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackEngine::schedule(PlaybackSession* pSession)
+{
+    //Add an entry for the next event of the session. Previous entries for this
+    //session become obsolete
+
+    ++pSession->m_generation;
+    if (pSession->m_iEvent > pSession->m_iEnd)
+        return;
+
+    SoundEvent* pEvent = pSession->m_pTable->get_events()[pSession->m_iEvent];
+    double tu = double(pEvent->DeltaTime + pSession->m_shift);
+    m_queue.push({pSession->time_for(tu), pSession, pSession->m_generation});
+    m_wakeUp.notify_one();
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackEngine::wait_for_delivery(unique_lock<mutex>& lock)
+{
+    //Wait until the requests collected by the engine thread are delivered. When
+    //invoked from the engine thread (i.e. from the MIDI server) there is no need to
+    //wait, as delivery is in progress in this same thread
+
+    if (this_thread::get_id() != m_thread.get_id())
+        m_delivered.wait(lock, [this]{ return !m_fDelivering; });
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackEngine::wait_for_callback(PlaybackSession* pSession,
+                                       unique_lock<mutex>& lock)
+{
+    //Wait until the end of playback callback for the session returns. When invoked
+    //from the engine thread (i.e. from the callback) there is no need to wait
+
+    if (this_thread::get_id() != m_thread.get_id())
+        m_notified.wait(lock, [this, pSession]{ return m_pNotifying != pSession; });
+}
+
+//---------------------------------------------------------------------------------------
+// Methods to be executed in the thread
+//---------------------------------------------------------------------------------------
+
+void PlaybackEngine::thread_main()
+{
+    LOMSE_LOG_DEBUG(Logger::k_score_player, ">> Enter");
+
+    unique_lock<mutex> lock(m_mutex);
+    while (!m_fStop)
+    {
+        if (m_queue.empty())
+        {
+            m_wakeUp.wait(lock);
+            continue;
+        }
+
+        steady_clock::time_point now = steady_clock::now();
+        if (m_queue.top().time > now)
+        {
+            m_wakeUp.wait_until(lock, m_queue.top().time);
+            continue;
+        }
+
+        //process all sessions with events due
+        while (!m_queue.empty() && m_queue.top().time <= now)
+        {
+            ScheduledEvent entry = m_queue.top();
+            m_queue.pop();
+
+            PlaybackSession* pSession = entry.pSession;
+            if (entry.generation != pSession->m_generation
+                || pSession->m_state != PlaybackSession::k_playing)
+            {
+                continue;   //obsolete entry
+            }
+
+            if (pSession->process(now))
+                schedule(pSession);
+            else if (pSession->m_pCallback)
+                m_finished.push_back(pSession);
+        }
+
+        deliver_requests(lock);
+        notify_end_of_playback(lock);
+    }
+
+    LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackEngine::deliver_requests(unique_lock<mutex>& lock)
+{
+    //Sound requests are delivered without lock, as the MIDI server could take
+    //time or invoke methods of the sessions
+
+    if (m_requests.empty())
+        return;
+
+    vector<MidiRequest> requests;
+    requests.swap(m_requests);
+    m_fDelivering = true;
+    lock.unlock();
+
+    for (MidiRequest& request : requests)
+    {
+        request.pMidi->set_playback_time(long(request.ms + 0.5));
+        request.pMidi->process_events(&request.events[0], request.events.size(),
+                                      uint64_t(request.ms * 1000.0 + 0.5));
+    }
+
+    lock.lock();
+    m_fDelivering = false;
+    m_delivered.notify_all();
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackEngine::notify_end_of_playback(unique_lock<mutex>& lock)
+{
+    //Callbacks are invoked without lock, as they could use the session or the
+    //engine. The sessions pending to notify are kept in m_finished, so that
+    //delete_session() can remove them, and m_pNotifying prevents deleting the
+    //session while its callback is running
+
+    while (!m_finished.empty())
+    {
+        PlaybackSession* pSession = m_finished.front();
+        m_finished.erase(m_finished.begin());
+        void* pCallbackObj = pSession->m_pCallbackObj;
+        void (*pCallback)(void*, PlaybackSession*) = pSession->m_pCallback;
+        if (!pCallback)
+            continue;   //callback removed after finishing
+        m_pNotifying = pSession;
+        lock.unlock();
+
+        pCallback(pCallbackObj, pSession);
+
+        lock.lock();
+        m_pNotifying = nullptr;
+        m_notified.notify_all();
+    }
+}
+
+
+}   //namespace lomse
+
+#endif  //LOMSE_ENABLE_THREADS == 1
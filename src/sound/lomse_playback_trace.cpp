@@ -0,0 +1,265 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_playback_trace.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace lomse
+{
+
+//---------------------------------------------------------------------------------------
+//names for record types
+static const char* m_recordNames[PlaybackTraceRecord::k_max_record] =
+{
+    "midi batch",
+    "tracking post",
+    "wake up",
+    "pause",
+    "resume",
+};
+
+//histogram buckets limits, in microseconds
+static const int64_t m_buckets[] = { 0, 100, 250, 500, 1000, 2000, 5000, 10000,
+                                     20000, 50000 };
+static const int k_num_buckets = int(sizeof(m_buckets) / sizeof(m_buckets[0]));
+
+
+//=======================================================================================
+// PlaybackTrace implementation
+//=======================================================================================
+PlaybackTrace::PlaybackTrace(size_t capacity)
+    : m_buffer(capacity)
+    , m_numDropped(0)
+    , m_start(steady_clock::now())
+    , m_paused(steady_clock::duration::zero())
+    , m_fPaused(false)
+{
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::start()
+{
+    m_start = steady_clock::now();
+    m_paused = steady_clock::duration::zero();
+    m_fPaused = false;
+}
+
+//---------------------------------------------------------------------------------------
+int64_t PlaybackTrace::now_us()
+{
+    steady_clock::time_point now = (m_fPaused ? m_pauseStart : steady_clock::now());
+    return int64_t( duration_cast<microseconds>(now - m_start - m_paused).count() );
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::pause(int64_t scheduledUs)
+{
+    if (m_fPaused)
+        return;
+
+    add_record(PlaybackTraceRecord::k_pause, scheduledUs, now_us(), 0);
+    m_pauseStart = steady_clock::now();
+    m_fPaused = true;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::resume(int64_t scheduledUs)
+{
+    if (!m_fPaused)
+        return;
+
+    steady_clock::duration paused = steady_clock::now() - m_pauseStart;
+    m_paused += paused;
+    m_fPaused = false;
+    add_record(PlaybackTraceRecord::k_resume, scheduledUs, now_us(),
+               int64_t( duration_cast<microseconds>(paused).count() ));
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::add_record(int type, int64_t scheduledUs, int64_t actualUs,
+                               int64_t durationUs, int numItems, int numNoteOn)
+{
+    PlaybackTraceRecord record;
+    record.type = type;
+    record.scheduledUs = scheduledUs;
+    record.actualUs = actualUs;
+    record.durationUs = durationUs;
+    record.numItems = numItems;
+    record.numNoteOn = numNoteOn;
+
+    if (!m_buffer.push(record))
+        ++m_numDropped;
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackTrace::collect()
+{
+    int count = 0;
+    PlaybackTraceRecord record;
+    while (m_buffer.pop(record))
+    {
+        m_records.push_back(record);
+        ++count;
+    }
+    return count;
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::clear()
+{
+    m_records.clear();
+    m_numDropped = 0;
+}
+
+//---------------------------------------------------------------------------------------
+int PlaybackTrace::count_records(int type, int64_t fromUs, int64_t toUs, bool fDuration)
+{
+    int count = 0;
+    for (const PlaybackTraceRecord& record : m_records)
+    {
+        int64_t value = (fDuration ? record.durationUs : record.lateness());
+        if (record.type == type && value >= fromUs && value < toUs)
+            ++count;
+    }
+    return count;
+}
+
+//---------------------------------------------------------------------------------------
+string PlaybackTrace::dump_summary()
+{
+    stringstream ss;
+    ss << "Playback trace: " << m_records.size() << " records, " << m_numDropped
+       << " dropped" << endl;
+
+    for (int type=0; type < PlaybackTraceRecord::k_max_record; ++type)
+    {
+        vector<int64_t> lateness;
+        vector<int64_t> durations;
+        for (const PlaybackTraceRecord& record : m_records)
+        {
+            if (record.type == type)
+            {
+                lateness.push_back(record.lateness());
+                durations.push_back(record.durationUs);
+            }
+        }
+        if (lateness.empty())
+            continue;
+
+        ss << endl << m_recordNames[type] << ": " << lateness.size() << " records" << endl;
+        if (is_pause_record(type))
+        {
+            //only the time paused is relevant
+            int64_t sum = 0;
+            for (int64_t value : durations)
+                sum += value;
+            if (type == PlaybackTraceRecord::k_resume)
+                ss << "    time paused (us): " << sum << endl;
+            continue;
+        }
+        for (int i=0; i < 2; ++i)
+        {
+            vector<int64_t>& values = (i == 0 ? lateness : durations);
+            sort(values.begin(), values.end());
+            int64_t sum = 0;
+            for (int64_t value : values)
+                sum += value;
+            size_t n = values.size();
+            ss << (i == 0 ? "    lateness (us): " : "    duration (us): ")
+               << "min=" << values.front()
+               << ", mean=" << sum / int64_t(n)
+               << ", p50=" << values[(n - 1) * 50 / 100]
+               << ", p95=" << values[(n - 1) * 95 / 100]
+               << ", p99=" << values[(n - 1) * 99 / 100]
+               << ", max=" << values.back() << endl;
+        }
+        dump_histogram(ss, type, false);
+        dump_histogram(ss, type, true);
+    }
+    return ss.str();
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::dump_histogram(ostream& out, int type, bool fDuration)
+{
+    out << (fDuration ? "    duration histogram:" : "    lateness histogram:") << endl;
+
+    int64_t k_min = numeric_limits<int64_t>::min();
+    int64_t k_max = numeric_limits<int64_t>::max();
+    for (int i=0; i <= k_num_buckets; ++i)
+    {
+        int64_t from = (i == 0 ? k_min : m_buckets[i-1]);
+        int64_t to = (i == k_num_buckets ? k_max : m_buckets[i]);
+        int count = count_records(type, from, to, fDuration);
+        if (count == 0)
+            continue;
+
+        stringstream range;
+        if (i == 0)
+            range << "< 0";
+        else if (i == k_num_buckets)
+            range << ">= " << from;
+        else
+            range << from << " - " << to;
+        out << "        " << setw(14) << left << range.str() << right
+            << setw(8) << count << endl;
+    }
+}
+
+//---------------------------------------------------------------------------------------
+void PlaybackTrace::write_chrome_trace(ostream& out)
+{
+    //Each record is a complete event ("X") in the sound thread track. Lateness is
+    //also added as a counter ("C") for displaying it as a graph. Pause and resume
+    //are instant events ("i")
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool fFirst = true;
+    for (const PlaybackTraceRecord& record : m_records)
+    {
+        if (!fFirst)
+            out << ",";
+        fFirst = false;
+
+        const char* name = m_recordNames[record.type];
+        if (is_pause_record(record.type))
+        {
+            out << endl << "{\"name\":\"" << name << "\",\"cat\":\"playback\",\"ph\":\"i\""
+                << ",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":" << record.actualUs
+                << ",\"args\":{\"scheduled_us\":" << record.scheduledUs
+                << ",\"paused_us\":" << record.durationUs << "}}";
+            continue;
+        }
+
+        out << endl << "{\"name\":\"" << name << "\",\"cat\":\"playback\",\"ph\":\"X\""
+            << ",\"pid\":1,\"tid\":1,\"ts\":" << record.actualUs
+            << ",\"dur\":" << record.durationUs
+            << ",\"args\":{\"scheduled_us\":" << record.scheduledUs
+            << ",\"lateness_us\":" << record.lateness()
+            << ",\"items\":" << record.numItems;
+        if (record.type == PlaybackTraceRecord::k_midi_batch)
+            out << ",\"note_on\":" << record.numNoteOn;
+        out << "}}";
+
+        out << "," << endl << "{\"name\":\"lateness\",\"ph\":\"C\",\"pid\":1"
+            << ",\"ts\":" << record.actualUs
+            << ",\"args\":{\"" << name << "\":" << record.lateness() << "}}";
+    }
+    out << endl << "]}" << endl;
+}
+
+
+}   //namespace lomse
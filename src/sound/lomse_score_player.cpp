@@ -24,13 +24,50 @@
 #include "lomse_im_note.h"
 
 #include <algorithm>    //max(), min()
-#include <ctime>        //clock()
+#include <chrono>
 
 
 namespace lomse
 {
 
-//---------------------------------------------------------------------------------------
+//Delay, in milliseconds, for considering that the sound thread is not on schedule
+const long k_max_sound_thread_delay = 10L;
+
+//=======================================================================================
+// MidiServerBase implementation
+//=======================================================================================
+void MidiServerBase::process_events(const MidiEvent* events, size_t n,
+                                    uint64_t UNUSED(timestampUs))
+{
+    //default implementation: adapter to the per-event methods
+
+    for (size_t i=0; i < n; ++i)
+    {
+        const MidiEvent& ev = events[i];
+        switch (ev.type)
+        {
+            case MidiEvent::k_note_on:
+                note_on(ev.channel, ev.data1, ev.data2);
+                break;
+            case MidiEvent::k_note_off:
+                note_off(ev.channel, ev.data1, ev.data2);
+                break;
+            case MidiEvent::k_voice_change:
+                voice_change(ev.channel, ev.data1);
+                break;
+            case MidiEvent::k_program_change:
+                program_change(ev.channel, ev.data1);
+                break;
+            default:
+                LOMSE_LOG_ERROR("Unknown MidiEvent type %d", ev.type);
+        }
+    }
+}
+
+
+//=======================================================================================
+// ScorePlayer implementation
+//=======================================================================================
 ScorePlayer::ScorePlayer(LibraryScope& libScope, MidiServerBase* pMidi)
     : m_libScope(libScope)
     , m_pThread(nullptr)
@@ -42,6 +79,9 @@ ScorePlayer::ScorePlayer(LibraryScope& libScope, MidiServerBase* pMidi)
     , m_fPostEvents(true)
     , m_fQuit(false)
     , m_fFinalEventSent(false)
+    , m_numStalls(0)
+    , m_fVirtualClock(false)
+    , m_playbackTime(0L)
     , m_pScore(nullptr)
     , m_pTable(nullptr)
     , m_MtrChannel(9)
@@ -75,6 +115,15 @@ ScorePlayer::~ScorePlayer()
     stop();
 }
 
+//---------------------------------------------------------------------------------------
+void ScorePlayer::enable_trace(bool value, size_t capacity)
+{
+    if (value)
+        m_pTrace.reset( LOMSE_NEW PlaybackTrace(capacity) );
+    else
+        m_pTrace.reset();
+}
+
 //---------------------------------------------------------------------------------------
 void ScorePlayer::load_score(ImoScore* pScore, PlayerGui* pPlayerGui,
                              int metronomeChannel, int metronomeInstr,
@@ -103,6 +152,16 @@ void ScorePlayer::load_score(AScore score, PlayerGui* pPlayerGui,
                    metronomeInstr, tone1, tone2);
 }
 
+//---------------------------------------------------------------------------------------
+void ScorePlayer::refresh_table()
+{
+    //The score could have been modified after loading it. When playing, the table in
+    //use is kept, as the sound thread is reading it
+
+    if (m_pScore && !m_fPlaying)
+        m_pTable = m_pScore->get_midi_table();
+}
+
 //---------------------------------------------------------------------------------------
 void ScorePlayer::play(bool fVisualTracking, long nMM, Interactor* pInteractor)
 {
@@ -111,6 +170,7 @@ void ScorePlayer::play(bool fVisualTracking, long nMM, Interactor* pInteractor)
     m_fVisualTracking = fVisualTracking;
     m_nMM = nMM;
     m_pInteractor = pInteractor;
+    refresh_table();
 
     int evStart = m_pTable->get_first_event_for_measure(1);
     int evEnd = m_pTable->get_last_event();
@@ -134,6 +194,7 @@ void ScorePlayer::play_from_measure(int nMeasure, bool fVisualTracking,
     m_fVisualTracking = fVisualTracking;
     m_nMM = nMM;
     m_pInteractor = pInteractor;
+    refresh_table();
 
     //remember:
     //   real measures 1..n correspond to table items 1..n
@@ -163,6 +224,7 @@ void ScorePlayer::play_measures(int startMeasure, int numMeasures, bool fVisualT
     m_fVisualTracking = fVisualTracking;
     m_nMM = nMM;
     m_pInteractor = pInteractor;
+    refresh_table();
 
     //remember:
     //   real measures 1..n correspond to table items 1..n
@@ -188,16 +250,126 @@ void ScorePlayer::play_measures(int startMeasure, int numMeasures, bool fVisualT
     play_segment(evStart, evEnd);
 }
 
+//---------------------------------------------------------------------------------------
+void ScorePlayer::play_from_pass(int nMeasure, int pass, bool fVisualTracking,
+                                 long nMM, Interactor* pInteractor)
+{
+    refresh_table();
+    PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+    int iSegment = pTimeline->find_segment(nMeasure, pass);
+    if (iSegment == -1)
+        return;     //the measure is empty or it is not played so many times
+
+    play_from_segment(iSegment, fVisualTracking, nMM, pInteractor);
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::play_from_time(long milliseconds, bool fVisualTracking,
+                                 long nMM, Interactor* pInteractor)
+{
+    refresh_table();
+    PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+    long time = long( float(milliseconds) / milliseconds_per_time_unit(nMM) );
+    int iSegment = max(0, pTimeline->find_segment_at(time));
+    if (iSegment >= pTimeline->num_segments())
+        return;     //empty score
+
+    play_from_segment(iSegment, fVisualTracking, nMM, pInteractor);
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::play_from_segment(int iSegment, bool fVisualTracking, long nMM,
+                                    Interactor* pInteractor)
+{
+    m_fVisualTracking = fVisualTracking;
+    m_nMM = nMM;
+    m_pInteractor = pInteractor;
+
+    //set jumps as when the segment is reached in normal playback
+    PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+    pTimeline->restore_jumps(iSegment);
+
+    int nEvStart = pTimeline->get_segment(iSegment).event;
+    int nEvEnd = m_pTable->get_last_event();
+
+    play_segment(nEvStart, nEvEnd);
+}
+
+//---------------------------------------------------------------------------------------
+long ScorePlayer::get_playback_duration(long nMM)
+{
+    refresh_table();
+    if (!m_pTable)
+        return 0L;
+
+    long duration = m_pTable->get_timeline()->get_duration();
+    return long( float(duration) * milliseconds_per_time_unit(nMM) );
+}
+
+//---------------------------------------------------------------------------------------
+long ScorePlayer::get_time_for_measure(int nMeasure, int pass, long nMM)
+{
+    refresh_table();
+    if (!m_pTable)
+        return -1L;
+
+    PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+    int iSegment = pTimeline->find_segment(nMeasure, pass);
+    if (iSegment == -1)
+        return -1L;
+
+    long time = pTimeline->get_segment(iSegment).time;
+    return long( float(time) * milliseconds_per_time_unit(nMM) );
+}
+
+//---------------------------------------------------------------------------------------
+int ScorePlayer::get_measure_for_time(long milliseconds, int* pPass, long nMM)
+{
+    refresh_table();
+    if (!m_pTable)
+        return 0;
+
+    PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+    long time = long( float(milliseconds) / milliseconds_per_time_unit(nMM) );
+    int iSegment = pTimeline->find_segment_at(time);
+    if (iSegment == -1 || time > pTimeline->get_duration())
+        return 0;
+
+    PlaybackSegment& segment = pTimeline->get_segment(iSegment);
+    if (pPass)
+        *pPass = segment.pass;
+    return segment.measure;
+}
+
+//---------------------------------------------------------------------------------------
+float ScorePlayer::milliseconds_per_time_unit(long nMM)
+{
+    //Same conversion factor than the one used in do_play()
+
+    if (nMM == 0)
+        nMM = (m_pPlayerGui ? m_pPlayerGui->get_metronome_mm() : 60L);
+    long interval = 60000L / max(1L, nMM);
+
+    long beatDuration = (m_pMtr ? long(m_pMtr->get_beat_duration())
+                                : long(k_duration_quarter));
+
+    return float(interval) / float(beatDuration);
+}
+
 //---------------------------------------------------------------------------------------
 void ScorePlayer::play_segment(int nEvStart, int nEvEnd)
 {
     LOMSE_LOG_DEBUG(Logger::k_score_player, ">>[ScorePlayer::play_segment]");
     m_fQuit = false;
     m_fFinalEventSent = false;
+    m_numStalls = 0;
+    if (m_pTrace)
+        m_pTrace->start();
 
     //Create a new thread. It starts immediately to execute do_play()
     m_pThread.reset();
     m_fPlaying = true;
+    m_pTable->add_user();
     m_startMutex.lock();
     m_pThread = std::unique_ptr<SoundThread>(
                     LOMSE_NEW SoundThread(&ScorePlayer::thread_main, this,
@@ -216,6 +388,7 @@ void ScorePlayer::thread_main(int nEvStart, int nEvEnd, bool fVisualTracking,
     // waiting for "play_segment" to initialize "m_pThread"
     m_startMutex.lock();
     m_startMutex.unlock();
+    SoundEventsTable* pTable = m_pTable;
 
     if (pInteractor && !m_fPostEvents)
         pInteractor->enable_forced_view_updates(false);
@@ -237,6 +410,7 @@ void ScorePlayer::thread_main(int nEvStart, int nEvEnd, bool fVisualTracking,
     {
         LOMSE_LOG_ERROR("Default exception caught");
     }
+    pTable->remove_user();
     m_fPlaying = false;
     m_fRunning = false;
 
@@ -337,9 +511,14 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
     if (m_pMtr)
         m_pMtr->mute(true);
 
+    //start playback time
+    m_playbackTime = 0L;
+    m_pMidi->set_playback_time(m_playbackTime);
+    m_midiEvents.clear();
+
     //Prepare instrument for metronome. Instruments for music voices
     //are prepared by events of type ProgInstr
-    m_pMidi->program_change(m_MtrChannel, m_MtrInstr);
+    queue_midi_event(MidiEvent::k_program_change, m_MtrChannel, m_MtrInstr);
 
     //-----------------------------------------------------------------------------------
     //Naming convention for variables:
@@ -413,17 +592,18 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             switch (playMode)
             {
                 case k_play_rhythm_instrument:
-                    m_pMidi->voice_change(events[i]->Channel, 57);        //57 = Trumpet
+                    queue_midi_event(MidiEvent::k_voice_change, events[i]->Channel, 57);        //57 = Trumpet
                     break;
                 case k_play_rhythm_percussion:
-                    m_pMidi->voice_change(events[i]->Channel, 66);        //66 = High Timbale
+                    queue_midi_event(MidiEvent::k_voice_change, events[i]->Channel, 66);        //66 = High Timbale
                     break;
                 case k_play_rhythm_human_voice:
                     //do nothing. Wave sound will be used
                     break;
                 case k_play_normal_instrument:
                 default:
-                    m_pMidi->voice_change(events[i]->Channel, events[i]->Instrument);
+                    queue_midi_event(MidiEvent::k_voice_change, events[i]->Channel,
+                                     events[i]->Instrument);
             }
         }
         else if (events[i]->EventType == SoundEvent::k_rhythm_change)
@@ -507,20 +687,20 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                         "nMtrEvDeltaTime=%ld",
                         nMtrIntvalOff, nMtrIntvalNextClick, nMtrEvDeltaTime);
         //generate two metronome pulses before starting
-        std::chrono::milliseconds timeToOff( time_units_to_milliseconds(nMtrIntvalOff) );
-        std::chrono::milliseconds timeToNext( time_units_to_milliseconds(nMtrIntvalNextClick) );
+        long timeToOff = time_units_to_milliseconds(nMtrIntvalOff);
+        long timeToNext = time_units_to_milliseconds(nMtrIntvalNextClick);
 
         int numPulses = (nMissingTime != 0 ? 2 : 1);
         for (int j=0 ; j < numPulses; ++j)
         {
-            m_pMidi->note_on(m_MtrChannel, m_MtrTone2, 100);
-            std::this_thread::sleep_for( timeToOff );
-            m_pMidi->note_off(m_MtrChannel, m_MtrTone2, 100);
-            std::this_thread::sleep_for( timeToNext );
+            queue_midi_event(MidiEvent::k_note_on, m_MtrChannel, m_MtrTone2, 100);
+            advance_playback_time(timeToOff);
+            queue_midi_event(MidiEvent::k_note_off, m_MtrChannel, m_MtrTone2, 100);
+            advance_playback_time(timeToNext);
         }
 
         //last click
-        m_pMidi->note_on(m_MtrChannel, m_MtrTone2, 100);
+        queue_midi_event(MidiEvent::k_note_on, m_MtrChannel, m_MtrTone2, 100);
 
         fSendMtrOff = true;
         nMtrEvDeltaTime += nMtrIntvalOff;
@@ -547,31 +727,25 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             if (curTime < nEvTime)
             {
                 //flush pending events
+                flush_midi_events();
                 long elapsed = 0L;
                 if (fVisualTracking && pEvent->get_num_items() > 0)
                 {
-                    clock_t t1=clock();
-                    if (m_fPostEvents)
-                        m_libScope.post_event(pEvent);
-                    else if (pInteractor)
-                        pInteractor->handle_event(pEvent);
+                    std::chrono::steady_clock::time_point t1 =
+                                                    std::chrono::steady_clock::now();
+                    send_tracking_event(pEvent, pInteractor);
                     pEvent = SpEventVisualTracking(
                                 LOMSE_NEW EventVisualTracking(wpInteractor,
                                                               m_pScore->get_id()) );
-                    clock_t t2=clock();
-                    elapsed = long( ((t2-t1)*1000.0)/double(CLOCKS_PER_SEC));
+                    elapsed = long( std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        std::chrono::steady_clock::now() - t1).count() );
                 }
 
                 //wait for current time
-                long waitT = nEvTime - curTime - elapsed;
-                if (waitT > 0L)
-                {
-                    std::chrono::milliseconds waitTime(waitT);
-                    std::this_thread::sleep_for(waitTime);
-                }
+                advance_playback_time(nEvTime - curTime, elapsed);
                 curTime = nEvTime;
-                LOMSE_LOG_DEBUG(Logger::k_score_player, "flush pending events: waitT=%ld, new curTime=%ld",
-                                waitT, curTime);
+                LOMSE_LOG_DEBUG(Logger::k_score_player, "flush pending events: elapsed=%ld, new curTime=%ld",
+                                elapsed, curTime);
             }
 
             if (fSendMtrOff)
@@ -580,9 +754,9 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                 if (fPlayWithMetronome || fCountOffPulseActive)
                 {
                     if (fFirstBeatInMeasure)
-                        m_pMidi->note_off(m_MtrChannel, m_MtrTone1, 127);
+                        queue_midi_event(MidiEvent::k_note_off, m_MtrChannel, m_MtrTone1, 127);
                     else
-                        m_pMidi->note_off(m_MtrChannel, m_MtrTone2, 80);
+                        queue_midi_event(MidiEvent::k_note_off, m_MtrChannel, m_MtrTone2, 80);
 
                     fCountOffPulseActive = false;
                 }
@@ -601,9 +775,9 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                 if (fPlayWithMetronome)
                 {
                     if (fFirstBeatInMeasure)
-                        m_pMidi->note_on(m_MtrChannel, m_MtrTone1, 127);
+                        queue_midi_event(MidiEvent::k_note_on, m_MtrChannel, m_MtrTone1, 127);
                     else
-                        m_pMidi->note_on(m_MtrChannel, m_MtrTone2, 80);
+                        queue_midi_event(MidiEvent::k_note_on, m_MtrChannel, m_MtrTone2, 80);
                 }
 
                 if (fVisualTracking && nMtrEvDeltaTime >= 0L)
@@ -632,30 +806,24 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             if (nEvTime > curTime)
             {
                 //flush accumulated events for curTime
+                flush_midi_events();
                 long elapsed = 0L;
                 if (fVisualTracking && pEvent->get_num_items() > 0)
                 {
                     LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                                     "Flush pending events");
-                    clock_t t1=clock();
-                    if (m_fPostEvents)
-                        m_libScope.post_event(pEvent);
-                    else if (pInteractor)
-                        pInteractor->handle_event(pEvent);
+                    std::chrono::steady_clock::time_point t1 =
+                                                    std::chrono::steady_clock::now();
+                    send_tracking_event(pEvent, pInteractor);
                     pEvent = SpEventVisualTracking(
                                 LOMSE_NEW EventVisualTracking(wpInteractor,
                                                               m_pScore->get_id()) );
-                    clock_t t2=clock();
-                    elapsed = long( ((t2-t1)*1000.0)/double(CLOCKS_PER_SEC));
+                    elapsed = long( std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        std::chrono::steady_clock::now() - t1).count() );
                 }
 
                 //wait until new time arrives
-                long waitT = nEvTime - curTime - elapsed;
-                if (waitT > 0L)
-                {
-                    std::chrono::milliseconds waitTime(waitT);
-                    std::this_thread::sleep_for(waitTime);
-                }
+                advance_playback_time(nEvTime - curTime, elapsed);
             }
 
             //if it is a jump event, execute the jump if applicable
@@ -693,20 +861,20 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                 switch(playMode)
                 {
                     case k_play_rhythm_instrument:
-                        m_pMidi->note_on(events[i]->Channel, k_SOLFA_NOTE,
-                                        events[i]->Volume);
+                        queue_midi_event(MidiEvent::k_note_on, events[i]->Channel,
+                                         k_SOLFA_NOTE, events[i]->Volume);
                         break;
                     case k_play_rhythm_percussion:
-                        m_pMidi->note_on(nPercussionChannel, k_SOLFA_NOTE,
-                                        events[i]->Volume);
+                        queue_midi_event(MidiEvent::k_note_on, nPercussionChannel,
+                                         k_SOLFA_NOTE, events[i]->Volume);
                         break;
                     case k_play_rhythm_human_voice:
                         //WaveOn .NoteStep, events[i]->Volume);
                         break;
                     case k_play_normal_instrument:
                     default:
-                        m_pMidi->note_on(events[i]->Channel, events[i]->NotePitch,
-                                        events[i]->Volume);
+                        queue_midi_event(MidiEvent::k_note_on, events[i]->Channel,
+                                         events[i]->NotePitch, events[i]->Volume);
                 }
 
                 //generate implicit visual on event
@@ -725,17 +893,18 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                 switch(playMode)
                 {
                     case k_play_rhythm_instrument:
-                        m_pMidi->note_off(events[i]->Channel, k_SOLFA_NOTE, 127);
+                        queue_midi_event(MidiEvent::k_note_off, events[i]->Channel, k_SOLFA_NOTE, 127);
                         break;
                     case k_play_rhythm_percussion:
-                        m_pMidi->note_off(nPercussionChannel, k_SOLFA_NOTE, 127);
+                        queue_midi_event(MidiEvent::k_note_off, nPercussionChannel, k_SOLFA_NOTE, 127);
                         break;
                     case k_play_rhythm_human_voice:
                         //WaveOff
                         break;
                     case k_play_normal_instrument:
                     default:
-                        m_pMidi->note_off(events[i]->Channel, events[i]->NotePitch, 127);
+                        queue_midi_event(MidiEvent::k_note_off, events[i]->Channel,
+                                         events[i]->NotePitch, 127);
                 }
 
                 //generate implicit visual off event
@@ -793,17 +962,18 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                 switch (playMode)
                 {
                     case k_play_rhythm_instrument:
-                        m_pMidi->voice_change(events[i]->Channel, 57);        //57 = Trumpet
+                        queue_midi_event(MidiEvent::k_voice_change, events[i]->Channel, 57);        //57 = Trumpet
                         break;
                     case k_play_rhythm_percussion:
-                        m_pMidi->voice_change(events[i]->Channel, 66);        //66 = High Timbale
+                        queue_midi_event(MidiEvent::k_voice_change, events[i]->Channel, 66);        //66 = High Timbale
                         break;
                     case k_play_rhythm_human_voice:
                         //do nothing. Wave sound will be used
                         break;
                     case k_play_normal_instrument:
                     default:
-                        m_pMidi->voice_change(events[i]->Channel, events[i]->NotePitch);
+                        queue_midi_event(MidiEvent::k_voice_change, events[i]->Channel,
+                                         events[i]->NotePitch);
                 }
             }
             else
@@ -824,6 +994,18 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
             LOMSE_LOG_DEBUG(Logger::k_score_player, "Going to finish 1");
             break;
         }
+        if (m_fPaused)
+        {
+            //Sound requests queued for current time are not sent now. They will be
+            //sent, together with the remaining ones for current time, when playback
+            //is resumed. But a batch could have been delivered while pause() was
+            //silencing the MIDI server
+            m_pMidi->all_sounds_off();
+
+            //time paused is excluded from trace times
+            if (m_pTrace)
+                m_pTrace->pause(int64_t(m_playbackTime) * 1000);
+        }
         while(m_fPaused)
         {
             std::this_thread::sleep_for( std::chrono::milliseconds(200) );
@@ -833,6 +1015,10 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
                 break;
             }
         }
+        if (m_fShouldStop)
+            break;
+        if (m_pTrace)
+            m_pTrace->resume(int64_t(m_playbackTime) * 1000);
 
         //update metronome information, just in case metronome was updated
         if (nMM == 0)   //AWARE: nMM==0 means: "read tempo from GUI controls"
@@ -857,6 +1043,13 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
 
     } while (i <= nEvEnd);
 
+    //send sound requests for last time. When stopped, they are discarded as all
+    //sounds will be stopped
+    if (m_fShouldStop)
+        m_midiEvents.clear();
+    else
+        flush_midi_events();
+
     //TODO: Last Highlight event (note off) is not send because loop break at line
     // 690 without sending last event. It is not important as next event will remove all
     // highlight but should be studied and decided. Can be sent here.
@@ -870,10 +1063,7 @@ void ScorePlayer::do_play(int nEvStart, int nEvEnd, bool fVisualTracking,
         pEvent->add_item(EventVisualTracking::k_end_of_visual_tracking, k_no_imoid);
         LOMSE_LOG_DEBUG(Logger::k_events | Logger::k_score_player,
                         "Flush pending events");
-        if (m_fPostEvents)
-            m_libScope.post_event(pEvent);
-        else if (pInteractor)
-            pInteractor->handle_event(pEvent);
+        send_tracking_event(pEvent, pInteractor);
     }
     LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
 }
@@ -899,10 +1089,7 @@ void ScorePlayer::end_of_playback_housekeeping(bool fVisualTracking,
         SpEventVisualTracking pEvent(
             LOMSE_NEW EventVisualTracking(wpInteractor, m_pScore->get_id()) );
         pEvent->add_item(EventVisualTracking::k_end_of_visual_tracking, k_no_imoid);
-        if (m_fPostEvents)
-            m_libScope.post_event(pEvent);
-        else if (pInteractor)
-            pInteractor->handle_event(pEvent);
+        send_tracking_event(pEvent, pInteractor);
     }
 
     //ensure that all sounds are off
@@ -942,14 +1129,117 @@ void ScorePlayer::end_of_playback_housekeeping(bool fVisualTracking,
         SpEventEndOfPlayback event(
             LOMSE_NEW EventEndOfPlayback(k_end_of_playback_event, wpInteractor,
                                          m_pScore, m_pPlayerGui) );
-        if (m_fPostEvents)
+        if (m_fPostEvents || !pInteractor)
             m_libScope.post_event(event);
-        else if (pInteractor)
-            pInteractor->handle_event(event);
+        else
+            pInteractor->queue_playback_event(event);
     }
     LOMSE_LOG_DEBUG(Logger::k_score_player, "<< Exit");
 }
 
+//---------------------------------------------------------------------------------------
+void ScorePlayer::advance_playback_time(long milliseconds, long elapsed)
+{
+    //Advance playback time and, when not using the virtual clock, wait until that
+    //time arrives. Parameter 'elapsed' is the time already consumed since last
+    //advance, to be discounted from the waiting time.
+
+    if (milliseconds <= 0L)
+        return;
+
+    //requests for current time must be sent before waiting
+    flush_midi_events();
+
+    m_playbackTime += milliseconds;
+    if (m_fVirtualClock)
+    {
+        m_pMidi->set_playback_time(m_playbackTime);
+        return;
+    }
+
+    //a stall is a wake up too late or the previous processing taking too long
+    long waitT = milliseconds - elapsed;
+    if (waitT > 0L)
+    {
+        std::chrono::steady_clock::time_point wakeUp =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(waitT);
+        std::this_thread::sleep_until(wakeUp);
+        if (m_pTrace)
+        {
+            int64_t scheduled = int64_t(m_playbackTime) * 1000;
+            m_pTrace->add_record(PlaybackTraceRecord::k_wake_up, scheduled,
+                                 m_pTrace->now_us(), 0);
+        }
+        if (std::chrono::steady_clock::now() - wakeUp
+                > std::chrono::milliseconds(k_max_sound_thread_delay))
+        {
+            ++m_numStalls;
+        }
+    }
+    else if (waitT < -k_max_sound_thread_delay)
+        ++m_numStalls;
+
+    m_pMidi->set_playback_time(m_playbackTime);
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::queue_midi_event(int type, int channel, int data1, int data2)
+{
+    //sound requests for current playback time are accumulated and sent together
+    //when playback time advances. See flush_midi_events()
+    m_midiEvents.push_back( MidiEvent(type, channel, data1, data2) );
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::flush_midi_events()
+{
+    if (m_midiEvents.empty())
+        return;
+
+    if (m_pTrace)
+    {
+        int numNoteOn = 0;
+        for (const MidiEvent& ev : m_midiEvents)
+        {
+            if (ev.type == MidiEvent::k_note_on)
+                ++numNoteOn;
+        }
+        int64_t start = m_pTrace->now_us();
+        m_pMidi->process_events(&m_midiEvents[0], m_midiEvents.size(),
+                                uint64_t(m_playbackTime) * 1000ULL);
+        m_pTrace->add_record(PlaybackTraceRecord::k_midi_batch,
+                             int64_t(m_playbackTime) * 1000, start,
+                             m_pTrace->now_us() - start,
+                             int(m_midiEvents.size()), numNoteOn);
+    }
+    else
+    {
+        m_pMidi->process_events(&m_midiEvents[0], m_midiEvents.size(),
+                                uint64_t(m_playbackTime) * 1000ULL);
+    }
+    m_midiEvents.clear();
+}
+
+//---------------------------------------------------------------------------------------
+void ScorePlayer::send_tracking_event(SpEventVisualTracking pEvent,
+                                      Interactor* pInteractor)
+{
+    pEvent->set_playback_time(m_playbackTime);
+    int64_t start = (m_pTrace ? m_pTrace->now_us() : 0);
+
+    if (m_fPostEvents)
+        m_libScope.post_event(pEvent);
+    else if (pInteractor && !pInteractor->queue_playback_event(pEvent))
+        ++m_numStalls;      //queue full: user interface is not processing events
+
+    if (m_pTrace)
+    {
+        m_pTrace->add_record(PlaybackTraceRecord::k_tracking_post,
+                             int64_t(m_playbackTime) * 1000, start,
+                             m_pTrace->now_us() - start, pEvent->get_num_items());
+    }
+}
+
 //---------------------------------------------------------------------------------------
 void ScorePlayer::set_new_beat_information(SoundEvent* pEvent)
 {
@@ -0,0 +1,256 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_batch_compiler.h"
+#include "lomse_doorway.h"
+#include "lomse_injectors.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+#include "private/lomse_document_p.h"
+
+#include <cstdio>
+#include <fstream>
+#if (LOMSE_ENABLE_THREADS == 1)
+    #include <thread>
+#endif
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class BatchCompilerTestFixture
+{
+public:
+    std::string m_scores_path;
+
+    BatchCompilerTestFixture()     //SetUp fixture
+        : m_scores_path(TESTLIB_SCORES_PATH)
+    {
+    }
+
+    ~BatchCompilerTestFixture()    //TearDown fixture
+    {
+    }
+
+    //LDP source includes the export date. Remove it for comparing
+    string remove_date(string ldp)
+    {
+        size_t start = ldp.find("Date: ");
+        size_t end = ldp.find(" */", start);
+        if (start != string::npos && end != string::npos)
+            ldp.erase(start, end - start);
+        return ldp;
+    }
+
+    vector<BatchJob> create_jobs(int actions)
+    {
+        vector<BatchJob> jobs;
+        jobs.push_back( BatchJob(m_scores_path + "01021-chords-beamed.lms", actions) );
+        jobs.push_back( BatchJob(m_scores_path + "01014-nested-tuplets.lms", actions) );
+        jobs.push_back( BatchJob(m_scores_path + "01030-ties.lms", actions) );
+        jobs.push_back( BatchJob(m_scores_path + "unit-tests/conversion/13-tied-chords.xml",
+                                 actions) );
+        jobs.push_back( BatchJob(m_scores_path + "unit-tests/conversion/20-wedge.xml",
+                                 actions) );
+        jobs.push_back( BatchJob(m_scores_path + "00011-empty-fill-page.lms", actions) );
+        return jobs;
+    }
+};
+
+SUITE(BatchCompilerTest)
+{
+
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_01)
+    {
+        //@01. documents compiled. Status and timings returned
+
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        vector<BatchJob> jobs = create_jobs(k_batch_compile);
+        vector<BatchResult> results = doorway.compile_batch(jobs, 1);
+
+        CHECK( results.size() == jobs.size() );
+        for (const BatchResult& result : results)
+        {
+            CHECK( result.status == k_batch_ok );
+            CHECK( result.numErrors == 0 );
+            CHECK( result.numPages == 0 );
+            CHECK( result.ldp.empty() );
+            CHECK( result.totalTime >= result.compileTime );
+        }
+    }
+
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_02)
+    {
+        //@02. unknown format. Job failed, other jobs processed
+
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        vector<BatchJob> jobs;
+        jobs.push_back( BatchJob(m_scores_path + "00011-empty-fill-page.txt") );
+        jobs.push_back( BatchJob(m_scores_path + "00011-empty-fill-page.lms") );
+        vector<BatchResult> results = doorway.compile_batch(jobs);
+
+        CHECK( results[0].status == k_batch_failed );
+        CHECK( results[0].messages.find("File format not supported") != string::npos );
+        CHECK( results[1].status == k_batch_ok );
+    }
+
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_03)
+    {
+        //@03. errors in source are reported
+
+        string filename = m_scores_path + "batch-compiler-03.lms";
+        {
+            ofstream file(filename, ios::out | ios::trunc);
+            file << "(score (vers 2.0)(instrument (musicData (clef G)(n c4 q)";
+        }
+
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        vector<BatchJob> jobs;
+        jobs.push_back( BatchJob(filename, k_batch_layout) );
+        jobs.push_back( BatchJob(m_scores_path + "no-file.lms", k_batch_layout,
+                                 Document::k_format_ldp) );
+        vector<BatchResult> results = doorway.compile_batch(jobs);
+
+        CHECK( results[0].status == k_batch_with_errors );
+        CHECK( results[0].numErrors > 0 );
+        CHECK( !results[0].messages.empty() );
+        CHECK( results[1].status == k_batch_failed );
+        CHECK( results[1].messages.find("File not found") != string::npos );
+
+        std::remove(filename.c_str());
+    }
+
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_04)
+    {
+        //@04. SVG export is the same than rendering the document in a vertical book view
+
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        string filename = m_scores_path + "01021-chords-beamed.lms";
+        vector<BatchJob> jobs;
+        jobs.push_back( BatchJob(filename, k_batch_export_svg) );
+        vector<BatchResult> results = doorway.compile_batch(jobs);
+
+        Presenter* pPresenter = doorway.open_document(k_view_vertical_book, filename);
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        stringstream svg;
+        pIntor->render_as_svg(svg, 0);
+
+        CHECK( results[0].status == k_batch_ok );
+        CHECK( results[0].numPages == pIntor->get_num_pages() );
+        CHECK( results[0].svg.size() == size_t(results[0].numPages) );
+        CHECK( results[0].svg.size() > 0 && results[0].svg[0] == svg.str() );
+        delete pPresenter;
+    }
+
+#if (LOMSE_ENABLE_THREADS == 1)
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_05)
+    {
+        //@05. results are independent of the number of threads
+
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        int actions = k_batch_export_ldp | k_batch_export_mxl | k_batch_export_svg;
+        vector<BatchJob> jobs = create_jobs(actions);
+        vector<BatchJob> more = create_jobs(actions);
+        jobs.insert(jobs.end(), more.begin(), more.end());
+
+        vector<BatchResult> sequential = doorway.compile_batch(jobs, 1);
+        vector<BatchResult> parallel = doorway.compile_batch(jobs, 4);
+
+        CHECK( parallel.size() == sequential.size() );
+        for (size_t i=0; i < jobs.size(); ++i)
+        {
+            CHECK( parallel[i].status == k_batch_ok );
+            CHECK( parallel[i].status == sequential[i].status );
+            CHECK( remove_date(parallel[i].ldp) == remove_date(sequential[i].ldp) );
+            CHECK( parallel[i].mxl == sequential[i].mxl );
+            CHECK( parallel[i].svg == sequential[i].svg );
+            CHECK( !parallel[i].svg.empty() );
+        }
+    }
+
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_06)
+    {
+        //@06. font engine bound to a thread is only used by that thread and only for
+        //@    the LibraryScope that bound it
+
+        LibraryScope libraryScope(cout);
+        LibraryScope otherScope(cout);
+        FontStorage* pMain = libraryScope.font_storage();
+        FontStorage* pOther = otherScope.font_storage();
+        FontStorage* pBound = nullptr;
+        FontStorage* pBoundOther = nullptr;
+        FontStorage* pUnbound = nullptr;
+
+        std::thread worker([&]()
+        {
+            libraryScope.bind_font_storage_to_this_thread();
+            pBound = libraryScope.font_storage();
+            pBoundOther = otherScope.font_storage();
+            libraryScope.unbind_font_storage_from_this_thread();
+            pUnbound = libraryScope.font_storage();
+        });
+        worker.join();
+
+        CHECK( pMain != nullptr );
+        CHECK( pBound != nullptr );
+        CHECK( pBound != pMain );
+        CHECK( pBoundOther == pOther );
+        CHECK( pUnbound == pMain );
+        CHECK( libraryScope.font_storage() == pMain );
+    }
+#endif
+
+    TEST_FIXTURE(BatchCompilerTestFixture, batch_compiler_07)
+    {
+        //@07. MusicXML options are copied when the batch compiler is created
+
+        string filename = m_scores_path + "batch_compiler_07.xml";
+        ofstream file(filename, ios::out | ios::trunc);
+        file << "<score-partwise version='3.0'><part-list>"
+                "<score-part id='P1'><part-name>Music</part-name></score-part>"
+                "</part-list><part id='P1'><measure number='1'>"
+                "<note><pitch><step>C</step><octave>4</octave></pitch>"
+                "<duration>4</duration><type>whole</type></note>"
+                "</measure></part></score-partwise>";
+        file.close();
+        vector<BatchJob> jobs;
+        jobs.push_back( BatchJob(filename, k_batch_export_ldp) );
+
+        LibraryScope libraryScope(cout);
+        libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+        MusicXmlOptions* pOpt = libraryScope.get_musicxml_options();
+        pOpt->use_default_clefs(false);
+        BatchCompiler compiler(libraryScope);
+        pOpt->use_default_clefs(true);
+        vector<BatchResult> results = compiler.compile(jobs, 1);
+
+        CHECK( results[0].status == k_batch_ok );
+        CHECK( results[0].ldp.find("(clef ") == string::npos );
+
+        BatchCompiler other(libraryScope);
+        results = other.compile(jobs, 1);
+        CHECK( results[0].ldp.find("(clef ") != string::npos );
+
+        std::remove(filename.c_str());
+    }
+
+};
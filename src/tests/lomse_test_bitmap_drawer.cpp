@@ -0,0 +1,451 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_bitmap_drawer.h"
+#include "lomse_doorway.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+#include "lomse_graphical_model.h"
+#include "lomse_gm_basic.h"
+#include "lomse_shape_barline.h"
+
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+//helper, to draw with paths instead of solid rectangles
+class MyPathsBitmapDrawer : public BitmapDrawer
+{
+public:
+    MyPathsBitmapDrawer(LibraryScope& libraryScope) : BitmapDrawer(libraryScope) {}
+
+    bool accepts_solid_rects() const override { return false; }
+};
+
+//---------------------------------------------------------------------------------------
+class BitmapDrawerTestFixture
+{
+public:
+    std::string m_scores_path;
+    LomseDoorway m_doorway;
+
+    BitmapDrawerTestFixture()     //SetUp fixture
+        : m_scores_path(TESTLIB_SCORES_PATH)
+    {
+        m_doorway.init_library(k_pix_format_rgba32, 96);
+    }
+
+    ~BitmapDrawerTestFixture()    //TearDown fixture
+    {
+    }
+
+    void render_view(const string& score, vector<unsigned char>& buf, int numThreads)
+    {
+        Presenter* pPresenter = m_doorway.open_document(k_view_vertical_book,
+                                                        m_scores_path + score);
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        buf.assign(640 * 900 * 4, 0);
+        pIntor->set_rendering_buffer(&buf[0], 640, 900);
+        pIntor->set_rendering_threads(numThreads);
+        pIntor->new_viewport(-20, 50);
+        delete pPresenter;
+    }
+
+    VRect damaged_rectangle(Interactor* pIntor)
+    {
+        GraphicView* pView = dynamic_cast<GraphicView*>(pIntor->get_view());
+        return pView->get_damaged_rectangle();
+    }
+
+    void print_page(const string& score, vector<unsigned char>& buf, int numThreads)
+    {
+        Presenter* pPresenter = m_doorway.open_document(k_view_vertical_book,
+                                                        m_scores_path + score);
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        buf.assign(1240 * 1754 * 4, 0);
+        pIntor->set_print_buffer(&buf[0], 1240, 1754);
+        pIntor->set_print_page_size(1240, 1754);
+        pIntor->set_rendering_threads(numThreads);
+        pIntor->print_page(0);
+        delete pPresenter;
+    }
+
+    //Draws first page of the score, in batch mode or not. Returns the number of flushes
+    int draw_page(const string& score, vector<unsigned char>& buf, bool fBatch)
+    {
+        Presenter* pPresenter = m_doorway.open_document(k_view_vertical_book,
+                                                        m_scores_path + score);
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        GraphicModel* pGModel = pIntor->get_graphic_model();
+
+        buf.assign(900 * 1200 * 4, 0);
+        BitmapDrawer drawer(*m_doorway.get_library_scope());
+        drawer.set_rendering_buffer(&buf[0], 900, 1200);
+        TransAffine transform;      //1 LUnit = 96/2540 pixels
+        drawer.set_affine_transformation(transform);
+
+        RenderOptions opt;
+        UPoint origin(0.0f, 0.0f);
+        if (fBatch)
+            pGModel->draw_page(0, origin, &drawer, opt);
+        else
+        {
+            pGModel->get_page(0)->on_draw(&drawer, opt);
+            drawer.render();
+        }
+        delete pPresenter;
+        return drawer.get_num_flushes();
+    }
+
+    //Draws a set of rectangles, with fractional coordinates and translucent colors.
+    //Mode: 0 - solid rectangles, 1 - filled paths, 2 - stroked horizontal lines
+    void draw_rects(vector<unsigned char>& buf, TransAffine& transform, int mode)
+    {
+        buf.assign(100 * 100 * 4, 0);
+        LibraryScope* pScope = m_doorway.get_library_scope();
+        BitmapDrawer drawer(*pScope);
+        drawer.set_rendering_buffer(&buf[0], 100, 100, Color(255, 255, 255));
+        drawer.set_affine_transformation(transform);
+
+        srand(11);
+        for (int i=0; i < 200; ++i)
+        {
+            double x1 = double(rand() % 12000) / 100.0 - 10.0;
+            double y1 = double(rand() % 12000) / 100.0 - 10.0;
+            double x2 = x1 + double(rand() % 4000) / 100.0;
+            double y2 = y1 + double(rand() % 400) / 100.0;
+            Color color(rand() % 256, rand() % 256, rand() % 256, rand() % 256);
+            if (mode == 0)
+                drawer.solid_rect(x1, y1, x2, y2, color);
+            else if (mode == 1)
+            {
+                drawer.Drawer::solid_rect(x1, y1, x2, y2, color);
+                drawer.render();
+            }
+            else
+            {
+                drawer.begin_path();
+                drawer.fill_none();
+                drawer.stroke(color);
+                drawer.stroke_width(y2 - y1);
+                drawer.move_to(x1, (y1 + y2) / 2.0);
+                drawer.line_to(x2, (y1 + y2) / 2.0);
+                drawer.end_path();
+                drawer.render();
+            }
+        }
+    }
+};
+
+SUITE(BitmapDrawerTest)
+{
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_bands_01)
+    {
+        //@01. view rasterized in bands is identical to single thread rasterization
+
+        vector<unsigned char> buf1, buf2, buf3;
+        render_view("02041-text-titles.lms", buf1, 1);
+        render_view("02041-text-titles.lms", buf2, 3);
+        render_view("02041-text-titles.lms", buf3, 0);
+
+        CHECK( buf1 == buf2 );
+        CHECK( buf1 == buf3 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_bands_02)
+    {
+        //@02. printed page rasterized in bands is identical
+
+        vector<unsigned char> buf1, buf2;
+        print_page("00626-lyrics-min-separation.lms", buf1, 1);
+        print_page("00626-lyrics-min-separation.lms", buf2, 4);
+
+        CHECK( buf1 == buf2 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_bands_03)
+    {
+        //@03. drawing restricted to the band rows
+
+        vector<unsigned char> buf(100 * 100 * 4, 0);
+        LibraryScope* pScope = m_doorway.get_library_scope();
+        BitmapDrawer target(*pScope);
+        target.set_rendering_buffer(&buf[0], 100, 100, Color(255, 255, 255));
+        TransAffine transform;
+        target.set_affine_transformation(transform);
+
+        BitmapDrawer band(*pScope);
+        band.share_rendering_buffer(&target, 40, 60);
+        band.begin_path();
+        band.fill(Color(0, 0, 0));
+        band.move_to(0.0, 0.0);
+        band.hline_to(100000.0);
+        band.vline_to(100000.0);
+        band.hline_to(0.0);
+        band.close_path();
+        band.end_path();
+        band.render();
+
+        CHECK( buf[(39 * 100 + 50) * 4] == 255 );
+        CHECK( buf[(40 * 100 + 50) * 4] == 0 );
+        CHECK( buf[(59 * 100 + 50) * 4] == 0 );
+        CHECK( buf[(60 * 100 + 50) * 4] == 255 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_solid_rect_01)
+    {
+        //@01. solid rectangles identical to filled rectangle paths
+
+        vector<unsigned char> buf1, buf2, buf3;
+        TransAffine transform(1.37, 0.0, 0.0, 0.91, -3.3, 2.7);
+        draw_rects(buf1, transform, 0);
+        draw_rects(buf2, transform, 1);
+        draw_rects(buf3, transform, 2);
+
+        CHECK( buf1 == buf2 );
+        CHECK( buf1 == buf3 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_solid_rect_02)
+    {
+        //@02. rotated solid rectangles are rendered as paths
+
+        vector<unsigned char> buf1, buf2;
+        TransAffine transform = agg::trans_affine_rotation(0.3);
+        draw_rects(buf1, transform, 0);
+        draw_rects(buf2, transform, 1);
+
+        CHECK( buf1 == buf2 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_solid_rect_03)
+    {
+        //@03. barlines drawn as solid rectangles cover the same area as the
+        //@    stroked paths
+
+        vector<unsigned char> buf1(200 * 200 * 4, 0);
+        vector<unsigned char> buf2(200 * 200 * 4, 0);
+        LibraryScope* pScope = m_doorway.get_library_scope();
+        double scale = 2.0 * 2540.0 / 96.0;     //1 LUnit = 2 pixels
+        TransAffine transform(scale, 0.0, 0.0, scale, 0.0, 0.0);
+        RenderOptions opt;
+        GmoShapeBarline shape(nullptr, 0, k_barline_end, 20.0, 10.0, 80.0, 4.0, 10.0,
+                              6.0, 3.0, Color(0,0,0), 0.0);
+
+        BitmapDrawer drawer1(*pScope);
+        drawer1.set_rendering_buffer(&buf1[0], 200, 200, Color(255, 255, 255));
+        drawer1.set_affine_transformation(transform);
+        shape.on_draw(&drawer1, opt);
+
+        MyPathsBitmapDrawer drawer2(*pScope);
+        drawer2.set_rendering_buffer(&buf2[0], 200, 200, Color(255, 255, 255));
+        drawer2.set_affine_transformation(transform);
+        shape.on_draw(&drawer2, opt);
+
+        CHECK( buf1 == buf2 );
+        //outline pixels: the thin line is drawn from x=19.5 to x=24 and from
+        //y=9.5 to y=80.5 LUnits
+        CHECK( buf1[(100 * 200 + 39) * 4] == 0 );
+        CHECK( buf1[(100 * 200 + 48) * 4] == 255 );
+        CHECK( buf1[(19 * 200 + 40) * 4] == 0 );
+        CHECK( buf1[(160 * 200 + 40) * 4] == 0 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_batch_01)
+    {
+        //@01. page drawn in batch mode is identical, with less flushes
+
+        vector<unsigned char> buf1, buf2;
+        int flushes = draw_page("01026-beamed-chords.lms", buf1, false);
+        int batchFlushes = draw_page("01026-beamed-chords.lms", buf2, true);
+
+        CHECK( buf1 == buf2 );
+        CHECK( batchFlushes < flushes );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_batch_02)
+    {
+        //@02. deferred paths rendered before an overlapping glyph
+
+        vector<unsigned char> buf(100 * 100 * 4, 0);
+        LibraryScope* pScope = m_doorway.get_library_scope();
+        BitmapDrawer drawer(*pScope);
+        drawer.set_rendering_buffer(&buf[0], 100, 100, Color(255, 255, 255));
+        TransAffine transform;
+        transform.scale(2540.0 / 96.0);     //1 LUnit = 1 pixel
+        drawer.set_affine_transformation(transform);
+
+        drawer.begin_batch();
+        drawer.begin_path();
+        drawer.fill(Color(255, 0, 0));
+        drawer.move_to(10.0, 10.0);
+        drawer.hline_to(20.0);
+        drawer.vline_to(20.0);
+        drawer.hline_to(10.0);
+        drawer.close_path();
+        drawer.end_path();
+        drawer.render();
+        CHECK( drawer.get_num_flushes() == 0 );
+
+        drawer.solid_rect(50.0, 50.0, 60.0, 60.0, Color(0, 0, 255));
+        CHECK( drawer.get_num_flushes() == 0 );
+        drawer.solid_rect(15.0, 15.0, 30.0, 30.0, Color(0, 0, 255));
+        CHECK( drawer.get_num_flushes() == 1 );
+        drawer.end_batch();
+
+        //red square below blue one
+        CHECK( buf[(12 * 100 + 12) * 4] == 255 );
+        CHECK( buf[(17 * 100 + 17) * 4] == 0 );
+        CHECK( buf[(17 * 100 + 17) * 4 + 2] == 255 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_scroll_01)
+    {
+        //@01. scroll_bitmap moves the buffer content
+
+        vector<unsigned char> buf(100 * 100 * 4, 0);
+        LibraryScope* pScope = m_doorway.get_library_scope();
+        BitmapDrawer drawer(*pScope);
+        drawer.set_rendering_buffer(&buf[0], 100, 100, Color(255, 255, 255));
+        buf[(10 * 100 + 20) * 4] = 7;
+
+        drawer.scroll_bitmap(5, 30);
+        CHECK( buf[(40 * 100 + 25) * 4] == 7 );
+        drawer.scroll_bitmap(-5, -30);
+        CHECK( buf[(10 * 100 + 20) * 4] == 7 );
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_scroll_02)
+    {
+        //@02. scrolled view is identical to full rendering. Damaged rectangle is
+        //@    the exposed strip
+
+        vector<unsigned char> buf1(640 * 500 * 4, 0);
+        vector<unsigned char> buf2(640 * 500 * 4, 0);
+        Presenter* pPresenter1 = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Presenter* pPresenter2 = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Interactor* pIntor1 = pPresenter1->get_interactor_raw_ptr(0);
+        Interactor* pIntor2 = pPresenter2->get_interactor_raw_ptr(0);
+        pIntor1->set_rendering_buffer(&buf1[0], 640, 500);
+        pIntor2->set_rendering_buffer(&buf2[0], 640, 500);
+        pIntor2->enable_scroll_blitting(true);
+        pIntor2->new_viewport(-20, 0, false);
+        pIntor2->redraw_bitmap();
+        damaged_rectangle(pIntor2);
+
+        pIntor1->new_viewport(-20, 130, false);
+        pIntor1->redraw_bitmap();
+        pIntor2->new_viewport(-20, 130, false);
+        pIntor2->redraw_bitmap();
+        CHECK( buf1 == buf2 );
+        CHECK( damaged_rectangle(pIntor2) == VRect(VPoint(0, 370), VPoint(640, 500)) );
+        CHECK( damaged_rectangle(pIntor1) == VRect(0, 0, 0, 0) );
+
+        pIntor1->new_viewport(35, 60, false);
+        pIntor1->redraw_bitmap();
+        pIntor2->new_viewport(35, 60, false);
+        pIntor2->redraw_bitmap();
+        CHECK( buf1 == buf2 );
+        CHECK( damaged_rectangle(pIntor2) == VRect(VPoint(0, 0), VPoint(640, 500)) );
+
+        pIntor1->new_viewport(-10, 60, false);
+        pIntor1->redraw_bitmap();
+        pIntor2->new_viewport(-10, 60, false);
+        pIntor2->redraw_bitmap();
+        CHECK( buf1 == buf2 );
+        CHECK( damaged_rectangle(pIntor2) == VRect(VPoint(0, 0), VPoint(45, 500)) );
+
+        delete pPresenter1;
+        delete pPresenter2;
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_scroll_03)
+    {
+        //@03. damaged rectangle after scrolling includes the overlays, at their
+        //@    previous and new positions
+
+        vector<unsigned char> buf(640 * 500 * 4, 0);
+        Presenter* pPresenter = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        GraphicView* pView = dynamic_cast<GraphicView*>(pIntor->get_view());
+        pIntor->set_rendering_buffer(&buf[0], 640, 500);
+        pIntor->enable_scroll_blitting(true);
+        pIntor->new_viewport(-20, 0, false);
+        pIntor->redraw_bitmap();
+        damaged_rectangle(pIntor);
+
+        pIntor->start_selection_rectangle(100, 200);
+        UPoint end = pIntor->screen_point_to_model_point(300, 300);
+        pView->update_selection_rectangle(end.x, end.y);
+        pView->draw_selection_rectangle();
+        VRect rect = damaged_rectangle(pIntor);
+        CHECK( rect.top() < 200 && rect.bottom() > 300 );
+
+        pIntor->new_viewport(-20, 130, false);
+        pIntor->redraw_bitmap();
+        rect = damaged_rectangle(pIntor);
+//        cout << "damaged: " << rect.left() << ", " << rect.top() << ", "
+//             << rect.right() << ", " << rect.bottom() << endl;
+        CHECK( rect.left() < 100 );
+        CHECK( rect.top() < 70 );
+        CHECK( rect.right() == 640 );
+        CHECK( rect.bottom() == 500 );
+
+        delete pPresenter;
+    }
+
+    TEST_FIXTURE(BitmapDrawerTestFixture, bitmap_drawer_scroll_04)
+    {
+        //@04. frames rendered from tiles are not reused after disabling tiles
+
+        vector<unsigned char> buf1(640 * 500 * 4, 0);
+        vector<unsigned char> buf2(640 * 500 * 4, 0);
+        Presenter* pPresenter1 = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Presenter* pPresenter2 = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Interactor* pIntor1 = pPresenter1->get_interactor_raw_ptr(0);
+        Interactor* pIntor2 = pPresenter2->get_interactor_raw_ptr(0);
+        pIntor1->set_rendering_buffer(&buf1[0], 640, 500);
+        pIntor2->set_rendering_buffer(&buf2[0], 640, 500);
+        pIntor2->enable_scroll_blitting(true);
+        pIntor2->new_viewport(-20, 0, false);
+        pIntor2->redraw_bitmap();
+
+        pIntor2->set_tile_cache_budget(16 * 1024 * 1024);
+        pIntor2->new_viewport(-20, 100, false);
+        pIntor2->redraw_bitmap();
+        pIntor2->set_tile_cache_budget(0);
+        pIntor2->new_viewport(-20, 130, false);
+        pIntor2->redraw_bitmap();
+
+        pIntor1->new_viewport(-20, 130, false);
+        pIntor1->redraw_bitmap();
+        CHECK( buf1 == buf2 );
+
+        delete pPresenter1;
+        delete pPresenter2;
+    }
+
+};
+
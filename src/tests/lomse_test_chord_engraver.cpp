@@ -504,8 +504,8 @@ SUITE(ChordEngraverTest)
 
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         //cout << "note1. left=" << m_pShape1->get_notehead_left() << endl;
         //cout << "note2. left=" << m_pShape2->get_notehead_left() << endl;
@@ -528,8 +528,8 @@ SUITE(ChordEngraverTest)
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pChordEngrv->my_get_stem_width(), 21.6f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         delete_chord();
     }
@@ -549,8 +549,8 @@ SUITE(ChordEngraverTest)
 
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         delete_chord();
     }
@@ -572,12 +572,12 @@ SUITE(ChordEngraverTest)
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
 
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         delete_chord();
     }
@@ -594,15 +594,15 @@ SUITE(ChordEngraverTest)
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
 
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         //cout << m_pShape1->get_stem_left() << endl;
-        CHECK ( is_equal_pos(m_pShape1->get_stem_left(), 207.4f) );
+        CHECK ( is_equal_pos(m_pShape1->get_stem_left(), 206.946f) );
         CHECK ( is_equal_pos(m_pShape1->get_stem_width(), 21.6f) );
 
         delete_chord();
@@ -627,8 +627,8 @@ SUITE(ChordEngraverTest)
 
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         //cout << "note1. left=" << m_pShape1->get_notehead_left() << endl;
         //cout << "note2. left=" << m_pShape2->get_notehead_left() << endl;
@@ -649,10 +649,10 @@ SUITE(ChordEngraverTest)
         m_pChordEngrv->my_arrange_notheads_to_avoid_collisions();
 
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 207.4f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 206.946f) );
         CHECK ( is_equal_pos(m_pChordEngrv->my_get_stem_width(), 21.6f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         delete_chord();
     }
@@ -671,10 +671,10 @@ SUITE(ChordEngraverTest)
         m_pChordEngrv->my_add_stem_and_flag();
 
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 207.4f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 206.946f) );
         CHECK ( is_equal_pos(m_pChordEngrv->my_get_stem_width(), 21.6f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         delete_chord();
     }
@@ -696,13 +696,13 @@ SUITE(ChordEngraverTest)
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
 
         //cout << "anchor offset: " << m_pShape2->get_anchor_offset() << endl;
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 207.4f) );
-        CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 197.4f) );
-        CHECK ( is_equal_pos(m_pShape2->get_left(), 207.4f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 206.946f) );
+        CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 196.946f) );
+        CHECK ( is_equal_pos(m_pShape2->get_left(), 206.946f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
         delete_chord();
     }
@@ -719,14 +719,14 @@ SUITE(ChordEngraverTest)
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 218.546f) );
 
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 207.4f) );
-        CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 197.4f) );
-        CHECK ( is_equal_pos(m_pShape2->get_left(), 207.4f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 219.0f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 206.946f) );
+        CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 196.946f) );
+        CHECK ( is_equal_pos(m_pShape2->get_left(), 206.946f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 218.546f) );
 
-        CHECK ( is_equal_pos(m_pShape1->get_stem_left(), 207.4f) );
+        CHECK ( is_equal_pos(m_pShape1->get_stem_left(), 206.946f) );
         CHECK ( is_equal_pos(m_pShape1->get_stem_width(), 21.6f) );
 
         delete_chord();
@@ -1333,17 +1333,17 @@ SUITE(ChordEngraverTest)
         CHECK ( is_equal_pos(m_pShape1->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 313.0f) );
+        CHECK ( is_equal_pos(m_pShape1->get_notehead_width(), 312.632f) );
 
         CHECK ( is_equal_pos(m_pShape2->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape2->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 313.0f) );
+        CHECK ( is_equal_pos(m_pShape2->get_notehead_width(), 312.632f) );
 
         CHECK ( is_equal_pos(m_pShape3->get_notehead_left(), 10.0f) );
         CHECK ( is_equal_pos(m_pShape3->get_anchor_offset(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape3->get_left(), 10.0f) );
-        CHECK ( is_equal_pos(m_pShape3->get_notehead_width(), 313.0f) );
+        CHECK ( is_equal_pos(m_pShape3->get_notehead_width(), 312.632f) );
 
         CHECK ( is_equal_pos(m_pShape1->get_stem_left(), 0.0f) );
         CHECK ( is_equal_pos(m_pShape1->get_stem_width(), 0.0f) );
@@ -0,0 +1,160 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_fast_pixfmt.h"
+#include "lomse_doorway.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class FastPixFormatTestFixture
+{
+public:
+    std::string m_scores_path;
+    int m_iset;
+
+    FastPixFormatTestFixture()     //SetUp fixture
+        : m_scores_path(TESTLIB_SCORES_PATH)
+        , m_iset(get_span_instruction_set())
+    {
+    }
+
+    ~FastPixFormatTestFixture()    //TearDown fixture
+    {
+        set_span_instruction_set(m_iset);
+    }
+
+    //Spans are drawn with AGG and with the fast pixel format, for all supported
+    //instruction sets. Returns true if results are identical
+    template<class PixFmt, class FastPixFmt>
+    bool compare_spans()
+    {
+        const unsigned width = 77;       //not multiple of SIMD steps
+        const unsigned height = 40;
+        const int bytes = int(width * height * PixFmt::pix_width);
+        vector<int8u> pixels(bytes);
+        srand(7);
+        for (int i=0; i < bytes; ++i)
+            pixels[i] = int8u(rand());
+
+        vector<int8u> expected(pixels);
+        rendering_buffer rbufExpected(&expected[0], width, height,
+                                      int(width * PixFmt::pix_width));
+        PixFmt pixfExpected(rbufExpected);
+        draw_spans(pixfExpected);
+
+        for (int iset=k_span_portable; iset <= k_span_avx2; ++iset)
+        {
+            if (!set_span_instruction_set(iset))
+                continue;
+
+            vector<int8u> result(pixels);
+            rendering_buffer rbuf(&result[0], width, height,
+                                  int(width * PixFmt::pix_width));
+            FastPixFmt pixf(rbuf);
+            draw_spans(pixf);
+            if (result != expected)
+                return false;
+        }
+        return true;
+    }
+
+    template<class PixFmt>
+    void draw_spans(PixFmt& pixf)
+    {
+        typedef typename PixFmt::color_type color_type;
+        const int8u alphas[] = { 0, 1, 100, 254, 255 };
+        const unsigned width = pixf.width();
+        vector<int8u> covers(width);
+        srand(13);
+        unsigned y = 0;
+        for (int8u alpha : alphas)
+        {
+            int8u r = int8u(rand());
+            int8u g = int8u(rand());
+            int8u b = int8u(rand());
+            color_type c = color_type(rgba8(r, g, b, alpha));
+
+            //covers: runs of 0 and 255 and random values
+            for (unsigned x=0; x < width; ++x)
+            {
+                int run = rand() % 3;
+                covers[x] = (run == 0 ? 0 : run == 1 ? 255 : int8u(rand()));
+            }
+            pixf.blend_solid_hspan(0, int(y++), width, c, &covers[0]);
+            for (unsigned x=0; x < 16; ++x)
+                covers[x] = 255;
+            for (unsigned x=16; x < 48; ++x)
+                covers[x] = 0;
+            pixf.blend_solid_hspan(3, int(y++), width - 3, c, &covers[0]);
+
+            pixf.blend_hline(0, int(y++), width, c, 255);
+            pixf.blend_hline(5, int(y++), width - 9, c, 128);
+            pixf.blend_hline(1, int(y++), 3, c, 30);
+            pixf.copy_hline(2, int(y++), width - 2, c);
+        }
+    }
+};
+
+SUITE(FastPixFormatTest)
+{
+
+    TEST_FIXTURE(FastPixFormatTestFixture, fast_pixfmt_01)
+    {
+        //@01. spans identical to AGG spans for all formats
+
+        CHECK( (compare_spans<agg::pixfmt_rgba32, FastPixFormat_rgba32>()) );
+        CHECK( (compare_spans<agg::pixfmt_argb32, FastPixFormat_argb32>()) );
+        CHECK( (compare_spans<agg::pixfmt_bgra32, FastPixFormat_bgra32>()) );
+        CHECK( (compare_spans<agg::pixfmt_rgb24, FastPixFormat_rgb24>()) );
+        CHECK( (compare_spans<agg::pixfmt_bgr24, FastPixFormat_bgr24>()) );
+        CHECK( (compare_spans<agg::pixfmt_gray8, FastPixFormat_gray8>()) );
+    }
+
+    TEST_FIXTURE(FastPixFormatTestFixture, fast_pixfmt_02)
+    {
+        //@02. rendered view identical for all instruction sets
+
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        vector<unsigned char> expected;
+        for (int iset=k_span_portable; iset <= k_span_avx2; ++iset)
+        {
+            if (!set_span_instruction_set(iset))
+                continue;
+
+            Presenter* pPresenter = doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+            Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+            vector<unsigned char> buf(600 * 400 * 4, 0);
+            pIntor->set_rendering_buffer(&buf[0], 600, 400);
+            pIntor->new_viewport(-20, 30);
+            if (expected.empty())
+                expected = buf;
+            CHECK( buf == expected );
+            delete pPresenter;
+        }
+    }
+
+};
+
@@ -0,0 +1,129 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "lomse_glyphs.h"
+#include "lomse_calligrapher.h"
+
+#include <cmath>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+//---------------------------------------------------------------------------------------
+class MusicGlyphsTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+
+    MusicGlyphsTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+    }
+
+    ~MusicGlyphsTestFixture()    //TearDown fixture
+    {
+    }
+
+    URect font_bounds(unsigned int ch, double fontHeight)
+    {
+        TextMeter meter(m_libraryScope);
+        meter.select_font("any",
+                          m_libraryScope.get_music_font_file(),
+                          m_libraryScope.get_music_font_name(),
+                          fontHeight);
+        return meter.bounding_rectangle(ch);
+    }
+
+    bool is_near(LUnits value, LUnits expected, LUnits tolerance)
+    {
+        if (fabs(value - expected) <= tolerance)
+            return true;
+        cout << UnitTest::CurrentTest::Details()->testName << ": value=" << value
+             << ", expected=" << expected << endl;
+        return false;
+    }
+};
+
+//---------------------------------------------------------------------------------------
+SUITE(MusicGlyphsTest)
+{
+
+    TEST_FIXTURE(MusicGlyphsTestFixture, glyph_metrics_01)
+    {
+        //@01. metrics available for default music font
+
+        MusicGlyphs* pGlyphs = m_libraryScope.get_glyphs_table();
+        if (!pGlyphs->has_metrics())
+            return;     //Lomse built without the metrics table
+
+        unsigned int ch = pGlyphs->glyph_code(k_glyph_notehead_quarter);
+        const GlyphMetrics* pData = pGlyphs->get_metrics(ch);
+        CHECK( pData != nullptr );
+        CHECK( pData && pData->code == ch );
+        CHECK( pData && pData->right > pData->left );
+        CHECK( pData && pData->top > pData->bottom );
+        CHECK( pGlyphs->get_metrics(0x0041) == nullptr );
+    }
+
+    TEST_FIXTURE(MusicGlyphsTestFixture, glyph_metrics_02)
+    {
+        //@02. bounding box and advance match the font, in LUnits
+
+        MusicGlyphs* pGlyphs = m_libraryScope.get_glyphs_table();
+        if (!pGlyphs->has_metrics())
+            return;
+
+        int glyphs[] = { k_glyph_notehead_quarter, k_glyph_g_clef, k_glyph_sharp_accidental,
+                         k_glyph_eighth_rest };
+        for (int iGlyph : glyphs)
+        {
+            unsigned int ch = pGlyphs->glyph_code(iGlyph);
+            URect bbox;
+            CHECK( pGlyphs->bounding_rectangle(ch, 21.0, &bbox) == true );
+
+            //font bounds are rounded to pixels
+            URect expected = font_bounds(ch, 21.0);
+            CHECK( is_near(bbox.x, expected.x, 1.5f) );
+            CHECK( is_near(bbox.y, expected.y, 1.5f) );
+            CHECK( is_near(bbox.width, expected.width, 2.5f) );
+            CHECK( is_near(bbox.height, expected.height, 2.5f) );
+
+            LUnits advance;
+            CHECK( pGlyphs->advance_x(ch, 21.0, &advance) == true );
+            CHECK( advance > 0.0f );
+        }
+    }
+
+    TEST_FIXTURE(MusicGlyphsTestFixture, glyph_metrics_03)
+    {
+        //@03. metrics are not used for other music fonts
+
+        MusicGlyphs* pGlyphs = m_libraryScope.get_glyphs_table();
+        m_libraryScope.set_music_font("Other.otf", "Other");
+        CHECK( pGlyphs->has_metrics() == false );
+
+        URect bbox;
+        LUnits advance;
+        unsigned int ch = pGlyphs->glyph_code(k_glyph_notehead_quarter);
+        CHECK( pGlyphs->get_metrics(ch) == nullptr );
+        CHECK( pGlyphs->bounding_rectangle(ch, 21.0, &bbox) == false );
+        CHECK( pGlyphs->advance_x(ch, 21.0, &advance) == false );
+    }
+
+};
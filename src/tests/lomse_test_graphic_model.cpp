@@ -29,6 +29,7 @@
 #include "lomse_model_builder.h"
 #include "lomse_im_factory.h"
 #include "lomse_timegrid_table.h"
+#include "lomse_gm_tracking_table.h"
 
 using namespace UnitTest;
 using namespace std;
@@ -1174,6 +1175,80 @@ SUITE(GraphicModelTest)
         delete pIntor;
     }
 
+
+    //@ GmTrackingTable -----------------------------------------------------------------
+
+    TEST_FIXTURE(GraphicModelTestFixture, tracking_table_001)
+    {
+        //@001. Same results than get_system_for() and get_x_for_note_rest_at_time()
+
+        MyDoorway doorway;
+        LibraryScope libraryScope(cout, &doorway);
+        libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+        SpDocument spDoc( new Document(libraryScope) );
+        spDoc->from_file(m_scores_path + "unit-tests/other/03-BeetAnGeSample.xml",
+                         Document::k_format_mxl);
+        VerticalBookView* pView = static_cast<VerticalBookView*>(
+        Injector::inject_View(libraryScope, k_view_vertical_book) );
+        Interactor* pIntor = Injector::inject_Interactor(libraryScope, WpDocument(spDoc), pView, nullptr);
+        GraphicModel* pGModel = pIntor->get_graphic_model();
+        ImoId scoreId = spDoc->get_im_root()->get_content_item(0)->get_id();
+
+        GmTrackingTable* pTable = pGModel->get_tracking_table(scoreId);
+        CHECK( pTable != nullptr );
+        CHECK( pTable->num_systems() == 4 );
+
+        TimeUnits endTime = pGModel->get_system_box(3, scoreId)->end_time();
+        int numErrors = 0;
+        for (TimeUnits t = -8.0; t <= endTime + 16.0; t += 4.0)
+        {
+            GmoBoxSystem* pBSys = pGModel->get_system_for(scoreId, t);
+            TrackingPosition pos;
+            bool fFound = pTable->find(t, &pos);
+            if (fFound != (pBSys != nullptr) || pos.pSystem != pBSys)
+                ++numErrors;
+            else if (pBSys && (pos.iPage != pBSys->get_page_number()
+                     || !is_equal_pos(pos.xPos, pBSys->get_x_for_note_rest_at_time(t))))
+            {
+                ++numErrors;
+            }
+        }
+        CHECK( numErrors == 0 );
+
+        delete pIntor;
+    }
+
+    TEST_FIXTURE(GraphicModelTestFixture, tracking_table_002)
+    {
+        //@002. Note in next system preferred to barline ending previous system
+
+        MyDoorway doorway;
+        LibraryScope libraryScope(cout, &doorway);
+        libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+        SpDocument spDoc( new Document(libraryScope) );
+        spDoc->from_file(m_scores_path + "unit-tests/other/03-BeetAnGeSample.xml",
+                         Document::k_format_mxl);
+        VerticalBookView* pView = static_cast<VerticalBookView*>(
+        Injector::inject_View(libraryScope, k_view_vertical_book) );
+        Interactor* pIntor = Injector::inject_Interactor(libraryScope, WpDocument(spDoc), pView, nullptr);
+        GraphicModel* pGModel = pIntor->get_graphic_model();
+        ImoId scoreId = spDoc->get_im_root()->get_content_item(0)->get_id();
+        GmTrackingTable* pTable = pGModel->get_tracking_table(scoreId);
+
+        GmoBoxSystem* pSys0 = pGModel->get_system_box(0, scoreId);
+        GmoBoxSystem* pSys1 = pGModel->get_system_box(1, scoreId);
+        TrackingPosition pos;
+        CHECK( pTable->find(pSys0->end_time(), &pos) );
+        CHECK( pos.pSystem == pSys1 );
+        CHECK( pTable->find_system(pSys0->end_time() - 1.0) == pSys0 );
+
+        TimeUnits endTime = pGModel->get_system_box(3, scoreId)->end_time();
+        CHECK( pTable->find(endTime + 1.0, &pos) == false );
+        CHECK( pTable->find_system(endTime + 1.0) == nullptr );
+
+        delete pIntor;
+    }
+
 };
 
 
@@ -0,0 +1,417 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "private/lomse_document_p.h"
+#include "lomse_internal_model.h"
+#include "lomse_im_note.h"
+#include "lomse_id_assigner.h"
+#include "lomse_staffobjs_table.h"
+#include "lomse_im_snapshot.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// helper, for accessing protected members
+class MySnapshotsCache : public SnapshotsCache
+{
+public:
+    MySnapshotsCache(const std::string& path, MusicXmlOptions* pOptions)
+        : SnapshotsCache(path, pOptions)
+    {
+    }
+
+    std::string my_snapshot_path(const std::string& filename, int format)
+    {
+        ifstream file(filename, ios::in | ios::binary);
+        stringstream content;
+        if (file.good())
+            content << file.rdbuf();
+        else
+            content << filename;
+        return snapshot_path(content.str(), format);
+    }
+};
+
+//---------------------------------------------------------------------------------------
+class ImSnapshotTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+
+    ImSnapshotTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+        , m_scores_path(TESTLIB_SCORES_PATH)
+    {
+    }
+
+    ~ImSnapshotTestFixture()    //TearDown fixture
+    {
+    }
+
+    inline const char* test_name()
+    {
+        return UnitTest::CurrentTest::Details()->testName;
+    }
+
+    inline void failure_header()
+    {
+        cout << endl << "*** Failure in " << test_name() << ":" << endl;
+    }
+
+    string read_file(const string& path)
+    {
+        ifstream file(path, ios::in | ios::binary);
+        stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    void write_file(const string& path, const string& data)
+    {
+        ofstream file(path, ios::out | ios::binary | ios::trunc);
+        file.write(data.data(), streamsize(data.size()));
+    }
+
+    //replaces the payload of a snapshot, updating the header so that it remains valid
+    string replace_payload(const string& data, const string& payload)
+    {
+        const size_t headerSize = 32;
+        string header = data.substr(0, headerSize);
+        uint64_t size = uint64_t(payload.size());
+        uint64_t checksum = ImSnapshot::hash(payload.data(), payload.size());
+        for (int i=0; i < 8; ++i)
+        {
+            header[16 + i] = char(size >> (8 * i));
+            header[24 + i] = char(checksum >> (8 * i));
+        }
+        return header + payload;
+    }
+
+    bool check_to_string(Document& doc, Document& copy)
+    {
+        string original = doc.get_im_root()->to_string(true);
+        string loaded = copy.get_im_root()->to_string(true);
+        if (original != loaded)
+        {
+            failure_header();
+            cout << "    original: " << original << endl;
+            cout << "      loaded: " << loaded << endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool check_equal_id_assigners(Document& doc, Document& copy)
+    {
+        IdAssigner* pAssigner = doc.get_doc_model()->get_id_assigner();
+        IdAssigner* pAssignerCopy = copy.get_doc_model()->get_id_assigner();
+        stringstream msg;
+        bool fOK = pAssigner->check_ids(pAssignerCopy, msg, "loaded");
+        if (!fOK)
+        {
+            pAssignerCopy->check_ids(pAssigner, msg, "original");
+            failure_header();
+            cout << msg.str();
+        }
+        return fOK && pAssigner->get_last_id() == pAssignerCopy->get_last_id();
+    }
+
+    bool check_staffobjs_tables(Document& doc, Document& copy)
+    {
+        for (int i=0; i < doc.get_num_content_items(); ++i)
+        {
+            ImoScore* pScore = dynamic_cast<ImoScore*>( doc.get_content_item(i) );
+            ImoScore* pCopy = dynamic_cast<ImoScore*>( copy.get_content_item(i) );
+            if (pScore && (!pCopy || pScore->get_staffobjs_table()->dump()
+                                     != pCopy->get_staffobjs_table()->dump()) )
+            {
+                failure_header();
+                cout << "    ColStaffObjs table is different for content item "
+                     << i << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool check_round_trip(const string& filename, int format)
+    {
+        stringstream errormsg;
+        Document doc(m_libraryScope, errormsg);
+        doc.from_file(m_scores_path + filename, format);
+
+        string data;
+        if (!doc.to_snapshot(data))
+        {
+            failure_header();
+            cout << "    Snapshot not created for " << filename << endl;
+            return false;
+        }
+
+        Document copy(m_libraryScope, errormsg);
+        if (!copy.from_snapshot(data.data(), data.size()))
+        {
+            failure_header();
+            cout << "    Snapshot not loaded for " << filename << endl;
+            return false;
+        }
+
+        string dataCopy;
+        copy.to_snapshot(dataCopy);
+
+        return check_to_string(doc, copy)
+               && check_equal_id_assigners(doc, copy)
+               && check_staffobjs_tables(doc, copy)
+               && copy.get_im_root()->get_doc_model() == copy.get_doc_model()
+               && dataCopy == data;
+    }
+
+};
+
+SUITE(ImSnapshotTest)
+{
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_01)
+    {
+        //@01. empty document
+
+        Document doc(m_libraryScope);
+        doc.create_empty();
+        string data;
+        CHECK( doc.to_snapshot(data) == true );
+
+        Document copy(m_libraryScope);
+        CHECK( copy.from_snapshot(data.data(), data.size()) == true );
+        CHECK( check_to_string(doc, copy) );
+        CHECK( check_equal_id_assigners(doc, copy) );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_02)
+    {
+        //@02. score with beams, chords and tuplets
+
+        CHECK( check_round_trip("01021-chords-beamed.lms", Document::k_format_ldp) );
+        CHECK( check_round_trip("01014-nested-tuplets.lms", Document::k_format_ldp) );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_03)
+    {
+        //@03. MusicXML scores with ties, wedges and directions. Xml ids are restored
+
+        CHECK( check_round_trip("unit-tests/conversion/13-tied-chords.xml",
+                                Document::k_format_mxl) );
+        CHECK( check_round_trip("unit-tests/conversion/20-wedge.xml",
+                                Document::k_format_mxl) );
+        CHECK( check_round_trip("unit-tests/conversion/12-directions-in-chord.xml",
+                                Document::k_format_mxl) );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_04)
+    {
+        //@04. score with system layout and options
+
+        CHECK( check_round_trip("00011-empty-fill-page.lms", Document::k_format_ldp) );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_05)
+    {
+        //@05. corrupted or truncated snapshots are rejected. Document can be created
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "unit-tests/conversion/20-wedge.xml",
+                      Document::k_format_mxl);
+        string data;
+        CHECK( doc.to_snapshot(data) == true );
+
+        string corrupted = data;
+        corrupted[data.size() / 2] ^= 0x10;
+        Document copy(m_libraryScope);
+        CHECK( copy.from_snapshot(corrupted.data(), corrupted.size()) == false );
+        CHECK( copy.from_snapshot(data.data(), data.size() - 7) == false );
+        CHECK( copy.from_snapshot(data.data(), 10) == false );
+        CHECK( copy.get_im_root() == nullptr );
+        CHECK( copy.get_doc_model()->id_assigner_size() == 0 );
+
+        CHECK( copy.from_snapshot(data.data(), data.size()) == true );
+        CHECK( check_to_string(doc, copy) );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_06)
+    {
+        //@06. documents with run-time objects are not saved
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "08042-read-png-image.lms", Document::k_format_ldp);
+        string data;
+        CHECK( doc.to_snapshot(data) == false );
+        CHECK( data.empty() );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_07)
+    {
+        //@07. model loaded from snapshot can be edited
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "01030-ties.lms", Document::k_format_ldp);
+        string data;
+        CHECK( doc.to_snapshot(data) == true );
+
+        Document copy(m_libraryScope);
+        CHECK( copy.from_snapshot(data.data(), data.size()) == true );
+        ImoScore* pScore = static_cast<ImoScore*>( copy.get_content_item(0) );
+        ImoInstrument* pInstr = pScore->get_instrument(0);
+        ImoMusicData* pMD = pInstr->get_musicdata();
+        ImoNote* pNote = nullptr;
+        for (ImoObj* pImo = pMD->get_first_child(); pImo; pImo = pImo->get_next_sibling())
+        {
+            if (pImo->is_note() && static_cast<ImoNote*>(pImo)->is_tied_next())
+            {
+                pNote = static_cast<ImoNote*>(pImo);
+                break;
+            }
+        }
+        CHECK( pNote != nullptr );
+        CHECK( pNote && pNote->get_tie_next()->get_end_note()->is_tied_prev() );
+        if (pNote)
+        {
+            ImoNote* pEnd = pNote->get_tie_next()->get_end_note();
+            pMD->remove_child_imo(pEnd);
+            delete pEnd;
+            CHECK( pNote->is_tied_next() == false );
+        }
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshot_08)
+    {
+        //@08. truncated snapshots are rejected even when the header is consistent
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path + "unit-tests/conversion/20-wedge.xml",
+                      Document::k_format_mxl);
+        string data;
+        CHECK( doc.to_snapshot(data) == true );
+        string payload = data.substr(32);
+
+        Document copy(m_libraryScope);
+        string truncated = replace_payload(data, payload.substr(0, payload.size() - 5));
+        CHECK( copy.from_snapshot(truncated.data(), truncated.size()) == false );
+        string extended = replace_payload(data, payload + "more");
+        CHECK( copy.from_snapshot(extended.data(), extended.size()) == false );
+        CHECK( copy.get_im_root() == nullptr );
+        CHECK( copy.get_doc_model()->id_assigner_size() == 0 );
+
+        string same = replace_payload(data, payload);
+        CHECK( same == data );
+        CHECK( copy.from_snapshot(same.data(), same.size()) == true );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshots_cache_01)
+    {
+        //@01. snapshot is saved in cache and used next time the file is opened
+
+        string filename = m_scores_path + "unit-tests/conversion/13-tied-chords.xml";
+        MySnapshotsCache cache(m_scores_path, m_libraryScope.get_musicxml_options());
+        string path = cache.my_snapshot_path(filename, Document::k_format_mxl);
+        std::remove(path.c_str());
+
+        Document doc(m_libraryScope);
+        CHECK( cache.open_document(&doc, filename, Document::k_format_mxl) == 0 );
+        string data;
+        doc.to_snapshot(data);
+        CHECK( read_file(path) == data );
+
+        //replace cached snapshot by other document snapshot, to check that it is used
+        Document other(m_libraryScope);
+        other.from_file(m_scores_path + "unit-tests/conversion/20-wedge.xml",
+                        Document::k_format_mxl);
+        string otherData;
+        other.to_snapshot(otherData);
+        write_file(path, otherData);
+
+        Document copy(m_libraryScope);
+        CHECK( cache.open_document(&copy, filename, Document::k_format_mxl) == 0 );
+        CHECK( check_to_string(other, copy) );
+
+        std::remove(path.c_str());
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshots_cache_02)
+    {
+        //@02. invalid cached snapshot is ignored and replaced
+
+        string filename = m_scores_path + "unit-tests/conversion/13-tied-chords.xml";
+        MySnapshotsCache cache(m_scores_path, m_libraryScope.get_musicxml_options());
+        string path = cache.my_snapshot_path(filename, Document::k_format_mxl);
+        write_file(path, "invalid snapshot");
+
+        Document doc(m_libraryScope);
+        CHECK( cache.open_document(&doc, filename, Document::k_format_mxl) == 0 );
+        CHECK( doc.get_im_root() != nullptr );
+        string data;
+        doc.to_snapshot(data);
+        CHECK( read_file(path) == data );
+
+        std::remove(path.c_str());
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshots_cache_03)
+    {
+        //@03. key depends on content, format and options
+
+        MySnapshotsCache cache(m_scores_path, m_libraryScope.get_musicxml_options());
+        string path1 = cache.my_snapshot_path("content", Document::k_format_mxl);
+        CHECK( path1 != cache.my_snapshot_path("content.", Document::k_format_mxl) );
+        CHECK( path1 != cache.my_snapshot_path("content", Document::k_format_ldp) );
+
+        MusicXmlOptions* pOpt = m_libraryScope.get_musicxml_options();
+        bool fFixBeams = pOpt->fix_beams();
+        pOpt->fix_beams(!fFixBeams);
+        CHECK( path1 != cache.my_snapshot_path("content", Document::k_format_mxl) );
+        pOpt->fix_beams(fFixBeams);
+        CHECK( path1 == cache.my_snapshot_path("content", Document::k_format_mxl) );
+    }
+
+    TEST_FIXTURE(ImSnapshotTestFixture, snapshots_cache_04)
+    {
+        //@04. truncated cached snapshot, as left by an interrupted writer, is ignored
+        //@    and replaced by a complete one
+
+        string filename = m_scores_path + "unit-tests/conversion/13-tied-chords.xml";
+        MySnapshotsCache cache(m_scores_path, m_libraryScope.get_musicxml_options());
+        string path = cache.my_snapshot_path(filename, Document::k_format_mxl);
+        std::remove(path.c_str());
+
+        Document doc(m_libraryScope);
+        CHECK( cache.open_document(&doc, filename, Document::k_format_mxl) == 0 );
+        string data = read_file(path);
+        CHECK( data.size() > 100 );
+        write_file(path, data.substr(0, data.size() / 2));
+
+        Document copy(m_libraryScope);
+        CHECK( cache.open_document(&copy, filename, Document::k_format_mxl) == 0 );
+        CHECK( check_to_string(doc, copy) );
+        CHECK( read_file(path) == data );
+
+        std::remove(path.c_str());
+    }
+
+};
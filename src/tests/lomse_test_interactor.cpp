@@ -779,7 +779,7 @@ SUITE(InteractorTest)
         Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
 
         //get graphic model clicked object
-        LUnits x = 6357.74;
+        LUnits x = 6345.74;
         LUnits y = 4979.33;
         GraphicModel* pGM = pIntor->get_graphic_model(); //this also forces to engrave the score
         GmoObj* pGmo = pGM->hit_test(0, x, y);
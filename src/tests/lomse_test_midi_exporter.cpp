@@ -0,0 +1,336 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_midi_exporter.h"
+#include "lomse_injectors.h"
+#include "lomse_midi_table.h"
+#include "private/lomse_document_p.h"
+#include "lomse_internal_model.h"
+
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+//Helper, to hold a decoded SMF channel event
+struct SmfEvent
+{
+    int track;
+    long ticks;
+    int status;
+    int data1;
+    int data2;
+};
+
+//---------------------------------------------------------------------------------------
+class MidiExporterTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+    int m_numTracks;
+    int m_division;
+    vector<SmfEvent> m_events;      //channel events
+    vector<SmfEvent> m_meta;        //meta events: status is the meta type
+
+    MidiExporterTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+        , m_scores_path(TESTLIB_SCORES_PATH)
+        , m_numTracks(0)
+        , m_division(0)
+    {
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+    }
+
+    ~MidiExporterTestFixture()    //TearDown fixture
+    {
+    }
+
+    int read_int(const string& smf, size_t pos, int bytes)
+    {
+        int value = 0;
+        for (int i=0; i < bytes; ++i)
+            value = (value << 8) | (static_cast<unsigned char>(smf[pos + i]));
+        return value;
+    }
+
+    long read_variable_length(const string& smf, size_t& pos)
+    {
+        long value = 0;
+        unsigned char byte;
+        do
+        {
+            byte = static_cast<unsigned char>(smf[pos++]);
+            value = (value << 7) | (byte & 0x7F);
+        } while (byte & 0x80);
+        return value;
+    }
+
+    //decodes the SMF. Returns false if not well formed
+    bool decode(const string& smf)
+    {
+        if (smf.size() < 14 || smf.compare(0, 4, "MThd") != 0
+            || read_int(smf, 4, 4) != 6 || read_int(smf, 8, 2) != 1)
+        {
+            return false;
+        }
+        m_numTracks = read_int(smf, 10, 2);
+        m_division = read_int(smf, 12, 2);
+
+        size_t pos = 14;
+        for (int iTrack=0; iTrack < m_numTracks; ++iTrack)
+        {
+            if (pos + 8 > smf.size() || smf.compare(pos, 4, "MTrk") != 0)
+                return false;
+            size_t end = pos + 8 + size_t(read_int(smf, pos + 4, 4));
+            if (end > smf.size())
+                return false;
+            pos += 8;
+
+            long ticks = 0;
+            int status = 0;
+            bool fEndOfTrack = false;
+            while (pos < end)
+            {
+                ticks += read_variable_length(smf, pos);
+                int byte = static_cast<unsigned char>(smf[pos]);
+                if (byte == 0xFF)
+                {
+                    int type = static_cast<unsigned char>(smf[pos + 1]);
+                    pos += 2;
+                    long length = read_variable_length(smf, pos);
+                    m_meta.push_back({iTrack, ticks, type, int(length), 0});
+                    pos += size_t(length);
+                    fEndOfTrack = (type == 0x2F);
+                    status = 0;
+                    continue;
+                }
+                if (byte & 0x80)
+                {
+                    status = byte;
+                    ++pos;
+                }
+                int data1 = static_cast<unsigned char>(smf[pos++]);
+                int data2 = -1;
+                if ((status & 0xF0) != 0xC0)
+                    data2 = static_cast<unsigned char>(smf[pos++]);
+                m_events.push_back({iTrack, ticks, status, data1, data2});
+            }
+            if (pos != end || !fEndOfTrack)
+                return false;
+        }
+        return pos == smf.size();
+    }
+
+    int count_events(int status)
+    {
+        int count = 0;
+        for (const SmfEvent& ev : m_events)
+        {
+            if ((ev.status & 0xF0) == status)
+                ++count;
+        }
+        return count;
+    }
+
+    int count_table_note_on(SoundEventsTable* pTable, int fromMeasure, int toMeasure)
+    {
+        int count = 0;
+        for (SoundEvent* pEv : pTable->get_events())
+        {
+            if (pEv->EventType == SoundEvent::k_note_on
+                && pEv->Measure >= fromMeasure && pEv->Measure <= toMeasure)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+};
+
+SUITE(MidiExporterTest)
+{
+
+    TEST_FIXTURE(MidiExporterTestFixture, midi_exporter_01)
+    {
+        //@01. simple score: header, tracks and events
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 e)(n g4 e) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+
+        MidiExporter exporter;
+        exporter.set_tempo(120);
+        CHECK( decode(exporter.get_smf(pScore)) );
+
+        CHECK( m_numTracks == 2 );
+        CHECK( m_division == 960 );
+        CHECK( m_events.size() == 7 );
+        CHECK( count_events(0xC0) == 1 );
+        CHECK( count_events(0x90) == 3 );
+        CHECK( count_events(0x80) == 3 );
+
+        //tempo: 500000 us per quarter note. Time signature in track 0
+        CHECK( m_meta.size() == 4 );
+        CHECK( m_meta[0].track == 0 && m_meta[0].status == 0x51 && m_meta[0].data1 == 3 );
+        CHECK( m_meta[1].track == 0 && m_meta[1].status == 0x58 && m_meta[1].data1 == 4 );
+
+        //notes
+        CHECK( m_events[0].track == 1 && m_events[0].status == 0xC0 );
+        CHECK( m_events[1].status == 0x90 && m_events[1].data1 == 60 );
+        CHECK( m_events[1].ticks == 0L );
+        CHECK( m_events[2].status == 0x80 && m_events[2].data1 == 60 );
+        CHECK( m_events[2].ticks == 960L );
+        CHECK( m_events[3].status == 0x90 && m_events[3].data1 == 64 );
+        CHECK( m_events[3].ticks == 960L );
+        CHECK( m_events[6].status == 0x80 && m_events[6].data1 == 67 );
+        CHECK( m_events[6].ticks == 1920L );
+    }
+
+    TEST_FIXTURE(MidiExporterTestFixture, midi_exporter_02)
+    {
+        //@02. repetitions are unrolled
+        //  |    |    |    :|     |     |
+        //  1    2    3     4     5
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path
+                      + "unit-tests/repeats/01-repeat-end-repetition-barline.xml",
+                      Document::k_format_mxl);
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+
+        MidiExporter exporter;
+        CHECK( decode(exporter.get_smf(pScore)) );
+
+        int numNotes = count_table_note_on(pTable, 1, 3) * 2
+                       + count_table_note_on(pTable, 4, pTable->get_num_measures());
+        CHECK( count_events(0x90) == numNotes );
+        CHECK( count_events(0x80) == numNotes );
+
+        //time never goes backwards
+        bool fOrdered = true;
+        for (size_t i=1; i < m_events.size(); ++i)
+        {
+            if (m_events[i].track == m_events[i-1].track
+                && m_events[i].ticks < m_events[i-1].ticks)
+            {
+                fOrdered = false;
+            }
+        }
+        CHECK( fOrdered );
+
+        //jumps counters not modified
+        for (int i=0; i < pTable->num_jumps(); ++i)
+        {
+            CHECK( pTable->get_jump(i)->get_executed() == 0 );
+            CHECK( pTable->get_jump(i)->get_visited() == 0 );
+        }
+    }
+
+    TEST_FIXTURE(MidiExporterTestFixture, midi_exporter_03)
+    {
+        //@03. one track per channel
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)"
+            "(instrument (infoMIDI 2 0)(musicData (clef G)(n c4 q)(n e4 q)))"
+            "(instrument (infoMIDI 40 1)(musicData (clef F4)(n c3 h))) )" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+
+        MidiExporter exporter;
+        CHECK( decode(exporter.get_smf(pScore)) );
+
+        CHECK( m_numTracks == 3 );
+        CHECK( count_events(0x90) == 3 );
+        for (const SmfEvent& ev : m_events)
+        {
+            CHECK( ev.track == (ev.status & 0x0F) + 1 );
+        }
+    }
+
+    TEST_FIXTURE(MidiExporterTestFixture, midi_exporter_04)
+    {
+        //@04. tempo changes in the score. Fixed tempo replaces them
+
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)"
+            "(metronome q 120)(n g4 h)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+
+        MidiExporter exporter;
+        CHECK( decode(exporter.get_smf(pScore)) );
+
+        vector<SmfEvent> tempos;
+        for (const SmfEvent& ev : m_meta)
+        {
+            if (ev.status == 0x51)
+                tempos.push_back(ev);
+        }
+        CHECK( tempos.size() == 2 );
+        CHECK( tempos.size() == 2 && tempos[0].ticks == 0L );
+        CHECK( tempos.size() == 2 && tempos[1].ticks == 1920L );
+
+        m_meta.clear();
+        m_events.clear();
+        exporter.set_tempo(90);
+        CHECK( decode(exporter.get_smf(pScore)) );
+        int numTempos = 0;
+        for (const SmfEvent& ev : m_meta)
+        {
+            if (ev.status == 0x51)
+                ++numTempos;
+        }
+        CHECK( numTempos == 1 );
+        CHECK( pScore->get_midi_table()->get_tempo_map()->get_tempo_override() == 0.0f );
+    }
+
+    TEST_FIXTURE(MidiExporterTestFixture, midi_exporter_05)
+    {
+        //@05. shared table not modified. Player state is ignored
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path
+                      + "unit-tests/repeats/01-repeat-end-repetition-barline.xml",
+                      Document::k_format_mxl);
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        MidiExporter exporter;
+        string smf = exporter.get_smf(pScore);
+
+        //a playback in progress: jumps executed and tempo changed
+        CHECK( pTable->num_jumps() > 0 );
+        JumpEntry* pJump = pTable->get_jump(0);
+        pJump->increment_visited();
+        pJump->increment_applied();
+        TempoMap* pTempoMap = pTable->get_tempo_map();
+        pTempoMap->set_tempo_override(200.0f);
+
+        CHECK( exporter.get_smf(pScore) == smf );
+        CHECK( pJump->get_visited() == 1 );
+        CHECK( pJump->get_executed() == 1 );
+        CHECK( pTempoMap->get_tempo_override() == 200.0f );
+
+        exporter.set_tempo(90);
+        exporter.get_smf(pScore);
+        CHECK( pTempoMap->get_tempo_override() == 200.0f );
+    }
+
+};
+
@@ -17,6 +17,7 @@
 #include "private/lomse_document_p.h"
 #include "lomse_internal_model.h"
 #include "lomse_im_note.h"
+#include "lomse_staffobjs_table.h"
 
 
 using namespace UnitTest;
@@ -99,6 +100,22 @@ public:
         m_pTable = m_pScore->get_midi_table();
     }
 
+    ImoStaffObj* find_staffobj(ImoScore* pScore, int measure, int type)
+    {
+        //first staffobj of given type in measure (1..n)
+        ColStaffObjs* pColStaffObjs = pScore->get_staffobjs_table();
+        for (ColStaffObjsEntry* pEntry = pColStaffObjs->front(); pEntry;
+             pEntry = pEntry->get_next())
+        {
+            if (pEntry->measure() + 1 == measure
+                && pEntry->imo_object()->get_obj_type() == type)
+            {
+                return pEntry->imo_object();
+            }
+        }
+        return nullptr;
+    }
+
     bool check_jump(int i, int measure, int timesValid, int timesBefore, int event)
     {
         JumpEntry* pEntry = static_cast<JumpEntry*>( m_pTable->get_jump(i) );
@@ -151,6 +168,17 @@ public:
             cout << "      " << it->dump_entry();
     }
 
+    bool check_timeline(int iLine, PlaybackTimeline* pTimeline,
+                        const std::vector<int>& measures)
+    {
+        bool fOk = (pTimeline->num_segments() == int(measures.size()));
+        for (int i=0; fOk && i < pTimeline->num_segments(); ++i)
+            fOk = (pTimeline->get_segment(i).measure == measures[i]);
+        if (!fOk)
+            cout << test_name() << " (line " << iLine << ") " << pTimeline->dump_timeline();
+        return fOk;
+    }
+
     bool check_num_events(int events, int expected)
     {
         if (events != expected)
@@ -1355,6 +1383,241 @@ SUITE(MidiTableTest)
         CHECK( check_measures_jump(__LINE__, jumps[3], 5,0) );      //from 5 to end
     }
 
+
+    //@ Playback timeline ---------------------------------------------------------------
+
+    TEST_FIXTURE(MidiTableTestFixture, timeline_01)
+    {
+        //@001. score with no repetitions: one segment per measure
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)(n g4 h)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+
+        PlaybackTimeline* pTimeline = pScore->get_midi_table()->get_timeline();
+
+        CHECK( check_timeline(__LINE__, pTimeline, {1, 2}) );
+        CHECK( pTimeline->get_segment(1).time == 128L );
+        CHECK( pTimeline->get_segment(1).pass == 1 );
+        CHECK( pTimeline->get_duration() == 256L );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, timeline_02)
+    {
+        //@002. end-repetition barline
+        //  |    |    |    :|     |     |
+        //  1    2    3     4     5
+        load_mxl_score_for_test("repeats/01-repeat-end-repetition-barline.xml");
+        PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+
+        CHECK( check_timeline(__LINE__, pTimeline, {1, 2, 3, 1, 2, 3, 4, 5}) );
+        CHECK( pTimeline->num_passes(2) == 2 );
+        CHECK( pTimeline->num_passes(4) == 1 );
+        CHECK( pTimeline->find_segment(2, 2) == 4 );
+        CHECK( pTimeline->find_segment(4, 2) == -1 );
+
+        //times increase. Measures 1 to 3 are repeated
+        PlaybackSegment& seg1 = pTimeline->get_segment(0);
+        PlaybackSegment& seg2 = pTimeline->get_segment(3);
+        PlaybackSegment& seg3 = pTimeline->get_segment(6);
+        CHECK( seg2.timepos == seg1.timepos );
+        CHECK( seg2.time == 768L );
+        CHECK( seg3.timepos == 768L );
+        CHECK( seg3.time == 1536L );
+        CHECK( pTimeline->get_duration() == 2048L );
+
+        //jumps not modified
+        CHECK( m_pTable->get_jump(0)->get_executed() == 0 );
+        CHECK( m_pTable->get_jump(0)->get_visited() == 0 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, timeline_03)
+    {
+        //@003. find segment by time
+        load_mxl_score_for_test("repeats/01-repeat-end-repetition-barline.xml");
+        PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+
+        for (int i=0; i < pTimeline->num_segments(); ++i)
+        {
+            long time = pTimeline->get_segment(i).time;
+            CHECK( pTimeline->find_segment_at(time) == i );
+            CHECK( pTimeline->find_segment_at(time + 1) == i );
+            if (i > 0)
+                CHECK( pTimeline->find_segment_at(time - 1) == i - 1 );
+        }
+        CHECK( pTimeline->find_segment_at(-1L) == -1 );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, timeline_04)
+    {
+        //@004. jumps state restored for a segment
+        //                   To                 DS al
+        //            Segno  Coda                Coda  Coda
+        //  |         |         |:      :|           ||         |
+        //  1         2         3        4            5
+        //                    J5,1,1   J3,1        J2,1
+        load_mxl_score_for_test("repeats/58-repeat-dal-segno-al-coda.xml");
+        PlaybackTimeline* pTimeline = m_pTable->get_timeline();
+
+        CHECK( check_timeline(__LINE__, pTimeline, {1, 2, 3, 3, 4, 2, 5}) );
+
+        //second pass through measure 2: 'To Coda' is executed
+        int iSegment = pTimeline->find_segment(2, 2);
+        CHECK( iSegment == 5 );
+        pTimeline->restore_jumps(iSegment);
+        PlaybackSegment& segment = pTimeline->get_segment(iSegment);
+        for (int j=0; j < m_pTable->num_jumps(); ++j)
+        {
+            JumpEntry* pJump = m_pTable->get_jump(j);
+            CHECK( pJump->get_executed() == segment.jumps[j].first );
+            CHECK( pJump->get_visited() == segment.jumps[j].second );
+        }
+        m_pTable->reset_jumps();
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, tempo_map_01)
+    {
+        //@001. score without tempo changes: base tempo and global override
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)(n g4 h)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        TempoMap* pMap = pTable->get_tempo_map();
+
+        CHECK( pTable->get_tempo_changes().size() == 0 );
+        CHECK( pMap->num_breakpoints() == 1 );
+        CHECK( pMap->get_tempo_at(0.0) == 60.0f );
+        CHECK( pMap->get_time_for(64.0) == 1000000ULL );
+        CHECK( pMap->get_event_time(pTable->num_events() - 1) == 4000000ULL );
+
+        pMap->set_tempo_override(120.0f);
+        CHECK( pMap->get_time_for(64.0) == 500000ULL );
+        CHECK( pMap->get_event_time(pTable->num_events() - 1) == 2000000ULL );
+
+        pMap->set_tempo_override(0.0f);
+        CHECK( pMap->get_time_for(64.0) == 1000000ULL );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, tempo_map_02)
+    {
+        //@002. tempo changes from metronome marks
+        //  q=60              q=120       e.=40 (q=30)
+        //  |  c4    e4     |   g4      |  c4    e4    |
+        //  0        64    128         256    320     384
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)"
+            "(metronome q 120)(n g4 h)(barline)"
+            "(metronome e. 40)(n c4 q)(n e4 q)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        TempoMap* pMap = pTable->get_tempo_map();
+
+//        cout << test_name() << endl << pMap->dump_tempo_map();
+
+        CHECK( pTable->get_tempo_changes().size() == 2 );
+        CHECK( pMap->num_breakpoints() == 3 );
+        CHECK( pMap->get_breakpoint_timepos(1) == 128.0 );
+        CHECK( pMap->get_tempo_at(200.0) == 120.0f );
+        CHECK( pMap->get_tempo_at(256.0) == 30.0f );
+
+        //event times
+        CHECK( pMap->get_event_time(6) == 2000000ULL );     //g4 on
+        CHECK( pMap->get_event_time(8) == 3000000ULL );     //c4 on, measure 3
+        CHECK( pMap->get_event_time(10) == 5000000ULL );    //e4 on, measure 3
+        CHECK( pMap->get_duration(128.0, 384.0) == 5000000ULL );
+
+        //inverse mapping
+        CHECK( is_equal_time(pMap->get_timepos_for(2500000ULL), 192.0) );
+        CHECK( is_equal_time(pMap->get_timepos_for(4000000ULL), 288.0) );
+
+        //changing the base tempo only affects the segment before first change
+        pMap->set_base_tempo(120.0f);
+        CHECK( pMap->get_event_time(6) == 1000000ULL );
+        CHECK( pMap->get_event_time(8) == 2000000ULL );
+
+        //override replaces all tempo changes
+        pMap->set_tempo_override(120.0f);
+        CHECK( pMap->get_event_time(10) == 2500000ULL );
+    }
+
+
+    TEST_FIXTURE(MidiTableTestFixture, table_update_01)
+    {
+        //@001. note modified: only its measure is updated. Result as a new table
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)(n g4 q)(n c5 q)(barline)"
+            "(n e4 h)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        SoundEvent* pEvent = pTable->get_events()[pTable->get_first_event_for_measure(1)];
+        SoundEvent* pLast = pTable->get_events()[pTable->get_first_event_for_measure(3)];
+
+        ImoNote* pNote = static_cast<ImoNote*>( find_staffobj(pScore, 2, k_imo_note_regular) );
+        pNote->set_notated_pitch(k_step_A, 4, k_no_accidentals);
+        pScore->end_of_changes();
+
+        CHECK( pTable->is_modified() == true );
+        CHECK( pScore->get_midi_table() == pTable );
+        CHECK( pTable->is_modified() == false );
+        CHECK( pTable->num_updated_measures() == 1 );
+
+        //events for other measures are not re-created
+        CHECK( pTable->get_events()[pTable->get_first_event_for_measure(1)] == pEvent );
+        CHECK( pTable->get_events()[pTable->get_first_event_for_measure(3)] == pLast );
+        CHECK( pTable->get_events()[pTable->get_first_event_for_measure(2)]->NotePitch == 69 );
+
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, table_update_02)
+    {
+        //@002. no changes in sound events: nothing updated
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)(n g4 q)(n c5 q)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        string before = pTable->dump_midi_events();
+
+        pScore->end_of_changes();
+
+        CHECK( pScore->get_midi_table() == pTable );
+        CHECK( pTable->num_updated_measures() == 0 );
+        CHECK( pTable->dump_midi_events() == before );
+    }
+
+    TEST_FIXTURE(MidiTableTestFixture, table_update_03)
+    {
+        //@003. repetition added: all table re-created, jumps updated
+        Document doc(m_libraryScope);
+        doc.from_string("(score (vers 2.0)(instrument (musicData "
+            "(clef G)(time 2 4)(n c4 q)(n e4 q)(barline)(n g4 q)(n c5 q)(barline)"
+            "(n e4 h)(barline) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        CHECK( pTable->num_jumps() == 0 );
+
+        ImoBarline* pBar = static_cast<ImoBarline*>(
+                                    find_staffobj(pScore, 2, k_imo_barline) );
+        pBar->set_type(k_barline_end_repetition);
+        pBar->set_num_repeats(1);
+        pScore->end_of_changes();
+
+        CHECK( pScore->get_midi_table() == pTable );
+        CHECK( pTable->num_updated_measures() == -1 );
+        CHECK( pTable->num_jumps() == 1 );
+        CHECK( pTable->num_jumps() == 1 && pTable->get_jump(0)->get_to_measure() == 1 );
+
+        MySoundEventsTable table(pScore);
+        table.create_table();
+        CHECK( pTable->dump_midi_events() == table.dump_midi_events() );
+    }
+
 }
 
 
@@ -114,6 +114,18 @@ SUITE(MusicXmlOptionsTest)
         CHECK( newopt->use_default_clefs() == false );
     }
 
+    TEST_FIXTURE(MusicXmlOptionsTestFixture, MusicXmlOptions_5)
+    {
+        //@05. analyse parts in parallel. Default value is false
+        MusicXmlOptions* opt = m_libraryScope.get_musicxml_options();
+        CHECK( opt->analyse_parts_in_parallel() == false );
+        opt->analyse_parts_in_parallel(true);
+
+        MusicXmlOptions* newopt = m_libraryScope.get_musicxml_options();
+        CHECK( newopt->analyse_parts_in_parallel() == true );
+        CHECK( newopt->fix_beams() == true );
+    }
+
 };
 
 
@@ -9689,5 +9701,128 @@ SUITE(MxlAnalyserTest)
         delete pRoot;
     }
 
+#if (LOMSE_ENABLE_THREADS == 1)
+    TEST_FIXTURE(MxlAnalyserTestFixture, mxl_analyser_90020)
+    {
+        //@90020 parts analysed in parallel. Same model, ids and messages
+
+        string filename = m_scores_path + "00623-clef-change-lyrics.xml";
+
+        stringstream msg1;
+        Document doc1(m_libraryScope, msg1);
+        doc1.from_file(filename, Document::k_format_mxl);
+
+        m_libraryScope.get_musicxml_options()->analyse_parts_in_parallel(true);
+        stringstream msg2;
+        Document doc2(m_libraryScope, msg2);
+        doc2.from_file(filename, Document::k_format_mxl);
+
+        CHECK( doc2.get_im_root()->to_string(true) == doc1.get_im_root()->to_string(true) );
+        CHECK( msg2.str() == msg1.str() );
+        CHECK( doc2.get_im_root()->get_num_content_items() == 1 );
+    }
+
+    TEST_FIXTURE(MxlAnalyserTestFixture, mxl_analyser_90021)
+    {
+        //@90021 parts analysed in parallel. Errors reported in <part> order
+
+        m_libraryScope.get_musicxml_options()->analyse_parts_in_parallel(true);
+        stringstream errormsg;
+        Document doc(m_libraryScope);
+        XmlParser parser;
+        stringstream expected;
+        expected << "Line 0. Part 'P1', measure '1'. Error: G clef only supported in lines 1 or 2. Line changed to 2."
+                 << endl
+                 << "Line 0. Part 'P2', measure '1'. Error: F clef only supported in lines 3, 4 or 5. Line changed to 4."
+                 << endl;
+        parser.parse_text(
+            "<score-partwise version='3.0'><part-list>"
+            "<score-part id='P1'><part-name>Music</part-name></score-part>"
+            "<score-part id='P2'><part-name>Music</part-name></score-part>"
+            "</part-list>"
+            "<part id='P1'><measure number='1'>"
+                "<attributes><clef><sign>G</sign><line>3</line></clef></attributes>"
+                "<note><pitch><step>C</step><octave>4</octave></pitch>"
+                    "<duration>4</duration><type>whole</type></note>"
+            "</measure></part>"
+            "<part id='P2'><measure number='1'>"
+                "<attributes><clef><sign>F</sign><line>1</line></clef></attributes>"
+            "</measure></part>"
+            "</score-partwise>"
+        );
+        MyMxlAnalyser a(errormsg, m_libraryScope, &doc, &parser);
+        XmlNode* tree = parser.get_tree_root();
+        ImoObj* pRoot =  a.analyse_tree(tree, "string:");
+
+        CHECK( check_errormsg(errormsg, expected) );
+        ImoDocument* pDoc = dynamic_cast<ImoDocument*>( pRoot );
+        CHECK( pDoc != nullptr );
+        if (pDoc)
+        {
+            ImoScore* pScore = dynamic_cast<ImoScore*>( pDoc->get_content_item(0) );
+            CHECK( pScore != nullptr );
+            if (pScore)
+            {
+                CHECK( pScore->get_num_instruments() == 2 );
+                ImoMusicData* pMD = pScore->get_instrument(0)->get_musicdata();
+                CHECK( pMD->get_num_items() == 3 );
+                CHECK( pMD->get_first_child()->get_doc_model() == doc.get_doc_model() );
+                CHECK( pMD->get_last_child()->get_doc_model() == doc.get_doc_model() );
+            }
+        }
+
+        delete pRoot;
+    }
+
+    TEST_FIXTURE(MxlAnalyserTestFixture, mxl_analyser_90022)
+    {
+        //@90022 parts analysed in parallel. Slur numbers as in sequential analysis
+        //@      when slur numbers are reused in other parts
+
+        string part =
+            "<measure number='1'>"
+                "<attributes><divisions>1</divisions>"
+                    "<clef><sign>G</sign><line>2</line></clef></attributes>"
+                "<note><pitch><step>C</step><octave>4</octave></pitch>"
+                    "<duration>1</duration><type>quarter</type>"
+                    "<notations><slur number='2' type='start'/></notations></note>"
+                "<note><pitch><step>D</step><octave>4</octave></pitch>"
+                    "<duration>1</duration><type>quarter</type>"
+                    "<notations><slur number='2' type='stop'/>"
+                        "<slur number='1' type='start'/></notations></note>"
+                "<note><pitch><step>E</step><octave>4</octave></pitch>"
+                    "<duration>1</duration><type>quarter</type>"
+                    "<notations><slur number='1' type='stop'/></notations></note>"
+            "</measure>";
+        string src =
+            "<score-partwise version='3.0'><part-list>"
+            "<score-part id='P1'><part-name>Music</part-name></score-part>"
+            "<score-part id='P2'><part-name>Music</part-name></score-part>"
+            "<score-part id='P3'><part-name>Music</part-name></score-part>"
+            "</part-list>"
+            "<part id='P1'>" + part + "</part>"
+            "<part id='P2'>" + part + "</part>"
+            "<part id='P3'>" + part + "</part>"
+            "</score-partwise>";
+
+        stringstream msg1;
+        Document doc1(m_libraryScope, msg1);
+        doc1.from_string(src, Document::k_format_mxl);
+
+        m_libraryScope.get_musicxml_options()->analyse_parts_in_parallel(true);
+        stringstream msg2;
+        Document doc2(m_libraryScope, msg2);
+        doc2.from_string(src, Document::k_format_mxl);
+
+        string model = doc1.get_im_root()->to_string(true);
+//        cout << test_name() << endl << model << endl;
+        CHECK( doc2.get_im_root()->to_string(true) == model );
+        CHECK( msg2.str() == msg1.str() );
+        CHECK( model.find("(slur#") != string::npos );
+        CHECK( model.find(" 3 start") == string::npos );
+    }
+
+#endif  //LOMSE_ENABLE_THREADS == 1
+
 }
 
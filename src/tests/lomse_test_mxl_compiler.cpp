@@ -15,6 +15,7 @@
 #include "lomse_injectors.h"
 #include "private/lomse_document_p.h"
 #include "lomse_mxl_compiler.h"
+#include "lomse_compressed_mxl_compiler.h"
 #include "lomse_internal_model.h"
 
 using namespace UnitTest;
@@ -104,5 +105,27 @@ SUITE(MxlCompilerTest)
         delete pRoot;
     }
 
+#if (LOMSE_ENABLE_COMPRESSION == 1)
+    TEST_FIXTURE(MxlCompilerTestFixture, MxlCompilerFromFile_101)
+    {
+        //101 - compile compressed .mxl file
+        Document doc(m_libraryScope);
+        CompressedMxlCompiler compiler(LOMSE_NEW MxlCompiler(m_libraryScope, &doc));
+        string path = m_scores_path + "10015-compressed-hello-world.mxl";
+        ImoObj* pRoot =  compiler.compile_file(path);
+        CHECK( compiler.get_file_locator() == path );
+        ImoDocument* pDoc = dynamic_cast<ImoDocument*>(pRoot);
+        CHECK( pDoc && pDoc->get_num_content_items() == 1 );
+        ImoScore* pScore = pDoc ? dynamic_cast<ImoScore*>( pDoc->get_content_item(0) ) : nullptr;
+        CHECK( pScore && pScore->get_num_instruments() == 1 );
+        ImoInstrument* pInstr = pScore ? pScore->get_instrument(0) : nullptr;
+        ImoMusicData* pMD = pInstr ? pInstr->get_musicdata() : nullptr;
+        CHECK( pMD && pMD->get_num_items() == 5 );
+        CHECK( compiler.get_num_errors() == 0 );
+
+        delete pRoot;
+    }
+#endif
+
 };
 
@@ -0,0 +1,204 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_overlays_generator.h"
+#include "lomse_visual_effect.h"
+#include "lomse_bitmap_drawer.h"
+#include "lomse_doorway.h"
+
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+// helper: a translucent square
+class MySquareEffect : public VisualEffect
+{
+public:
+    UPoint m_pos;
+    Color m_color;
+
+    MySquareEffect(LibraryScope& libraryScope, UPoint pos, Color color)
+        : VisualEffect(nullptr, libraryScope)
+        , m_pos(pos)
+        , m_color(color)
+    {
+        m_fVisible = true;
+    }
+    ~MySquareEffect() {}
+
+    void on_draw(BitmapDrawer* pDrawer) override
+    {
+        pDrawer->begin_path();
+        pDrawer->fill(m_color);
+        pDrawer->stroke_none();
+        pDrawer->rect(m_pos, USize(1000.0f, 1000.0f), 100.0f);
+        pDrawer->end_path();
+        pDrawer->render();
+    }
+
+    URect get_bounds() override { return URect(m_pos, USize(1000.0f, 1000.0f)); }
+};
+
+//---------------------------------------------------------------------------------------
+class OverlaysGeneratorTestFixture
+{
+public:
+    LomseDoorway m_doorway;
+    LibraryScope* m_pScope;
+
+    OverlaysGeneratorTestFixture()     //SetUp fixture
+    {
+        m_doorway.init_library(k_pix_format_rgba32, 96);
+        m_pScope = m_doorway.get_library_scope();
+    }
+
+    ~OverlaysGeneratorTestFixture()    //TearDown fixture
+    {
+    }
+
+    void draw_background(BitmapDrawer& drawer, vector<unsigned char>& buf)
+    {
+        buf.assign(200 * 200 * 4, 0);
+        drawer.set_rendering_buffer(&buf[0], 200, 200, Color(255, 255, 255));
+        TransAffine transform;
+        drawer.set_affine_transformation(transform);
+        drawer.begin_path();
+        drawer.fill(Color(0, 0, 255));
+        drawer.move_to(0.0, 0.0);
+        drawer.line_to(5000.0, 2000.0);
+        drawer.line_to(1000.0, 5000.0);
+        drawer.close_path();
+        drawer.end_path();
+        drawer.render();
+    }
+
+    //the expected result: background and visible effects drawn in order
+    void draw_expected(vector<unsigned char>& buf, vector<MySquareEffect*>& effects)
+    {
+        BitmapDrawer drawer(*m_pScope);
+        draw_background(drawer, buf);
+        for (MySquareEffect* pEffect : effects)
+        {
+            if (pEffect->is_visible())
+                pEffect->on_draw(&drawer);
+        }
+    }
+};
+
+SUITE(OverlaysGeneratorTest)
+{
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, bitmap_drawer_drawn_area)
+    {
+        //@00. drawer informs about the pixels modified
+
+        vector<unsigned char> buf(200 * 200 * 4, 0);
+        BitmapDrawer drawer(*m_pScope);
+        drawer.set_rendering_buffer(&buf[0], 200, 200, Color(255, 255, 255));
+        TransAffine transform;
+        drawer.set_affine_transformation(transform);
+        MySquareEffect effect(*m_pScope, UPoint(1000.0f, 2000.0f), Color(255, 0, 0));
+
+        drawer.reset_drawn_area();
+        CHECK( drawer.get_drawn_area().is_empty() );
+        effect.on_draw(&drawer);
+        VRect area = drawer.get_drawn_area();
+        //1000 LUnits = 37.8 pixels at 96 ppi
+        CHECK( area == VRect(VPoint(37, 75), VPoint(76, 114)) );
+        CHECK( buf[(74 * 200 + 50) * 4 + 1] == 255 );
+        CHECK( buf[(75 * 200 + 50) * 4 + 1] != 255 );
+    }
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, overlays_generator_01)
+    {
+        //@01. updating one effect gives the same result than drawing all
+
+        vector<unsigned char> buf, expected;
+        BitmapDrawer drawer(*m_pScope);
+        draw_background(drawer, buf);
+        OverlaysGenerator generator(nullptr, *m_pScope);
+        generator.set_rendering_buffer(&buf[0], 200, 200);
+        generator.on_new_background();
+
+        vector<MySquareEffect*> effects;
+        effects.push_back(LOMSE_NEW MySquareEffect(*m_pScope, UPoint(500.0f, 500.0f),
+                                                   Color(255, 0, 0, 128)));
+        effects.push_back(LOMSE_NEW MySquareEffect(*m_pScope, UPoint(1000.0f, 800.0f),
+                                                   Color(0, 255, 0, 128)));
+        effects.push_back(LOMSE_NEW MySquareEffect(*m_pScope, UPoint(3000.0f, 3000.0f),
+                                                   Color(0, 0, 0, 128)));
+        for (MySquareEffect* pEffect : effects)
+            generator.add_visual_effect(pEffect);
+        generator.update_all_visual_effects(&drawer);
+        draw_expected(expected, effects);
+        CHECK( buf == expected );
+
+        //move effect below other effect
+        effects[0]->m_pos = UPoint(1300.0f, 1200.0f);
+        generator.update_visual_effect(effects[0], &drawer);
+        draw_expected(expected, effects);
+        CHECK( buf == expected );
+
+        //move effect away
+        effects[1]->m_pos = UPoint(4000.0f, 200.0f);
+        generator.update_visual_effect(effects[1], &drawer);
+        draw_expected(expected, effects);
+        CHECK( buf == expected );
+
+        //hide effect
+        effects[0]->hide();
+        generator.update_visual_effect(effects[0], &drawer);
+        draw_expected(expected, effects);
+        CHECK( buf == expected );
+
+        //remove effect
+        generator.remove_visual_effect(effects[2]);
+        delete effects[2];
+        effects.pop_back();
+        effects[1]->m_pos = UPoint(1500.0f, 1500.0f);
+        generator.update_visual_effect(effects[1], &drawer);
+        draw_expected(expected, effects);
+        CHECK( buf == expected );
+    }
+
+    TEST_FIXTURE(OverlaysGeneratorTestFixture, overlays_generator_02)
+    {
+        //@02. restore background removes all overlays
+
+        vector<unsigned char> buf, expected;
+        BitmapDrawer drawer(*m_pScope);
+        draw_background(drawer, buf);
+        OverlaysGenerator generator(nullptr, *m_pScope);
+        generator.set_rendering_buffer(&buf[0], 200, 200);
+        generator.on_new_background();
+
+        vector<MySquareEffect*> effects;
+        effects.push_back(LOMSE_NEW MySquareEffect(*m_pScope, UPoint(500.0f, 500.0f),
+                                                   Color(255, 0, 0, 128)));
+        generator.add_visual_effect(effects[0]);
+        generator.update_all_visual_effects(&drawer);
+        effects[0]->hide();
+        draw_expected(expected, effects);
+        CHECK( buf != expected );
+
+        generator.restore_background();
+        CHECK( buf == expected );
+    }
+
+};
+
@@ -0,0 +1,251 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_page_cache.h"
+#include "lomse_bitmap_drawer.h"
+#include "lomse_doorway.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+#include "private/lomse_document_p.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class PageCacheTestFixture
+{
+public:
+    std::string m_scores_path;
+    LomseDoorway m_doorway;
+    LibraryScope* m_pScope;
+    int m_numRenders;
+
+    PageCacheTestFixture()     //SetUp fixture
+        : m_scores_path(TESTLIB_SCORES_PATH)
+        , m_numRenders(0)
+    {
+        m_doorway.init_library(k_pix_format_rgba32, 96);
+        m_pScope = m_doorway.get_library_scope();
+    }
+
+    ~PageCacheTestFixture()    //TearDown fixture
+    {
+        m_pScope->set_page_cache_budget(0);
+    }
+
+    PageKey create_key(int iPage)
+    {
+        PageKey key;
+        key.docModelRef = 1L;
+        key.gmodelId = -1L;
+        key.gmodelVersion = 0L;
+        key.layoutConstrains = 0;
+        key.iPage = iPage;
+        key.bounds = URect(0.0f, 0.0f, 1000.0f, 1000.0f);
+        key.scale = 1.0;
+        key.pixelFormat = k_pix_format_rgba32;
+        return key;
+    }
+
+    //draws a page made of horizontal lines
+    void draw_page(PageCache& cache, int iPage, BitmapDrawer& drawer)
+    {
+        cache.draw_page(create_key(iPage), VRect(0, 0, 40, 30), this, &drawer, 5, 5,
+                        [&](RenderingBuffer& rbuf)
+        {
+            ++m_numRenders;
+            for (unsigned y=0; y < rbuf.height(); ++y)
+                memset(rbuf.row_ptr(int(y)), int(y * 8 + iPage), rbuf.width() * 4);
+        });
+    }
+
+    Presenter* open_document(vector<unsigned char>& buf)
+    {
+        Presenter* pPresenter = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        buf.assign(700 * 500 * 4, 0);
+        pIntor->set_rendering_buffer(&buf[0], 700, 500);
+        return pPresenter;
+    }
+};
+
+SUITE(PageCacheTest)
+{
+
+    TEST_FIXTURE(PageCacheTestFixture, page_cache_01)
+    {
+        //@01. pages rendered once. Least recently used pages discarded
+
+        vector<unsigned char> buf(100 * 100 * 4, 0);
+        BitmapDrawer drawer(*m_pScope);
+        drawer.set_rendering_buffer(&buf[0], 100, 100);
+        size_t pageBytes = 40 * 30 * 4;
+        PageCache cache(4, 2 * pageBytes);
+
+        draw_page(cache, 0, drawer);
+        draw_page(cache, 1, drawer);
+        draw_page(cache, 0, drawer);
+        CHECK( m_numRenders == 2 );
+        CHECK( buf[(5 * 100 + 5) * 4] == 0 );
+        CHECK( buf[(6 * 100 + 5) * 4] == 8 );
+        CHECK( buf[(34 * 100 + 5) * 4] == 232 );
+        CHECK( buf[(35 * 100 + 5) * 4] == 255 );
+
+        draw_page(cache, 2, drawer);
+        CHECK( m_numRenders == 3 );
+        CHECK( cache.get_num_pages() == 2 );
+        CHECK( cache.get_used_bytes() == 2 * pageBytes );
+        draw_page(cache, 0, drawer);
+        CHECK( m_numRenders == 3 );
+        CHECK( cache.get_num_hits() == 2 );
+        CHECK( cache.get_num_misses() == 3 );
+    }
+
+    TEST_FIXTURE(PageCacheTestFixture, page_cache_02)
+    {
+        //@02. pages not displayed are compressed
+
+        vector<unsigned char> buf(100 * 100 * 4, 0);
+        BitmapDrawer drawer(*m_pScope);
+        drawer.set_rendering_buffer(&buf[0], 100, 100);
+        size_t pageBytes = 40 * 30 * 4;
+        PageCache cache(4, 10 * pageBytes);
+
+        cache.start_frame(this);
+        draw_page(cache, 0, drawer);
+        draw_page(cache, 1, drawer);
+        cache.end_frame(this);
+        CHECK( cache.get_num_compressed_pages() == 0 );
+
+        cache.start_frame(this);
+        draw_page(cache, 1, drawer);
+        cache.end_frame(this);
+        CHECK( cache.get_num_compressed_pages() == 1 );
+        CHECK( cache.get_used_bytes() < 2 * pageBytes );
+
+        vector<unsigned char> expected(buf);
+        drawer.set_rendering_buffer(&buf[0], 100, 100);
+        draw_page(cache, 0, drawer);
+        draw_page(cache, 1, drawer);
+        CHECK( m_numRenders == 2 );
+        CHECK( cache.get_num_compressed_pages() == 0 );
+        CHECK( cache.get_used_bytes() == 2 * pageBytes );
+
+        //page 1 drawn last in both cases
+        CHECK( buf == expected );
+    }
+
+    TEST_FIXTURE(PageCacheTestFixture, page_cache_10)
+    {
+        //@10. view drawn from cached pages is identical. Pages reused in redraws
+
+        vector<unsigned char> buf1, buf2;
+        Presenter* pPresenter1 = open_document(buf1);
+        pPresenter1->get_interactor_raw_ptr(0)->new_viewport(-35, 40);
+
+        m_pScope->set_page_cache_budget(64000000);
+        PageCache* pCache = m_pScope->get_page_cache();
+        Presenter* pPresenter2 = open_document(buf2);
+        Interactor* pIntor2 = pPresenter2->get_interactor_raw_ptr(0);
+        pIntor2->new_viewport(-35, 40);
+
+        CHECK( buf1 == buf2 );
+        CHECK( pCache->get_num_misses() == 1 );
+
+        buf2.assign(buf2.size(), 0);
+        pIntor2->redraw_bitmap();
+        CHECK( buf1 == buf2 );
+        CHECK( pCache->get_num_misses() == 1 );
+        CHECK( pCache->get_num_hits() == 1 );
+
+        delete pPresenter1;
+        delete pPresenter2;
+    }
+
+    TEST_FIXTURE(PageCacheTestFixture, page_cache_11)
+    {
+        //@11. pages discarded when the document is modified
+
+        vector<unsigned char> buf;
+        m_pScope->set_page_cache_budget(64000000);
+        PageCache* pCache = m_pScope->get_page_cache();
+        Presenter* pPresenter = open_document(buf);
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        pIntor->redraw_bitmap();
+        CHECK( pCache->get_num_misses() == 1 );
+
+        //the view is re-drawn after the modification
+        Document* pDoc = pPresenter->get_document_raw_ptr();
+        SpEventDoc pEvent( LOMSE_NEW EventDoc(k_doc_modified_event, pDoc) );
+        pIntor->handle_event(pEvent);
+        CHECK( pCache->get_num_pages() == 1 );
+        CHECK( pCache->get_num_misses() == 2 );
+        CHECK( pCache->get_num_hits() == 0 );
+
+        delete pPresenter;
+    }
+
+    TEST_FIXTURE(PageCacheTestFixture, page_cache_12)
+    {
+        //@12. pages of deleted views are compressed
+
+        vector<unsigned char> buf;
+        m_pScope->set_page_cache_budget(64000000);
+        PageCache* pCache = m_pScope->get_page_cache();
+        Presenter* pPresenter = open_document(buf);
+        pPresenter->get_interactor_raw_ptr(0)->redraw_bitmap();
+        CHECK( pCache->get_num_compressed_pages() == 0 );
+
+        delete pPresenter;
+        CHECK( pCache->get_num_pages() == 1 );
+        CHECK( pCache->get_num_compressed_pages() == 1 );
+    }
+
+    TEST_FIXTURE(PageCacheTestFixture, page_cache_13)
+    {
+        //@13. pages are rasterized without locking the cache
+
+        vector<unsigned char> buf(100 * 100 * 4, 0);
+        BitmapDrawer drawer(*m_pScope);
+        drawer.set_rendering_buffer(&buf[0], 100, 100);
+        vector<unsigned char> buf2(100 * 100 * 4, 0);
+        BitmapDrawer drawer2(*m_pScope);
+        drawer2.set_rendering_buffer(&buf2[0], 100, 100);
+        size_t pageBytes = 40 * 30 * 4;
+        PageCache cache(4, 10 * pageBytes);
+
+        cache.draw_page(create_key(0), VRect(0, 0, 40, 30), this, &drawer, 5, 5,
+                        [&](RenderingBuffer& rbuf)
+        {
+            ++m_numRenders;
+            std::thread other([&]() { draw_page(cache, 1, drawer2); });
+            other.join();
+            memset(rbuf.buf(), 0, rbuf.height() * rbuf.width() * 4);
+        });
+
+        CHECK( m_numRenders == 2 );
+        CHECK( cache.get_num_pages() == 2 );
+        CHECK( cache.get_used_bytes() == 2 * pageBytes );
+        CHECK( buf2[(6 * 100 + 5) * 4] == 9 );
+    }
+
+};
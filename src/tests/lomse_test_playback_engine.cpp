@@ -0,0 +1,402 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include "lomse_config.h"
+#if (LOMSE_ENABLE_THREADS == 1)
+
+#define LOMSE_INTERNAL_API
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_injectors.h"
+#include "lomse_playback_engine.h"
+#include "private/lomse_document_p.h"
+#include "lomse_internal_model.h"
+#include "lomse_doorway.h"
+#include "lomse_midi_table.h"
+#include "lomse_im_note.h"
+#include "lomse_staffobjs_table.h"
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+//Helper, mock class that counts requests and saves the batches timestamps
+class MyCountingMidiServer : public MidiServerBase
+{
+public:
+    std::atomic<int> m_notesOn;
+    std::atomic<int> m_notesOff;
+    std::atomic<int> m_allOff;
+    std::vector<uint64_t> m_timestamps;     //only accessed from engine thread
+
+    MyCountingMidiServer()
+        : MidiServerBase(), m_notesOn(0), m_notesOff(0), m_allOff(0)
+    {
+    }
+    virtual ~MyCountingMidiServer() {}
+
+    //overrides
+    void process_events(const MidiEvent* events, size_t n, uint64_t timestampUs)
+    {
+        m_timestamps.push_back(timestampUs);
+        MidiServerBase::process_events(events, n, timestampUs);
+    }
+    void note_on(int UNUSED(channel), int UNUSED(pitch), int UNUSED(volume)) {
+        ++m_notesOn;
+    }
+    void note_off(int UNUSED(channel), int UNUSED(pitch), int UNUSED(volume)) {
+        ++m_notesOff;
+    }
+    void all_sounds_off() { ++m_allOff; }
+};
+
+//---------------------------------------------------------------------------------------
+//Helper, mock class that uses the session when receiving requests. It stops the
+//session when receiving the second batch
+class MyStoppingMidiServer : public MyCountingMidiServer
+{
+public:
+    PlaybackSession* m_pSession;
+    std::atomic<int> m_numBatches;
+    std::atomic<bool> m_fWasPlaying;
+
+    MyStoppingMidiServer()
+        : MyCountingMidiServer(), m_pSession(nullptr), m_numBatches(0)
+        , m_fWasPlaying(false)
+    {
+    }
+
+    //overrides
+    void process_events(const MidiEvent* events, size_t n, uint64_t timestampUs)
+    {
+        MyCountingMidiServer::process_events(events, n, timestampUs);
+        if (++m_numBatches == 2)
+        {
+            m_fWasPlaying = m_pSession->is_playing();
+            m_pSession->stop();
+        }
+    }
+};
+
+//---------------------------------------------------------------------------------------
+//Helper, end of playback callback
+static std::atomic<int> m_numEndOfPlayback(0);
+
+static void my_end_of_playback(void* UNUSED(pThis), PlaybackSession* UNUSED(pSession))
+{
+    ++m_numEndOfPlayback;
+}
+
+//---------------------------------------------------------------------------------------
+//Helper, mock class for a slow end of playback callback that uses the session
+class MySlowCallback
+{
+public:
+    std::atomic<bool> m_fStarted;
+    std::atomic<bool> m_fReturned;
+    long m_tempo;
+
+    MySlowCallback() : m_fStarted(false), m_fReturned(false), m_tempo(0L) {}
+
+    static void end_of_playback(void* pThis, PlaybackSession* pSession)
+    {
+        MySlowCallback* pObj = static_cast<MySlowCallback*>(pThis);
+        pObj->m_fStarted = true;
+        std::this_thread::sleep_for( std::chrono::milliseconds(200) );
+        pObj->m_tempo = pSession->get_tempo();
+        pObj->m_fReturned = true;
+    }
+};
+
+
+//---------------------------------------------------------------------------------------
+class PlaybackEngineTestFixture
+{
+public:
+    LibraryScope m_libraryScope;
+    std::string m_scores_path;
+
+    PlaybackEngineTestFixture()     //SetUp fixture
+        : m_libraryScope(cout)
+    {
+        m_scores_path = TESTLIB_SCORES_PATH;
+        m_libraryScope.set_default_fonts_path(TESTLIB_FONTS_PATH);
+        m_numEndOfPlayback = 0;
+    }
+
+    ~PlaybackEngineTestFixture()    //TearDown fixture
+    {
+    }
+
+    bool wait_for_end(PlaybackEngine* pEngine, int maxMs)
+    {
+        for (int i=0; i < maxMs / 5; ++i)
+        {
+            if (pEngine->num_playing_sessions() == 0)
+                return true;
+            std::this_thread::sleep_for( std::chrono::milliseconds(5) );
+        }
+        return false;
+    }
+};
+
+SUITE(PlaybackEngineTest)
+{
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_01)
+    {
+        //@01. one session. Requests delivered at score time
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q)(n g4 q)(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyCountingMidiServer midi;
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+        PlaybackSession* pSession = engine->create_session(pScore, &midi);
+        pSession->set_end_of_playback_callback(nullptr, my_end_of_playback);
+
+        pSession->play(600L);     //100 ms per quarter note
+        CHECK( wait_for_end(engine.get(), 3000) );
+
+        CHECK( midi.m_notesOn == 4 );
+        CHECK( midi.m_notesOff == 4 );
+        CHECK( m_numEndOfPlayback == 1 );
+        CHECK( pSession->is_playing() == false );
+
+        //program changes + note on at 0 ms, then one batch every 100 ms
+        std::vector<uint64_t>& timestamps = midi.m_timestamps;
+        CHECK( timestamps.size() == 5 );
+        CHECK( timestamps.size() == 5 && timestamps[0] == 0ULL );
+        CHECK( timestamps.size() == 5 && timestamps[1] == 100000ULL );
+        CHECK( timestamps.size() == 5 && timestamps[4] == 400000ULL );
+    }
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_02)
+    {
+        //@02. many sessions sharing the same score. Repetitions played in all of them
+        //  |    |    |    :|     |     |
+        //  1    2    3     4     5
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path
+                      + "unit-tests/repeats/01-repeat-end-repetition-barline.xml",
+                      Document::k_format_mxl);
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+
+        //play the score alone, to know the expected number of notes
+        MyCountingMidiServer reference;
+        PlaybackSession* pRef = engine->create_session(pScore, &reference);
+        pRef->play(6000L);      //10 ms per beat
+        CHECK( wait_for_end(engine.get(), 3000) );
+        engine->delete_session(pRef);
+        CHECK( engine->num_sessions() == 0 );
+
+        //now, many sessions simultaneously
+        const int numSessions = 50;
+        std::vector< std::unique_ptr<MyCountingMidiServer> > servers;
+        std::vector<PlaybackSession*> sessions;
+        for (int i=0; i < numSessions; ++i)
+        {
+            servers.push_back( std::unique_ptr<MyCountingMidiServer>(
+                                                LOMSE_NEW MyCountingMidiServer()) );
+            PlaybackSession* pSession = engine->create_session(pScore, servers[i].get());
+            pSession->set_end_of_playback_callback(nullptr, my_end_of_playback);
+            sessions.push_back(pSession);
+        }
+        CHECK( engine->num_sessions() == numSessions );
+
+        for (PlaybackSession* pSession : sessions)
+            pSession->play(6000L);
+        CHECK( wait_for_end(engine.get(), 5000) );
+
+        CHECK( reference.m_notesOn > 0 );
+        bool fAllOk = true;
+        for (int i=0; i < numSessions; ++i)
+            fAllOk &= (servers[i]->m_notesOn == reference.m_notesOn);
+        CHECK( fAllOk );
+        CHECK( m_numEndOfPlayback == numSessions );
+    }
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_03)
+    {
+        //@03. pause, resume and stop
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 w)(n e4 w) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyCountingMidiServer midi;
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+        PlaybackSession* pSession = engine->create_session(pScore, &midi);
+        pSession->set_end_of_playback_callback(nullptr, my_end_of_playback);
+
+        pSession->play(60L);     //4 seconds per note
+        std::this_thread::sleep_for( std::chrono::milliseconds(50) );
+        CHECK( midi.m_notesOn == 1 );
+
+        pSession->pause();
+        CHECK( pSession->is_paused() );
+        CHECK( pSession->is_playing() == false );
+        CHECK( midi.m_allOff == 1 );
+
+        pSession->pause();
+        CHECK( pSession->is_playing() );
+
+        pSession->stop();
+        CHECK( pSession->is_playing() == false );
+        CHECK( pSession->is_paused() == false );
+        CHECK( midi.m_allOff == 2 );
+        CHECK( engine->num_playing_sessions() == 0 );
+
+        std::this_thread::sleep_for( std::chrono::milliseconds(20) );
+        CHECK( midi.m_notesOn == 1 );
+        CHECK( m_numEndOfPlayback == 0 );
+    }
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_04)
+    {
+        //@04. tempo change while playing is applied from current position
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 w)(n e4 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyCountingMidiServer midi;
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+        PlaybackSession* pSession = engine->create_session(pScore, &midi);
+
+        pSession->play(60L);     //4 seconds for first note
+        std::this_thread::sleep_for( std::chrono::milliseconds(50) );
+        pSession->set_tempo(6000L);     //remaining of first note: < 40 ms
+        CHECK( pSession->get_tempo() == 6000L );
+        CHECK( wait_for_end(engine.get(), 1000) );
+
+        CHECK( midi.m_notesOn == 2 );
+        CHECK( midi.m_notesOff == 2 );
+    }
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_05)
+    {
+        //@05. MIDI server is invoked without lock: it can use the session
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q)(barline)"
+            "(n g4 q)(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyStoppingMidiServer midi;
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+        PlaybackSession* pSession = engine->create_session(pScore, &midi);
+        pSession->set_end_of_playback_callback(nullptr, my_end_of_playback);
+        midi.m_pSession = pSession;
+
+        pSession->play(600L);     //100 ms per quarter note
+        CHECK( wait_for_end(engine.get(), 3000) );
+
+        CHECK( midi.m_fWasPlaying == true );
+        CHECK( midi.m_numBatches == 2 );
+        CHECK( midi.m_notesOn == 2 );
+        CHECK( midi.m_allOff == 1 );
+        CHECK( m_numEndOfPlayback == 0 );
+
+        //play second measure
+        pSession->play_from_measure(2, 600L);
+        CHECK( wait_for_end(engine.get(), 3000) );
+
+        CHECK( midi.m_notesOn == 4 );
+        CHECK( midi.m_notesOff == 3 );
+        CHECK( m_numEndOfPlayback == 1 );
+    }
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_06)
+    {
+        //@06. session is not deleted while its end of playback callback is running
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyCountingMidiServer midi;
+        MySlowCallback callback;
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+        PlaybackSession* pSession = engine->create_session(pScore, &midi);
+        pSession->set_end_of_playback_callback(&callback,
+                                               MySlowCallback::end_of_playback);
+
+        pSession->play(600L);     //100 ms per quarter note
+        for (int i=0; i < 600 && !callback.m_fStarted; ++i)
+            std::this_thread::sleep_for( std::chrono::milliseconds(5) );
+        CHECK( callback.m_fStarted == true );
+
+        engine->delete_session(pSession);
+        CHECK( callback.m_fReturned == true );
+        CHECK( callback.m_tempo == 600L );
+        CHECK( engine->num_sessions() == 0 );
+    }
+
+    TEST_FIXTURE(PlaybackEngineTestFixture, playback_engine_07)
+    {
+        //@07. score modified: table used by the session is not modified. New table
+        //@    used after update_table()
+
+        Document doc(m_libraryScope);
+        doc.from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyCountingMidiServer midi;
+        std::unique_ptr<PlaybackEngine> engine(
+                                Injector::inject_PlaybackEngine(m_libraryScope) );
+        PlaybackSession* pSession = engine->create_session(pScore, &midi);
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        CHECK( pTable->is_in_use() == true );
+        string before = pTable->dump_midi_events();
+
+        ImoStaffObj* pSO = pScore->get_staffobjs_table()->front()->get_next()->imo_object();
+        CHECK( pSO->is_note() );
+        static_cast<ImoNote*>(pSO)->set_notated_pitch(k_step_A, 4, k_no_accidentals);
+        pScore->end_of_changes();
+
+        SoundEventsTable* pNewTable = pScore->get_midi_table();
+        CHECK( pNewTable != pTable );
+        CHECK( pTable->dump_midi_events() == before );
+        CHECK( pNewTable->is_in_use() == false );
+
+        pSession->update_table();
+        CHECK( pNewTable->is_in_use() == true );
+        pSession->play(600L);     //100 ms per quarter note
+        CHECK( wait_for_end(engine.get(), 3000) );
+        CHECK( midi.m_notesOn == 2 );
+
+        engine->delete_session(pSession);
+        CHECK( pNewTable->is_in_use() == false );
+    }
+
+};
+
+#endif  //LOMSE_ENABLE_THREADS == 1
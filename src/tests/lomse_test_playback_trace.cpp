@@ -0,0 +1,160 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_playback_trace.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+class PlaybackTraceTestFixture
+{
+public:
+
+    PlaybackTraceTestFixture()     //SetUp fixture
+    {
+    }
+
+    ~PlaybackTraceTestFixture()    //TearDown fixture
+    {
+    }
+
+    int count_substrings(const string& text, const string& sub)
+    {
+        int count = 0;
+        for (size_t pos = text.find(sub); pos != string::npos;
+             pos = text.find(sub, pos + sub.size()))
+        {
+            ++count;
+        }
+        return count;
+    }
+};
+
+SUITE(PlaybackTraceTest)
+{
+
+    TEST_FIXTURE(PlaybackTraceTestFixture, playback_trace_01)
+    {
+        //@01. records collected. Records discarded when buffer full
+
+        PlaybackTrace trace(4);
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 0, 50, 10, 2, 1);
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 1000, 1300, 20, 1, 1);
+        trace.add_record(PlaybackTraceRecord::k_tracking_post, 1000, 1320, 400, 3);
+        CHECK( trace.num_records() == 0 );
+
+        CHECK( trace.collect() == 3 );
+        CHECK( trace.num_records() == 3 );
+        CHECK( trace.get_record(1).lateness() == 300 );
+        CHECK( trace.get_record(2).numItems == 3 );
+
+        for (int i=0; i < 6; ++i)
+            trace.add_record(PlaybackTraceRecord::k_wake_up, 0, 0, 0);
+        CHECK( trace.num_dropped() == 2 );
+        CHECK( trace.collect() == 4 );
+        CHECK( trace.num_records() == 7 );
+
+        trace.clear();
+        CHECK( trace.num_records() == 0 );
+        CHECK( trace.num_dropped() == 0 );
+    }
+
+    TEST_FIXTURE(PlaybackTraceTestFixture, playback_trace_02)
+    {
+        //@02. histogram counts and summary
+
+        PlaybackTrace trace;
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 0, 50, 10);
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 1000, 1300, 20);
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 2000, 1990, 2500);
+        trace.add_record(PlaybackTraceRecord::k_tracking_post, 1000, 1320, 400);
+        trace.collect();
+
+        CHECK( trace.count_records(PlaybackTraceRecord::k_midi_batch, 0, 100) == 1 );
+        CHECK( trace.count_records(PlaybackTraceRecord::k_midi_batch, 250, 500) == 1 );
+        CHECK( trace.count_records(PlaybackTraceRecord::k_midi_batch, -100, 0) == 1 );
+        CHECK( trace.count_records(PlaybackTraceRecord::k_midi_batch, 2000, 5000, true) == 1 );
+
+        string summary = trace.dump_summary();
+//        cout << summary;
+        CHECK( summary.find("midi batch: 3 records") != string::npos );
+        CHECK( summary.find("tracking post: 1 records") != string::npos );
+        CHECK( summary.find("wake up") == string::npos );
+        CHECK( summary.find("min=-10, mean=113, p50=50, p95=50, p99=50, max=300") != string::npos );
+    }
+
+    TEST_FIXTURE(PlaybackTraceTestFixture, playback_trace_03)
+    {
+        //@03. Chrome trace event format
+
+        PlaybackTrace trace;
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 0, 50, 10, 2, 1);
+        trace.add_record(PlaybackTraceRecord::k_tracking_post, 1000, 1320, 400, 3);
+        trace.collect();
+
+        stringstream ss;
+        trace.write_chrome_trace(ss);
+        string json = ss.str();
+//        cout << json;
+        CHECK( json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0 );
+        CHECK( count_substrings(json, "\"ph\":\"X\"") == 2 );
+        CHECK( count_substrings(json, "\"ph\":\"C\"") == 2 );
+        CHECK( json.find("\"name\":\"midi batch\",\"cat\":\"playback\",\"ph\":\"X\","
+                         "\"pid\":1,\"tid\":1,\"ts\":50,\"dur\":10,\"args\":{"
+                         "\"scheduled_us\":0,\"lateness_us\":50,\"items\":2,"
+                         "\"note_on\":1}}") != string::npos );
+        CHECK( json.find("\"args\":{\"tracking post\":320}") != string::npos );
+        CHECK( json.substr(json.size() - 3) == "]}\n" );
+    }
+
+    TEST_FIXTURE(PlaybackTraceTestFixture, playback_trace_04)
+    {
+        //@04. time paused is excluded from actual times. Pause and resume recorded
+
+        PlaybackTrace trace;
+        trace.start();
+        int64_t before = trace.now_us();
+        trace.pause(1000);
+        std::this_thread::sleep_for( std::chrono::milliseconds(60) );
+        CHECK( trace.now_us() - before < 30000 );
+        trace.resume(1000);
+        trace.add_record(PlaybackTraceRecord::k_midi_batch, 1000, trace.now_us(), 10);
+        CHECK( trace.collect() == 3 );
+
+        CHECK( trace.get_record(0).type == PlaybackTraceRecord::k_pause );
+        CHECK( trace.get_record(0).scheduledUs == 1000 );
+        CHECK( trace.get_record(1).type == PlaybackTraceRecord::k_resume );
+        CHECK( trace.get_record(1).durationUs >= 60000 );
+        CHECK( trace.get_record(2).actualUs - before < 30000 );
+
+        string summary = trace.dump_summary();
+//        cout << summary;
+        CHECK( summary.find("pause: 1 records") != string::npos );
+        CHECK( summary.find("time paused (us): ") != string::npos );
+
+        stringstream ss;
+        trace.write_chrome_trace(ss);
+        string json = ss.str();
+//        cout << json;
+        CHECK( count_substrings(json, "\"ph\":\"i\"") == 2 );
+        CHECK( count_substrings(json, "\"ph\":\"C\"") == 1 );
+        CHECK( json.find("\"name\":\"resume\",\"cat\":\"playback\",\"ph\":\"i\"") != string::npos );
+    }
+
+};
+
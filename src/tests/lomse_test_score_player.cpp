@@ -25,8 +25,13 @@
 #include "lomse_doorway.h"
 #include "lomse_interactor.h"
 #include "lomse_player_gui.h"
+#include "lomse_im_note.h"
 
+#include <algorithm>
 #include <list>
+#include <vector>
+#include <chrono>
+#include <mutex>
 
 
 using namespace UnitTest;
@@ -137,6 +142,8 @@ public:
         }
         m_pThread = std::unique_ptr<SoundThread>(nullptr);
     }
+
+    bool my_is_paused() { return m_fPaused; }
 };
 
 //---------------------------------------------------------------------------------------
@@ -179,6 +186,137 @@ public:
     std::list<int>& my_get_events() { return m_events; }
 };
 
+//---------------------------------------------------------------------------------------
+//Helper, mock class that saves requests and their playback time
+class MyTimedMidiServer : public MidiServerBase
+{
+protected:
+    long m_time;
+    std::vector<string> m_events;
+
+public:
+    MyTimedMidiServer() : MidiServerBase(), m_time(-1L) {}
+    virtual ~MyTimedMidiServer() {}
+
+    //overrides
+    void set_playback_time(long milliseconds) { m_time = milliseconds; }
+    void program_change(int channel, int instr) { save("program", channel, instr); }
+    void voice_change(int channel, int instr) { save("voice", channel, instr); }
+    void note_on(int channel, int pitch, int UNUSED(volume)) { save("on", channel, pitch); }
+    void note_off(int channel, int pitch, int UNUSED(volume)) { save("off", channel, pitch); }
+    void all_sounds_off() { save("all-off", 0, 0); }
+
+    void save(const char* request, int channel, int value)
+    {
+        stringstream ss;
+        ss << m_time << " " << request << " " << channel << " " << value;
+        m_events.push_back(ss.str());
+    }
+
+    std::vector<string>& my_get_events() { return m_events; }
+};
+
+//---------------------------------------------------------------------------------------
+//Helper, mock class that saves the batches of requests
+class MyBatchMidiServer : public MyTimedMidiServer
+{
+protected:
+    std::vector<size_t> m_sizes;
+    std::vector<uint64_t> m_timestamps;
+
+public:
+    MyBatchMidiServer() : MyTimedMidiServer() {}
+    virtual ~MyBatchMidiServer() {}
+
+    //overrides
+    void process_events(const MidiEvent* events, size_t n, uint64_t timestampUs)
+    {
+        m_sizes.push_back(n);
+        m_timestamps.push_back(timestampUs);
+        MidiServerBase::process_events(events, n, timestampUs);
+    }
+
+    std::vector<size_t>& my_get_sizes() { return m_sizes; }
+    std::vector<uint64_t>& my_get_timestamps() { return m_timestamps; }
+};
+
+//---------------------------------------------------------------------------------------
+//Helper, mock class that saves the batches of requests and can be accessed while
+//the player is running
+class MyPausingMidiServer : public MyBatchMidiServer
+{
+protected:
+    std::recursive_mutex m_mutex;
+
+public:
+    MyPausingMidiServer() : MyBatchMidiServer() {}
+    virtual ~MyPausingMidiServer() {}
+
+    //overrides
+    void set_playback_time(long milliseconds)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_time = milliseconds;
+    }
+    void process_events(const MidiEvent* events, size_t n, uint64_t timestampUs)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        MyBatchMidiServer::process_events(events, n, timestampUs);
+    }
+    void all_sounds_off()
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        save("all-off", 0, 0);
+    }
+
+    void mark(const char* text)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        m_events.push_back(text);
+    }
+    size_t num_requests()
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        return m_events.size();
+    }
+    long my_get_time()
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_mutex);
+        return m_time;
+    }
+};
+
+//---------------------------------------------------------------------------------------
+//Helper, mock class that pauses the player when playback time reaches the given
+//time. The player reads the GUI status after processing each event, so that pause
+//takes place between the requests for that time
+class MyPausingPlayerGui : public PlayerNoGui
+{
+protected:
+    ScorePlayer* m_pPlayer;
+    MyPausingMidiServer* m_pMidi;
+    long m_pauseTime;
+
+public:
+    MyPausingPlayerGui(ScorePlayer* pPlayer, MyPausingMidiServer* pMidi, long pauseTime)
+        : PlayerNoGui()
+        , m_pPlayer(pPlayer)
+        , m_pMidi(pMidi)
+        , m_pauseTime(pauseTime)
+    {
+    }
+
+    bool metronome_status() override
+    {
+        if (m_pPlayer && m_pMidi->my_get_time() == m_pauseTime)
+        {
+            m_pPlayer->pause();
+            m_pPlayer = nullptr;
+        }
+        return false;
+    }
+};
+
 //---------------------------------------------------------------------------------------
 class MyEventHandlerCPP2 : public EventHandler
 {
@@ -476,6 +614,409 @@ SUITE(ScorePlayerTest)
         CHECK( handler.my_last_event_type() == k_end_of_playback_event );
     }
 
+    TEST_FIXTURE(ScorePlayerTestFixture, VirtualClock_01)
+    {
+        //@01. virtual clock: same requests and times than in real time playback
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(time 2 4)(n c4 q)(n e4 e)(n g4 e)"
+            "(barline endRepetition)(chord (n c4 q)(n e4 q))(r q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        PlayerNoGui playGui(600L, k_do_countoff, k_play_metronome);
+
+        MyTimedMidiServer midiReal;
+        MyScorePlayer2 playerReal(m_libraryScope, &midiReal);
+        playerReal.load_score(pScore, &playGui);
+        playerReal.play(k_no_visual_tracking, 0L, nullptr);
+        playerReal.my_wait_for_termination();
+
+        MyTimedMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        player.load_score(pScore, &playGui);
+        player.play(k_no_visual_tracking, 0L, nullptr);
+        player.my_wait_for_termination();
+
+        std::vector<string>& events = midi.my_get_events();
+        CHECK( events.size() > 20 );
+        CHECK( events == midiReal.my_get_events() );
+//        for (size_t i=0; i < events.size(); ++i)
+//            cout << events[i] << endl;
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, VirtualClock_02)
+    {
+        //@02. virtual clock: no waiting. Playback time in tracking events
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q)(n g4 q)(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyTimedMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+        SpInteractor inter( LOMSE_NEW Interactor(m_libraryScope, WpDocument(spDoc), nullptr, nullptr) );
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_do_visual_tracking,
+                          k_no_countoff, 60L, inter.get());
+        player.my_wait_for_termination();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        //5 seconds of music: a metronome pulse before first note and 4 notes
+        CHECK( std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+               < 1000 );
+        std::vector<string>& events = midi.my_get_events();
+        CHECK( events.size() == 11 );
+        CHECK( events[2] == "1000 on 0 60" );
+        CHECK( events[3] == "2000 off 0 60" );
+        CHECK( events[4] == "2000 on 0 64" );
+        CHECK( events[8] == "4000 on 0 72" );
+        CHECK( events[9] == "5000 off 0 72" );
+
+        //highlight on for last note at 4000ms. End of tracking at 5000ms
+        SpEventVisualTracking pLastNote;
+        SpEventVisualTracking pEnd;
+        for (SpEventInfo pEv : m_notifications)
+        {
+            if (pEv->get_event_type() != k_tracking_event)
+                continue;
+            SpEventVisualTracking pTrk = static_pointer_cast<EventVisualTracking>(pEv);
+            for (const pair<int, ImoId>& item : pTrk->get_items())
+            {
+                if (item.first == EventVisualTracking::k_highlight_on)
+                    pLastNote = pTrk;
+                else if (item.first == EventVisualTracking::k_end_of_visual_tracking)
+                    pEnd = pTrk;
+            }
+        }
+        CHECK( pLastNote && pLastNote->get_playback_time() == 4000L );
+        CHECK( pEnd && pEnd->get_playback_time() == 5000L );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, VirtualClock_03)
+    {
+        //@03. virtual clock: score modified while playing. The table in use is not
+        //modified. Changes are played in next playback
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyPausingMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        MyPausingPlayerGui playGui(&player, &midi, 1000L);
+        player.load_score(pScore, &playGui);
+        SoundEventsTable* pTable = pScore->get_midi_table();
+        int numEvents = pTable->num_events();
+        player.play(k_no_visual_tracking, 60L, nullptr);
+
+        //modify second note while paused in first one
+        for (int i=0; i < 50 && !player.my_is_paused(); ++i)
+            std::this_thread::sleep_for( std::chrono::milliseconds(20) );
+        CHECK( player.my_is_paused() );
+        ImoInstrument* pInstr = pScore->get_instrument(0);
+        ImoNote* pNote = static_cast<ImoNote*>( pInstr->get_musicdata()->get_last_child() );
+        pNote->set_notated_pitch(k_step_A, 4, k_no_accidentals);
+        pScore->end_of_changes();
+
+        SoundEventsTable* pNewTable = pScore->get_midi_table();
+        CHECK( pNewTable != pTable );
+        CHECK( pTable->is_in_use() == true );
+        CHECK( pTable->num_events() == numEvents );
+        CHECK( player.get_playback_duration(60L) > 0L );
+
+        player.pause();
+        player.my_wait_for_termination();
+
+        std::vector<string>& events = midi.my_get_events();
+        CHECK( find(events.begin(), events.end(), "2000 on 0 64") != events.end() );
+        CHECK( find(events.begin(), events.end(), "2000 on 0 69") == events.end() );
+
+        //next playback uses the new table
+        events.clear();
+        player.play(k_no_visual_tracking, 60L, nullptr);
+        player.my_wait_for_termination();
+        CHECK( pScore->get_midi_table() == pNewTable );
+        CHECK( pNewTable->is_in_use() == false );
+        CHECK( find(events.begin(), events.end(), "2000 on 0 69") != events.end() );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, BatchedEvents_01)
+    {
+        //@01. simultaneous requests are delivered together
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(chord (n c4 q)(n e4 q)(n g4 q))(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyBatchMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_no_visual_tracking,
+                          k_no_countoff, 60L, nullptr);
+        player.my_wait_for_termination();
+
+        //program changes at 0 ms, chord at 1000 ms, chord off + note at 2000 ms,
+        //note off at 3000 ms. all-off is not batched
+        std::vector<size_t>& sizes = midi.my_get_sizes();
+        std::vector<uint64_t>& timestamps = midi.my_get_timestamps();
+        CHECK( sizes.size() == 4 );
+        CHECK( sizes.size() == 4 && sizes[0] == 2 && timestamps[0] == 0ULL );
+        CHECK( sizes.size() == 4 && sizes[1] == 3 && timestamps[1] == 1000000ULL );
+        CHECK( sizes.size() == 4 && sizes[2] == 4 && timestamps[2] == 2000000ULL );
+        CHECK( sizes.size() == 4 && sizes[3] == 1 && timestamps[3] == 3000000ULL );
+
+        //default adapter invokes per-event methods, in order
+        std::vector<string>& events = midi.my_get_events();
+        CHECK( events.size() == 11 );
+        CHECK( events.size() > 4 && events[2] == "1000 on 0 60" );
+        CHECK( events.size() > 4 && events[4] == "1000 on 0 67" );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, BatchedEvents_02)
+    {
+        //@02. paused between requests for the same time: no sounds after silencing
+        //the MIDI server. Pending requests sent when resumed
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(chord (n c4 q)(n e4 q)(n g4 q))(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyPausingMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        MyPausingPlayerGui playGui(&player, &midi, 1000L);
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_no_visual_tracking,
+                          k_no_countoff, 60L, nullptr);
+
+        //wait until the player is paused, after queuing the first chord note
+        for (int i=0; i < 50 && midi.num_requests() < 3; ++i)
+            std::this_thread::sleep_for( std::chrono::milliseconds(20) );
+        std::this_thread::sleep_for( std::chrono::milliseconds(300) );
+        midi.mark("resume");
+        player.pause();
+        player.my_wait_for_termination();
+
+        std::vector<string>& events = midi.my_get_events();
+//        for (const string& ev : events)
+//            cout << ev << endl;
+        size_t iOff = find(events.begin(), events.end(), "1000 all-off 0 0") - events.begin();
+        size_t iResume = find(events.begin(), events.end(), "resume") - events.begin();
+        CHECK( iOff < iResume );
+        bool fSoundsWhilePaused = false;
+        for (size_t i=iOff; i < iResume && i < events.size(); ++i)
+            fSoundsWhilePaused |= (events[i].find(" on ") != string::npos);
+        CHECK( !fSoundsWhilePaused );
+        CHECK( iResume + 3 < events.size() && events[iResume + 1] == "1000 on 0 60" );
+        CHECK( iResume + 3 < events.size() && events[iResume + 3] == "1000 on 0 67" );
+
+        //the chord is delivered in one batch after resuming
+        std::vector<size_t>& sizes = midi.my_get_sizes();
+        CHECK( sizes.size() == 4 && sizes[1] == 3 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, Trace_01)
+    {
+        //@01. timing of sound requests is traced when enabled
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(chord (n c4 q)(n e4 q)(n g4 q))(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyBatchMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        CHECK( player.get_trace() == nullptr );
+        player.enable_trace(true);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_no_visual_tracking,
+                          k_no_countoff, 60L, nullptr);
+        player.my_wait_for_termination();
+
+        //one record for each batch of requests. No waiting in virtual clock mode
+        PlaybackTrace* pTrace = player.get_trace();
+        CHECK( pTrace && pTrace->collect() == 4 );
+        CHECK( pTrace && pTrace->num_records() == 4 );
+        if (pTrace && pTrace->num_records() == 4)
+        {
+            CHECK( pTrace->get_record(1).type == PlaybackTraceRecord::k_midi_batch );
+            CHECK( pTrace->get_record(1).scheduledUs == 1000000 );
+            CHECK( pTrace->get_record(1).numItems == 3 );
+            CHECK( pTrace->get_record(1).numNoteOn == 3 );
+            CHECK( pTrace->get_record(2).numNoteOn == 1 );
+        }
+
+        player.enable_trace(false);
+        CHECK( player.get_trace() == nullptr );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, Trace_02)
+    {
+        //@02. pause and resume are traced. Time paused excluded from actual times
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyPausingMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        player.enable_trace(true);
+        MyPausingPlayerGui playGui(&player, &midi, 1000L);
+        player.load_score(pScore, &playGui);
+        player.play(k_no_visual_tracking, 60L, nullptr);
+
+        for (int i=0; i < 50 && !player.my_is_paused(); ++i)
+            std::this_thread::sleep_for( std::chrono::milliseconds(20) );
+        std::this_thread::sleep_for( std::chrono::milliseconds(300) );
+        player.pause();
+        player.my_wait_for_termination();
+
+        PlaybackTrace* pTrace = player.get_trace();
+        CHECK( pTrace && pTrace->collect() > 2 );
+        int iPause = -1;
+        int iResume = -1;
+        for (int i=0; pTrace && i < pTrace->num_records(); ++i)
+        {
+            if (pTrace->get_record(i).type == PlaybackTraceRecord::k_pause)
+                iPause = i;
+            else if (pTrace->get_record(i).type == PlaybackTraceRecord::k_resume)
+                iResume = i;
+        }
+        CHECK( iPause != -1 && iPause + 1 == iResume );
+        if (pTrace && iPause != -1 && iResume != -1)
+        {
+            CHECK( pTrace->get_record(iPause).scheduledUs == 1000000 );
+            CHECK( pTrace->get_record(iResume).durationUs >= 250000 );
+
+            //no waiting in virtual clock mode: all records near the start
+            const PlaybackTraceRecord& last =
+                pTrace->get_record(pTrace->num_records() - 1);
+            CHECK( last.type == PlaybackTraceRecord::k_midi_batch );
+            CHECK( last.actualUs < 200000 );
+        }
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, TimeMapping_01)
+    {
+        //@01. map measure and pass to playback time and back. Repetitions unrolled
+        //  |    |    |    :|     |     |
+        //  1    2    3     4     5
+
+        Document doc(m_libraryScope);
+        doc.from_file(m_scores_path
+                      + "unit-tests/repeats/01-repeat-end-repetition-barline.xml",
+                      Document::k_format_mxl);
+        ImoScore* pScore = static_cast<ImoScore*>( doc.get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+
+        //4 beats per measure, 1000 ms per beat
+        CHECK( player.get_playback_duration(60L) == 32000L );
+        CHECK( player.get_time_for_measure(1, 1, 60L) == 0L );
+        CHECK( player.get_time_for_measure(1, 2, 60L) == 12000L );
+        CHECK( player.get_time_for_measure(4, 1, 120L) == 12000L );
+        CHECK( player.get_time_for_measure(4, 2, 60L) == -1L );
+
+        int pass = 0;
+        CHECK( player.get_measure_for_time(17500L, &pass, 60L) == 2 );
+        CHECK( pass == 2 );
+        CHECK( player.get_measure_for_time(24000L, &pass, 60L) == 4 );
+        CHECK( pass == 1 );
+        CHECK( player.get_measure_for_time(40000L, &pass, 60L) == 0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, QueuedTracking_01)
+    {
+        //@01. tracking events not posted: queued in the interactor for the UI thread
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        pLomse->set_notify_callback(nullptr, MyScorePlayer::my_callback);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(n c4 q)(n e4 q)(n g4 q)(n c5 q) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyTimedMidiServer midi;
+        MyScorePlayer player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        player.post_tracking_events(false);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        int nEvMax = player.my_get_table()->num_events() - 1;
+        SpInteractor inter( LOMSE_NEW Interactor(m_libraryScope, WpDocument(spDoc), nullptr, nullptr) );
+
+        player.my_do_play(0, nEvMax, k_play_normal_instrument, k_do_visual_tracking,
+                          k_no_countoff, 60L, inter.get());
+        player.my_wait_for_termination();
+
+        int numTracking = 0;
+        for (SpEventInfo pEv : m_notifications)
+        {
+            if (pEv->get_event_type() == k_tracking_event)
+                ++numTracking;
+        }
+        CHECK( numTracking == 0 );
+        CHECK( inter->process_playback_events() > 0 );
+        CHECK( inter->process_playback_events() == 0 );
+        CHECK( player.get_num_stalls() == 0 );
+    }
+
+    TEST_FIXTURE(ScorePlayerTestFixture, QueuedTracking_02)
+    {
+        //@02. tracking events not posted but no interactor: end of playback posted
+
+        LomseDoorway* pLomse = m_libraryScope.platform_interface();
+        MyEventHandlerCPP2 handler;
+        pLomse->set_notify_callback(&handler, MyEventHandlerCPP2::wrapper_for_handler);
+        SpDocument spDoc( new Document(m_libraryScope) );
+        spDoc->from_string("(lenmusdoc (vers 0.0) (content (score (vers 2.0) "
+            "(instrument (musicData (clef G)(chord (n c4 q)(n e4 q)(n g4 q)) )) )))" );
+        ImoScore* pScore = static_cast<ImoScore*>( spDoc->get_im_root()->get_content_item(0) );
+        MyMidiServer midi;
+        MyScorePlayer2 player(m_libraryScope, &midi);
+        player.set_virtual_clock(true);
+        player.post_tracking_events(false);
+        PlayerNoGui playGui;
+        player.load_score(pScore, &playGui);
+        player.play(k_no_visual_tracking, 60L, nullptr);
+        player.my_wait_for_termination();
+
+        CHECK( handler.event_received() == true );
+        CHECK( handler.my_last_event_type() == k_end_of_playback_event );
+    }
+
 }
 
 #endif  //LOMSE_ENABLE_THREADS == 1
@@ -234,23 +234,23 @@ SUITE(SpAlgGourlayTest)
         MyTimeSlice* pSlice = static_cast<MyTimeSlice*>(*it);
         CHECK( is_equal_pos(pSlice->get_left_rod(), 0.0f) );
         CHECK( is_equal_pos(pSlice->get_right_rod(), 0.0f) );
-        CHECK( is_equal_pos(pSlice->get_left_space(), 1096.0f) );
+        CHECK( is_equal_pos(pSlice->get_left_space(), 1095.434f) );
         CHECK( pSlice->my_get_iShape() == 0 );
         ++it;
         pSlice = static_cast<MyTimeSlice*>(*it);
-        CHECK( is_equal_pos(pSlice->get_left_rod(), 219.0f) );
-        CHECK( is_equal_pos(pSlice->get_right_rod(), 257.0f) );
+        CHECK( is_equal_pos(pSlice->get_left_rod(), 218.546f) );
+        CHECK( is_equal_pos(pSlice->get_right_rod(), 256.467f) );
         CHECK( is_equal_pos(pSlice->get_left_space(), 0.0f) );
         CHECK( pSlice->my_get_iShape() == 2 );
         ++it;
         pSlice = static_cast<MyTimeSlice*>(*it);
-        CHECK( is_equal_pos(pSlice->get_left_rod(), 219.0f) );
+        CHECK( is_equal_pos(pSlice->get_left_rod(), 218.546f) );
         CHECK( is_equal_pos(pSlice->get_right_rod(), 45.0f) );
         CHECK( is_equal_pos(pSlice->get_left_space(), 0.0f) );
         CHECK( pSlice->my_get_iShape() == 4 );
         ++it;
         pSlice = static_cast<MyTimeSlice*>(*it);
-        CHECK( is_equal_pos(pSlice->get_left_rod(), 219.0f) );
+        CHECK( is_equal_pos(pSlice->get_left_rod(), 218.546f) );
         CHECK( is_equal_pos(pSlice->get_right_rod(), 0.0f) );
         CHECK( is_equal_pos(pSlice->get_left_space(), 0.0f) );
         CHECK( pSlice->my_get_iShape() == 5 );
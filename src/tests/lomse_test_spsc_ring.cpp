@@ -0,0 +1,127 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_spsc_ring.h"
+
+#include <thread>
+#include <memory>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+class SpscRingTestFixture
+{
+public:
+
+    SpscRingTestFixture()     //SetUp fixture
+    {
+    }
+
+    ~SpscRingTestFixture()    //TearDown fixture
+    {
+    }
+};
+
+SUITE(SpscRingTest)
+{
+
+    TEST_FIXTURE(SpscRingTestFixture, spsc_ring_01)
+    {
+        //@01. capacity rounded to power of two. Push fails when full
+
+        SpscRing<int> ring(5);
+        CHECK( ring.capacity() == 8 );
+        CHECK( ring.empty() );
+
+        for (int i=0; i < 8; ++i)
+            CHECK( ring.push(i) );
+        CHECK( ring.push(8) == false );
+        CHECK( ring.size() == 8 );
+
+        int value = -1;
+        CHECK( ring.pop(value) );
+        CHECK( value == 0 );
+        CHECK( ring.push(8) );
+    }
+
+    TEST_FIXTURE(SpscRingTestFixture, spsc_ring_02)
+    {
+        //@02. FIFO order is kept when indexes wrap around
+
+        SpscRing<int> ring(4);
+        int value = -1;
+        bool fOk = true;
+        for (int i=0; i < 100; ++i)
+        {
+            ring.push(2*i);
+            ring.push(2*i + 1);
+            fOk &= ring.pop(value) && value == 2*i;
+            fOk &= ring.pop(value) && value == 2*i + 1;
+        }
+        CHECK( fOk );
+        CHECK( ring.pop(value) == false );
+    }
+
+    TEST_FIXTURE(SpscRingTestFixture, spsc_ring_03)
+    {
+        //@03. popped slot is reset: resources released in consumer thread
+
+        std::shared_ptr<int> sp = std::make_shared<int>(7);
+        SpscRing< std::shared_ptr<int> > ring(2);
+        ring.push(sp);
+        CHECK( sp.use_count() == 2 );
+
+        std::shared_ptr<int> item;
+        CHECK( ring.pop(item) );
+        item.reset();
+        CHECK( sp.use_count() == 1 );
+    }
+
+    TEST_FIXTURE(SpscRingTestFixture, spsc_ring_04)
+    {
+        //@04. producer and consumer in different threads
+
+        const int numItems = 100000;
+        SpscRing<int> ring(64);
+        std::thread producer([&ring]() {
+            for (int i=0; i < numItems; ++i)
+            {
+                while (!ring.push(i))
+                    std::this_thread::yield();
+            }
+        });
+
+        bool fOrdered = true;
+        int expected = 0;
+        int value;
+        while (expected < numItems)
+        {
+            if (ring.pop(value))
+            {
+                fOrdered &= (value == expected);
+                ++expected;
+            }
+            else
+                std::this_thread::yield();
+        }
+        producer.join();
+
+        CHECK( fOrdered );
+        CHECK( ring.empty() );
+    }
+
+};
+
@@ -85,6 +85,7 @@ public:
         options.add_newlines = true;
         shape.on_draw(&drawer, ropts);
 
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -143,6 +144,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<g><rect x='50' y='70' width='130' height='176'/></g>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -160,6 +162,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<g id='m34'><rect x='50' y='70' width='130' height='176'/></g>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -177,6 +180,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<g class='staff'><rect x='50' y='70' width='130' height='176'/></g>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -195,6 +199,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<g id='m34' class='staff'><rect x='50' y='70' width='130' height='176'/></g>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -212,6 +217,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<rect id='m34' class='staff' x='50' y='70' width='130' height='176'/>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -233,6 +239,7 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected << "<rect id='m30' class='rectangle' x='40' y='60' width='120' height='100'/>"
             << "<g id='m34' class='staff'><rect x='50' y='70' width='130' height='176'/></g>";
+        drawer.flush();
         CHECK( ss.str() == expected.str() );
         check_expected(ss.str(), expected.str());
     }
@@ -256,6 +263,7 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected << "<rect id='m30' class='rectangle' x='40' y='60' width='120' height='100'/>"
             << "<g id='m34' class='staff'>   <rect x='50' y='70' width='130' height='176'/></g>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -279,6 +287,7 @@ SUITE(SvgDrawerTest)
             << "<g>" << endl
             << "   <rect x='50' y='70' width='130' height='176'/>" << endl
             << "</g>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -306,9 +315,51 @@ SUITE(SvgDrawerTest)
             << "   <g id='m34' class='staff'>" << endl
             << "      <rect x='50' y='70' width='130' height='176'/>" << endl
             << "   </g>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
+    TEST_FIXTURE(SvgDrawerTestFixture, options_10)
+    {
+        //@10. precision: max number of decimal places. Trailing zeros removed
+        stringstream ss;
+        SvgOptions options;
+        SvgDrawer drawer(m_libraryScope, ss, options);
+
+        options.precision = 2;
+        drawer.rect(UPoint(40.1234f, -0.001f), USize(120.5f, 100.0f), 0.0);
+        drawer.begin_path();
+        drawer.move_to(3.14159, 2.0);
+        drawer.line_to(-7.256, 0.999);
+        drawer.end_path();
+
+        stringstream expected;
+        expected << "<rect x='40.12' y='0' width='120.5' height='100'/>"
+            << "<path d=' M 3.14 2 L -7.26 1'/>";
+        drawer.flush();
+        check_expected(ss.str(), expected.str());
+    }
+
+    TEST_FIXTURE(SvgDrawerTestFixture, options_11)
+    {
+        //@11. code is buffered. Written when flushing, rendering or when buffer is full
+        stringstream ss;
+        SvgOptions options;
+        SvgDrawer drawer(m_libraryScope, ss, options);
+
+        drawer.rect(UPoint(40.0, 60.0), USize(120.0, 100.0), 0.0);
+        CHECK( ss.str().empty() );
+        drawer.render();
+        CHECK( ss.str() == "<rect x='40' y='60' width='120' height='100'/>" );
+
+        while (ss.str().size() < 100000)
+            drawer.rect(UPoint(40.0, 60.0), USize(120.0, 100.0), 0.0);
+        size_t size = ss.str().size();
+        CHECK( size % 46 == 0 );
+        drawer.flush();
+        CHECK( ss.str().size() == size );
+    }
+
 
     //@ circle --------------------------------------------------------------------------
     TEST_FIXTURE(SvgDrawerTestFixture, circle_01)
@@ -333,6 +384,7 @@ SUITE(SvgDrawerTest)
             << "   <circle cx='50' cy='70' r='20'/>" << endl
             << "</g>" << endl
             << "<circle id='m30' class='rectangle' cx='40' cy='60' r='10'/>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -360,9 +412,81 @@ SUITE(SvgDrawerTest)
             << "   <text x='50' y='70' fill='#000' font-family='Bravura' font-size='352.778'>&#97;</text>" << endl
             << "</g>" << endl
             << "<text id='m30' class='rectangle' x='40' y='60' fill='#000' font-family='Bravura' font-size='352.778'>&#98;</text>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
+    TEST_FIXTURE(SvgDrawerTestFixture, draw_glyph_02)
+    {
+        //@02. glyphs as symbols. Outline written once. Glyphs drawn by <use>
+        stringstream ss;
+        SvgOptions options;
+        options.glyphs_as_symbols = true;
+        options.add_newlines = true;
+        SvgDrawer drawer(m_libraryScope, ss, options);
+
+        drawer.draw_glyph(50.0, 70.0, 0xE0A4);
+        drawer.draw_glyph(150.0, 70.0, 0xE0A4);
+        drawer.draw_glyph_rotated(40.0, 60.0, 0xE0A4, 3.141592654/2.0);
+
+        drawer.flush();
+        string svg = ss.str();
+        string symbol = "<symbol id='glyph-E0A4-353' overflow='visible'><path d='m";
+        CHECK( svg.find(symbol) == 0 );
+        CHECK( svg.find("<symbol", 1) == string::npos );
+        CHECK( svg.find("z'/></symbol>\n<use xlink:href='#glyph-E0A4-353' x='50' y='70'/>\n"
+                        "<use xlink:href='#glyph-E0A4-353' x='150' y='70'/>\n"
+                        "<use xlink:href='#glyph-E0A4-353' x='40' y='60' "
+                        "transform='rotate(90,40,60)'/>\n") != string::npos );
+        CHECK( svg.find("<text") == string::npos );
+//        cout << test_name() << endl << svg << endl;
+    }
+
+    TEST_FIXTURE(SvgDrawerTestFixture, draw_glyph_03)
+    {
+        //@03. glyphs as symbols. A symbol for each font size
+        stringstream ss;
+        SvgOptions options;
+        options.glyphs_as_symbols = true;
+        SvgDrawer drawer(m_libraryScope, ss, options);
+
+        drawer.draw_glyph(50.0, 70.0, 0xE0A4);
+        drawer.select_font("", "", "Bravura", 21.0);
+        drawer.draw_glyph(150.0, 70.0, 0xE0A4);
+
+        drawer.flush();
+        string svg = ss.str();
+        CHECK( svg.find("<symbol id='glyph-E0A4-353'") != string::npos );
+        CHECK( svg.find("<symbol id='glyph-E0A4-741'") != string::npos );
+        CHECK( svg.find("<use xlink:href='#glyph-E0A4-741' x='150' y='70'/>")
+               != string::npos );
+    }
+
+    TEST_FIXTURE(SvgDrawerTestFixture, draw_glyph_04)
+    {
+        //@04. glyphs as symbols. Score rendered without glyphs as <text> elements
+        LomseDoorway doorway;
+        doorway.init_library(k_pix_format_rgba32, 96);
+        Presenter* pPresenter = doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "09003-ebook-three-pages.lms");
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+
+        stringstream svg1;
+        pIntor->render_as_svg(svg1, 0);
+        pIntor->svg_glyphs_as_symbols(true);
+        stringstream svg2;
+        pIntor->render_as_svg(svg2, 0);
+
+        string svg = svg2.str();
+        CHECK( svg.find("xmlns:xlink='http://www.w3.org/1999/xlink'") != string::npos );
+        CHECK( svg.find("font-family='Bravura'") == string::npos );
+        CHECK( svg.find("<symbol") != string::npos );
+        CHECK( svg.size() < svg1.str().size() );
+//        cout << test_name() << ": text=" << svg1.str().size()
+//             << ", symbols=" << svg.size() << endl;
+        delete pPresenter;
+    }
+
 
     //@ draw_glyph_rotated --------------------------------------------------------------
     TEST_FIXTURE(SvgDrawerTestFixture, draw_glyph_rotated_01)
@@ -387,6 +511,7 @@ SUITE(SvgDrawerTest)
             << "   <text x='50' y='70' fill='#000' transform='rotate(90,50,70)' font-family='Bravura' font-size='352.778'>&#97;</text>" << endl
             << "</g>" << endl
             << "<text id='m30' class='rectangle' x='40' y='60' fill='#000' transform='rotate(90,40,60)' font-family='Bravura' font-size='352.778'>&#98;</text>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -414,6 +539,7 @@ SUITE(SvgDrawerTest)
             << "   <text x='50' y='70' fill='#000' font-family='Bravura' font-size='352.778'>hello</text>" << endl
             << "</g>" << endl
             << "<text id='m30' class='rectangle' x='40' y='60' fill='#000' font-family='Bravura' font-size='352.778'>world</text>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -445,6 +571,7 @@ SUITE(SvgDrawerTest)
             << "   <path d=' M 52 68.5 L 48 71.5 L 18 31.5 L 22 28.5'/>" << endl
             << "</g>" << endl
             << "<path id='m30' class='rectangle' d=' M 42.2406 57.3112 L 37.7594 62.6888 L 7.75935 37.6888 L 12.2406 32.3112'/>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -476,6 +603,7 @@ SUITE(SvgDrawerTest)
             << "   <path d=' M 52 68.5 L 48 71.5 L 18 31.5 L 22 28.5 Z'/>" << endl
             << "</g>" << endl
             << "<path id='m30' class='rectangle' d=' M 42.2406 57.3112 L 37.7594 62.6888 L 7.75935 37.6888 L 12.2406 32.3112 Z'/>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -498,6 +626,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<path d=' M 2000 3000 L 18000 3300' stroke='#000' stroke-width='50'/>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -532,6 +661,7 @@ SUITE(SvgDrawerTest)
             << "   <path d=' M 2000 3000 L 18000 3300'/>" << endl
             << "</g>" << endl
             << "<path id='m30' class='rectangle' d=' M 20 30 L 180 33'/>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -549,6 +679,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<rect x='50' y='70' width='130' height='176'/>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -563,6 +694,7 @@ SUITE(SvgDrawerTest)
 
         stringstream expected;
         expected << "<rect x='50' y='70' width='130' height='176' rx='10' ry='10'/>";
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -588,6 +720,7 @@ SUITE(SvgDrawerTest)
             << "   <rect x='50' y='70' width='130' height='176'/>" << endl
             << "</g>" << endl
             << "<rect id='m30' class='rectangle' x='40' y='60' width='120' height='100'/>" << endl;
+        drawer.flush();
         check_expected(ss.str(), expected.str());
     }
 
@@ -656,9 +789,9 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g id='m83' class='arpeggio'>" << endl
-            << "   <text x='140' y='1123.46' fill='#000' transform='rotate(-90,140,1123.46)' "
+            << "   <text x='140.733' y='1123.37' fill='#000' transform='rotate(-90,140.733,1123.37)' "
             <<        "font-family='Bravura' font-size='740.834'>&#60073;</text>" << endl
-            << "   <text x='140' y='934.535' fill='#000' transform='rotate(-90,140,934.535)' "
+            << "   <text x='140.733' y='934.455' fill='#000' transform='rotate(-90,140.733,934.455)' "
             <<        "font-family='Bravura' font-size='740.834'>&#60077;</text>" << endl
             << "</g>" << endl;
         run_test_for(shape, expected);
@@ -1021,7 +1154,7 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g class='fret'>" << endl
-            << "   <path d=' M 170.875 -26 H 602.125 V 512 H 170.875 V -26' fill='#fff'/>" << endl
+            << "   <path d=' M 171.848 -25.2508 H 601.532 V 511.112 H 171.848 V -25.2508' fill='#fff'/>" << endl
             << "   <text x='200' y='500' fill='#000' font-family='Bravura' font-size='740.834'>&#60016;</text>" << endl
             << "</g>" << endl;
         run_test_for(shape, expected);
@@ -1256,7 +1389,7 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g id='m83' class='note'>" << endl
-            << "   <path class='ledger-line' d=' M 300 507 H 519' fill='#00000000' "
+            << "   <path class='ledger-line' d=' M 300 507.396 H 518.546' fill='#00000000' "
             <<          "stroke='#000' stroke-width='0'/>" << endl
             << "   <text class='notehead' x='300' y='600' fill='#000' "
             <<          "font-family='Bravura' font-size='740.834'>&#57508;</text>" << endl
@@ -1284,7 +1417,7 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g id='m83' class='note'>" << endl
-            << "   <path class='ledger-line' d=' M 300 507 H 519' fill='#00000000' "
+            << "   <path class='ledger-line' d=' M 300 507.396 H 518.546' fill='#00000000' "
             <<          "stroke='#000' stroke-width='0'/>" << endl
             << "   <text class='notehead' x='300' y='600' fill='#000' "
             <<          "font-family='Bravura' font-size='740.834'>&#57508;</text>" << endl
@@ -1327,8 +1460,8 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g id='m83' class='octave-shift'>" << endl
-            << "   <path d=' M 300 256 H 400 M 500 256 H 600 M 700 256 H 800 M 900 256 "
-            <<          "M 800 256 H 956 V 256' fill='none' stroke='#000' stroke-width='0'/>" << endl
+            << "   <path d=' M 300 256.994 H 400 M 500 256.994 H 600 M 700 256.994 H 800 M 900 256.994 "
+            <<          "M 800 256.994 H 955.637 V 256.994' fill='none' stroke='#000' stroke-width='0'/>" << endl
             << "   <text x='300' y='600' fill='#000' font-family='Bravura' "
             <<          "font-size='740.834'>&#58641;</text>" << endl
             << "</g>" << endl;
@@ -1870,8 +2003,8 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g id='m83' class='tuplet'>" << endl
-            << "   <path d=' M 214 166.428 L 214 173.572 L 508 473.572 L 508 466.428' fill='#000'/>" << endl
-            << "   <path d=' M 219 170 L 214 170 L 214 190 L 219 190 M 508 470 L 503 470 L 503 490 L 508 490' fill='#000'/>" << endl
+            << "   <path d=' M 214.817 166.424 L 214.817 173.576 L 508.187 473.576 L 508.187 466.424' fill='#000'/>" << endl
+            << "   <path d=' M 219.817 170 L 214.817 170 L 214.817 190 L 219.817 190 M 508.187 470 L 503.187 470 L 503.187 490 L 508.187 490' fill='#000'/>" << endl
             << "</g>" << endl;
 
         run_test_for(shape, expected);
@@ -1903,8 +2036,8 @@ SUITE(SvgDrawerTest)
         stringstream expected;
         expected
             << "<g id='m83' class='tuplet'>" << endl
-            << "   <path d=' M 400 19.2155 L 400 24.6627 L 156 -80.8128 L 156 -86.26 M 216 -60.3234 L 216 -54.8762 L 1094 324.663 L 1094 319.216' fill='#000'/>" << endl
-            << "   <path d=' M 405 21.9391 L 400 21.9391 L 400 41.9391 L 405 41.9391 M 1094 321.939 L 1089 321.939 L 1089 341.939 L 1094 341.939' fill='#000'/>" << endl
+            << "   <path d=' M 400 19.2151 L 400 24.6631 L 155.183 -81.2616 L 155.183 -86.7096 M 215.183 -60.7494 L 215.183 -55.3014 L 1093.37 324.663 L 1093.37 319.215' fill='#000'/>" << endl
+            << "   <path d=' M 405 21.9391 L 400 21.9391 L 400 41.9391 L 405 41.9391 M 1093.37 321.939 L 1088.37 321.939 L 1088.37 341.939 L 1093.37 341.939' fill='#000'/>" << endl
             << "   <text x='400' y='350' fill='#000' font-family='Liberation serif' font-size='423.334'>3:2</text>" << endl
             << "</g>" << endl;
 
@@ -0,0 +1,177 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+#include <UnitTest++.h>
+#include <sstream>
+#include "lomse_build_options.h"
+
+//classes related to these tests
+#include "lomse_tile_cache.h"
+#include "lomse_doorway.h"
+#include "lomse_presenter.h"
+#include "lomse_interactor.h"
+#include "lomse_graphic_view.h"
+
+#include <vector>
+
+using namespace UnitTest;
+using namespace std;
+using namespace lomse;
+
+
+//---------------------------------------------------------------------------------------
+class TileCacheTestFixture
+{
+public:
+    std::string m_scores_path;
+    LomseDoorway m_doorway;
+
+    TileCacheTestFixture()     //SetUp fixture
+        : m_scores_path(TESTLIB_SCORES_PATH)
+    {
+        m_doorway.init_library(k_pix_format_rgba32, 96);
+    }
+
+    ~TileCacheTestFixture()    //TearDown fixture
+    {
+    }
+
+    Presenter* open_document(vector<unsigned char>& buf, unsigned width,
+                             unsigned height, size_t cacheBytes)
+    {
+        Presenter* pPresenter = m_doorway.open_document(k_view_vertical_book,
+                                    m_scores_path + "01021-chords-beamed.lms");
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        buf.assign(width * height * 4, 0);
+        pIntor->set_rendering_buffer(&buf[0], width, height);
+        pIntor->set_tile_cache_budget(cacheBytes);
+        return pPresenter;
+    }
+
+    double get_timing(Presenter* pPresenter, int item)
+    {
+        Interactor* pIntor = pPresenter->get_interactor_raw_ptr(0);
+        return *(pIntor->get_elapsed_times() + item);
+    }
+};
+
+SUITE(TileCacheTest)
+{
+
+    TEST_FIXTURE(TileCacheTestFixture, tile_cache_01)
+    {
+        //@01. least recently used tiles are discarded when budget exceeded
+
+        size_t tileBytes = 16 * 16 * 4;
+        TileCache cache(4, 2 * tileBytes, 16);
+        cache.add_tile(1.0, 0, 0);
+        cache.add_tile(1.0, 1, 0);
+        CHECK( cache.find_tile(1.0, 0, 0) != nullptr );
+        cache.add_tile(1.0, 2, 0);
+
+        CHECK( cache.get_num_tiles() == 2 );
+        CHECK( cache.get_used_bytes() == 2 * tileBytes );
+        CHECK( cache.find_tile(1.0, 1, 0) == nullptr );
+        CHECK( cache.find_tile(1.0, 0, 0) != nullptr );
+        CHECK( cache.find_tile(1.0, 2, 0) != nullptr );
+        CHECK( cache.find_tile(2.0, 2, 0) == nullptr );
+        CHECK( cache.get_num_hits() == 3 );
+        CHECK( cache.get_num_misses() == 2 );
+    }
+
+    TEST_FIXTURE(TileCacheTestFixture, tile_cache_02)
+    {
+        //@02. tiles discarded when content changes
+
+        TileCache cache(4, 1000000, 16);
+        RenderOptions options;
+        cache.set_content(1L, 0L, options);
+        cache.add_tile(1.0, 0, 0);
+        cache.set_content(1L, 0L, options);
+        CHECK( cache.get_num_tiles() == 1 );
+
+        cache.set_content(1L, 1L, options);
+        CHECK( cache.get_num_tiles() == 0 );
+
+        cache.add_tile(1.0, 0, 0);
+        options.highlighted_voice = 2;
+        cache.set_content(1L, 1L, options);
+        CHECK( cache.get_num_tiles() == 0 );
+        CHECK( cache.get_used_bytes() == 0 );
+    }
+
+    TEST_FIXTURE(TileCacheTestFixture, tile_cache_10)
+    {
+        //@10. view composed from tiles is identical to direct rendering
+
+        vector<unsigned char> buf1, buf2;
+        Presenter* pPresenter1 = open_document(buf1, 700, 500, 0);
+        Presenter* pPresenter2 = open_document(buf2, 700, 500, 16000000);
+        pPresenter1->get_interactor_raw_ptr(0)->redraw_bitmap();
+        pPresenter2->get_interactor_raw_ptr(0)->redraw_bitmap();
+
+        CHECK( buf1 == buf2 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_hits) == 0.0 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_misses) == 6.0 );
+
+        delete pPresenter1;
+        delete pPresenter2;
+    }
+
+    TEST_FIXTURE(TileCacheTestFixture, tile_cache_11)
+    {
+        //@11. scrolling only rasterizes missing tiles. Result is identical
+
+        vector<unsigned char> buf1, buf2;
+        Presenter* pPresenter1 = open_document(buf1, 700, 500, 0);
+        Presenter* pPresenter2 = open_document(buf2, 700, 500, 16000000);
+        Interactor* pIntor1 = pPresenter1->get_interactor_raw_ptr(0);
+        Interactor* pIntor2 = pPresenter2->get_interactor_raw_ptr(0);
+        pIntor2->redraw_bitmap();
+
+        //new_viewport() redraws the view
+        pIntor1->new_viewport(-37, 120);
+        pIntor2->new_viewport(-37, 120);
+
+        CHECK( buf1 == buf2 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_hits) == 6.0 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_misses) == 6.0 );
+
+        pIntor2->redraw_bitmap();
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_hits) == 12.0 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_misses) == 0.0 );
+
+        delete pPresenter1;
+        delete pPresenter2;
+    }
+
+    TEST_FIXTURE(TileCacheTestFixture, tile_cache_12)
+    {
+        //@12. tiles are discarded when scale changes
+
+        vector<unsigned char> buf1, buf2;
+        Presenter* pPresenter1 = open_document(buf1, 700, 500, 0);
+        Presenter* pPresenter2 = open_document(buf2, 700, 500, 16000000);
+        Interactor* pIntor1 = pPresenter1->get_interactor_raw_ptr(0);
+        Interactor* pIntor2 = pPresenter2->get_interactor_raw_ptr(0);
+        pIntor2->redraw_bitmap();
+
+        //set_scale() redraws the view
+        pIntor1->set_scale(1.5);
+        pIntor2->set_scale(1.5);
+
+        CHECK( buf1 == buf2 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_hits) == 0.0 );
+        CHECK( get_timing(pPresenter2, Interactor::k_timing_tile_cache_misses) > 0.0 );
+
+        delete pPresenter1;
+        delete pPresenter2;
+    }
+
+};
@@ -9,6 +9,7 @@
 
 #include <UnitTest++.h>
 #include <iostream>
+#include <cstring>
 #include "lomse_build_options.h"
 
 //classes related to these tests
@@ -156,6 +157,22 @@ SUITE(XmlParserTest)
 
     }
 
+    TEST_FIXTURE(XmlParserTestFixture, xml_parser_07)
+    {
+        //@07. Parse in place a buffer owned by the parser
+
+        string src("<score-partwise version='3.0'><part-list/></score-partwise>");
+        void* buffer = XmlParser::allocate_buffer(src.size());
+        memcpy(buffer, src.data(), src.size());
+
+        XmlParser parser;
+        parser.parse_buffer_own(buffer, src.size());
+        XmlNode* root = parser.get_tree_root();
+        CHECK( root->name() == "score-partwise" );
+        CHECK( root->attribute_value("version") == "3.0" );
+        CHECK( root->first_child().name() == "part-list" );
+    }
+
     TEST_FIXTURE(XmlParserTestFixture, xml_parser_901)
     {
         //@901. File not found
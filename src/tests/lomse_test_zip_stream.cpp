@@ -380,6 +380,35 @@ SUITE(ZipInputStreamTest)
         delete[] data;
     }
 
+    TEST_FIXTURE(ZipInputStreamTestFixture, move_to_entry)
+    {
+        string path = m_scores_path + "10015-compressed-hello-world.mxl";
+        ZipInputStream zs(path);
+        CHECK( zs.move_to_entry("hello-world.xml") == true );
+        ZipEntryInfo info;
+        zs.get_current_entry_info(info);
+        CHECK( info.filename == "hello-world.xml" );
+        CHECK( zs.move_to_entry("META-INF/container.xml") == true );
+        zs.get_current_entry_info(info);
+        CHECK( info.filename == "META-INF/container.xml" );
+        CHECK( zs.move_to_entry("no-such-entry.xml") == false );
+    }
+
+    TEST_FIXTURE(ZipInputStreamTestFixture, inflate_current_entry)
+    {
+        string path = m_scores_path + "10014-compressed-flat-lmd.zip#zip:lenmusdoc-example.lmd";
+        ZipInputStream zs(path);
+        long size = zs.get_size();
+        vector<unsigned char> expected = zs.get_as_vector();
+
+        vector<unsigned char> data(size);
+        CHECK( zs.inflate_current_entry(data.data(), size) == size );
+        CHECK( memcmp(data.data(), expected.data(), size) == 0 );
+        CHECK( zs.is_open() == false );
+        //the entry can be inflated again
+        CHECK( zs.inflate_current_entry(data.data(), size) == size );
+    }
+
 }
 
 #endif // LOMSE_ENABLE_COMPRESSION
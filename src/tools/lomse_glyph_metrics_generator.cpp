@@ -0,0 +1,121 @@
+//---------------------------------------------------------------------------------------
+// This file is part of the Lomse library.
+// Copyright (c) 2010-present, Lomse Developers
+//
+// Licensed under the MIT license.
+//
+// See LICENSE and NOTICE.md files in the root directory of this source tree.
+//---------------------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------------------
+// Build tool for generating the glyph metrics table of the music font.
+//
+// Usage:
+//      lomse_glyph_metrics_generator <font file> <output file>
+//
+// Bounding boxes and advance widths are taken from the glyph outlines of all glyphs in
+// the SMuFL range (U+E000 - U+F8FF), in font units, and converted to staff spaces
+// (1 em = 4 staff spaces). The exact outline bounds are used, as in SMuFL metadata
+// files.
+//
+// The generated file is included by lomse_glyphs.cpp. It is not part of the library
+// sources, so that layout does not depend on FreeType rasterization at run time.
+//---------------------------------------------------------------------------------------
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_OUTLINE_H
+#include FT_BBOX_H
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+
+//---------------------------------------------------------------------------------------
+static string hex_code(unsigned long code)
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "0x%04lX", code);
+    return string(buffer);
+}
+
+//---------------------------------------------------------------------------------------
+static string number(double value)
+{
+    //float literal, with enough digits for an exact float value
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.9g", value);
+    string literal(buffer);
+    if (literal.find_first_of(".e") == string::npos)
+        literal += ".0";
+    return literal + "f";
+}
+
+//---------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <font file> <output file>\n", argv[0]);
+        return 1;
+    }
+
+    FT_Library library;
+    FT_Face face;
+    if (FT_Init_FreeType(&library) || FT_New_Face(library, argv[1], 0, &face))
+    {
+        fprintf(stderr, "Error loading font '%s'\n", argv[1]);
+        return 1;
+    }
+
+    //font units to staff spaces
+    const double scale = 4.0 / double(face->units_per_EM);
+
+    stringstream out;
+    out << "//-----------------------------------------------------------------------\n"
+        << "// Glyph metrics for music font '" << face->family_name << "'.\n"
+        << "// Generated by lomse_glyph_metrics_generator. Do not edit.\n"
+        << "//-----------------------------------------------------------------------\n\n"
+        << "static const char* const k_glyph_metrics_font = \""
+        << face->family_name << "\";\n\n"
+        << "static const GlyphMetrics k_glyph_metrics[] = {\n";
+
+    int numGlyphs = 0;
+    FT_UInt index;
+    FT_ULong code = FT_Get_First_Char(face, &index);
+    while (index != 0)
+    {
+        if (code >= 0xE000 && code <= 0xF8FF
+            && FT_Load_Glyph(face, index, FT_LOAD_NO_SCALE | FT_LOAD_NO_HINTING) == 0)
+        {
+            FT_BBox box;
+            FT_Outline_Get_BBox(&face->glyph->outline, &box);
+            if (face->glyph->outline.n_points == 0)
+                box.xMin = box.yMin = box.xMax = box.yMax = 0;
+
+            out << "    { " << hex_code(code)
+                << ", " << number(face->glyph->advance.x * scale)
+                << ", " << number(box.xMin * scale)
+                << ", " << number(box.yMin * scale)
+                << ", " << number(box.xMax * scale)
+                << ", " << number(box.yMax * scale)
+                << " },\n";
+            ++numGlyphs;
+        }
+        code = FT_Get_Next_Char(face, code, &index);
+    }
+    out << "    { 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }     //end of table\n"
+        << "};\n"
+        << "static const int k_num_glyph_metrics = " << numGlyphs << ";\n";
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+
+    ofstream file(argv[2], ios::out | ios::trunc);
+    file << out.str();
+    return file.good() ? 0 : 1;
+}